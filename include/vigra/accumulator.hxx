@@ -59,6 +59,7 @@
 #include "functorexpression.hxx"
 #include "labelimage.hxx"
 #include "multi_labeling.hxx"
+#include "threadpool.hxx"
 #include <algorithm>
 #include <iostream>
 
@@ -320,6 +321,8 @@ Pixel coordinates are always at index 0. To collect statistics, you simply pass
     a1.merge(a2, labelMapping);
     \endcode
 
+    When the labels are sparse to begin with (e.g. large object IDs of a subvolume) and relabeling is not an option, use \ref acc::SparseAccumulatorChainArray instead. It only allocates accumulators for the labels actually present and provides the same <tt>get<TAG>(a, label)</tt> interface.
+
     \anchor histogram
     Four kinds of <b>histograms</b> are currently implemented:
 
@@ -924,6 +927,10 @@ struct AccumulatorEndImpl
     void mergeImpl(U const &)
     {}
 
+    template <class U>
+    void mergePassImpl(U const &, unsigned int)
+    {}
+
     template <class U>
     void resize(U const &)
     {}
@@ -1386,6 +1393,16 @@ struct LabelDispatch
         regions_[k].setCoordinateOffsetImpl(offset);
     }
 
+    RegionAccumulatorChain & regionAccumulator(MultiArrayIndex label)
+    {
+        return regions_[label];
+    }
+
+    RegionAccumulatorChain const & regionAccumulator(MultiArrayIndex label) const
+    {
+        return regions_[label];
+    }
+
     template <class U>
     void resize(U const & t)
     {
@@ -1478,6 +1495,13 @@ struct LabelDispatch
         next_.mergeImpl(o.next_);
     }
 
+    void mergePassImpl(LabelDispatch const & o, unsigned int pass)
+    {
+        for(unsigned int k=0; k<regions_.size(); ++k)
+            regions_[k].mergePassImpl(o.regions_[k], pass);
+        next_.mergePassImpl(o.next_, pass);
+    }
+
     void mergeImpl(unsigned i, unsigned j)
     {
         regions_[i].mergeImpl(regions_[j]);
@@ -1494,6 +1518,339 @@ struct LabelDispatch
             regions_[labelMapping[k]].mergeImpl(o.regions_[k]);
         next_.mergeImpl(o.next_);
     }
+
+        // The following functions support merging region chains that were computed
+        // independently (e.g. in the blocks of extractFeaturesBlockwise()).
+        // resizeForMerge() creates the regions up to 'maxlabel' and resizes all
+        // regions not resized yet ('first' means that the chain hasn't seen any data),
+        // 't' is a handle of the data and only needed to determine the shape.
+    template <class U>
+    void resizeForMerge(MultiArrayIndex maxlabel, U const & t, bool first)
+    {
+        unsigned int oldSize = first ? 0 : regions_.size();
+        if(first)
+            next_.resize(t);
+        if(maxlabel > maxRegionLabel())
+            setMaxRegionLabel(maxlabel);
+        for(unsigned int k=oldSize; k<regions_.size(); ++k)
+            regions_[k].resize(t);
+    }
+
+    void copyRegionImpl(MultiArrayIndex label, RegionAccumulatorChain const & r)
+    {
+        if(label > maxRegionLabel())
+            setMaxRegionLabel(label);
+        regions_[label] = r;
+        getAccumulator<AccumulatorEnd>(regions_[label]).setGlobalAccumulator(&next_);
+        regions_[label].setCoordinateOffsetImpl(coordinateOffset_);
+    }
+
+    void mergeRegionPassImpl(MultiArrayIndex label, RegionAccumulatorChain const & r, unsigned int pass)
+    {
+        regions_[label].mergePassImpl(r, pass);
+    }
+};
+
+    // RegionSlotIndex maps (possibly huge and sparse) region labels to consecutive
+    // slot indices 0, 1, 2, ... in the order in which the labels were first seen.
+    // It is an open-addressing hash table with linear probing whose entries are
+    // slot indices; the labels themselves are stored compactly in labels_.
+class RegionSlotIndex
+{
+  public:
+    RegionSlotIndex()
+    : table_(),
+      labels_(),
+      mask_(0)
+    {}
+
+    MultiArrayIndex size() const
+    {
+        return (MultiArrayIndex)labels_.size();
+    }
+
+    ArrayVector<MultiArrayIndex> const & labels() const
+    {
+        return labels_;
+    }
+
+    MultiArrayIndex label(MultiArrayIndex slot) const
+    {
+        return labels_[slot];
+    }
+
+        // return the slot of 'label', or -1 if the label is unknown
+    MultiArrayIndex find(MultiArrayIndex label) const
+    {
+        if(table_.size() == 0)
+            return -1;
+        for(std::size_t h = hash(label) & mask_;; h = (h + 1) & mask_)
+        {
+            MultiArrayIndex slot = table_[h];
+            if(slot < 0 || labels_[slot] == label)
+                return slot;
+        }
+    }
+
+        // return the slot of 'label', appending a new slot if the label is unknown
+    MultiArrayIndex insert(MultiArrayIndex label)
+    {
+        if(2*(labels_.size() + 1) > table_.size())
+            rehash(std::max<std::size_t>(16, 2*table_.size()));
+        std::size_t h = hash(label) & mask_;
+        for(;; h = (h + 1) & mask_)
+        {
+            MultiArrayIndex slot = table_[h];
+            if(slot < 0)
+                break;
+            if(labels_[slot] == label)
+                return slot;
+        }
+        table_[h] = (MultiArrayIndex)labels_.size();
+        labels_.push_back(label);
+        return table_[h];
+    }
+
+    void clear()
+    {
+        ArrayVector<MultiArrayIndex>().swap(table_);
+        ArrayVector<MultiArrayIndex>().swap(labels_);
+        mask_ = 0;
+    }
+
+  private:
+    static std::size_t hash(MultiArrayIndex label)
+    {
+        // Fibonacci hashing, so that labels with regular gaps are spread over the table
+        UInt64 h = (UInt64)label * 0x9E3779B97F4A7C15ull;
+        return (std::size_t)(h ^ (h >> 32));
+    }
+
+    void rehash(std::size_t newSize)
+    {
+        ArrayVector<MultiArrayIndex>(newSize, -1).swap(table_);
+        mask_ = newSize - 1;
+        for(std::size_t slot=0; slot<labels_.size(); ++slot)
+        {
+            std::size_t h = hash(labels_[slot]) & mask_;
+            while(table_[h] >= 0)
+                h = (h + 1) & mask_;
+            table_[h] = (MultiArrayIndex)slot;
+        }
+    }
+
+    ArrayVector<MultiArrayIndex> table_;
+    ArrayVector<MultiArrayIndex> labels_;
+    std::size_t mask_;
+};
+
+    // SparseLabelDispatch is the LabelDispatch of SparseAccumulatorChainArray. Instead
+    // of allocating one region chain for every label between 0 and the maximum label,
+    // it allocates chains on demand (when a label is first seen) and stores them
+    // compactly in regions_, indexed by the slots of a RegionSlotIndex.
+template <class T, class GlobalAccumulators, class RegionAccumulators>
+struct SparseLabelDispatch
+: public LabelDispatch<T, GlobalAccumulators, RegionAccumulators>
+{
+    typedef LabelDispatch<T, GlobalAccumulators, RegionAccumulators> base_type;
+    typedef typename base_type::RegionAccumulatorChain RegionAccumulatorChain;
+    typedef typename base_type::CoordinateType CoordinateType;
+
+    typedef SparseLabelDispatch type;
+    typedef SparseLabelDispatch & reference;
+    typedef SparseLabelDispatch const & const_reference;
+
+    RegionSlotIndex slots_;
+    MultiArrayIndex max_label_;
+
+    SparseLabelDispatch()
+    : base_type(),
+      slots_(),
+      max_label_(-1)
+    {}
+
+    MultiArrayIndex maxRegionLabel() const
+    {
+        return max_label_;
+    }
+
+    MultiArrayIndex regionSlot(MultiArrayIndex label) const
+    {
+        return slots_.find(label);
+    }
+
+        // return the slot of 'label', creating and initializing a new region chain if necessary
+    MultiArrayIndex addRegion(MultiArrayIndex label)
+    {
+        MultiArrayIndex slot = slots_.insert(label);
+        if(slot == (MultiArrayIndex)this->regions_.size())
+        {
+            this->regions_.push_back(RegionAccumulatorChain());
+            RegionAccumulatorChain & r = this->regions_.back();
+            getAccumulator<AccumulatorEnd>(r).setGlobalAccumulator(&this->next_);
+            getAccumulator<AccumulatorEnd>(r).active_accumulators_ = this->active_region_accumulators_;
+            r.applyHistogramOptions(this->region_histogram_options_);
+            r.setCoordinateOffsetImpl(this->coordinateOffset_);
+            max_label_ = std::max(max_label_, label);
+        }
+        return slot;
+    }
+
+    RegionAccumulatorChain & regionAccumulator(MultiArrayIndex label)
+    {
+        MultiArrayIndex slot = slots_.find(label);
+        vigra_precondition(slot >= 0,
+            "SparseAccumulatorChainArray: region label does not exist.");
+        return this->regions_[slot];
+    }
+
+    RegionAccumulatorChain const & regionAccumulator(MultiArrayIndex label) const
+    {
+        MultiArrayIndex slot = slots_.find(label);
+        vigra_precondition(slot >= 0,
+            "SparseAccumulatorChainArray: region label does not exist.");
+        return this->regions_[slot];
+    }
+
+    void setCoordinateOffsetImpl(CoordinateType const & offset)
+    {
+        base_type::setCoordinateOffsetImpl(offset);
+    }
+
+    void setCoordinateOffsetImpl(MultiArrayIndex label, CoordinateType const & offset)
+    {
+        regionAccumulator(label).setCoordinateOffsetImpl(offset);
+    }
+
+    template <class U>
+    void resize(U const & t)
+    {
+        // unlike LabelDispatch, we don't scan the labels for their maximum:
+        // region chains are created on demand in pass() and resized there
+        this->next_.resize(t);
+        for(unsigned int k=0; k<this->regions_.size(); ++k)
+            this->regions_[k].resize(t);
+    }
+
+    template <unsigned N>
+    void pass(T const & t)
+    {
+        typedef HandleArgSelector<T, LabelArgTag, GlobalAccumulators> LabelHandle;
+        MultiArrayIndex label = LabelHandle::getValue(t);
+        if(label != this->ignore_label_)
+        {
+            this->next_.template pass<N>(t);
+            regionForPass(label, t).template pass<N>(t);
+        }
+    }
+
+    template <unsigned N>
+    void pass(T const & t, double weight)
+    {
+        typedef HandleArgSelector<T, LabelArgTag, GlobalAccumulators> LabelHandle;
+        MultiArrayIndex label = LabelHandle::getValue(t);
+        if(label != this->ignore_label_)
+        {
+            this->next_.template pass<N>(t, weight);
+            regionForPass(label, t).template pass<N>(t, weight);
+        }
+    }
+
+    void reset()
+    {
+        base_type::reset();
+        slots_.clear();
+        max_label_ = -1;
+    }
+
+    void mergeImpl(SparseLabelDispatch const & o)
+    {
+        for(MultiArrayIndex k=0; k<o.slots_.size(); ++k)
+        {
+            MultiArrayIndex slot = slots_.find(o.slots_.label(k));
+            if(slot < 0)
+                copyRegion(o.slots_.label(k), o.regions_[k]);
+            else
+                this->regions_[slot].mergeImpl(o.regions_[k]);
+        }
+        this->next_.mergeImpl(o.next_);
+    }
+
+    void mergePassImpl(SparseLabelDispatch const & o, unsigned int pass)
+    {
+        for(MultiArrayIndex k=0; k<o.slots_.size(); ++k)
+        {
+            MultiArrayIndex slot = slots_.find(o.slots_.label(k));
+            if(slot < 0)
+                copyRegion(o.slots_.label(k), o.regions_[k]);
+            else
+                this->regions_[slot].mergePassImpl(o.regions_[k], pass);
+        }
+        this->next_.mergePassImpl(o.next_, pass);
+    }
+
+    template <class U>
+    void resizeForMerge(MultiArrayIndex, U const & t, bool first)
+    {
+        // regions that are new to this chain are copied in mergeRegionPassImpl()
+        if(first)
+            resize(t);
+    }
+
+    void copyRegionImpl(MultiArrayIndex label, RegionAccumulatorChain const & r)
+    {
+        MultiArrayIndex slot = slots_.find(label);
+        if(slot < 0)
+        {
+            copyRegion(label, r);
+        }
+        else
+        {
+            this->regions_[slot] = r;
+            getAccumulator<AccumulatorEnd>(this->regions_[slot]).setGlobalAccumulator(&this->next_);
+            this->regions_[slot].setCoordinateOffsetImpl(this->coordinateOffset_);
+        }
+    }
+
+    void mergeRegionPassImpl(MultiArrayIndex label, RegionAccumulatorChain const & r, unsigned int pass)
+    {
+        MultiArrayIndex slot = slots_.find(label);
+        if(slot < 0)
+            copyRegion(label, r);
+        else
+            this->regions_[slot].mergePassImpl(r, pass);
+    }
+
+    void mergeImpl(MultiArrayIndex i, MultiArrayIndex j)
+    {
+        RegionAccumulatorChain & rj = regionAccumulator(j);
+        regionAccumulator(i).mergeImpl(rj);
+        rj.reset();
+        getAccumulator<AccumulatorEnd>(rj).active_accumulators_ = this->active_region_accumulators_;
+    }
+
+  private:
+        // a region that only exists on the right-hand side of a merge is simply copied,
+        // so that it need not be resized for the data before merging
+    void copyRegion(MultiArrayIndex label, RegionAccumulatorChain const & r)
+    {
+        slots_.insert(label);
+        this->regions_.push_back(r);
+        getAccumulator<AccumulatorEnd>(this->regions_.back()).setGlobalAccumulator(&this->next_);
+        this->regions_.back().setCoordinateOffsetImpl(this->coordinateOffset_);
+        max_label_ = std::max(max_label_, label);
+    }
+
+    RegionAccumulatorChain & regionForPass(MultiArrayIndex label, T const & t)
+    {
+        MultiArrayIndex slot = slots_.find(label);
+        if(slot < 0)
+        {
+            slot = addRegion(label);
+            this->regions_[slot].resize(shapeOf(t));
+        }
+        return this->regions_[slot];
+    }
 };
 
 template <class TargetTag, class TagList>
@@ -1714,6 +2071,13 @@ struct AccumulatorFactory
             this->next_.mergeImpl(o.next_);
         }
 
+        void mergePassImpl(Accumulator const & o, unsigned int pass)
+        {
+            if(Accumulator::workInPass == pass)
+                DecoratorImpl<Accumulator, Accumulator::workInPass, allowRuntimeActivation>::mergeImpl(*this, o);
+            this->next_.mergePassImpl(o.next_, pass);
+        }
+
         void applyHistogramOptions(HistogramOptions const & options)
         {
             DecoratorImpl<Accumulator, workInPass, allowRuntimeActivation>::applyHistogramOptions(*this, options);
@@ -1812,6 +2176,15 @@ struct ConfigureAccumulatorChainArray<T, TypeList<HEAD, TAIL>, dynamic>
     typedef LabelDispatch<T, GlobalAccumulatorChain, RegionAccumulatorChain> type;
 };
 
+template <class T, class Selected, bool dynamic=false>
+struct ConfigureSparseAccumulatorChainArray
+: public ConfigureAccumulatorChainArray<T, Selected, dynamic>
+{
+    typedef ConfigureAccumulatorChainArray<T, Selected, dynamic> base_type;
+    typedef SparseLabelDispatch<T, typename base_type::GlobalAccumulatorChain,
+                                   typename base_type::RegionAccumulatorChain> type;
+};
+
 } // namespace acc_detail
 
 /****************************************************************************/
@@ -1939,6 +2312,16 @@ class AccumulatorChainImpl
         next_.mergeImpl(o.next_);
     }
 
+    /** Merge only the statistics that work in pass N. This is used when the
+        passes of both chains were computed on different parts of the data, but
+        the chains agree in the results of all earlier passes (see the parallel
+        version of extractFeatures()).
+    */
+    void mergePassN(AccumulatorChainImpl const & o, unsigned int N)
+    {
+        next_.mergePassImpl(o.next_, N);
+    }
+
     result_type operator()() const
     {
         return next_.get();
@@ -2093,6 +2476,10 @@ class AccumulatorChain
    */
   void merge(AccumulatorChainImpl const & o);
 
+  /** Merge only the statistics that work in pass N. This is used when the passes of both chains were computed on different parts of the data, but the chains agree in the results of all earlier passes (see the parallel version of extractFeatures()).
+   */
+  void mergePassN(AccumulatorChainImpl const & o, unsigned int N);
+
   /** Upate all accumulators in the accumulator chain that work in pass N with data t. Requirement: 0 < N < 6 and N >= current_pass_ . If N < current_pass_ call reset first.
    */
   void updatePassN(T const & t, unsigned int N);
@@ -2525,6 +2912,154 @@ class AccumulatorChainArray<CoupledArrays<N, T1, T2, T3, T4, T5>, Selected, dyna
 : public AccumulatorChainArray<typename CoupledArrays<N, T1, T2, T3, T4, T5>::HandleType, Selected, dynamic>
 {};
 
+/** \brief Create a sparse array of accumulator chains containing the selected per-region and global statistics and their dependencies.
+
+    SparseAccumulatorChainArray computes the same statistics as \ref AccumulatorChainArray, but
+    does not allocate a region chain for every label between 0 and the maximum label. Instead,
+    a chain is created when its label is first encountered, and the chains are stored compactly
+    in an array addressed via an open-addressing hash table that maps labels to array slots.
+    Memory consumption is therefore proportional to the number of regions actually present,
+    which makes this class the right choice for label images with large gaps between the labels
+    (e.g. 64-bit object IDs of a subvolume of a big dataset).
+
+    Statistics are queried in the same way as for AccumulatorChainArray, i.e. via
+    <tt>get<TAG>(a, label)</tt> and <tt>getAccumulator<TAG>(a, label)</tt>. Asking for a label that
+    has not been seen is a precondition violation, use hasRegion() to check. The labels present
+    are returned by regionLabels() in the order in which they were first encountered.
+
+    Usage:
+    \code
+    MultiArray<3, double> data(...);
+    MultiArray<3, Int64>  labels(...);   // e.g. object IDs of the order 10^12
+
+    SparseAccumulatorChainArray<CoupledArrays<3, double, Int64>,
+                                Select<DataArg<1>, LabelArg<2>, Count, Mean, RegionCenter> > a;
+    extractFeatures(data, labels, a);
+
+    for(unsigned int k=0; k<a.regionCount(); ++k)
+    {
+        MultiArrayIndex label = a.regionLabels()[k];
+        std::cout << label << ": " << get<Count>(a, label) << " " << get<Mean>(a, label) << "\n";
+    }
+    \endcode
+
+    Two sparse chains are merged label by label, regions existing only on the right-hand side
+    are added to the left-hand side. Merging with a label mapping is not supported.
+    Run-time activation of statistics (cf. \ref DynamicAccumulatorChainArray) is
+    not provided for sparse chains.
+
+    See \ref FeatureAccumulators for more information and examples of use.
+*/
+template <class T, class Selected>
+class SparseAccumulatorChainArray
+#ifndef DOXYGEN //hide AccumulatorChainImpl vom documentation
+: public AccumulatorChainImpl<T, typename acc_detail::ConfigureSparseAccumulatorChainArray<T, Selected>::type>
+#endif
+{
+  public:
+    typedef AccumulatorChainImpl<T, typename acc_detail::ConfigureSparseAccumulatorChainArray<T, Selected>::type> base_type;
+    typedef typename acc_detail::ConfigureSparseAccumulatorChainArray<T, Selected> Creator;
+    typedef typename Creator::TagList AccumulatorTags;
+    typedef typename Creator::GlobalTags GlobalTags;
+    typedef typename Creator::RegionTags RegionTags;
+
+    /** Statistics will not be computed for label l. Note that only one label can be ignored.
+    */
+    void ignoreLabel(MultiArrayIndex l)
+    {
+        this->next_.ignoreLabel(l);
+    }
+
+    /** Ask for a label to be ignored. Default: -1 (meaning that no label is ignored).
+    */
+    MultiArrayIndex ignoredLabel() const
+    {
+        return this->next_.ignoredLabel();
+    }
+
+    /** Maximum region label encountered so far (-1 if no region exists).
+    */
+    MultiArrayIndex maxRegionLabel() const
+    {
+        return this->next_.maxRegionLabel();
+    }
+
+    /** Number of regions actually present.
+    */
+    unsigned int regionCount() const
+    {
+        return this->next_.regions_.size();
+    }
+
+    /** Check if region \a label exists.
+    */
+    bool hasRegion(MultiArrayIndex label) const
+    {
+        return this->next_.regionSlot(label) >= 0;
+    }
+
+    /** Labels of all regions present, in the order of their first occurrence.
+    */
+    ArrayVector<MultiArrayIndex> const & regionLabels() const
+    {
+        return this->next_.slots_.labels();
+    }
+
+    /** Equivalent to <tt>merge(o)</tt>.
+    */
+    void operator+=(SparseAccumulatorChainArray const & o)
+    {
+        merge(o);
+    }
+
+    /** Merge region j into region i. Both regions must exist.
+    */
+    void merge(MultiArrayIndex i, MultiArrayIndex j)
+    {
+        this->next_.mergeImpl(i, j);
+    }
+
+    /** Merge with accumulator chain o. Regions are matched by label, regions
+        only present in o are added.
+    */
+    void merge(SparseAccumulatorChainArray const & o)
+    {
+        this->next_.mergeImpl(o.next_);
+    }
+
+    /** Return names of all tags in the accumulator chain (selected statistics and their dependencies).
+    */
+    static ArrayVector<std::string> const & tagNames()
+    {
+        static const ArrayVector<std::string> n = collectTagNames();
+        return n;
+    }
+
+    using base_type::setCoordinateOffset;
+
+    /** Set an offset for <tt>Coord<...></tt> statistics for region \a label, which must exist.
+    */
+    template <class SHAPE>
+    void setCoordinateOffset(MultiArrayIndex label, SHAPE const & offset)
+    {
+        this->next_.setCoordinateOffsetImpl(label, offset);
+    }
+
+  private:
+    static ArrayVector<std::string> collectTagNames()
+    {
+        ArrayVector<std::string> n;
+        acc_detail::CollectAccumulatorNames<AccumulatorTags>::exec(n);
+        std::sort(n.begin(), n.end());
+        return n;
+    }
+};
+
+template <unsigned int N, class T1, class T2, class T3, class T4, class T5, class Selected>
+class SparseAccumulatorChainArray<CoupledArrays<N, T1, T2, T3, T4, T5>, Selected>
+: public SparseAccumulatorChainArray<typename CoupledArrays<N, T1, T2, T3, T4, T5>::HandleType, Selected>
+{};
+
 /** \brief Create an array of dynamic accumulator chains containing the selected per-region and global statistics and their dependencies.
 
 
@@ -2854,7 +3389,7 @@ struct CastImpl<Tag, LabelDispatchTag, reference>
     template <class A>
     static reference exec(A & a, MultiArrayIndex label)
     {
-        return CastImpl<Tag, typename A::RegionAccumulatorChain::Tag, reference>::exec(a.regions_[label]);
+        return CastImpl<Tag, typename A::RegionAccumulatorChain::Tag, reference>::exec(a.regionAccumulator(label));
     }
 };
 
@@ -3077,6 +3612,41 @@ namespace vigra { namespace acc {
 \endcode
 Of course, the number and types of the arrays specified in <tt>CoupledArrays</tt> must conform to the number and types of the arrays passed to <tt>extractFeatures()</tt>.
 
+All variants can be executed in parallel by passing \ref vigra::ParallelOptions as the last argument:
+\code
+namespace vigra { namespace acc {
+
+    template <class ITERATOR, class ACCUMULATOR>
+    void extractFeatures(ITERATOR start, ITERATOR end, ACCUMULATOR & a,
+                         ParallelOptions const & options);
+
+    template <unsigned int N, class T1, class S1,
+                              class T2, class S2,
+              class ACCUMULATOR>
+    void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
+                         MultiArrayView<N, T2, S2> const & a2,
+                         ACCUMULATOR & a,
+                         ParallelOptions const & options);
+    ... // likewise for one to five arrays
+}}
+\endcode
+The scan-order range is split into one contiguous slab per thread, and every thread computes
+the current pass over its slab with a private copy of the accumulator chain. The copies are
+merged into <tt>a</tt> after each pass, so that later passes see the global results of earlier ones
+(e.g. the global mean when central moments are computed in pass 2). The iterator must be a
+random access iterator (such as \ref vigra::CoupledScanOrderIterator), and all selected statistics
+must support merging (see \ref FeatureAccumulators). Each thread holds a copy of the
+chain, which includes the accumulators of all regions in case of an \ref AccumulatorChainArray.
+If <tt>a</tt> already contains data from an earlier call, or only one thread is requested,
+the function falls back to the sequential algorithm. Due to the different order of
+floating-point operations, results may differ from the sequential ones by round-off.
+\code
+    AccumulatorChainArray<CoupledArrays<3, double, int>,
+                          Select<DataArg<1>, LabelArg<2>, Mean, Variance, Skewness> > a;
+
+    extractFeatures(data, labels, a, ParallelOptions().numThreads(8));
+\endcode
+
 See \ref FeatureAccumulators for more information about feature computation via accumulators.
 */
 doxygen_overloaded_function(template <...> void extractFeatures)
@@ -3090,6 +3660,42 @@ void extractFeatures(ITERATOR start, ITERATOR end, ACCUMULATOR & a)
             a.updatePassN(*i, k);
 }
 
+template <class ITERATOR, class ACCUMULATOR>
+void extractFeatures(ITERATOR start, ITERATOR end, ACCUMULATOR & a,
+                     ParallelOptions const & options)
+{
+    std::ptrdiff_t size = end - start;
+    std::ptrdiff_t slabCount = std::min<std::ptrdiff_t>(options.getActualNumThreads(), size);
+    if(slabCount <= 1 || a.current_pass_ != 0)
+    {
+        extractFeatures(start, end, a);
+        return;
+    }
+
+    // initialize the chain for pass 1 as the sequential loop would do upon
+    // the first sample (for region chains, this determines the maximum label)
+    a.next_.resize(acc_detail::shapeOf(*start));
+    a.current_pass_ = 1;
+
+    for(unsigned int pass=1; pass <= a.passesRequired(); ++pass)
+    {
+        // every slab starts from the global results of the earlier passes
+        std::vector<VIGRA_UNIQUE_PTR<ACCUMULATOR> > slabChains(slabCount);
+        parallel_foreach(options, slabCount,
+            [&](size_t /*thread_id*/, size_t k)
+            {
+                slabChains[k].reset(new ACCUMULATOR(a));
+                ITERATOR i    = start + size * (std::ptrdiff_t)k / slabCount,
+                         iend = start + size * (std::ptrdiff_t)(k+1) / slabCount;
+                for(; i < iend; ++i)
+                    slabChains[k]->updatePassN(*i, pass);
+            });
+        for(std::ptrdiff_t k=0; k < slabCount; ++k)
+            a.mergePassN(*slabChains[k], pass);
+        a.current_pass_ = pass;
+    }
+}
+
 template <unsigned int N, class T1, class S1,
           class ACCUMULATOR>
 void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
@@ -3165,6 +3771,86 @@ void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
     extractFeatures(start, end, a);
 }
 
+template <unsigned int N, class T1, class S1,
+          class ACCUMULATOR>
+void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
+                     ACCUMULATOR & a,
+                     ParallelOptions const & options)
+{
+    typedef typename CoupledIteratorType<N, T1>::type Iterator;
+    Iterator start = createCoupledIterator(a1),
+             end   = start.getEndIterator();
+    extractFeatures(start, end, a, options);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class ACCUMULATOR>
+void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
+                     MultiArrayView<N, T2, S2> const & a2,
+                     ACCUMULATOR & a,
+                     ParallelOptions const & options)
+{
+    typedef typename CoupledIteratorType<N, T1, T2>::type Iterator;
+    Iterator start = createCoupledIterator(a1, a2),
+             end   = start.getEndIterator();
+    extractFeatures(start, end, a, options);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+                          class T3, class S3,
+          class ACCUMULATOR>
+void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
+                     MultiArrayView<N, T2, S2> const & a2,
+                     MultiArrayView<N, T3, S3> const & a3,
+                     ACCUMULATOR & a,
+                     ParallelOptions const & options)
+{
+    typedef typename CoupledIteratorType<N, T1, T2, T3>::type Iterator;
+    Iterator start = createCoupledIterator(a1, a2, a3),
+             end   = start.getEndIterator();
+    extractFeatures(start, end, a, options);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+                          class T3, class S3,
+                          class T4, class S4,
+          class ACCUMULATOR>
+void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
+                     MultiArrayView<N, T2, S2> const & a2,
+                     MultiArrayView<N, T3, S3> const & a3,
+                     MultiArrayView<N, T4, S4> const & a4,
+                     ACCUMULATOR & a,
+                     ParallelOptions const & options)
+{
+    typedef typename CoupledIteratorType<N, T1, T2, T3, T4>::type Iterator;
+    Iterator start = createCoupledIterator(a1, a2, a3, a4),
+             end   = start.getEndIterator();
+    extractFeatures(start, end, a, options);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+                          class T3, class S3,
+                          class T4, class S4,
+                          class T5, class S5,
+          class ACCUMULATOR>
+void extractFeatures(MultiArrayView<N, T1, S1> const & a1,
+                     MultiArrayView<N, T2, S2> const & a2,
+                     MultiArrayView<N, T3, S3> const & a3,
+                     MultiArrayView<N, T4, S4> const & a4,
+                     MultiArrayView<N, T5, S5> const & a5,
+                     ACCUMULATOR & a,
+                     ParallelOptions const & options)
+{
+    typedef typename CoupledIteratorType<N, T1, T2, T3, T4, T5>::type Iterator;
+    Iterator start = createCoupledIterator(a1, a2, a3, a4, a5),
+             end   = start.getEndIterator();
+    extractFeatures(start, end, a, options);
+}
+
 /****************************************************************************/
 /*                                                                          */
 /*                          AccumulatorResultTraits                         */
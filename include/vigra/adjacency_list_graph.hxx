@@ -471,7 +471,18 @@ namespace vigra{
         */
         Edge addEdge(const index_type u ,const index_type v);
 
-        
+        /* \brief add a batch of edges to a graph which has no edges yet.
+            The range must hold pairs (u,v) of existing node ids with u<v,
+            sorted lexicographically and free of duplicates. The edges get
+            the ids 0,1,2,... in the order of the range. Since the node
+            degrees are counted in a first pass, each adjacency set is
+            allocated only once and filled by appending, which is much
+            faster than repeated calls to addEdge().
+        */
+        template<class ITER>
+        void assignSortedEdges(ITER begin, ITER end);
+
+
         size_t maxDegree()const{
             size_t md=0;
             for(NodeIt it(*this);it!=lemon::INVALID;++it){
@@ -763,6 +774,47 @@ namespace vigra{
         return addEdge(uu,vv);
     }
 
+    template<class ITER>
+    inline void
+    AdjacencyListGraph::assignSortedEdges(ITER begin, ITER end){
+        vigra_precondition(edgeNum_==0,
+            "AdjacencyListGraph::assignSortedEdges(): graph must not have edges.");
+
+        // count the degrees, so that every adjacency set is allocated once
+        std::vector<size_t> degree(nodes_.size(), 0);
+        size_t numEdges=0;
+        index_type lastU=-1, lastV=-1;
+        for(ITER iter=begin; iter!=end; ++iter, ++numEdges){
+            const index_type u = iter->first;
+            const index_type v = iter->second;
+            vigra_precondition(u<v && nodeFromId(u)!=lemon::INVALID && nodeFromId(v)!=lemon::INVALID,
+                "AdjacencyListGraph::assignSortedEdges(): edges must connect existing nodes u<v.");
+            vigra_precondition(u>lastU || (u==lastU && v>lastV),
+                "AdjacencyListGraph::assignSortedEdges(): edges must be sorted and unique.");
+            lastU=u;
+            lastV=v;
+            ++degree[u];
+            ++degree[v];
+        }
+        for(size_t i=0; i<nodes_.size(); ++i)
+            if(degree[i]>0)
+                nodes_[i].adjacency_.reserve(degree[i]);
+
+        // for sorted input, the neighbors of every node arrive in increasing
+        // order, so each insert() appends to the end of the adjacency set
+        edges_.clear();
+        edges_.reserve(numEdges);
+        for(ITER iter=begin; iter!=end; ++iter){
+            const index_type eid = edges_.size();
+            const index_type u = iter->first;
+            const index_type v = iter->second;
+            edges_.push_back(EdgeStorage(u,v,eid));
+            nodes_[u].insert(v,eid);
+            nodes_[v].insert(u,eid);
+        }
+        edgeNum_=numEdges;
+    }
+
     
     
     inline AdjacencyListGraph::Arc 
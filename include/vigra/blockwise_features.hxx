@@ -0,0 +1,356 @@
+/************************************************************************/
+/*                                                                      */
+/*          Copyright 2016 by the VIGRA developers                      */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_BLOCKWISE_FEATURES_HXX
+#define VIGRA_BLOCKWISE_FEATURES_HXX
+
+#include <algorithm>
+#include <vector>
+
+#include "accumulator.hxx"
+#include "multi_blockwise.hxx"
+#include "multi_blocking.hxx"
+#include "multi_array_chunked.hxx"
+#include "threadpool.hxx"
+
+namespace vigra { namespace acc {
+
+namespace blockwise_features_detail {
+
+template <unsigned int N, class T1, class T2, class ACCUMULATOR>
+struct BlockState
+{
+    MultiArrayView<N, T1, StridedArrayTag> data;
+    MultiArray<N, T2> labels;                 // local labels 0...mapping.size()-1
+    ArrayVector<MultiArrayIndex> mapping;     // local label => global label
+    VIGRA_UNIQUE_PTR<ACCUMULATOR> chain;
+};
+
+    // Replace the labels of a block with consecutive local labels in the order of
+    // their first occurrence, so that the block's accumulator chain only holds the
+    // regions actually present in the block. The ignored label gets the local label
+    // mapping.size(), which is then ignored by the block's chain.
+template <unsigned int N, class T, class S1, class S2>
+void
+localizeLabels(MultiArrayView<N, T, S1> const & labels,
+               MultiArrayView<N, T, S2> local,
+               MultiArrayIndex ignoreLabel,
+               ArrayVector<MultiArrayIndex> & mapping)
+{
+    acc_detail::RegionSlotIndex slots;
+    typename MultiArrayView<N, T, S1>::const_iterator i = labels.begin(), end = labels.end();
+    typename MultiArrayView<N, T, S2>::iterator j = local.begin();
+    bool ignored = false;
+    for(; i != end; ++i, ++j)
+    {
+        if(*i == ignoreLabel)
+            ignored = true;
+        else
+            *j = static_cast<T>(slots.insert(*i));
+    }
+    if(ignored)
+    {
+        for(i = labels.begin(), j = local.begin(); i != end; ++i, ++j)
+            if(*i == ignoreLabel)
+                *j = static_cast<T>(slots.size());
+    }
+    mapping = slots.labels();
+}
+
+template <unsigned int N, class T1, class S1, class T2, class S2>
+class ViewBlockLoader
+{
+  public:
+    typedef T1 DataType;
+    typedef T2 LabelType;
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ViewBlockLoader(MultiArrayView<N, T1, S1> const & data,
+                    MultiArrayView<N, T2, S2> const & labels,
+                    unsigned int)
+    : data_(data),
+      labels_(labels)
+    {}
+
+    template <class STATE>
+    void load(unsigned int, Shape const & start, Shape const & stop,
+              MultiArrayIndex ignoreLabel, STATE & s) const
+    {
+        s.data.reset();
+        s.data = data_.subarray(start, stop);
+        s.labels.reshape(stop - start);
+        localizeLabels(labels_.subarray(start, stop), s.labels, ignoreLabel, s.mapping);
+    }
+
+  private:
+    MultiArrayView<N, T1, S1> data_;
+    MultiArrayView<N, T2, S2> labels_;
+};
+
+template <unsigned int N, class T1, class T2>
+class ChunkedBlockLoader
+{
+  public:
+    typedef T1 DataType;
+    typedef T2 LabelType;
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ChunkedBlockLoader(ChunkedArray<N, T1> const & data,
+                       ChunkedArray<N, T2> const & labels,
+                       unsigned int slotCount)
+    : data_(data),
+      labels_(labels),
+      data_buffers_(slotCount),
+      label_buffers_(slotCount)
+    {}
+
+        // each slot owns a pair of buffers, so that at most slotCount
+        // blocks of the chunked arrays are held in memory at any time
+    template <class STATE>
+    void load(unsigned int slot, Shape const & start, Shape const & stop,
+              MultiArrayIndex ignoreLabel, STATE & s)
+    {
+        data_buffers_[slot].reshape(stop - start);
+        data_.checkoutSubarray(start, data_buffers_[slot]);
+        label_buffers_[slot].reshape(stop - start);
+        labels_.checkoutSubarray(start, label_buffers_[slot]);
+        s.data.reset();
+        s.data = data_buffers_[slot];
+        s.labels.reshape(stop - start);
+        localizeLabels(label_buffers_[slot], s.labels, ignoreLabel, s.mapping);
+    }
+
+  private:
+    ChunkedArray<N, T1> const & data_;
+    ChunkedArray<N, T2> const & labels_;
+    std::vector<MultiArray<N, T1> > data_buffers_;
+    std::vector<MultiArray<N, T2> > label_buffers_;
+};
+
+template <unsigned int N, class LOADER, class ACCUMULATOR>
+void
+extractFeaturesBlockwiseImpl(LOADER & loader,
+                             typename MultiArrayShape<N>::type const & shape,
+                             typename MultiArrayShape<N>::type const & blockShape,
+                             ACCUMULATOR & a,
+                             BlockwiseOptions const & options)
+{
+    typedef typename MultiBlocking<N>::Block Block;
+    typedef typename ACCUMULATOR::InternalBaseType::CoordinateType CoordinateType;
+    typedef BlockState<N, typename LOADER::DataType, typename LOADER::LabelType, ACCUMULATOR> State;
+    typedef typename CoupledIteratorType<N, typename LOADER::DataType, typename LOADER::LabelType>::type Iterator;
+
+    vigra_precondition(a.current_pass_ == 0,
+        "extractFeaturesBlockwise(): the accumulator chain must not contain data.");
+
+    MultiBlocking<N> blocking(shape, blockShape);
+    std::vector<Block> blocks;
+    for(typename MultiBlocking<N>::BlockIter b = blocking.blockBegin(); b != blocking.blockEnd(); ++b)
+        blocks.push_back(*b);
+
+    // the block chains are copies of the (still empty) chain 'a', so that
+    // they inherit its configuration (histogram options, active statistics etc.)
+    ACCUMULATOR const prototype(a);
+    std::size_t slotCount = std::min<std::size_t>(options.getActualNumThreads(), blocks.size());
+    std::vector<State> states(slotCount);
+
+    unsigned int passes = a.passesRequired();
+    for(unsigned int pass = 1; pass <= passes; ++pass)
+    {
+        // the block chains of later passes start from the results of the
+        // previous passes, which must not change while the blocks are merged
+        VIGRA_UNIQUE_PTR<ACCUMULATOR> previous;
+        if(pass > 1)
+            previous.reset(new ACCUMULATOR(a));
+
+        // process the blocks in waves of slotCount blocks, so that memory
+        // is bounded by the blocks in flight
+        for(std::size_t first = 0; first < blocks.size(); first += slotCount)
+        {
+            std::size_t count = std::min(slotCount, blocks.size() - first);
+            parallel_foreach(options, count,
+                [&](std::size_t /*thread_id*/, std::size_t k)
+                {
+                    State & s = states[k];
+                    Block const & block = blocks[first + k];
+                    loader.load(k, block.begin(), block.end(), a.ignoredLabel(), s);
+
+                    s.chain.reset(new ACCUMULATOR(prototype));
+                    ACCUMULATOR & c = *s.chain;
+                    c.ignoreLabel(s.mapping.size());
+                    if(pass > 1)
+                    {
+                        // restrict the results of the previous passes to the regions of
+                        // this block (in reverse order, so that a dense chain allocates
+                        // its regions only once)
+                        c.next_.next_ = previous->next_.next_;
+                        for(MultiArrayIndex j = (MultiArrayIndex)s.mapping.size() - 1; j >= 0; --j)
+                            c.next_.copyRegionImpl(j, previous->next_.regionAccumulator(s.mapping[j]));
+                        c.current_pass_ = pass - 1;
+                    }
+                    CoordinateType offset(a.next_.coordinateOffset_);
+                    for(unsigned int d = 0; d < N; ++d)
+                        offset[d] += block.begin()[d];
+                    c.setCoordinateOffset(offset);
+
+                    Iterator i = createCoupledIterator(s.data, s.labels),
+                             end = i.getEndIterator();
+                    for(; i < end; ++i)
+                        c.updatePassN(*i, pass);
+                });
+
+            // merge in block order, so that the result doesn't depend on the number of threads
+            for(std::size_t k = 0; k < count; ++k)
+            {
+                State & s = states[k];
+                ACCUMULATOR & c = *s.chain;
+                if(pass == 1)
+                {
+                    MultiArrayIndex maxLabel = s.mapping.size() == 0
+                                                   ? -1
+                                                   : *argMax(s.mapping.begin(), s.mapping.end());
+                    a.next_.resizeForMerge(maxLabel,
+                                           acc_detail::shapeOf(*createCoupledIterator(s.data, s.labels)),
+                                           a.current_pass_ == 0);
+                    a.current_pass_ = 1;
+                }
+                for(unsigned int j = 0; j < s.mapping.size(); ++j)
+                    a.next_.mergeRegionPassImpl(s.mapping[j], c.next_.regionAccumulator(j), pass);
+                a.next_.next_.mergePassImpl(c.next_.next_, pass);
+                s.chain.reset();
+            }
+        }
+        a.current_pass_ = pass;
+    }
+}
+
+} // namespace blockwise_features_detail
+
+/** \brief Compute region features of a large volume block by block, in parallel.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra { namespace acc {
+        template <unsigned int N, class T1, class S1, class T2, class S2, class ACCUMULATOR>
+        void extractFeaturesBlockwise(MultiArrayView<N, T1, S1> const & data,
+                                      MultiArrayView<N, T2, S2> const & labels,
+                                      ACCUMULATOR & a,
+                                      BlockwiseOptions const & options = BlockwiseOptions());
+
+        template <unsigned int N, class T1, class T2, class ACCUMULATOR>
+        void extractFeaturesBlockwise(ChunkedArray<N, T1> const & data,
+                                      ChunkedArray<N, T2> const & labels,
+                                      ACCUMULATOR & a,
+                                      BlockwiseOptions const & options = BlockwiseOptions());
+    }}
+    \endcode
+
+    The blockwise counterpart of \ref extractFeatures() for region statistics. The accumulator
+    \a a must be an \ref AccumulatorChainArray or \ref SparseAccumulatorChainArray for
+    <tt>CoupledArrays<N, T1, T2></tt> that has not seen any data yet (configuration such as
+    histogram options, ignored label and coordinate offset is respected).
+
+    The volume is split into blocks of shape <tt>options.getBlockShapeN<N>()</tt> (ChunkedArrays
+    use their chunk shape when no block shape is given). Each block is labeled locally and
+    processed by its own accumulator chain, which only holds the regions present in the block.
+    The block chains are merged into \a a in block order, so the result does not depend on the
+    number of threads. At most <tt>options.getActualNumThreads()</tt> blocks (and their chains)
+    are held in memory at any time, and ChunkedArrays are only accessed via checkoutSubarray().
+    All passes required by the selected statistics are performed; later passes start from the
+    merged results of the earlier passes (a copy of which is kept during the pass), as in the
+    serial algorithm.
+
+    Order-independent statistics (Count, Minimum, Maximum, histograms, coordinate extrema etc.)
+    are identical to the result of the serial \ref extractFeatures(). Moments are combined with
+    the usual pairwise merge formulas and agree up to floating-point round-off.
+    All selected statistics must support merging (see \ref FeatureAccumulators).
+
+    <b> Usage: </b>
+
+    <b>\#include </b> \<vigra/blockwise_features.hxx\><br>
+    Namespace: vigra::acc
+
+    \code
+    ChunkedArrayLazy<3, float>  data(shape, Shape3(64));
+    ChunkedArrayLazy<3, UInt32> labels(shape, Shape3(64));
+    ... // fill data and labels
+
+    AccumulatorChainArray<CoupledArrays<3, float, UInt32>,
+                          Select<DataArg<1>, LabelArg<2>, Count, Mean, Variance, RegionCenter> > a;
+    extractFeaturesBlockwise(data, labels, a, BlockwiseOptions().numThreads(8));
+
+    std::cout << get<Mean>(a, 10) << std::endl;
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void extractFeaturesBlockwise)
+
+template <unsigned int N, class T1, class S1, class T2, class S2, class ACCUMULATOR>
+void
+extractFeaturesBlockwise(MultiArrayView<N, T1, S1> const & data,
+                         MultiArrayView<N, T2, S2> const & labels,
+                         ACCUMULATOR & a,
+                         BlockwiseOptions const & options = BlockwiseOptions())
+{
+    vigra_precondition(data.shape() == labels.shape(),
+        "extractFeaturesBlockwise(): shape mismatch between data and labels.");
+    blockwise_features_detail::ViewBlockLoader<N, T1, S1, T2, S2>
+        loader(data, labels, options.getActualNumThreads());
+    blockwise_features_detail::extractFeaturesBlockwiseImpl<N>(
+        loader, data.shape(), options.getBlockShapeN<N>(), a, options);
+}
+
+template <unsigned int N, class T1, class T2, class ACCUMULATOR>
+void
+extractFeaturesBlockwise(ChunkedArray<N, T1> const & data,
+                         ChunkedArray<N, T2> const & labels,
+                         ACCUMULATOR & a,
+                         BlockwiseOptions const & options = BlockwiseOptions())
+{
+    vigra_precondition(data.shape() == labels.shape(),
+        "extractFeaturesBlockwise(): shape mismatch between data and labels.");
+    typename MultiArrayShape<N>::type blockShape = options.getBlockShape().size() == 0
+                                                       ? data.chunkShape()
+                                                       : options.getBlockShapeN<N>();
+    blockwise_features_detail::ChunkedBlockLoader<N, T1, T2>
+        loader(data, labels, options.getActualNumThreads());
+    blockwise_features_detail::extractFeaturesBlockwiseImpl<N>(
+        loader, data.shape(), blockShape, a, options);
+}
+
+}} // namespace vigra::acc
+
+#endif // VIGRA_BLOCKWISE_FEATURES_HXX
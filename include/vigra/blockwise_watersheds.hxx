@@ -72,7 +72,7 @@ void prepareBlockwiseWatersheds(const Overlaps<DataArray>& overlaps,
     MultiCoordinateIterator<DataArray::actual_dimension> end = itBegin.getEndIterator();
     typedef typename MultiCoordinateIterator<DataArray::actual_dimension>::value_type Coordinate;
 
-    parallel_foreach(options.getNumThreads(),
+    parallel_foreach(options,
         itBegin,end,
         [&](const int /*threadId*/, const Coordinate  iterVal){
 
@@ -50,6 +50,8 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cstring>
 
 #include "array_vector.hxx"
 #include "config.hxx"
@@ -203,6 +205,105 @@ namespace vigra
         virtual const void * currentScanlineOfBand( unsigned int ) const = 0;
         virtual void nextScanline() = 0;
 
+        // Decode the entire image into a caller-provided buffer, as an
+        // alternative to reading it scanline by scanline (i.e. instead of
+        // any call to nextScanline()). The elements are stored in the decoder's
+        // pixel type (see getPixelType()) without conversion, and the first
+        // 'numBands' bands (at most getNumBands()) are copied. 'dest' points to
+        // band 0 of the upper left pixel, the strides between consecutive pixels,
+        // scanlines and bands are given in bytes.
+        //
+        // The default implementation copies the scanlines one by one. Codecs
+        // override it to decode directly into 'dest' when its layout matches
+        // the file's layout, or to decode entire strips or tiles at once.
+        virtual void decodeImage( void * dest, std::ptrdiff_t pixelStride,
+                                  std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                  unsigned int numBands )
+        {
+            decodeRegion(dest, pixelStride, lineStride, bandStride, numBands,
+                         0, 0, getWidth(), getHeight());
+        }
+
+        // Decode the rectangle of size 'width' x 'height' whose upper left
+        // corner is at ('x', 'y') into a caller-provided buffer, see decodeImage().
+        // Like decodeImage(), this replaces all calls to nextScanline().
+        //
+        // The default implementation skips the scanlines above the rectangle and
+        // copies the relevant part of the following ones. Codecs storing the image
+        // in independently compressed tiles or strips override it to decode
+        // only the parts intersecting the rectangle.
+        virtual void decodeRegion( void * dest, std::ptrdiff_t pixelStride,
+                                   std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                   unsigned int numBands, unsigned int x, unsigned int y,
+                                   unsigned int width, unsigned int height )
+        {
+            const std::size_t elementSize = pixelTypeSize(getPixelType());
+            const std::ptrdiff_t srcStride = getOffset() * elementSize;
+            for (unsigned int k = 0; k < y; ++k)
+                nextScanline();
+            char * line = static_cast<char *>(dest);
+            for (unsigned int k = 0; k < height; ++k, line += lineStride)
+            {
+                nextScanline();
+                for (unsigned int b = 0; b < numBands; ++b)
+                    copyScanline(static_cast<const char *>(currentScanlineOfBand(b)) + x*srcStride,
+                                 srcStride, width, elementSize, line + b*bandStride, pixelStride);
+            }
+        }
+
+        // Maximum number of threads used by decodeImage() and decodeRegion()
+        // (with the semantics of ParallelOptions::numThreads()). Codecs that
+        // cannot decode concurrently ignore this setting.
+        virtual void setNumThreads( int )
+        {
+        }
+
+        // size of an element of the given pixel type in bytes (0 if unknown)
+        static std::size_t pixelTypeSize( const std::string & pixeltype )
+        {
+            if (pixeltype == "UINT8" || pixeltype == "INT8" || pixeltype == "BILEVEL")
+                return 1;
+            if (pixeltype == "UINT16" || pixeltype == "INT16")
+                return 2;
+            if (pixeltype == "UINT32" || pixeltype == "INT32" || pixeltype == "FLOAT")
+                return 4;
+            if (pixeltype == "DOUBLE")
+                return 8;
+            return 0;
+        }
+
+        // copy 'width' elements of size 'elementSize' between buffers with
+        // the given strides (in bytes)
+        static void copyScanline( const void * src, std::ptrdiff_t srcStride,
+                                  unsigned int width, std::size_t elementSize,
+                                  void * dest, std::ptrdiff_t destStride )
+        {
+            if (srcStride == (std::ptrdiff_t)elementSize && destStride == (std::ptrdiff_t)elementSize)
+            {
+                std::memcpy(dest, src, width*elementSize);
+                return;
+            }
+            switch (elementSize)
+            {
+              case 1:
+                copyElements<UInt8>(src, srcStride, width, dest, destStride);
+                break;
+              case 2:
+                copyElements<UInt16>(src, srcStride, width, dest, destStride);
+                break;
+              case 4:
+                copyElements<UInt32>(src, srcStride, width, dest, destStride);
+                break;
+              default:
+                {
+                    const char * s = static_cast<const char *>(src);
+                    char * d = static_cast<char *>(dest);
+                    for (unsigned int x = 0; x < width; ++x, s += srcStride, d += destStride)
+                        std::memcpy(d, s, elementSize);
+                }
+            }
+        }
+
         typedef ArrayVector<unsigned char> ICCProfile;
 
         const ICCProfile & getICCProfile() const
@@ -211,6 +312,18 @@ namespace vigra
         }
 
         ICCProfile iccProfile_;
+
+      private:
+
+        template <class T>
+        static void copyElements( const void * src, std::ptrdiff_t srcStride,
+                                  unsigned int width, void * dest, std::ptrdiff_t destStride )
+        {
+            const char * s = static_cast<const char *>(src);
+            char * d = static_cast<char *>(dest);
+            for (unsigned int x = 0; x < width; ++x, s += srcStride, d += destStride)
+                std::memcpy(d, s, sizeof(T));
+        }
     };
 
     struct Encoder
@@ -256,9 +369,47 @@ namespace vigra
         {
         }
 
+        // Request that the image be stored in tiles of the given size rather
+        // than in strips. Codecs that don't support tiles ignore this setting.
+        virtual void setTileSize( const vigra::Size2D & /*size*/ )
+        {
+        }
+
+        // Maximum number of threads used by encodeImage() (with the semantics
+        // of ParallelOptions::numThreads()). Codecs that cannot encode
+        // concurrently ignore this setting.
+        virtual void setNumThreads( int )
+        {
+        }
+
         virtual void * currentScanlineOfBand( unsigned int ) = 0;
         virtual void nextScanline() = 0;
 
+        // Encode the entire image from a caller-provided buffer, as an
+        // alternative to writing it scanline by scanline (i.e. instead of
+        // any call to nextScanline()). It must be called after finalizeSettings(),
+        // and 'width', 'height' and 'numBands' must equal the values set before.
+        // The elements must already have the encoder's pixel type, whose size
+        // is 'elementSize'. The strides are given in bytes, see Decoder::decodeImage().
+        //
+        // The default implementation copies the scanlines one by one. Codecs
+        // override it to encode entire strips or tiles at once.
+        virtual void encodeImage( const void * src, std::ptrdiff_t pixelStride,
+                                  std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                  unsigned int width, unsigned int height,
+                                  unsigned int numBands, std::size_t elementSize )
+        {
+            const std::ptrdiff_t destStride = getOffset() * elementSize;
+            const char * line = static_cast<const char *>(src);
+            for (unsigned int y = 0; y < height; ++y, line += lineStride)
+            {
+                for (unsigned int b = 0; b < numBands; ++b)
+                    Decoder::copyScanline(line + b*bandStride, pixelStride, width, elementSize,
+                                          currentScanlineOfBand(b), destStride);
+                nextScanline();
+            }
+        }
+
         struct TIFFCompressionException {};
     };
 
@@ -50,22 +50,50 @@ enum CompressionMethod {  DEFAULT_COMPRESSION=-2,  // use default method (depend
                           ZLIB_FAST=1, // fastest compression using zlib
                           ZLIB=6,      // zlib default compression level
                           ZLIB_BEST=9, // highest compression using zlib
-                          LZ4          // very fast LZ4 algorithm
+                          LZ4,         // very fast LZ4 algorithm
+
+                          // pre-filters, combine with a ZLIB or LZ4 method by bitwise 'or'
+                          SHUFFLE_FILTER    = 0x100, // group the i-th bytes of all elements
+                          BITSHUFFLE_FILTER = 0x200, // group the i-th bits of all elements
+                          DELTA_FILTER      = 0x400, // store differences of consecutive elements
+
+                          // common combinations
+                          LZ4_SHUFFLE             = LZ4 | SHUFFLE_FILTER,
+                          LZ4_BITSHUFFLE          = LZ4 | BITSHUFFLE_FILTER,
+                          LZ4_DELTA_SHUFFLE       = LZ4 | DELTA_FILTER | SHUFFLE_FILTER,
+                          ZLIB_FAST_SHUFFLE       = ZLIB_FAST | SHUFFLE_FILTER,
+                          ZLIB_FAST_BITSHUFFLE    = ZLIB_FAST | BITSHUFFLE_FILTER,
+                          ZLIB_FAST_DELTA_SHUFFLE = ZLIB_FAST | DELTA_FILTER | SHUFFLE_FILTER
                        };
 
 /** Compress the source buffer.
 
     The destination array will be resized as required.
+
+    If \a method includes pre-filters (<tt>SHUFFLE_FILTER</tt>, <tt>BITSHUFFLE_FILTER</tt>,
+    <tt>DELTA_FILTER</tt>), the buffer is interpreted as an array of elements of
+    \a elementSize bytes. The delta filter replaces each element with its difference
+    to the preceding element (modulo 2<sup>8*elementSize</sup> for element sizes 1, 2, 4,
+    and 8, bytewise otherwise), which makes slowly varying data and piecewise constant
+    labels very compressible. The shuffle filters then transpose the buffer so that
+    all first bytes (or bits) of the elements are stored consecutively, followed by
+    all second bytes etc. This exposes the redundancy in the high-order bytes of
+    integer labels and floating point values to the subsequent ZLIB or LZ4 compression.
+    Shuffle and bit-shuffle cannot be combined. The same \a method and \a elementSize
+    must be passed to uncompress().
 */
-VIGRA_EXPORT void compress(char const * source, std::size_t size, ArrayVector<char> & dest, CompressionMethod method);
-VIGRA_EXPORT void compress(char const * source, std::size_t size, std::vector<char> & dest, CompressionMethod method);
+VIGRA_EXPORT void compress(char const * source, std::size_t size, ArrayVector<char> & dest,
+                           CompressionMethod method, std::size_t elementSize = 1);
+VIGRA_EXPORT void compress(char const * source, std::size_t size, std::vector<char> & dest,
+                           CompressionMethod method, std::size_t elementSize = 1);
 
 /** Uncompress the source buffer when the uncompressed size is known.
 
     The destination buffer must be allocated to the correct size.
 */
-VIGRA_EXPORT void uncompress(char const * source, std::size_t srcSize, 
-                             char * dest, std::size_t destSize, CompressionMethod method);
+VIGRA_EXPORT void uncompress(char const * source, std::size_t srcSize,
+                             char * dest, std::size_t destSize, CompressionMethod method,
+                             std::size_t elementSize = 1);
 
 
 } // namespace vigra
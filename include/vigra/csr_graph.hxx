@@ -0,0 +1,785 @@
+/************************************************************************/
+/*                                                                      */
+/*          Copyright 2016 by the VIGRA developers                      */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_CSR_GRAPH_HXX
+#define VIGRA_CSR_GRAPH_HXX
+
+/*std*/
+#include <vector>
+#include <algorithm>
+
+/*vigra*/
+#include "multi_array.hxx"
+#include "graphs.hxx"
+#include "graph_maps.hxx"
+#include "graph_item_impl.hxx"
+#include "iteratorfacade.hxx"
+#include "adjacency_list_graph.hxx"
+
+namespace vigra{
+
+/** \addtogroup GraphDataStructures
+*/
+//@{
+
+    namespace detail_csr_graph{
+
+        // iterator over the adjacency range of a single node, the FILTER
+        // (from graph_item_impl.hxx) selects and transforms the items
+        template<class GRAPH,class FILTER>
+        class IncItemIt
+        : public ForwardIteratorFacade<
+            IncItemIt<GRAPH,FILTER>,
+            typename FILTER::ResultType,true
+        >
+        {
+        public:
+            typedef GRAPH Graph;
+            typedef typename Graph::index_type index_type;
+            typedef typename Graph::Node Node;
+            typedef typename Graph::NodeIt NodeIt;
+            typedef typename FILTER::ResultType ResultItem;
+
+            IncItemIt(const lemon::Invalid & /*invalid*/ = lemon::INVALID)
+            :   graph_(NULL),
+                ownNodeId_(-1),
+                begin_(NULL),
+                iter_(NULL),
+                end_(NULL),
+                resultItem_(lemon::INVALID){
+            }
+
+            IncItemIt(const Graph & g, const NodeIt & nodeIt)
+            :   graph_(&g),
+                ownNodeId_(g.id(*nodeIt)),
+                begin_(g.adjacencyBegin(*nodeIt)),
+                iter_(begin_),
+                end_(g.adjacencyEnd(*nodeIt)),
+                resultItem_(lemon::INVALID){
+                skipInvalid();
+            }
+
+            IncItemIt(const Graph & g, const Node & node)
+            :   graph_(&g),
+                ownNodeId_(g.id(node)),
+                begin_(g.adjacencyBegin(node)),
+                iter_(begin_),
+                end_(g.adjacencyEnd(node)),
+                resultItem_(lemon::INVALID){
+                skipInvalid();
+            }
+
+        private:
+            friend class vigra::IteratorFacadeCoreAccess;
+
+            typedef typename Graph::NodeStorage::AdjacencyElement AdjacencyElement;
+
+            void skipInvalid(){
+                if(FILTER::IsFilter){
+                    while(iter_!=end_ && !FILTER::valid(*graph_,*iter_,ownNodeId_))
+                        ++iter_;
+                }
+            }
+
+            bool isEnd()const{
+                return iter_==end_;
+            }
+            bool isBegin()const{
+                return graph_!=NULL && iter_==begin_;
+            }
+            bool equal(const IncItemIt & other)const{
+                if(isEnd() && other.isEnd())
+                    return true;
+                else if(isEnd() != other.isEnd())
+                    return false;
+                else
+                    return iter_==other.iter_;
+            }
+
+            void increment(){
+                ++iter_;
+                skipInvalid();
+            }
+
+            const ResultItem & dereference()const{
+                resultItem_ = FILTER::transform(*graph_,*iter_,ownNodeId_);
+                return resultItem_;
+            }
+
+            const Graph * graph_;
+            index_type ownNodeId_;
+            const AdjacencyElement * begin_;
+            const AdjacencyElement * iter_;
+            const AdjacencyElement * end_;
+            mutable ResultItem resultItem_;
+        };
+
+    } // namespace detail_csr_graph
+
+
+    /** \brief immutable undirected graph in compressed sparse row (CSR) layout,
+        implementing the LEMON API.
+
+        CsrGraph is a frozen counterpart of \ref AdjacencyListGraph. It has the
+        same node, edge and arc descriptors and the same id conventions, so that
+        node and edge ids (e.g. region labels of a region adjacency graph) are
+        preserved by the conversion. The neighbors of all nodes are stored in a
+        single array of (neighbor id, edge id) pairs, sorted by neighbor within
+        each node, plus an offset per node. <tt>findEdge()</tt> is a binary
+        search. There are no per-node allocations, so the graph needs only a
+        fraction of the memory of an AdjacencyListGraph, and iteration over the
+        neighbors of a node is a linear scan through contiguous memory.
+
+        Nodes and edges cannot be added after construction. Unused node and
+        edge ids (gaps) of the source graph remain invalid in the CsrGraph.
+
+        <b>\#include</b> \<vigra/csr_graph.hxx\> <br/>
+        Namespace: vigra
+    */
+    class CsrGraph
+    {
+
+    public:
+        // public typdedfs
+        typedef Int64                                                     index_type;
+    private:
+        // private typedes which are needed for defining public typedes
+        typedef CsrGraph                                                    GraphType;
+        struct NodeStorage{
+            typedef detail::Adjacency<index_type> AdjacencyElement;
+        };
+        typedef NodeStorage::AdjacencyElement                               AdjacencyElement;
+        typedef TinyVector<index_type,2>                                    EdgeStorage;
+        typedef detail::NeighborNodeFilter<GraphType>                       NnFilter;
+        typedef detail::IncEdgeFilter<GraphType>                            IncFilter;
+        typedef detail::IsInFilter<GraphType>                               InFlter;
+        typedef detail::IsOutFilter<GraphType>                              OutFilter;
+        typedef detail::IsBackOutFilter<GraphType>                          BackOutFilter;
+    public:
+        // LEMON API TYPEDEFS (and a few more(NeighborNodeIt))
+
+        /// node descriptor
+        typedef detail::GenericNode<index_type>                           Node;
+        /// edge descriptor
+        typedef detail::GenericEdge<index_type>                           Edge;
+        /// arc descriptor
+        typedef detail::GenericArc<index_type>                            Arc;
+        /// edge iterator
+        typedef detail_adjacency_list_graph::ItemIter<GraphType,Edge>    EdgeIt;
+        /// node iterator
+        typedef detail_adjacency_list_graph::ItemIter<GraphType,Node>    NodeIt;
+        /// arc iterator
+        typedef detail_adjacency_list_graph::ArcIt<GraphType>            ArcIt;
+
+        /// incident edge iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,IncFilter >        IncEdgeIt;
+        /// incoming arc iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,InFlter   >        InArcIt;
+        /// outgoing arc iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,OutFilter >        OutArcIt;
+
+        typedef detail_csr_graph::IncItemIt<GraphType,NnFilter  >        NeighborNodeIt;
+
+        /// outgoing back arc iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,BackOutFilter >    OutBackArcIt;
+
+
+        // BOOST GRAPH API TYPEDEFS
+        // - categories (not complete yet)
+        typedef directed_tag            directed_category;
+        // iterators
+        typedef NeighborNodeIt          adjacency_iterator;
+        typedef EdgeIt                  edge_iterator;
+        typedef NodeIt                  vertex_iterator;
+        typedef IncEdgeIt               in_edge_iterator;
+        typedef IncEdgeIt               out_edge_iterator;
+
+        // size types
+        typedef size_t                  degree_size_type;
+        typedef size_t                  edge_size_type;
+        typedef size_t                  vertex_size_type;
+        // item descriptors
+        typedef Edge                    edge_descriptor;
+        typedef Node                    vertex_descriptor;
+
+
+        /// default edge map
+        template<class T>
+        struct EdgeMap : DenseEdgeReferenceMap<GraphType,T> {
+            EdgeMap(): DenseEdgeReferenceMap<GraphType,T>(){
+            }
+            EdgeMap(const GraphType & g)
+            : DenseEdgeReferenceMap<GraphType,T>(g){
+            }
+            EdgeMap(const GraphType & g,const T & val)
+            : DenseEdgeReferenceMap<GraphType,T>(g,val){
+            }
+        };
+
+        /// default node map
+        template<class T>
+        struct NodeMap : DenseNodeReferenceMap<GraphType,T> {
+            NodeMap(): DenseNodeReferenceMap<GraphType,T>(){
+            }
+            NodeMap(const GraphType & g)
+            : DenseNodeReferenceMap<GraphType,T>(g){
+            }
+            NodeMap(const GraphType & g,const T & val)
+            : DenseNodeReferenceMap<GraphType,T>(g,val){
+            }
+        };
+
+        /// default arc map
+        template<class T>
+        struct ArcMap : DenseArcReferenceMap<GraphType,T> {
+            ArcMap(): DenseArcReferenceMap<GraphType,T>(){
+            }
+            ArcMap(const GraphType & g)
+            : DenseArcReferenceMap<GraphType,T>(g){
+            }
+            ArcMap(const GraphType & g,const T & val)
+            : DenseArcReferenceMap<GraphType,T>(g,val){
+            }
+        };
+
+    // public member functions
+    public:
+        /** \brief Construct an empty graph.
+        */
+        CsrGraph();
+
+        /** \brief Freeze an AdjacencyListGraph.
+
+            All node and edge ids as well as the orientation (<tt>u(e)</tt>,
+            <tt>v(e)</tt>) of each edge are preserved, so that node and edge
+            maps of \a graph can be used with the new graph as well.
+        */
+        explicit CsrGraph(const AdjacencyListGraph & graph);
+
+        /** \brief Construct a graph from an edge list.
+
+            The graph gets the nodes <tt>0...nodeNum-1</tt>. Edge \a i connects
+            the nodes <tt>uvIds(i,0)</tt> and <tt>uvIds(i,1)</tt> and gets the
+            id \a i. Self-loops and parallel edges are not allowed.
+        */
+        template<class T, class S>
+        CsrGraph(const index_type nodeNum, const MultiArrayView<2,T,S> & uvIds);
+
+        /** \brief Get the number of edges in this graph (API: LEMON).
+        */
+        index_type edgeNum()const;
+        /** \brief Get the number of nodes in this graph (API: LEMON).
+        */
+        index_type nodeNum()const;
+        /** \brief Get the number of arcs in this graph (API: LEMON).
+        */
+        index_type arcNum()const;
+
+        /** \brief Get the maximum ID of any edge in this graph (API: LEMON).
+        */
+        index_type maxEdgeId()const;
+        /** \brief Get the maximum ID of any node in this graph (API: LEMON).
+        */
+        index_type maxNodeId()const;
+        /** \brief Get the maximum ID of any edge in arc graph (API: LEMON).
+        */
+        index_type maxArcId()const;
+
+        /** \brief Create an arc for the given edge \a e, oriented along the
+            edge's natural (<tt>forward = true</tt>) or reversed
+            (<tt>forward = false</tt>) direction (API: LEMON).
+        */
+        Arc direct(const Edge & edge,const bool forward)const;
+        /** \brief Create an arc for the given edge \a e oriented
+            so that node \a n is the starting node of the arc (API: LEMON), or
+            return <tt>lemon::INVALID</tt> if the edge is not incident to this node.
+        */
+        Arc direct(const Edge & edge,const Node & node)const;
+        /** \brief Return <tt>true</tt> when the arc is looking on the underlying
+            edge in its natural (i.e. forward) direction, <tt>false</tt> otherwise (API: LEMON).
+        */
+        bool direction(const Arc & arc)const;
+
+        /** \brief Get the start node of the given edge \a e (API: LEMON).
+        */
+        Node u(const Edge & edge)const;
+        /** \brief Get the end node of the given edge \a e (API: LEMON).
+        */
+        Node v(const Edge & edge)const;
+        /** \brief Get the start node of the given arc \a a (API: LEMON).
+        */
+        Node source(const Arc & arc)const;
+        /** \brief Get the end node of the given arc \a a (API: LEMON).
+        */
+        Node target(const Arc & arc)const;
+        /** \brief Return the opposite node of the given node \a n
+            along edge \a e (API: LEMON), or return <tt>lemon::INVALID</tt>
+            if the edge is not incident to this node.
+        */
+        Node oppositeNode(Node const &n, const Edge &e) const;
+
+        /** \brief Return the start node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node baseNode(const IncEdgeIt & iter)const;
+        /** \brief Return the start node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node baseNode(const OutArcIt & iter)const;
+        /** \brief Return the end node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node runningNode(const IncEdgeIt & iter)const;
+        /** \brief Return the end node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node runningNode(const OutArcIt & iter)const;
+
+        /** \brief Get the ID  for node desciptor \a v (API: LEMON).
+        */
+        index_type id(const Node & node)const;
+        /** \brief Get the ID  for edge desciptor \a v (API: LEMON).
+        */
+        index_type id(const Edge & edge)const;
+        /** \brief Get the ID  for arc desciptor \a v (API: LEMON).
+        */
+        index_type id(const Arc  & arc )const;
+
+        /** \brief Get edge descriptor for given node ID \a i (API: LEMON).
+            Return <tt>Edge(lemon::INVALID)</tt> when the ID does not exist in this graph.
+        */
+        Edge edgeFromId(const index_type id)const;
+        /** \brief Get node descriptor for given node ID \a i (API: LEMON).
+            Return <tt>Node(lemon::INVALID)</tt> when the ID does not exist in this graph.
+        */
+        Node nodeFromId(const index_type id)const;
+        /** \brief Get arc descriptor for given node ID \a i (API: LEMON).
+            Return <tt>Arc(lemon::INVALID)</tt> when the ID does not exist in this graph.
+        */
+        Arc  arcFromId(const index_type id)const;
+
+        /** \brief Get a descriptor for the edge connecting vertices \a u and \a v,<br/>or <tt>lemon::INVALID</tt> if no such edge exists (API: LEMON).
+        */
+        Edge findEdge(const Node & a,const Node & b)const;
+        /** \brief Get a descriptor for the arc connecting vertices \a u and \a v,<br/>or <tt>lemon::INVALID</tt> if no such edge exists (API: LEMON).
+        */
+        Arc  findArc(const Node & u,const Node & v)const;
+
+        /** \brief Get the number of edges incident to node \a node.
+        */
+        degree_size_type degree(const Node & node)const{
+            return offsets_[id(node)+1] - offsets_[id(node)];
+        }
+
+        size_t maxDegree()const{
+            size_t md=0;
+            for(NodeIt it(*this);it!=lemon::INVALID;++it){
+                md = std::max(md, size_t( degree(*it) ) );
+            }
+            return md;
+        }
+
+        static const bool is_directed = false;
+
+    private:
+        template<class G,class FILT>
+        friend class detail_csr_graph::IncItemIt;
+
+        template<class G>
+        friend struct detail::NeighborNodeFilter;
+        template<class G>
+        friend struct detail::IncEdgeFilter;
+        template<class G>
+        friend struct detail::BackEdgeFilter;
+        template<class G>
+        friend struct detail::IsOutFilter;
+        template<class G>
+        friend struct detail::IsBackOutFilter;
+        template<class G>
+        friend struct detail::IsInFilter;
+
+        const AdjacencyElement * adjacencyBegin(const Node & node)const{
+            return adjacency_.data() + offsets_[id(node)];
+        }
+        const AdjacencyElement * adjacencyEnd(const Node & node)const{
+            return adjacency_.data() + offsets_[id(node)+1];
+        }
+
+        void buildAdjacency();
+
+        // isNode_[i] is true when i is a valid node id
+        std::vector<bool> isNode_;
+        // u and v of each edge (-1 for unused edge ids)
+        std::vector<EdgeStorage> edges_;
+        // neighbors of node i are adjacency_[offsets_[i]...offsets_[i+1]-1]
+        std::vector<index_type> offsets_;
+        std::vector<AdjacencyElement> adjacency_;
+
+        index_type nodeNum_;
+        index_type edgeNum_;
+    };
+
+
+
+#ifndef DOXYGEN  // doxygen doesn't like out-of-line definitions
+
+    inline CsrGraph::CsrGraph()
+    :   isNode_(),
+        edges_(),
+        offsets_(1, 0),
+        adjacency_(),
+        nodeNum_(0),
+        edgeNum_(0)
+    {}
+
+    inline CsrGraph::CsrGraph(const AdjacencyListGraph & graph)
+    :   isNode_(graph.nodeNum() > 0 ? graph.maxNodeId()+1 : 0, false),
+        edges_(graph.edgeNum() > 0 ? graph.maxEdgeId()+1 : 0, EdgeStorage(-1)),
+        offsets_(),
+        adjacency_(),
+        nodeNum_(graph.nodeNum()),
+        edgeNum_(graph.edgeNum())
+    {
+        for(AdjacencyListGraph::NodeIt n(graph); n!=lemon::INVALID; ++n)
+            isNode_[graph.id(*n)] = true;
+        for(AdjacencyListGraph::EdgeIt e(graph); e!=lemon::INVALID; ++e)
+            edges_[graph.id(*e)] = EdgeStorage(graph.id(graph.u(*e)), graph.id(graph.v(*e)));
+        buildAdjacency();
+    }
+
+    template<class T, class S>
+    inline CsrGraph::CsrGraph(const index_type nodeNum, const MultiArrayView<2,T,S> & uvIds)
+    :   isNode_(nodeNum, true),
+        edges_(uvIds.shape(0)),
+        offsets_(),
+        adjacency_(),
+        nodeNum_(nodeNum),
+        edgeNum_(uvIds.shape(0))
+    {
+        vigra_precondition(uvIds.shape(0) == 0 || uvIds.shape(1) == 2,
+            "CsrGraph(): uvIds must have shape (edgeNum, 2).");
+        for(index_type e=0; e<edgeNum_; ++e){
+            const index_type u = static_cast<index_type>(uvIds(e,0));
+            const index_type v = static_cast<index_type>(uvIds(e,1));
+            vigra_precondition(0 <= u && u < nodeNum && 0 <= v && v < nodeNum,
+                "CsrGraph(): node id out of range.");
+            edges_[e] = EdgeStorage(u, v);
+        }
+        buildAdjacency();
+    }
+
+    inline void
+    CsrGraph::buildAdjacency(){
+        // count the degrees, turn them into offsets and scatter the edges
+        offsets_.assign(isNode_.size()+1, 0);
+        for(size_t e=0; e<edges_.size(); ++e){
+            if(edges_[e][0] == -1)
+                continue;
+            vigra_precondition(edges_[e][0] != edges_[e][1],
+                "CsrGraph(): self-loops are not allowed.");
+            ++offsets_[edges_[e][0]+1];
+            ++offsets_[edges_[e][1]+1];
+        }
+        for(size_t i=1; i<offsets_.size(); ++i)
+            offsets_[i] += offsets_[i-1];
+
+        adjacency_.assign(offsets_.back(), AdjacencyElement(-1, -1));
+        std::vector<index_type> fill(offsets_.begin(), offsets_.end()-1);
+        for(size_t e=0; e<edges_.size(); ++e){
+            const index_type u = edges_[e][0];
+            const index_type v = edges_[e][1];
+            if(u == -1)
+                continue;
+            adjacency_[fill[u]++] = AdjacencyElement(v, e);
+            adjacency_[fill[v]++] = AdjacencyElement(u, e);
+        }
+
+        // sort the neighbors of each node for findEdge()
+        for(size_t i=0; i+1<offsets_.size(); ++i){
+            std::sort(adjacency_.begin()+offsets_[i], adjacency_.begin()+offsets_[i+1]);
+            for(index_type k=offsets_[i]+1; k<offsets_[i+1]; ++k)
+                vigra_precondition(adjacency_[k-1].nodeId() != adjacency_[k].nodeId(),
+                    "CsrGraph(): parallel edges are not allowed.");
+        }
+    }
+
+    inline CsrGraph::Arc
+    CsrGraph::direct(
+        const CsrGraph::Edge & edge,
+        const bool forward
+    )const{
+        if(edge!=lemon::INVALID){
+            if(forward)
+                return Arc(id(edge),id(edge));
+            else
+                return Arc(id(edge)+maxEdgeId()+1,id(edge));
+        }
+        else
+            return Arc(lemon::INVALID);
+    }
+
+    inline CsrGraph::Arc
+    CsrGraph::direct(
+        const CsrGraph::Edge & edge,
+        const CsrGraph::Node & node
+    )const{
+        if(u(edge)==node){
+            return Arc(id(edge),id(edge));
+        }
+        else if(v(edge)==node){
+            return Arc(id(edge)+maxEdgeId()+1,id(edge));
+        }
+        else{
+            return Arc(lemon::INVALID);
+        }
+    }
+
+    inline bool
+    CsrGraph::direction(
+        const CsrGraph::Arc & arc
+    )const{
+        return id(arc)<=maxEdgeId();
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::u(
+        const CsrGraph::Edge & edge
+    )const{
+        return Node(edges_[id(edge)][0]);
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::v(
+        const CsrGraph::Edge & edge
+    )const{
+        return Node(edges_[id(edge)][1]);
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::source(
+        const CsrGraph::Arc & arc
+    )const{
+        if(id(arc) > maxEdgeId())
+            return v(Edge(arc.edgeId()));
+        else
+            return u(Edge(arc.edgeId()));
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::target(
+        const CsrGraph::Arc & arc
+    )const{
+        if(id(arc) > maxEdgeId())
+            return u(Edge(arc.edgeId()));
+        else
+            return v(Edge(arc.edgeId()));
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::oppositeNode(
+        const CsrGraph::Node &n,
+        const CsrGraph::Edge &e
+    ) const {
+        const Node uNode = u(e);
+        const Node vNode = v(e);
+        if(id(uNode)==id(n)){
+            return vNode;
+        }
+        else if(id(vNode)==id(n)){
+            return uNode;
+        }
+        else{
+            return Node(-1);
+        }
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::baseNode(
+        const CsrGraph::IncEdgeIt & iter
+    )const{
+        return u(*iter);
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::baseNode(
+        const CsrGraph::OutArcIt & iter
+    )const{
+        return source(*iter);
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::runningNode(
+        const CsrGraph::IncEdgeIt & iter
+    )const{
+        return v(*iter);
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::runningNode(
+        const CsrGraph::OutArcIt & iter
+    )const{
+        return target(*iter);
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::edgeNum()const{
+        return edgeNum_;
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::nodeNum()const{
+        return nodeNum_;
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::arcNum()const{
+        return edgeNum()*2;
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::maxEdgeId()const{
+        return static_cast<index_type>(edges_.size())-1;
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::maxNodeId()const{
+        return static_cast<index_type>(isNode_.size())-1;
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::maxArcId()const{
+        return maxEdgeId()*2+1;
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::id(
+        const CsrGraph::Node & node
+    )const{
+        return node.id();
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::id(
+        const CsrGraph::Edge & edge
+    )const{
+        return edge.id();
+    }
+
+    inline CsrGraph::index_type
+    CsrGraph::id(
+        const CsrGraph::Arc & arc
+    )const{
+        return arc.id();
+    }
+
+    inline CsrGraph::Edge
+    CsrGraph::edgeFromId(
+        const CsrGraph::index_type id
+    )const{
+        if(id >= 0 && (std::size_t)id < edges_.size() && edges_[id][0] != -1)
+            return Edge(id);
+        else
+            return Edge(lemon::INVALID);
+    }
+
+    inline CsrGraph::Node
+    CsrGraph::nodeFromId(
+        const CsrGraph::index_type id
+    )const{
+        if(id >= 0 && (std::size_t)id < isNode_.size() && isNode_[id])
+            return Node(id);
+        else
+            return Node(lemon::INVALID);
+    }
+
+    inline CsrGraph::Arc
+    CsrGraph::arcFromId(
+        const CsrGraph::index_type id
+    )const{
+        if(id<=maxEdgeId()){
+            if(edgeFromId(id)==lemon::INVALID)
+                return Arc(lemon::INVALID);
+            else
+                return Arc(id,id);
+        }
+        else{
+            const index_type edgeId = id - (maxEdgeId() + 1);
+            if( edgeFromId(edgeId)==lemon::INVALID)
+                return Arc(lemon::INVALID);
+            else
+                return Arc(id,edgeId);
+        }
+    }
+
+    inline CsrGraph::Edge
+    CsrGraph::findEdge(
+        const CsrGraph::Node & a,
+        const CsrGraph::Node & b
+    )const{
+        if(a==b || a==lemon::INVALID || b==lemon::INVALID)
+            return Edge(lemon::INVALID);
+        // search the shorter of the two adjacency ranges
+        const bool searchA = degree(a) <= degree(b);
+        const Node & owner    = searchA ? a : b;
+        const Node & neighbor = searchA ? b : a;
+        const AdjacencyElement * end  = adjacencyEnd(owner);
+        const AdjacencyElement * iter = std::lower_bound(adjacencyBegin(owner), end,
+                                                         AdjacencyElement(id(neighbor), 0));
+        if(iter!=end && iter->nodeId()==id(neighbor))
+            return Edge(iter->edgeId());
+        return Edge(lemon::INVALID);
+    }
+
+    inline CsrGraph::Arc
+    CsrGraph::findArc(
+        const CsrGraph::Node & uNode,
+        const CsrGraph::Node & vNode
+    )const{
+        const Edge e = findEdge(uNode,vNode);
+        if(e==lemon::INVALID){
+            return Arc(lemon::INVALID);
+        }
+        else{
+            if(u(e)==uNode)
+                return direct(e,true) ;
+            else
+                return direct(e,false) ;
+        }
+    }
+
+#endif //DOXYGEN
+
+//@}
+
+} // namespace vigra
+
+#endif /*VIGRA_CSR_GRAPH_HXX*/
@@ -43,6 +43,7 @@
 /*std*/
 #include <algorithm>
 #include <vector>
+#include <iterator>
 #include <functional>
 #include <set>
 #include <iomanip>
@@ -55,6 +56,7 @@
 #include "union_find.hxx"
 #include "adjacency_list_graph.hxx"
 #include "graph_maps.hxx"
+#include "threadpool.hxx"
 
 #include "timing.hxx"
 //#include "openmp_helper.hxx"
@@ -213,6 +215,160 @@ namespace vigra{
         }
     }
 
+    namespace detail_graph_algorithms{
+        // a boundary edge of the input graph, keyed by the (ordered) pair
+        // of region labels it connects
+        template<class EDGE>
+        struct RagEdgeCandidate
+        {
+            typedef AdjacencyListGraph::index_type index_type;
+
+            RagEdgeCandidate(index_type u, index_type v, const EDGE & edge)
+            : u_(u), v_(v), edge_(edge)
+            {}
+
+            bool operator<(const RagEdgeCandidate & other) const{
+                return u_ < other.u_ || (u_ == other.u_ && v_ < other.v_);
+            }
+
+            bool sameRegions(const RagEdgeCandidate & other) const{
+                return u_ == other.u_ && v_ == other.v_;
+            }
+
+            index_type u_, v_;
+            EDGE edge_;
+        };
+    } // namespace detail_graph_algorithms
+
+    /// \brief make a region adjacency graph from a GridGraph and labels in parallel
+    ///
+    /// Same result as the serial version above, except that the edges of \a rag
+    /// are numbered in lexicographic order of their (smaller label, larger label)
+    /// pairs, and <tt>rag.u(e)</tt> is always the region with the smaller label.
+    /// The affiliated edges of each RAG edge are in increasing order of their
+    /// id in \a graphIn.
+    ///
+    /// Instead of calling <tt>rag.addEdge()</tt> and <tt>rag.findEdge()</tt> for
+    /// every edge of \a graphIn, the edge id range is split into one slab per
+    /// thread. Each thread collects the boundary edges of its slab as
+    /// (label u, label v, edge) triples and sorts them. The sorted slabs are
+    /// merged pairwise in parallel, the RAG edges are created in one bulk step
+    /// from the distinct label pairs, and the affiliated edge lists are filled
+    /// in parallel from the runs of equal label pairs.
+    ///
+    /// \param graphIn  : input grid graph
+    /// \param labels   : labels w.r.t. graphIn
+    /// \param[out] rag  : region adjacency graph
+    /// \param[out] affiliatedEdges : a vector of edges of graphIn for each edge in rag
+    /// \param options  : number of threads to use
+    /// \param      ignoreLabel : optional label to ignore (default: -1 means no label will be ignored)
+    ///
+    template<
+        unsigned int DIM,
+        class DTAG,
+        class GRAPH_IN_NODE_LABEL_MAP
+    >
+    void makeRegionAdjacencyGraph(
+        const GridGraph<DIM,DTAG> &   graphIn,
+        GRAPH_IN_NODE_LABEL_MAP       labels,
+        AdjacencyListGraph & rag,
+        typename AdjacencyListGraph:: template EdgeMap< std::vector<typename GridGraph<DIM,DTAG>::Edge> > & affiliatedEdges,
+        ParallelOptions const & options,
+        const Int64   ignoreLabel=-1
+    ){
+        rag=AdjacencyListGraph();
+        typedef typename GraphMapTypeTraits<GRAPH_IN_NODE_LABEL_MAP>::Value LabelType;
+        typedef GridGraph<DIM,DTAG> GraphIn;
+        typedef AdjacencyListGraph GraphOut;
+
+        typedef typename GraphIn::Edge   EdgeGraphIn;
+        typedef typename GraphIn::NodeIt NodeItGraphIn;
+        typedef typename GraphOut::Edge  EdgeGraphOut;
+        typedef typename GraphOut::index_type index_type;
+        typedef detail_graph_algorithms::RagEdgeCandidate<EdgeGraphIn> Candidate;
+        typedef std::vector<Candidate> CandidateVector;
+
+        for(NodeItGraphIn iter(graphIn);iter!=lemon::INVALID;++iter){
+            const LabelType l=labels[*iter];
+            if(ignoreLabel==-1 || static_cast<Int64>(l)!=ignoreLabel)
+                rag.addNode(l);
+        }
+
+        // collect and sort the boundary edges of each slab
+        const std::ptrdiff_t idCount = graphIn.maxEdgeId() + 1;
+        const int nThreads = options.getActualNumThreads();
+        const std::ptrdiff_t slabCount = std::max<std::ptrdiff_t>(1, std::min<std::ptrdiff_t>(nThreads, idCount));
+        const std::ptrdiff_t slabSize  = (idCount + slabCount - 1) / slabCount;
+
+        std::vector<CandidateVector> slabs(slabCount);
+        parallel_foreach(options, slabCount,
+            [&](int /*thread*/, std::ptrdiff_t k)
+            {
+                CandidateVector & slab = slabs[k];
+                const std::ptrdiff_t end = std::min(idCount, (k+1)*slabSize);
+                for(std::ptrdiff_t id = k*slabSize; id < end; ++id){
+                    const EdgeGraphIn edge(graphIn.edgeFromId(id));
+                    if(edge==lemon::INVALID)
+                        continue;
+                    index_type lu = labels[graphIn.u(edge)];
+                    index_type lv = labels[graphIn.v(edge)];
+                    if(  lu!=lv && ( ignoreLabel==-1 || (lu!=ignoreLabel  && lv!=ignoreLabel) )  ){
+                        if(lv < lu)
+                            std::swap(lu, lv);
+                        slab.push_back(Candidate(lu, lv, edge));
+                    }
+                }
+                // stable: equal label pairs stay in edge id order
+                std::stable_sort(slab.begin(), slab.end());
+            });
+
+        // merge neighboring slabs pairwise until a single sorted sequence remains;
+        // std::merge() is stable, so the edge id order is preserved
+        while(slabs.size() > 1){
+            std::vector<CandidateVector> merged((slabs.size() + 1) / 2);
+            parallel_foreach(options, merged.size(),
+                [&](int /*thread*/, std::size_t k)
+                {
+                    if(2*k+1 == slabs.size()){
+                        merged[k].swap(slabs[2*k]);
+                        return;
+                    }
+                    CandidateVector & a = slabs[2*k], & b = slabs[2*k+1];
+                    merged[k].reserve(a.size() + b.size());
+                    std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                               std::back_inserter(merged[k]));
+                    CandidateVector().swap(a);
+                    CandidateVector().swap(b);
+                });
+            slabs.swap(merged);
+        }
+        const CandidateVector & candidates = slabs[0];
+
+        // distinct label pairs become the RAG edges, the runs of equal pairs
+        // their affiliated edges (stored in CSR fashion as run offsets)
+        std::vector<std::pair<index_type, index_type> > ragEdges;
+        std::vector<std::size_t> runStart;
+        for(std::size_t i=0; i<candidates.size(); ++i){
+            if(i==0 || !candidates[i].sameRegions(candidates[i-1])){
+                ragEdges.push_back(std::make_pair(candidates[i].u_, candidates[i].v_));
+                runStart.push_back(i);
+            }
+        }
+        runStart.push_back(candidates.size());
+
+        rag.assignSortedEdges(ragEdges.begin(), ragEdges.end());
+
+        affiliatedEdges.assign(rag);
+        parallel_foreach(options, ragEdges.size(),
+            [&](int /*thread*/, std::size_t e)
+            {
+                std::vector<EdgeGraphIn> & aff = affiliatedEdges[EdgeGraphOut(e)];
+                aff.reserve(runStart[e+1] - runStart[e]);
+                for(std::size_t i=runStart[e]; i<runStart[e+1]; ++i)
+                    aff.push_back(candidates[i].edge_);
+            });
+    }
+
     template<unsigned int DIM, class DTAG, class AFF_EDGES>
     size_t affiliatedEdgesSerializationSize(
         const GridGraph<DIM,DTAG> &,
@@ -74,12 +74,26 @@
 # include <hdf5_hl.h>
 #endif
 
+// direct chunk I/O (H5Dread_chunk(), H5Dwrite_chunk()) is available since HDF5 1.10.3
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && (H5_VERS_MINOR > 10 || \
+                          (H5_VERS_MINOR == 10 && H5_VERS_RELEASE >= 3)))
+# define VIGRA_HDF5_DIRECT_CHUNK_IO
+#endif
+
+// H5Pset_chunk_cache() is available since HDF5 1.8.3
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && (H5_VERS_MINOR > 8 || \
+                          (H5_VERS_MINOR == 8 && H5_VERS_RELEASE >= 3)))
+# define VIGRA_HDF5_CHUNK_CACHE
+#endif
+
 #include "impex.hxx"
 #include "multi_array.hxx"
 #include "multi_iterator_coupled.hxx"
 #include "multi_impex.hxx"
 #include "utilities.hxx"
 #include "error.hxx"
+#include "threadpool.hxx"
+#include "compression.hxx"
 
 #if defined(_MSC_VER)
 #  include <io.h>
@@ -920,9 +934,309 @@ inline hid_t getH5DataType<FFTWComplex<double> >()
 }
 #endif
 
+    // Describes how the raw chunks of a dataset are encoded. 'supported' is
+    // true if VIGRA can encode and decode the chunks itself, i.e. if the stored
+    // type equals the memory type, the bands of a pixel are not split among
+    // several chunks, and the filter pipeline is either empty, 'deflate',
+    // or 'shuffle' followed by 'deflate'.
+struct HDF5ChunkCodec
+{
+    bool supported, shuffle, deflate;
+    int level;
+    unsigned int shuffle_index, deflate_index; // positions in the filter pipeline
+    std::size_t element_size;                  // size of the scalar type
+    ArrayVector<hsize_t> chunks;               // chunk shape in HDF5 axis order
+
+    HDF5ChunkCodec()
+    : supported(false), shuffle(false), deflate(false), level(0),
+      shuffle_index(0), deflate_index(0), element_size(0)
+    {}
+
+        // Determine the method for vigra::compress()/uncompress() for a chunk
+        // with the given filter mask (bit k set means that filter k was
+        // skipped for this chunk). Returns false if VIGRA can't decode the chunk.
+    bool method(unsigned int filterMask, CompressionMethod & res) const
+    {
+        bool useShuffle = shuffle && (filterMask & (1u << shuffle_index)) == 0,
+             useDeflate = deflate && (filterMask & (1u << deflate_index)) == 0;
+        if(!useDeflate)
+        {
+            res = NO_COMPRESSION;
+            return !useShuffle;
+        }
+        res = level <= 0
+                 ? ZLIB_NONE
+                 : level <= 3
+                     ? ZLIB_FAST
+                     : level <= 7
+                         ? ZLIB
+                         : ZLIB_BEST;
+        if(useShuffle)
+            res = CompressionMethod(res | SHUFFLE_FILTER);
+        return true;
+    }
+};
+
+inline HDF5ChunkCodec
+getHDF5ChunkCodec(hid_t dataset, hid_t datatype, int dimensions, int numBandsOfType)
+{
+    HDF5ChunkCodec codec;
+    HDF5Handle properties(H5Dget_create_plist(dataset),
+                          &H5Pclose, "HDF5File: failed to get property list.");
+    if(H5D_CHUNKED != H5Pget_layout(properties))
+        return codec;
+    HDF5Handle filetype(H5Dget_type(dataset),
+                        &H5Tclose, "HDF5File: failed to get data type.");
+    if(H5Tequal(filetype, datatype) <= 0)
+        return codec;
+    codec.chunks.resize(dimensions);
+    if(H5Pget_chunk(properties, dimensions, codec.chunks.data()) != dimensions)
+        return codec;
+    if(numBandsOfType > 1 && codec.chunks[dimensions-1] != static_cast<hsize_t>(numBandsOfType))
+        return codec;
+    int nfilters = H5Pget_nfilters(properties);
+    for(int k=0; k<nfilters; ++k)
+    {
+        unsigned int flags = 0, values[8];
+        size_t nvalues = 8;
+        H5Z_filter_t filter = H5Pget_filter2(properties, k, &flags, &nvalues, values, 0, NULL, NULL);
+        if(filter == H5Z_FILTER_SHUFFLE && !codec.shuffle && !codec.deflate)
+        {
+            codec.shuffle = true;
+            codec.shuffle_index = k;
+        }
+        else if(filter == H5Z_FILTER_DEFLATE && !codec.deflate)
+        {
+            codec.deflate = true;
+            codec.deflate_index = k;
+            codec.level = nvalues > 0 ? static_cast<int>(values[0]) : 6;
+        }
+        else
+        {
+            return codec;
+        }
+    }
+    if(codec.shuffle && !codec.deflate)
+        return codec;
+    codec.element_size = H5Tget_size(datatype);
+    codec.supported = true;
+    return codec;
+}
+
+    // smallest prime >= n (HDF5 recommends a prime number of chunk cache slots)
+inline std::size_t nextPrime(std::size_t n)
+{
+    if(n <= 2)
+        return 2;
+    if(n % 2 == 0)
+        ++n;
+    for(;; n += 2)
+    {
+        std::size_t k = 3;
+        for(; k*k <= n; k += 2)
+            if(n % k == 0)
+                break;
+        if(k*k > n)
+            return n;
+    }
+}
 
 } // namespace detail
 
+/********************************************************/
+/*                                                      */
+/*                HDF5ChunkCacheOptions                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Options for the raw data chunk cache of HDF5 datasets.
+
+    HDF5 keeps recently used chunks of a dataset in uncompressed form in a cache
+    which belongs to the open dataset handle. By default, this cache holds at most
+    1 MB in 521 hash slots. When a chunked dataset is read in slices across its
+    chunks (e.g. z-slices of a 3D volume chunked as 64x64x64), the chunks
+    intersecting a slice usually don't fit into the default cache. Each chunk
+    must then be read and decompressed again for every slice.
+
+    The options can either specify the cache parameters explicitly
+    (see <tt>H5Pset_chunk_cache()</tt>), or describe the access pattern, so that
+    the size is determined automatically from the dataset's shape and chunk shape:
+
+    \code
+    HDF5File file("data.h5", HDF5File::ReadOnly);
+    // the cache shall hold all chunks intersecting a z-slice (axis 2)
+    file.setChunkCache(HDF5ChunkCacheOptions().accessAxis(2));
+
+    HDF5HandleShared dataset = file.getDatasetHandleShared("volume");
+    MultiArray<3, float> slice(Shape3(width, height, 1));
+    for(int z=0; z<depth; ++z)
+        file.readBlock(dataset, Shape3(0, 0, z), slice.shape(), slice);
+    \endcode
+
+    When the cache parameters are not set, HDF5's defaults are used. A cache size
+    of 0 disables the cache, which is advisable when each chunk is accessed as a
+    whole exactly once, or when the application caches the data itself.
+
+    <b>\#include</b> \<vigra/hdf5impex.hxx\><br>
+    Namespace: vigra
+*/
+class HDF5ChunkCacheOptions
+{
+  public:
+    enum { NoAccessAxis = -1, BlockAccess = -2 };
+
+    /** \brief Marker for parameters that use HDF5's default.
+    */
+    static std::size_t useDefault()
+    {
+        return ~std::size_t(0);
+    }
+
+    /** \brief Initialize options with HDF5's defaults.
+    */
+    HDF5ChunkCacheOptions()
+    : nslots(useDefault())
+    , nbytes(useDefault())
+    , w0(-1.0)
+    , access_axis(NoAccessAxis)
+    , max_bytes(std::size_t(256) << 20)
+    {}
+
+    /** \brief Number of hash table slots of the cache.
+
+        Should be a prime number about 100 times the number of chunks that fit into
+        the cache.
+
+        Default: useDefault() (= derived from the cache size if that is set, HDF5's default otherwise)
+    */
+    HDF5ChunkCacheOptions & slots(std::size_t v)
+    {
+        nslots = v;
+        return *this;
+    }
+
+    /** \brief Size of the cache in bytes (0 disables the cache).
+
+        Default: useDefault() (= derived from the access pattern if that is set, HDF5's default otherwise)
+    */
+    HDF5ChunkCacheOptions & bytes(std::size_t v)
+    {
+        nbytes = v;
+        return *this;
+    }
+
+    /** \brief Preemption policy 'w0' between 0.0 and 1.0.
+
+        The larger this value, the earlier are chunks evicted that have been read or
+        written completely.
+
+        Default: -1.0 (= 1.0 if the access pattern is set, HDF5's default 0.75 otherwise)
+    */
+    HDF5ChunkCacheOptions & preemption(double v)
+    {
+        vigra_precondition(v <= 1.0,
+            "HDF5ChunkCacheOptions::preemption(): value must not exceed 1.0.");
+        w0 = v;
+        return *this;
+    }
+
+    /** \brief Size the cache for slice-wise access along the given axis.
+
+        The cache is made large enough to hold all chunks intersecting a slice
+        orthogonal to 'axis', so that every chunk is decompressed only once when
+        consecutive slices are read or written. The axis index refers to the
+        dataset's shape as reported by \ref HDF5File::getDatasetShape(), i.e. for
+        a multi-band dataset, axis 0 is the band axis.
+    */
+    HDF5ChunkCacheOptions & accessAxis(int axis)
+    {
+        vigra_precondition(axis >= 0,
+            "HDF5ChunkCacheOptions::accessAxis(): axis must be non-negative.");
+        access_axis = axis;
+        return *this;
+    }
+
+    /** \brief Size the cache for block-wise access in scan order.
+
+        The cache is made large enough to hold one layer of chunks orthogonal to the
+        last (slowest-varying) axis. Then, chunks shared by neighbouring blocks that
+        are not aligned with the chunk grid are decompressed only once when the
+        blocks are visited in scan order.
+    */
+    HDF5ChunkCacheOptions & blockAccess()
+    {
+        access_axis = BlockAccess;
+        return *this;
+    }
+
+    /** \brief Upper limit for the automatically determined cache size in bytes.
+
+        Default: 256 MB
+    */
+    HDF5ChunkCacheOptions & maxBytes(std::size_t v)
+    {
+        max_bytes = v;
+        return *this;
+    }
+
+    /** \brief True if all parameters are left at HDF5's defaults.
+    */
+    bool isDefault() const
+    {
+        return nslots == useDefault() && nbytes == useDefault() &&
+               w0 < 0.0 && access_axis == NoAccessAxis;
+    }
+
+    /** \brief Determine the cache parameters for a dataset.
+
+        'shape' and 'chunks' are given in HDF5 axis order (i.e. reversed with respect
+        to VIGRA), 'elementSize' is the size of a scalar element in bytes. Results equal
+        to useDefault() (resp. a negative 'resW0') mean that HDF5's default shall be used.
+    */
+    void compute(ArrayVector<hsize_t> const & shape, ArrayVector<hsize_t> const & chunks,
+                 std::size_t elementSize,
+                 std::size_t & resSlots, std::size_t & resBytes, double & resW0) const
+    {
+        int ndim = (int)shape.size();
+        std::size_t chunkBytes = elementSize;
+        for(int k=0; k<ndim; ++k)
+            chunkBytes *= chunks[k];
+
+        resBytes = nbytes;
+        resW0 = w0;
+        if(resBytes == useDefault() && access_axis != NoAccessAxis)
+        {
+            int fixedAxis = access_axis == BlockAccess
+                               ? 0
+                               : ndim - 1 - access_axis;
+            vigra_precondition(fixedAxis >= 0,
+                "HDF5ChunkCacheOptions::compute(): access axis exceeds dataset dimension.");
+            std::size_t chunkCount = 1;
+            for(int k=0; k<ndim; ++k)
+                if(k != fixedAxis)
+                    chunkCount *= (shape[k] + chunks[k] - 1) / chunks[k];
+            resBytes = std::max(chunkBytes, std::min(chunkCount*chunkBytes, std::size_t(max_bytes)));
+            if(resW0 < 0.0)
+                resW0 = 1.0;
+        }
+
+        resSlots = nslots;
+        if(resSlots == useDefault() && resBytes != useDefault() && resBytes > 0)
+        {
+            // about 100 slots per cached chunk, but at most ~10^6 unless
+            // that leaves fewer than 10 slots per chunk
+            std::size_t chunkCount = std::max<std::size_t>(1, resBytes / std::max<std::size_t>(1, chunkBytes));
+            resSlots = detail::nextPrime(std::min(100*chunkCount,
+                                                  std::max<std::size_t>(10*chunkCount, 1000000)));
+        }
+    }
+
+    std::size_t nslots, nbytes;
+    double w0;
+    int access_axis;
+    std::size_t max_bytes;
+};
+
 // helper friend function for callback HDF5_ls_inserter_callback()
 void HDF5_ls_insert(void*, const std::string &);
 // callback function for ls(), called via HDF5File::H5Literate()
@@ -985,6 +1299,9 @@ class HDF5File
 
     bool read_only_;
 
+    // raw data chunk cache of datasets opened or created by this object
+    HDF5ChunkCacheOptions chunk_cache_;
+
     // helper classes for ls() and listAttributes()
     struct ls_closure
     {
@@ -1126,7 +1443,8 @@ class HDF5File
     HDF5File(HDF5File const & other)
     : fileHandle_(other.fileHandle_),
       track_time(other.track_time),
-      read_only_(other.read_only_)
+      read_only_(other.read_only_),
+      chunk_cache_(other.chunk_cache_)
     {
         cGroupHandle_ = HDF5Handle(openCreateGroup_(other.currentGroupName_()), &H5Gclose,
                                    "HDF5File(HDF5File const &): Failed to open group.");
@@ -1157,6 +1475,7 @@ class HDF5File
                                        "HDF5File::operator=(): Failed to open group.");
             track_time = other.track_time;
             read_only_ = other.read_only_;
+            chunk_cache_ = other.chunk_cache_;
         }
         return *this;
     }
@@ -1181,6 +1500,29 @@ class HDF5File
         read_only_ = stat;
     }
 
+        /** \brief Configure the raw data chunk cache of datasets.
+
+            The options apply to all datasets subsequently opened or created by this
+            object and its copies (including \ref ChunkedArrayHDF5 objects constructed
+            from it). See \ref HDF5ChunkCacheOptions for details.
+
+            Note that HDF5 maintains the cache per open dataset handle and discards
+            it when the handle is closed. Since functions like <tt>readBlock(datasetName, ...)</tt>
+            open the dataset anew in every call, repeated partial accesses should go
+            through a handle obtained by getDatasetHandleShared().
+        */
+    void setChunkCache(HDF5ChunkCacheOptions const & options)
+    {
+        chunk_cache_ = options;
+    }
+
+        /** \brief Get the options for the raw data chunk cache of datasets.
+        */
+    HDF5ChunkCacheOptions const & chunkCache() const
+    {
+        return chunk_cache_;
+    }
+
         /** \brief Open or create the given file in the given mode and set the group to "/".
             If another file is currently open, it is first closed.
          */
@@ -1863,6 +2205,72 @@ class HDF5File
                            TypeTraits::getH5DataType(), TypeTraits::numberOfBands());
     }
 
+        /** \brief Write a multi array into a larger volume, compressing the dataset's
+            chunks in parallel.
+
+            Works like the serial writeBlock(), but the dataset's chunks which are
+            completely covered by 'array' are filled and compressed concurrently by
+            the threads of 'options'. The compressed chunks are then stored with
+            <tt>H5Dwrite_chunk()</tt> by the calling thread, because the HDF5
+            library must not be entered concurrently. Partially covered chunks
+            are written via <tt>H5Dwrite()</tt>.
+
+            The parallel path requires HDF5 1.10.3 or later, a dataset whose stored
+            type equals the array's element type, and a filter pipeline of at most
+            'shuffle' and 'deflate' (e.g. created by \ref createDataset() or \ref write()).
+            Otherwise, or when only one thread is requested, the function is
+            equivalent to the serial writeBlock().
+        */
+    template<unsigned int N, class T, class Stride>
+    inline void writeBlock(std::string datasetName,
+                           typename MultiArrayShape<N>::type blockOffset,
+                           const MultiArrayView<N, T, Stride> & array,
+                           ParallelOptions const & options)
+    {
+        // make datasetName clean
+        datasetName = get_absolute_path(datasetName);
+        std::string errorMessage = "HDF5File::writeBlock(): Error opening dataset '" + datasetName + "'.";
+        HDF5HandleShared dataset(getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
+        herr_t status = writeBlock(dataset, blockOffset, array, options);
+        vigra_postcondition(status >= 0,
+            "HDF5File::writeBlock(): write to dataset '" + datasetName + "' failed.");
+    }
+
+    template<unsigned int N, class T, class Stride>
+    inline herr_t writeBlock(HDF5HandleShared dataset,
+                             typename MultiArrayShape<N>::type blockOffset,
+                             const MultiArrayView<N, T, Stride> & array,
+                             ParallelOptions const & options)
+    {
+        typedef detail::HDF5TypeTraits<T> TypeTraits;
+        return writeBlockParallel_(dataset, blockOffset, array,
+                                   TypeTraits::getH5DataType(), TypeTraits::numberOfBands(),
+                                   options);
+    }
+
+        /** \brief Write a multi array into a new chunked dataset, compressing
+            the chunks in parallel.
+
+            The dataset is created by \ref createDataset() with the given 'chunkSize'
+            and 'compression', and filled by the parallel writeBlock().
+        */
+    template<unsigned int N, class T, class Stride>
+    inline void write(std::string datasetName,
+                      const MultiArrayView<N, T, Stride> & array,
+                      typename MultiArrayShape<N>::type chunkSize, int compression,
+                      ParallelOptions const & options)
+    {
+        // make datasetName clean
+        datasetName = get_absolute_path(datasetName);
+
+        HDF5HandleShared dataset(this->template createDataset<N, T>(datasetName, array.shape(),
+                                       typename detail::HDF5TypeTraits<T>::value_type(),
+                                       chunkSize, compression));
+        herr_t status = writeBlock(dataset, typename MultiArrayShape<N>::type(), array, options);
+        vigra_postcondition(status >= 0,
+            "HDF5File::write(): write to dataset '" + datasetName + "' failed.");
+    }
+
     // non-scalar (TinyVector) and unstrided multi arrays
     template<unsigned int N, class T, int SIZE, class Stride>
     inline void write(std::string datasetName,
@@ -2088,6 +2496,82 @@ class HDF5File
                           TypeTraits::getH5DataType(), TypeTraits::numberOfBands());
     }
 
+        /** \brief Read a block of data into a multi array, decompressing the dataset's
+            chunks in parallel.
+
+            Works like the serial readBlock(), but the raw (compressed) chunks
+            intersecting the block are fetched with <tt>H5Dread_chunk()</tt> by the
+            calling thread, because the HDF5 library must not be entered concurrently,
+            while decompression and copying into 'array' are distributed over the threads
+            of 'options'. Chunks which were never written are read via <tt>H5Dread()</tt>,
+            so that they assume the dataset's fill value.
+
+            The parallel path requires HDF5 1.10.3 or later, a dataset whose stored
+            type equals the array's element type, and a filter pipeline of at most
+            'shuffle' and 'deflate' (e.g. created by \ref createDataset() or \ref write()).
+            Otherwise, or when only one thread is requested, the function is
+            equivalent to the serial readBlock().
+        */
+    template<unsigned int N, class T, class Stride>
+    inline void readBlock(std::string datasetName,
+                          typename MultiArrayShape<N>::type blockOffset,
+                          typename MultiArrayShape<N>::type blockShape,
+                          MultiArrayView<N, T, Stride> array,
+                          ParallelOptions const & options)
+    {
+        // make datasetName clean
+        datasetName = get_absolute_path(datasetName);
+        std::string errorMessage ("HDF5File::readBlock(): Unable to open dataset '" + datasetName + "'.");
+        HDF5HandleShared dataset(getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
+        herr_t status = readBlock(dataset, blockOffset, blockShape, array, options);
+        vigra_postcondition(status >= 0,
+            "HDF5File::readBlock(): read from dataset '" + datasetName + "' failed.");
+    }
+
+    template<unsigned int N, class T, class Stride>
+    inline herr_t readBlock(HDF5HandleShared dataset,
+                            typename MultiArrayShape<N>::type blockOffset,
+                            typename MultiArrayShape<N>::type blockShape,
+                            MultiArrayView<N, T, Stride> array,
+                            ParallelOptions const & options)
+    {
+        typedef detail::HDF5TypeTraits<T> TypeTraits;
+        return readBlockParallel_(dataset, blockOffset, blockShape, array,
+                                  TypeTraits::getH5DataType(), TypeTraits::numberOfBands(),
+                                  options);
+    }
+
+        /** \brief Read an entire dataset into a multi array, decompressing the
+            chunks in parallel.
+
+            The array must have the dataset's shape. See the parallel readBlock()
+            for details and requirements.
+        */
+    template<unsigned int N, class T, class Stride>
+    inline void read(std::string datasetName, MultiArrayView<N, T, Stride> array,
+                     ParallelOptions const & options)
+    {
+        typedef detail::HDF5TypeTraits<T> TypeTraits;
+
+        // make datasetName clean
+        datasetName = get_absolute_path(datasetName);
+
+        ArrayVector<hsize_t> dimshape = getDatasetShape(datasetName);
+        int offset = TypeTraits::numberOfBands() > 1
+                        ? 1
+                        : 0;
+        vigra_precondition(MultiArrayIndex(N + offset) == MultiArrayIndex(dimshape.size()),
+            "HDF5File::read(): Array dimension disagrees with dataset dimension.");
+
+        typename MultiArrayShape<N>::type shape;
+        for(int k=offset; k < (int)dimshape.size(); ++k)
+            shape[k-offset] = (MultiArrayIndex)dimshape[k];
+        vigra_precondition(shape == array.shape(),
+                           "HDF5File::read(): Array shape disagrees with dataset shape.");
+
+        readBlock(datasetName, typename MultiArrayShape<N>::type(), shape, array, options);
+    }
+
     // non-scalar (TinyVector) and unstrided target MultiArrayView
     template<unsigned int N, class T, int SIZE, class Stride>
     inline void read(std::string datasetName, MultiArrayView<N, TinyVector<T, SIZE>, Stride> array)
@@ -2545,7 +3029,67 @@ class HDF5File
         // Open parent group
         HDF5Handle groupHandle(openGroup_(groupname), &H5Gclose, "HDF5File::getDatasetHandle_(): Internal error");
 
-        return H5Dopen(groupHandle, setname.c_str(), H5P_DEFAULT);
+        hid_t datasetHandle = H5Dopen(groupHandle, setname.c_str(), H5P_DEFAULT);
+        if(datasetHandle < 0 || chunk_cache_.isDefault())
+            return datasetHandle;
+
+        // the chunk cache must be configured when the dataset is opened,
+        // but its size depends on the dataset's properties => open again
+        hid_t properties = H5P_DEFAULT;
+        {
+            HDF5Handle dataset(datasetHandle, &H5Dclose, "HDF5File::getDatasetHandle_(): Internal error");
+            HDF5Handle plist(H5Dget_create_plist(dataset), &H5Pclose,
+                             "HDF5File::getDatasetHandle_(): failed to get property list.");
+            if(H5D_CHUNKED != H5Pget_layout(plist))
+                return dataset.release();
+            ArrayVector<hsize_t> shape(getDatasetDimensions_(dataset)), chunks(shape.size());
+            HDF5Handle dataspace(H5Dget_space(dataset), &H5Sclose,
+                                 "HDF5File::getDatasetHandle_(): unable to get dataspace.");
+            H5Sget_simple_extent_dims(dataspace, shape.data(), NULL);
+            H5Pget_chunk(plist, (int)chunks.size(), chunks.data());
+            HDF5Handle datatype(H5Dget_type(dataset), &H5Tclose,
+                                "HDF5File::getDatasetHandle_(): failed to get data type.");
+            properties = createDatasetAccessProperties_(shape, chunks, H5Tget_size(datatype));
+        }
+        HDF5Handle dapl(properties, &H5Pclose, "HDF5File::getDatasetHandle_(): failed to create property list.");
+        return H5Dopen(groupHandle, setname.c_str(), dapl);
+    }
+
+        /* create a dataset access property list implementing the chunk cache
+           options for a dataset with the given shape and chunk shape (both in
+           HDF5 order), or return H5P_DEFAULT if the defaults apply
+         */
+    hid_t createDatasetAccessProperties_(ArrayVector<hsize_t> const & shape,
+                                         ArrayVector<hsize_t> const & chunks,
+                                         std::size_t elementSize) const
+    {
+#ifdef VIGRA_HDF5_CHUNK_CACHE
+        if(chunk_cache_.isDefault() || chunks.size() == 0)
+            return H5P_DEFAULT;
+
+        std::size_t nslots, nbytes;
+        double w0;
+        chunk_cache_.compute(shape, chunks, elementSize, nslots, nbytes, w0);
+
+        hid_t properties = H5Pcreate(H5P_DATASET_ACCESS);
+        if(properties >= 0 &&
+           H5Pset_chunk_cache(properties,
+                              nslots != HDF5ChunkCacheOptions::useDefault()
+                                  ? nslots
+                                  : H5D_CHUNK_CACHE_NSLOTS_DEFAULT,
+                              nbytes != HDF5ChunkCacheOptions::useDefault()
+                                  ? nbytes
+                                  : H5D_CHUNK_CACHE_NBYTES_DEFAULT,
+                              w0 >= 0.0  ? w0     : H5D_CHUNK_CACHE_W0_DEFAULT) < 0)
+        {
+            H5Pclose(properties);
+            return -1;
+        }
+        return properties;
+#else
+        ignore_argument(shape, chunks, elementSize);
+        return H5P_DEFAULT;
+#endif
     }
 
         /* get the type of an object specified by a string
@@ -2752,6 +3296,25 @@ class HDF5File
                       typename MultiArrayShape<N>::type &blockShape,
                       MultiArrayView<N, T, Stride> array,
                       const hid_t datatype, const int numBandsOfType);
+
+        /* parallel versions of readBlock_() and writeBlock_() using direct chunk I/O.
+           They fall back to the serial functions when the dataset's chunks can't be
+           processed by VIGRA (see detail::HDF5ChunkCodec).
+        */
+    template<unsigned int N, class T, class Stride>
+    herr_t readBlockParallel_(HDF5HandleShared dataset,
+                              typename MultiArrayShape<N>::type blockOffset,
+                              typename MultiArrayShape<N>::type blockShape,
+                              MultiArrayView<N, T, Stride> array,
+                              const hid_t datatype, const int numBandsOfType,
+                              ParallelOptions const & options);
+
+    template<unsigned int N, class T, class Stride>
+    herr_t writeBlockParallel_(HDF5HandleShared dataset,
+                               typename MultiArrayShape<N>::type blockOffset,
+                               const MultiArrayView<N, T, Stride> & array,
+                               const hid_t datatype, const int numBandsOfType,
+                               ParallelOptions const & options);
 };  /* class HDF5File */
 
 /********************************************************************/
@@ -2820,10 +3383,15 @@ HDF5File::createDataset(std::string datasetName,
         H5Pset_deflate(plist, compressionParameter);
     }
 
+    // configure the chunk cache
+    HDF5Handle dapl(createDatasetAccessProperties_(shape_inv, chunks,
+                                                   H5Tget_size(TypeTraits::getH5DataType())),
+                    &H5Pclose, "HDF5File::createDataset(): unable to create property list.");
+
     //create the dataset.
     HDF5HandleShared datasetHandle(H5Dcreate(parent, setname.c_str(),
                                              TypeTraits::getH5DataType(),
-                                             dataspaceHandle, H5P_DEFAULT, plist, H5P_DEFAULT),
+                                             dataspaceHandle, H5P_DEFAULT, plist, dapl),
                                    &H5Dclose,
                                    "HDF5File::createDataset(): unable to create dataset.");
     if(parent != cGroupHandle_)
@@ -3301,6 +3869,239 @@ herr_t HDF5File::readBlock_(HDF5HandleShared datasetHandle,
 
 /********************************************************************/
 
+template<unsigned int N, class T, class Stride>
+herr_t HDF5File::readBlockParallel_(HDF5HandleShared datasetHandle,
+                                    typename MultiArrayShape<N>::type blockOffset,
+                                    typename MultiArrayShape<N>::type blockShape,
+                                    MultiArrayView<N, T, Stride> array,
+                                    const hid_t datatype, const int numBandsOfType,
+                                    ParallelOptions const & options)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    vigra_precondition(blockShape == array.shape(),
+         "HDF5File::readBlock(): Array shape disagrees with block size.");
+
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+    int offset = numBandsOfType > 1
+                    ? 1
+                    : 0;
+    vigra_precondition(N + offset == getDatasetDimensions_(datasetHandle),
+        "HDF5File::readBlock(): Array dimension disagrees with data dimension.");
+
+    detail::HDF5ChunkCodec codec(detail::getHDF5ChunkCodec(datasetHandle, datatype,
+                                                           N + offset, numBandsOfType));
+    if(codec.supported && options.getActualNumThreads() > 1)
+    {
+        Shape chunkShape, blockStop(blockOffset + blockShape);
+        for(unsigned int k=0; k<N; ++k)
+            chunkShape[k] = static_cast<MultiArrayIndex>(codec.chunks[N-1-k]);
+        std::size_t chunkBytes = prod(chunkShape)*sizeof(T);
+
+        ArrayVector<Shape> chunks;
+        MultiCoordinateIterator<N> chunkIter(blockOffset / chunkShape,
+                                             (blockStop + chunkShape - Shape(1)) / chunkShape),
+                                   chunkEnd(chunkIter.getEndIterator());
+        for(; chunkIter != chunkEnd; ++chunkIter)
+            chunks.push_back(*chunkIter * chunkShape);
+
+        // process the chunks in batches to bound the memory for raw chunk buffers
+        std::size_t batchSize = 4*options.getActualNumThreads();
+        std::vector<ArrayVector<char> > raw(batchSize), decoded(batchSize);
+        ArrayVector<unsigned int> filterMasks(batchSize);
+        ArrayVector<char> direct(batchSize);
+        ArrayVector<hsize_t> fileOffset(N + offset, 0);
+
+        herr_t status = 0;
+        for(std::size_t begin = 0; begin < chunks.size() && status >= 0; begin += batchSize)
+        {
+            std::size_t count = std::min(batchSize, chunks.size() - begin);
+
+            // fetch the raw chunks (the HDF5 library is only called from this thread)
+            for(std::size_t k=0; k<count; ++k)
+            {
+                direct[k] = 0;
+                for(unsigned int d=0; d<N; ++d)
+                    fileOffset[N-1-d] = chunks[begin+k][d];
+                hsize_t storageSize = 0;
+                if(H5Dget_chunk_storage_size(datasetHandle, fileOffset.data(), &storageSize) < 0 ||
+                   storageSize == 0)
+                    continue; // unallocated chunk => H5Dread() below provides the fill value
+                raw[k].resize(storageSize);
+                uint32_t filterMask = 0;
+                if(H5Dread_chunk(datasetHandle, H5P_DEFAULT, fileOffset.data(),
+                                 &filterMask, raw[k].data()) < 0)
+                    continue;
+                filterMasks[k] = filterMask;
+                direct[k] = 1;
+            }
+
+            // decompress and scatter in parallel
+            parallel_foreach(options, count,
+                [&](int, std::size_t k)
+                {
+                    CompressionMethod method;
+                    if(!direct[k] || !codec.method(filterMasks[k], method))
+                    {
+                        direct[k] = 0;
+                        return;
+                    }
+                    char * data = raw[k].data();
+                    if(method != NO_COMPRESSION)
+                    {
+                        decoded[k].resize(chunkBytes);
+                        ::vigra::uncompress(raw[k].data(), raw[k].size(),
+                                            decoded[k].data(), chunkBytes,
+                                            method, codec.element_size);
+                        data = decoded[k].data();
+                    }
+                    else if(raw[k].size() != chunkBytes)
+                    {
+                        direct[k] = 0;
+                        return;
+                    }
+                    Shape chunkStart(chunks[begin+k]),
+                          start(max(chunkStart, blockOffset)),
+                          stop(min(chunkStart + chunkShape, blockStop));
+                    MultiArrayView<N, T> chunk(chunkShape, reinterpret_cast<T *>(data));
+                    array.subarray(start - blockOffset, stop - blockOffset) =
+                        chunk.subarray(start - chunkStart, stop - chunkStart);
+                });
+
+            // read the remaining chunks via the HDF5 library
+            for(std::size_t k=0; k<count && status >= 0; ++k)
+            {
+                if(direct[k])
+                    continue;
+                Shape chunkStart(chunks[begin+k]),
+                      start(max(chunkStart, blockOffset)),
+                      stop(min(chunkStart + chunkShape, blockStop)),
+                      shape(stop - start);
+                status = readBlock_(datasetHandle, start, shape,
+                                    array.subarray(start - blockOffset, stop - blockOffset),
+                                    datatype, numBandsOfType);
+            }
+        }
+        return status;
+    }
+#else
+    ignore_argument(options);
+#endif
+    return readBlock_(datasetHandle, blockOffset, blockShape, array, datatype, numBandsOfType);
+}
+
+/********************************************************************/
+
+template<unsigned int N, class T, class Stride>
+herr_t HDF5File::writeBlockParallel_(HDF5HandleShared datasetHandle,
+                                     typename MultiArrayShape<N>::type blockOffset,
+                                     const MultiArrayView<N, T, Stride> & array,
+                                     const hid_t datatype, const int numBandsOfType,
+                                     ParallelOptions const & options)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    vigra_precondition(!isReadOnly(),
+        "HDF5File::writeBlock(): file is read-only.");
+
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+    int offset = numBandsOfType > 1
+                    ? 1
+                    : 0;
+    int dimensions = N + offset;
+    vigra_precondition(dimensions == getDatasetDimensions_(datasetHandle),
+        "HDF5File::writeBlock(): Array dimension disagrees with data dimension.");
+
+    detail::HDF5ChunkCodec codec(detail::getHDF5ChunkCodec(datasetHandle, datatype,
+                                                           dimensions, numBandsOfType));
+    CompressionMethod method;
+    if(codec.supported && codec.method(0, method) && options.getActualNumThreads() > 1)
+    {
+        ArrayVector<hsize_t> fileShape(dimensions);
+        HDF5Handle dataspace(H5Dget_space(datasetHandle), &H5Sclose,
+                             "HDF5File::writeBlock(): unable to get dataspace.");
+        H5Sget_simple_extent_dims(dataspace, fileShape.data(), NULL);
+
+        Shape chunkShape, datasetShape, blockStop(blockOffset + array.shape());
+        for(unsigned int k=0; k<N; ++k)
+        {
+            chunkShape[k] = static_cast<MultiArrayIndex>(codec.chunks[N-1-k]);
+            datasetShape[k] = static_cast<MultiArrayIndex>(fileShape[N-1-k]);
+        }
+        std::size_t chunkBytes = prod(chunkShape)*sizeof(T);
+
+        ArrayVector<Shape> chunks;
+        MultiCoordinateIterator<N> chunkIter(blockOffset / chunkShape,
+                                             (blockStop + chunkShape - Shape(1)) / chunkShape),
+                                   chunkEnd(chunkIter.getEndIterator());
+        for(; chunkIter != chunkEnd; ++chunkIter)
+            chunks.push_back(*chunkIter * chunkShape);
+
+        std::size_t batchSize = 4*options.getActualNumThreads();
+        std::vector<ArrayVector<char> > raw(batchSize), buffers(batchSize);
+        ArrayVector<char> direct(batchSize);
+        ArrayVector<hsize_t> fileOffset(dimensions, 0);
+
+        herr_t status = 0;
+        for(std::size_t begin = 0; begin < chunks.size() && status >= 0; begin += batchSize)
+        {
+            std::size_t count = std::min(batchSize, chunks.size() - begin);
+
+            // gather and compress the completely covered chunks in parallel
+            parallel_foreach(options, count,
+                [&](int, std::size_t k)
+                {
+                    Shape chunkStart(chunks[begin+k]),
+                          start(max(chunkStart, blockOffset)),
+                          stop(min(chunkStart + chunkShape, blockStop));
+                    direct[k] = (start == chunkStart &&
+                                 stop == min(chunkStart + chunkShape, datasetShape));
+                    if(!direct[k])
+                        return;
+                    // chunks at the dataset border are stored with full size,
+                    // zero the part outside the dataset
+                    ArrayVector<char>(chunkBytes, 0).swap(buffers[k]);
+                    MultiArrayView<N, T> chunk(chunkShape, reinterpret_cast<T *>(buffers[k].data()));
+                    chunk.subarray(Shape(), stop - start) =
+                        array.subarray(start - blockOffset, stop - blockOffset);
+                    if(method == NO_COMPRESSION)
+                        raw[k].swap(buffers[k]);
+                    else
+                        ::vigra::compress(buffers[k].data(), chunkBytes, raw[k],
+                                          method, codec.element_size);
+                });
+
+            // store the chunks (the HDF5 library is only called from this thread)
+            for(std::size_t k=0; k<count && status >= 0; ++k)
+            {
+                Shape chunkStart(chunks[begin+k]),
+                      start(max(chunkStart, blockOffset)),
+                      stop(min(chunkStart + chunkShape, blockStop));
+                if(direct[k])
+                {
+                    for(unsigned int d=0; d<N; ++d)
+                        fileOffset[N-1-d] = chunkStart[d];
+                    status = H5Dwrite_chunk(datasetHandle, H5P_DEFAULT, 0, fileOffset.data(),
+                                            raw[k].size(), raw[k].data());
+                }
+                else
+                {
+                    status = writeBlock_(datasetHandle, start,
+                                         array.subarray(start - blockOffset, stop - blockOffset),
+                                         datatype, numBandsOfType);
+                }
+            }
+        }
+        return status;
+    }
+#else
+    ignore_argument(options);
+#endif
+    return writeBlock_(datasetHandle, blockOffset, array, datatype, numBandsOfType);
+}
+
+/********************************************************************/
+
 template<unsigned int N, class T, class Stride>
 void HDF5File::read_attribute_(std::string datasetName,
                                std::string attributeName,
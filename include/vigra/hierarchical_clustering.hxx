@@ -62,7 +62,8 @@ template<
         class EDGE_INDICATOR_MAP,
         class EDGE_SIZE_MAP,
         class NODE_SIZE_MAP,
-        class MIN_WEIGHT_MAP
+        class MIN_WEIGHT_MAP,
+        class PRIORITY_QUEUE = ChangeablePriorityQueue<typename EDGE_INDICATOR_MAP::Value>
     >
 class EdgeWeightedUcm
 {
@@ -71,7 +72,8 @@ class EdgeWeightedUcm
         EDGE_INDICATOR_MAP,
         EDGE_SIZE_MAP,
         NODE_SIZE_MAP,
-        MIN_WEIGHT_MAP
+        MIN_WEIGHT_MAP,
+        PRIORITY_QUEUE
     > SelfType;
 
   public:
@@ -280,7 +282,7 @@ class EdgeWeightedUcm
     EDGE_SIZE_MAP edgeSizeMap_;
     NODE_SIZE_MAP nodeSizeMap_;
     MIN_WEIGHT_MAP minWeightEdgeMap_;
-    vigra::ChangeablePriorityQueue< ValueType > pq_;
+    PRIORITY_QUEUE pq_;
     ValueType wardness_;;
 };
     /// \brief  This Cluster Operator is a MONSTER.
@@ -319,7 +321,8 @@ class EdgeWeightedUcm
         class NODE_FEATURE_MAP,
         class NODE_SIZE_MAP,
         class MIN_WEIGHT_MAP,
-        class NODE_LABEL_MAP
+        class NODE_LABEL_MAP,
+        class PRIORITY_QUEUE = ChangeablePriorityQueue<typename EDGE_INDICATOR_MAP::Value>
     >
     class EdgeWeightNodeFeatures{
 
@@ -330,7 +333,8 @@ class EdgeWeightedUcm
             NODE_FEATURE_MAP,
             NODE_SIZE_MAP,
             MIN_WEIGHT_MAP,
-            NODE_LABEL_MAP
+            NODE_LABEL_MAP,
+            PRIORITY_QUEUE
         > SelfType;
     public:
 
@@ -619,7 +623,7 @@ class EdgeWeightedUcm
         NODE_SIZE_MAP nodeSizeMap_;
         MIN_WEIGHT_MAP minWeightEdgeMap_;
         NODE_LABEL_MAP nodeLabelMap_;
-        vigra::ChangeablePriorityQueue< ValueType > pq_;
+        PRIORITY_QUEUE pq_;
         ValueType beta_;
         ValueType wardness_;
         ValueType gamma_;
@@ -658,6 +662,8 @@ class ClusteringOptions
     , nodeFeatureMetric_(metrics::ManhattanMetric)
     , buildMergeTreeEncoding_(buildMergeTree)
     , verbose_(verbose)
+    , lazyPriorityUpdates_(false)
+    , smallToLargeMerging_(false)
     {}
 
         /** Stop merging when the number of clusters reaches this threshold.
@@ -741,6 +747,40 @@ class ClusteringOptions
         return *this;
     }
 
+        /** Update edge priorities lazily.
+
+            When true, \ref hierarchicalClustering() uses a \ref vigra::LazyPriorityQueue
+            instead of a \ref vigra::ChangeablePriorityQueue: outdated priorities remain
+            in the queue and are discarded when they reach the top. This is faster
+            when many edge weights change per merge step. The result is the same
+            unless different edges have identical weights.
+
+            Default: false
+        */
+    ClusteringOptions & lazyPriorityUpdates(bool val=true)
+    {
+        lazyPriorityUpdates_ = val;
+        return *this;
+    }
+
+        /** Merge the adjacency of the smaller node into the larger one.
+
+            When true, each contraction keeps the node with more neighbors as
+            representative (see \ref vigra::MergeGraphAdaptor::setSmallToLargeMerging()).
+            The adjacency of the smaller node is then merged into that of the
+            larger node in one linear pass rather than by one sorted insertion
+            per neighbor, which helps on graphs with high-degree nodes.
+            The partition is the same, but the representative
+            node ids (and thus the cluster ids in the label map) may differ.
+
+            Default: false
+        */
+    ClusteringOptions & smallToLargeMerging(bool val=true)
+    {
+        smallToLargeMerging_ = val;
+        return *this;
+    }
+
     size_t nodeNumStopCond_;
     double maxMergeWeight_;
     double nodeFeatureImportance_;
@@ -748,6 +788,8 @@ class ClusteringOptions
     metrics::MetricType nodeFeatureMetric_;
     bool   buildMergeTreeEncoding_;
     bool   verbose_;
+    bool   lazyPriorityUpdates_;
+    bool   smallToLargeMerging_;
 };
 
 // \brief  do hierarchical clustering with a given cluster operator
@@ -799,6 +841,9 @@ class HierarchicalClusteringImpl
         timeStampIndexToMergeIndex_(),
         mergeTreeEndcoding_()
     {
+        if(param_.smallToLargeMerging_){
+            mergeGraph_.setSmallToLargeMerging(true);
+        }
         if(param_.buildMergeTreeEncoding_){
             // this can be be made smater since user can pass
             // stoping condition based on nodeNum
@@ -943,6 +988,68 @@ private:
 };
 
 
+namespace detail_hierarchical_clustering {
+
+template <class PRIORITY_QUEUE,
+          class GRAPH,
+          class EDGE_WEIGHT_MAP,  class EDGE_LENGTH_MAP,
+          class NODE_FEATURE_MAP, class NOSE_SIZE_MAP,
+          class NODE_LABEL_MAP>
+void
+hierarchicalClusteringImpl(GRAPH const & graph,
+                           EDGE_WEIGHT_MAP const & edgeWeights, EDGE_LENGTH_MAP const & edgeLengths,
+                           NODE_FEATURE_MAP const & nodeFeatures, NOSE_SIZE_MAP const & nodeSizes,
+                           NODE_LABEL_MAP & labelMap,
+                           ClusteringOptions const & options)
+{
+    typedef typename NODE_LABEL_MAP::Value LabelType;
+    typedef MergeGraphAdaptor<GRAPH> MergeGraph;
+    typedef typename GRAPH::template EdgeMap<float>     EdgeUltrametric;
+    typedef typename GRAPH::template NodeMap<LabelType> NodeSeeds;
+
+    MergeGraph mergeGraph(graph);
+
+    // create property maps to store the computed ultrametric and
+    // to provide optional cannot-link constraints;
+    // we don't use these options here and therefore leave the maps empty
+    EdgeUltrametric edgeUltrametric(graph);
+    NodeSeeds nodeSeeds(graph);
+
+    // create an operator that stores all property maps needed for
+    // hierarchical clustering and updates them after every merge step
+    typedef cluster_operators::EdgeWeightNodeFeatures<
+        MergeGraph,
+        EDGE_WEIGHT_MAP,
+        EDGE_LENGTH_MAP,
+        NODE_FEATURE_MAP,
+        NOSE_SIZE_MAP,
+        EdgeUltrametric,
+        NodeSeeds,
+        PRIORITY_QUEUE>
+    MergeOperator;
+
+    MergeOperator mergeOperator(mergeGraph,
+                                edgeWeights, edgeLengths,
+                                nodeFeatures, nodeSizes,
+                                edgeUltrametric, nodeSeeds,
+                                options.nodeFeatureImportance_,
+                                options.nodeFeatureMetric_,
+                                options.sizeImportance_,
+                                options.maxMergeWeight_);
+
+    typedef HierarchicalClusteringImpl<MergeOperator> Clustering;
+
+    Clustering clustering(mergeOperator, options);
+    clustering.cluster();
+
+    for(typename GRAPH::NodeIt node(graph); node != lemon::INVALID; ++node)
+    {
+        labelMap[*node] = mergeGraph.reprNodeId(graph.id(*node));
+    }
+}
+
+} // namespace detail_hierarchical_clustering
+
 /********************************************************/
 /*                                                      */
 /*                hierarchicalClustering                */
@@ -1030,6 +1137,10 @@ private:
     and \ref vigra::ClusteringOptions::maxMergeDistance() to stop at a particular number of
     clusters or a particular cluster distance respectively.
 
+    On large graphs, \ref vigra::ClusteringOptions::lazyPriorityUpdates() and
+    \ref vigra::ClusteringOptions::smallToLargeMerging() reduce the cost of the
+    priority queue and adjacency updates after each merge step.
+
     <b> Usage:</b>
 
     <b>\#include</b> \<vigra/hierarchical_clustering.hxx\><br>
@@ -1050,49 +1161,14 @@ hierarchicalClustering(GRAPH const & graph,
                        NODE_LABEL_MAP & labelMap,
                        ClusteringOptions options = ClusteringOptions())
 {
-    typedef typename NODE_LABEL_MAP::Value LabelType;
-    typedef MergeGraphAdaptor<GRAPH> MergeGraph;
-    typedef typename GRAPH::template EdgeMap<float>     EdgeUltrametric;
-    typedef typename GRAPH::template NodeMap<LabelType> NodeSeeds;
-
-    MergeGraph mergeGraph(graph);
-
-    // create property maps to store the computed ultrametric and
-    // to provide optional cannot-link constraints;
-    // we don't use these options here and therefore leave the maps empty
-    EdgeUltrametric edgeUltrametric(graph);
-    NodeSeeds nodeSeeds(graph);
-
-    // create an operator that stores all property maps needed for
-    // hierarchical clustering and updates them after every merge step
-    typedef cluster_operators::EdgeWeightNodeFeatures<
-        MergeGraph,
-        EDGE_WEIGHT_MAP,
-        EDGE_LENGTH_MAP,
-        NODE_FEATURE_MAP,
-        NOSE_SIZE_MAP,
-        EdgeUltrametric,
-        NodeSeeds>
-    MergeOperator;
-
-    MergeOperator mergeOperator(mergeGraph,
-                                edgeWeights, edgeLengths,
-                                nodeFeatures, nodeSizes,
-                                edgeUltrametric, nodeSeeds,
-                                options.nodeFeatureImportance_,
-                                options.nodeFeatureMetric_,
-                                options.sizeImportance_,
-                                options.maxMergeWeight_);
-
-    typedef HierarchicalClusteringImpl<MergeOperator> Clustering;
-
-    Clustering clustering(mergeOperator, options);
-    clustering.cluster();
-
-    for(typename GRAPH::NodeIt node(graph); node != lemon::INVALID; ++node)
-    {
-        labelMap[*node] = mergeGraph.reprNodeId(graph.id(*node));
-    }
+    typedef typename EDGE_WEIGHT_MAP::Value WeightType;
+
+    if(options.lazyPriorityUpdates_)
+        detail_hierarchical_clustering::hierarchicalClusteringImpl<LazyPriorityQueue<WeightType> >(
+            graph, edgeWeights, edgeLengths, nodeFeatures, nodeSizes, labelMap, options);
+    else
+        detail_hierarchical_clustering::hierarchicalClusteringImpl<ChangeablePriorityQueue<WeightType> >(
+            graph, edgeWeights, edgeLengths, nodeFeatures, nodeSizes, labelMap, options);
 }
 
 //@}
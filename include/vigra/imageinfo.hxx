@@ -361,12 +361,39 @@ class ImageExportInfo
          **/
     VIGRA_EXPORT ImageExportInfo & setICCProfile(const ICCProfile & profile);
 
+        /** Store the image in tiles of the given size instead of strips.
+
+            Currently only supported by TIFF files (tile width and height are
+            rounded up to multiples of 16, as required by the TIFF specification).
+            Tiles are compressed independently, so that readers can decode
+            regions of interest efficiently (see \ref importImageBlock()).
+            Default: <tt>Size2D(0,0)</tt> (don't use tiles).
+         **/
+    VIGRA_EXPORT ImageExportInfo & setTileSize(const Size2D & size);
+
+        /** Get the tile size set by setTileSize().
+         **/
+    VIGRA_EXPORT Size2D getTileSize() const;
+
+        /** Set the number of threads used to compress tiles or strips concurrently,
+            with the semantics of <tt>ParallelOptions::numThreads()</tt>.
+
+            Currently only supported by TIFF files with "DEFLATE" compression.
+            Default: <tt>ParallelOptions::Auto</tt>
+         **/
+    VIGRA_EXPORT ImageExportInfo & setNumThreads(int n);
+
+        /** Get the number of threads set by setNumThreads().
+         **/
+    VIGRA_EXPORT int getNumThreads() const;
+
   private:
     std::string m_filename, m_filetype, m_pixeltype, m_comp, m_mode;
     float m_x_res, m_y_res;
     Diff2D m_pos;
     ICCProfile m_icc_profile;
-    Size2D m_canvas_size;
+    Size2D m_canvas_size, m_tile_size;
+    int m_num_threads;
     double fromMin_, fromMax_, toMin_, toMax_;
 };
 
@@ -463,6 +490,17 @@ class ImageImportInfo
          **/
     VIGRA_EXPORT int getImageIndex() const;
 
+        /** Set the number of threads used to decode tiles or strips concurrently,
+            with the semantics of <tt>ParallelOptions::numThreads()</tt>.
+
+            Currently only supported by TIFF files. Default: <tt>ParallelOptions::Auto</tt>
+         **/
+    VIGRA_EXPORT void setNumThreads(int n);
+
+        /** Get the number of threads set by setNumThreads().
+         **/
+    VIGRA_EXPORT int getNumThreads() const;
+
         /** Get size of the image.
          **/
     VIGRA_EXPORT Size2D size() const;
@@ -550,7 +588,8 @@ class ImageImportInfo
 
   private:
     std::string m_filename, m_filetype, m_pixeltype;
-    int m_width, m_height, m_num_bands, m_num_extra_bands, m_num_images, m_image_index;
+    int m_width, m_height, m_num_bands, m_num_extra_bands, m_num_images, m_image_index,
+        m_num_threads;
     float m_x_res, m_y_res;
     Diff2D m_pos;
     Size2D m_canvas_size;
@@ -277,6 +277,195 @@ namespace vigra
             decoder->close();
         }
 
+
+        // element type and number of bands of pixel types that
+        // importImageDirectly() and exportImageDirectly() can handle
+        template <class T>
+        struct ImportElementTraits
+        {
+            typedef T element_type;
+            enum { size = 1 };
+        };
+
+        template <class T, int SIZE>
+        struct ImportElementTraits<TinyVector<T, SIZE> >
+        {
+            typedef T element_type;
+            enum { size = SIZE };
+        };
+
+        template <class T>
+        struct ImportElementTraits<RGBValue<T> >
+        {
+            typedef T element_type;
+            enum { size = 3 };
+        };
+
+
+        // Decode the image (or the block starting at 'block_offset') with a single
+        // call to Decoder::decodeImage() resp. Decoder::decodeRegion(), provided
+        // that the file's pixel type equals the array's element type and no band
+        // replication is needed. Otherwise, nothing is read and false is returned.
+        template <class T, class S>
+        bool
+        importImageDirectly(const ImageImportInfo& import_info, MultiArrayView<2, T, S> image,
+                            typename MultiArrayShape<2>::type const & block_offset =
+                                typename MultiArrayShape<2>::type())
+        {
+            typedef ImportElementTraits<T> Traits;
+            typedef typename Traits::element_type ElementType;
+
+            if (TypeAsString<ElementType>::result() != import_info.getPixelType() ||
+                (Traits::size > 1 && import_info.numBands() != (int)Traits::size))
+                return false;
+
+            VIGRA_UNIQUE_PTR<Decoder> decoder(vigra::decoder(import_info));
+            if (image.shape() == import_info.shape())
+                decoder->decodeImage(image.data(),
+                                     image.stride(0)*sizeof(T), image.stride(1)*sizeof(T),
+                                     sizeof(ElementType), Traits::size);
+            else
+                decoder->decodeRegion(image.data(),
+                                      image.stride(0)*sizeof(T), image.stride(1)*sizeof(T),
+                                      sizeof(ElementType), Traits::size,
+                                      (unsigned)block_offset[0], (unsigned)block_offset[1],
+                                      (unsigned)image.shape(0), (unsigned)image.shape(1));
+            decoder->close();
+            return true;
+        }
+
+
+        template <class ValueType,
+                  class ImageIterator, class ImageAccessor>
+        void
+        copy_image_block(const ValueType* block, unsigned bands, Size2D const & size,
+                         ImageIterator image_iterator, ImageAccessor image_accessor,
+                         /* isScalar? */ VigraTrueType)
+        {
+            for (int y = 0; y != size.y; ++y, ++image_iterator.y)
+            {
+                typename ImageIterator::row_iterator is(image_iterator.rowIterator());
+                for (int x = 0; x != size.x; ++x, ++is, block += bands)
+                {
+                    image_accessor.set(*block, is);
+                }
+            }
+        }
+
+
+        template <class ValueType,
+                  class ImageIterator, class ImageAccessor>
+        void
+        copy_image_block(const ValueType* block, unsigned bands, Size2D const & size,
+                         ImageIterator image_iterator, ImageAccessor image_accessor,
+                         /* isScalar? */ VigraFalseType)
+        {
+            const unsigned accessor_size(image_accessor.size(image_iterator));
+
+            for (int y = 0; y != size.y; ++y, ++image_iterator.y)
+            {
+                typename ImageIterator::row_iterator is(image_iterator.rowIterator());
+                for (int x = 0; x != size.x; ++x, ++is, block += bands)
+                {
+                    for (unsigned i = 0U; i != accessor_size; ++i)
+                    {
+                        image_accessor.setComponent(block[bands == 1 ? 0 : i], is, static_cast<int>(i));
+                    }
+                }
+            }
+        }
+
+
+        template <class ImageIterator, class ImageAccessor>
+        inline bool
+        import_bands_match(const ImageImportInfo&, ImageIterator, ImageAccessor,
+                           /* isScalar? */ VigraTrueType)
+        {
+            return true;
+        }
+
+
+        template <class ImageIterator, class ImageAccessor>
+        inline bool
+        import_bands_match(const ImageImportInfo& import_info,
+                           ImageIterator image_iterator, ImageAccessor image_accessor,
+                           /* isScalar? */ VigraFalseType)
+        {
+            return static_cast<unsigned int>(import_info.numBands()) == image_accessor.size(image_iterator) ||
+                   import_info.numBands() == 1;
+        }
+
+
+        // Decode the block into an interleaved buffer of the file's pixel type
+        // with Decoder::decodeRegion(), and then convert it via the accessor.
+        template <class ValueType,
+                  class ImageIterator, class ImageAccessor>
+        void
+        read_image_block(Decoder* decoder, Diff2D const & block_offset, Size2D const & block_size,
+                         ImageIterator image_iterator, ImageAccessor image_accessor)
+        {
+            typedef typename ImageAccessor::value_type ImageValueType;
+            typedef typename NumericTraits<ImageValueType>::isScalar is_scalar;
+
+            const unsigned bands(decoder->getNumBands());
+            ArrayVector<ValueType> block(block_size.area() * bands);
+
+            decoder->decodeRegion(block.data(),
+                                  bands*sizeof(ValueType), block_size.x*bands*sizeof(ValueType),
+                                  sizeof(ValueType), bands,
+                                  block_offset.x, block_offset.y, block_size.x, block_size.y);
+            copy_image_block(block.data(), bands, block_size,
+                             image_iterator, image_accessor, is_scalar());
+        }
+
+
+        template <class ImageIterator, class ImageAccessor>
+        void
+        importImageBlock(const ImageImportInfo& import_info,
+                         Diff2D const & block_offset, Size2D const & block_size,
+                         pair<ImageIterator, ImageAccessor> image)
+        {
+            typedef typename ImageAccessor::value_type ImageValueType;
+
+            ImageIterator image_iterator(image.first);
+            ImageAccessor image_accessor(image.second);
+
+            vigra_precondition(import_bands_match(import_info, image_iterator, image_accessor,
+                                                  typename NumericTraits<ImageValueType>::isScalar()),
+                "importImageBlock(): Number of channels in input and destination image don't match.");
+
+            VIGRA_UNIQUE_PTR<Decoder> decoder(vigra::decoder(import_info));
+
+            switch (pixel_t_of_string(decoder->getPixelType()))
+            {
+            case UNSIGNED_INT_8:
+                read_image_block<UInt8>(decoder.get(), block_offset, block_size, image_iterator, image_accessor);
+                break;
+            case UNSIGNED_INT_16:
+                read_image_block<UInt16>(decoder.get(), block_offset, block_size, image_iterator, image_accessor);
+                break;
+            case UNSIGNED_INT_32:
+                read_image_block<UInt32>(decoder.get(), block_offset, block_size, image_iterator, image_accessor);
+                break;
+            case SIGNED_INT_16:
+                read_image_block<Int16>(decoder.get(), block_offset, block_size, image_iterator, image_accessor);
+                break;
+            case SIGNED_INT_32:
+                read_image_block<Int32>(decoder.get(), block_offset, block_size, image_iterator, image_accessor);
+                break;
+            case IEEE_FLOAT_32:
+                read_image_block<float>(decoder.get(), block_offset, block_size, image_iterator, image_accessor);
+                break;
+            case IEEE_FLOAT_64:
+                read_image_block<double>(decoder.get(), block_offset, block_size, image_iterator, image_accessor);
+                break;
+            default:
+                vigra_fail("vigra::detail::importImageBlock: not reached");
+            }
+
+            decoder->close();
+        }
+
         template<class ValueType,
                  class ImageIterator, class ImageAccessor, class ImageScaler>
         void
@@ -629,6 +818,41 @@ namespace vigra
 
             encoder->close();
         }
+
+
+        // Encode the image with a single call to Encoder::encodeImage(), provided
+        // that the array's element type can be stored in the file without conversion
+        // or range mapping. Otherwise, no file is created and false is returned.
+        template <class T, class S>
+        bool
+        exportImageDirectly(MultiArrayView<2, T, S> const & image, const ImageExportInfo& export_info)
+        {
+            typedef ImportElementTraits<T> Traits;
+            typedef typename Traits::element_type ElementType;
+
+            if (export_info.hasForcedRangeMapping())
+                return false;
+
+            const std::string file_type(getEncoderType(export_info.getFileName(), export_info.getFileType()));
+            std::string pixel_type(export_info.getPixelType());
+            if (negotiatePixelType(file_type, TypeAsString<ElementType>::result(), pixel_type) ||
+                pixel_type != TypeAsString<ElementType>::result() ||
+                !isBandNumberSupported(file_type, Traits::size))
+                return false;
+
+            VIGRA_UNIQUE_PTR<Encoder> encoder(vigra::encoder(export_info));
+            encoder->setPixelType(pixel_type);
+            encoder->setWidth(image.shape(0));
+            encoder->setHeight(image.shape(1));
+            encoder->setNumBands(Traits::size);
+            encoder->finalizeSettings();
+            encoder->encodeImage(image.data(),
+                                 image.stride(0)*sizeof(T), image.stride(1)*sizeof(T),
+                                 sizeof(ElementType), image.shape(0), image.shape(1),
+                                 Traits::size, sizeof(ElementType));
+            encoder->close();
+            return true;
+        }
     }  // end namespace detail
 
     /** 
@@ -643,6 +867,11 @@ namespace vigra
     destination array, only the first band is read. Any other mismatch between the number of bands in
     input and output is an error and will throw a precondition exception.
     
+    When a \ref vigra::MultiArrayView is passed whose element type (resp. the band type of a
+    <tt>TinyVector</tt> or <tt>RGBValue</tt>) equals the file's pixel type, and no band 
+    replication is needed, the codec decodes the data directly into the array (see 
+    <tt>Decoder::decodeImage()</tt>) without per-scanline type conversion.
+    
     <B>Declarations</B>
    
     pass 2D array views:
@@ -816,7 +1045,8 @@ namespace vigra
     {
         vigra_precondition(import_info.shape() == image.shape(),
             "importImage(): shape mismatch between input and output.");
-        importImage(import_info, destImage(image));
+        if (!detail::importImageDirectly(import_info, image))
+            importImage(import_info, destImage(image));
     }
 
     template <class T, class A>
@@ -826,7 +1056,7 @@ namespace vigra
     {
         ImageImportInfo info(name);
         image.reshape(info.shape());
-        importImage(info, destImage(image));
+        importImage(info, MultiArrayView<2, T>(image));
     }
 
     template <class T, class A>
@@ -837,6 +1067,65 @@ namespace vigra
         importImage(name.c_str(), image);
     }
 
+    /**
+    \brief Read a rectangular block of an image from a file.
+
+    The block starts at <tt>block_offset</tt> in the image and has the shape of the
+    destination array, which must lie entirely inside the image. Bands are handled
+    as in \ref importImage().
+
+    Codecs which store images in independently compressed tiles or strips (currently TIFF)
+    only decode the tiles resp. strips intersecting the block, concurrently
+    on <tt>import_info.getNumThreads()</tt> threads. This allows to read regions
+    of interest from images which are too large for memory. Other codecs decode
+    the image scanline by scanline up to the last row of the block.
+
+    <B>Declarations</B>
+
+    \code
+    namespace vigra {
+        template <class T, class S>
+        void
+        importImageBlock(ImageImportInfo const & import_info,
+                         MultiArrayShape<2>::type const & block_offset,
+                         MultiArrayView<2, T, S> image);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/impex.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    ImageImportInfo info("huge_montage.tif");
+    info.setNumThreads(8);
+
+    // read a 1024 x 1024 region of interest
+    MultiArray<2, UInt8> roi(Shape2(1024, 1024));
+    importImageBlock(info, Shape2(20000, 30000), roi);
+    \endcode
+    */
+    doxygen_overloaded_function(template <...> void importImageBlock)
+
+    template <class T, class S>
+    inline void
+    importImageBlock(ImageImportInfo const & import_info,
+                     typename MultiArrayShape<2>::type const & block_offset,
+                     MultiArrayView<2, T, S> image)
+    {
+        vigra_precondition(allLessEqual(typename MultiArrayShape<2>::type(), block_offset) &&
+                           allLessEqual(block_offset + image.shape(), import_info.shape()),
+            "importImageBlock(): block exceeds the image.");
+        if (image.size() == 0)
+            return;
+        if (!detail::importImageDirectly(import_info, image, block_offset))
+            detail::importImageBlock(import_info,
+                                     Diff2D(block_offset[0], block_offset[1]),
+                                     Size2D(image.shape(0), image.shape(1)),
+                                     destImage(image));
+    }
+
     /** \brief Write an image to a file.
     
     The file can be specified either by a file name or by a \ref vigra::ImageExportInfo object.
@@ -854,6 +1143,11 @@ namespace vigra
     converted to <tt>unsigned char</tt>, unless another mapping is explicitly requested by
     the ImageExportInfo object.  
     
+    TIFF files can be stored in tiles instead of strips (see <tt>ImageExportInfo::setTileSize()</tt>).
+    When a \ref vigra::MultiArrayView is written without conversion, the codec encodes
+    the array as a whole (see <tt>Encoder::encodeImage()</tt>), so that TIFF tiles resp. strips
+    are compressed concurrently when "DEFLATE" compression is requested.
+    
     Currently, the following file formats are supported.  The pixel types given in brackets
     are those that are written without conversion:
         - BMP: Microsoft Windows bitmap image file (pixel types: UINT8 as gray and RGB);
@@ -999,6 +1293,19 @@ namespace vigra
     exportImage(MultiArrayView<2, T, S> const & image,
                 ImageExportInfo const & export_info)
     {
+        try
+        {
+            if (detail::exportImageDirectly(image, export_info))
+                return;
+        }
+        catch (Encoder::TIFFCompressionException&)
+        {
+            ImageExportInfo info(export_info);
+
+            info.setCompression("");
+            if (detail::exportImageDirectly(image, info))
+                return;
+        }
         exportImage(srcImageRange(image), export_info);
     }
 
@@ -1008,7 +1315,7 @@ namespace vigra
                 char const * name)
     {
         ImageExportInfo export_info(name);
-        exportImage(srcImageRange(image), export_info);
+        exportImage(image, export_info);
     }
 
     template <class T, class S>
@@ -1017,7 +1324,7 @@ namespace vigra
                 std::string const & name)
     {
         ImageExportInfo export_info(name.c_str());
-        exportImage(srcImageRange(image), export_info);
+        exportImage(image, export_info);
     }
 
 /** @} */
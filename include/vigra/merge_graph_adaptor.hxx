@@ -164,6 +164,7 @@ public:
    // manipulation
    void reset(const value_type&);
    void merge(value_type, value_type);
+   void mergeInto(value_type, value_type);
 
    value_type firstRep()const{
       return firstRep_;
@@ -703,6 +704,27 @@ class MergeGraphAdaptor
         // modification
         void contractEdge(const Edge & edge);
 
+        /** \brief Merge adjacency small-to-large in contractEdge().
+
+            By default, the representative of a contracted edge's end nodes
+            is chosen by the union-find rank. When this option is on, the node
+            with more neighbors survives, so that only the neighbors of the
+            smaller node have to be visited. Their entries are merged into the
+            sorted adjacency of the larger node in a single linear pass, instead
+            of one sorted-vector insertion per entry. A contraction therefore
+            still costs O(larger degree), but no longer O(smaller degree *
+            larger degree), which matters on graphs with high-degree nodes.
+            The resulting partitions are the same, but the representative
+            node ids may differ from the default mode.
+        */
+        void setSmallToLargeMerging(const bool enable){
+            smallToLargeMerging_ = enable;
+        }
+
+        bool smallToLargeMerging()const{
+            return smallToLargeMerging_;
+        }
+
 
         Node oppositeNode(Node const &n, const Edge &e) const {
             const Node uNode = u(e);
@@ -824,6 +846,9 @@ class MergeGraphAdaptor
 
         size_t nDoubleEdges_;
         std::vector<std::pair<index_type,index_type> > doubleEdges_;
+
+        bool smallToLargeMerging_;
+        std::vector<typename NodeStorage::AdjacencyElement> newAdjacency_;
 };
 
 
@@ -835,7 +860,9 @@ MergeGraphAdaptor<GRAPH>::MergeGraphAdaptor(const GRAPH & graph )
     edgeUfd_(graph.maxEdgeId()+1),
     nodeVector_(graph.maxNodeId()+1),
     nDoubleEdges_(0),
-    doubleEdges_(graph_.edgeNum()/2 +1)
+    doubleEdges_(graph_.edgeNum()/2 +1),
+    smallToLargeMerging_(false),
+    newAdjacency_()
 {
     for(index_type possibleNodeId = 0 ; possibleNodeId <= graph_.maxNodeId(); ++possibleNodeId){
         if(graph_.nodeFromId(possibleNodeId)==lemon::INVALID){
@@ -1169,7 +1196,16 @@ void MergeGraphAdaptor<GRAPH>::contractEdge(
     const index_type nodesIds[2]={id(u(toDeleteEdge)),id(v(toDeleteEdge))};
 
     // merge the two nodes
-    nodeUfd_.merge(nodesIds[0],nodesIds[1]);
+    if(smallToLargeMerging_){
+        if(nodeVector_[nodesIds[0]].numberOfEdges() >= nodeVector_[nodesIds[1]].numberOfEdges())
+            nodeUfd_.mergeInto(nodesIds[0],nodesIds[1]);
+        else
+            nodeUfd_.mergeInto(nodesIds[1],nodesIds[0]);
+        newAdjacency_.clear();
+    }
+    else{
+        nodeUfd_.merge(nodesIds[0],nodesIds[1]);
+    }
     const IdType newNodeRep    = reprNodeId(nodesIds[0]);
     const IdType notNewNodeRep =  (newNodeRep == nodesIds[0] ? nodesIds[1] : nodesIds[0] );
 
@@ -1214,11 +1250,17 @@ void MergeGraphAdaptor<GRAPH>::contractEdge(
 
                 // symetric
                 //nodeVector_[newNodeRep].eraseFromAdjacency(adjToDeadNodeId);
-                nodeVector_[newNodeRep].insert(adjToDeadNodeId,iter->edgeId());
+                if(smallToLargeMerging_)
+                    newAdjacency_.push_back(*iter); // sorted by node id
+                else
+                    nodeVector_[newNodeRep].insert(adjToDeadNodeId,iter->edgeId());
 
             }
         }
     }
+    if(smallToLargeMerging_){
+        nodeVector_[newNodeRep].adjacency_.insertSorted(newAdjacency_.begin(), newAdjacency_.end());
+    }
 
     //nodeVector_[newNodeRep].merge(nodeVector_[notNewNodeRep]);
     nodeVector_[newNodeRep].eraseFromAdjacency(notNewNodeRep);
@@ -1410,6 +1452,31 @@ IterablePartition<T>::merge
    }
 }  
 
+/// Merge two sets such that the set of the first element
+/// keeps its representative (regardless of the ranks).
+///
+/// \param rep An element of the surviving set.
+/// \param other An element of the set to be merged.
+///
+template<class T>
+inline void
+IterablePartition<T>::mergeInto
+(
+   value_type rep,
+   value_type other
+)
+{
+   rep = find(rep);
+   other = find(other);
+   if(rep!=other){
+      parents_[static_cast<SizeTType>(other)] = rep;
+      ranks_[static_cast<SizeTType>(rep)] = std::max(ranks_[static_cast<SizeTType>(rep)],
+                                                     ranks_[static_cast<SizeTType>(other)]+1);
+      --numberOfSets_;
+      this->eraseElement(other,false);
+   }
+}
+
 template<class T>
 inline typename IterablePartition<T>::value_type
 IterablePartition<T>::numberOfElements() const
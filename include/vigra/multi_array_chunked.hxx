@@ -131,6 +131,7 @@
 
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "multi_fwd.hxx"
 #include "multi_handle.hxx"
@@ -138,6 +139,7 @@
 #include "memory.hxx"
 #include "metaprogramming.hxx"
 #include "threading.hxx"
+#include "threadpool.hxx"
 #include "compression.hxx"
 
 #ifdef _WIN32
@@ -230,6 +232,9 @@ std::size_t mmap_alignment = sysconf(_SC_PAGE_SIZE);
 template <unsigned int N, class T>
 class IteratorChunkHandle;
 
+template <unsigned int N, class T>
+class ChunkPrefetcher;
+
 namespace detail {
 
 template <unsigned int N>
@@ -319,8 +324,153 @@ defaultCacheSize(TinyVector<T, M> const & shape)
     return res + 1;
 }
 
+    // A byte counter that can be updated concurrently. Chunks are loaded
+    // and unloaded without a global lock, so that the backends' bookkeeping
+    // of data and overhead bytes must be atomic.
+class ChunkByteCounter
+{
+  public:
+    ChunkByteCounter(std::size_t value = 0)
+    : value_()
+    {
+        value_ = (long)value;
+    }
+
+    ChunkByteCounter(ChunkByteCounter const & rhs)
+    : value_()
+    {
+        value_ = rhs.value_.load();
+    }
+
+    ChunkByteCounter & operator=(ChunkByteCounter const & rhs)
+    {
+        value_.store(rhs.value_.load());
+        return *this;
+    }
+
+    ChunkByteCounter & operator=(std::size_t value)
+    {
+        value_.store((long)value);
+        return *this;
+    }
+
+    ChunkByteCounter & operator+=(std::size_t value)
+    {
+        value_.fetch_add((long)value);
+        return *this;
+    }
+
+    ChunkByteCounter & operator-=(std::size_t value)
+    {
+        value_.fetch_sub((long)value);
+        return *this;
+    }
+
+    operator std::size_t() const
+    {
+        return (std::size_t)value_.load();
+    }
+
+  private:
+    threading::atomic_long value_;
+};
+
+    // The chunk cache of a ChunkedArray. Handles are distributed over
+    // a fixed number of shards according to a hash of their chunk's
+    // linear index, so that threads working on different chunks rarely
+    // compete for the same lock. Each shard is managed by the CLOCK policy
+    // (see ChunkedArray::cleanCache()).
+template <class Handle>
+class ChunkCache
+{
+  public:
+    static const std::size_t shard_count = 16;
+
+    struct Shard
+    {
+        Shard()
+        : entries_()
+        , hand_(0)
+        , hits_()
+        , misses_()
+        , evictions_(0)
+        {
+            hits_ = 0;
+            misses_ = 0;
+        }
+
+        threading::mutex lock_;
+        std::vector<Handle *> entries_;   // guarded by lock_
+        std::size_t hand_;                // guarded by lock_
+        threading::atomic_long hits_, misses_;
+        std::size_t evictions_;           // guarded by lock_
+        char padding_[64];                // keep shards in separate cache lines
+    };
+
+    ChunkCache()
+    : size_()
+    {
+        size_ = 0;
+    }
+
+        // a copied array starts with an empty cache
+    ChunkCache(ChunkCache const &)
+    : size_()
+    {
+        size_ = 0;
+    }
+
+    Shard & shard(std::size_t k)
+    {
+        return shards_[k];
+    }
+
+        // Fibonacci hashing of the chunk's linear index, so that
+        // neighboring chunks end up in different shards
+    static std::size_t shardIndex(std::size_t chunk_index)
+    {
+        return (std::size_t)((UInt32)chunk_index * 2654435769u) >> 28;
+    }
+
+    std::size_t size() const
+    {
+        return (std::size_t)size_.load();
+    }
+
+    Shard shards_[shard_count];
+    threading::atomic_long size_;
+
+  private:
+    ChunkCache & operator=(ChunkCache const &);
+};
+
 } // namespace detail
 
+/** \brief Usage statistics of the chunk cache of a \ref ChunkedArray.
+
+    See \ref ChunkedArray::cacheStatistics().
+*/
+struct ChunkCacheStatistics
+{
+    ChunkCacheStatistics()
+    : hits(0)
+    , misses(0)
+    , evictions(0)
+    {}
+
+        /** Number of chunk requests that found the chunk already active.
+        */
+    std::size_t hits;
+
+        /** Number of chunk requests that had to load (or create) the chunk.
+        */
+    std::size_t misses;
+
+        /** Number of chunks sent asleep by the cache's replacement policy.
+        */
+    std::size_t evictions;
+};
+
 template <unsigned int N, class T>
 class ChunkBase
 {
@@ -357,15 +507,21 @@ class SharedChunkHandle
     SharedChunkHandle()
     : pointer_(0)
     , chunk_state_()
+    , chunk_referenced_()
+    , in_cache_(false)
     {
         chunk_state_ = chunk_uninitialized;
+        chunk_referenced_ = 0;
     }
 
     SharedChunkHandle(SharedChunkHandle const & rhs)
     : pointer_(rhs.pointer_)
     , chunk_state_()
+    , chunk_referenced_()
+    , in_cache_(false)
     {
         chunk_state_ = chunk_uninitialized;
+        chunk_referenced_ = 0;
     }
 
     shape_type const & strides() const
@@ -375,6 +531,11 @@ class SharedChunkHandle
 
     ChunkBase<N, T> * pointer_;
     mutable threading::atomic_long chunk_state_;
+        // reference bit of the CLOCK cache policy, set on every cache hit
+    mutable threading::atomic_long chunk_referenced_;
+        // true while the handle is in the chunk cache (guarded by the lock
+        // of the handle's cache shard)
+    bool in_cache_;
 
   private:
     SharedChunkHandle & operator=(SharedChunkHandle const & rhs);
@@ -1273,6 +1434,7 @@ class ChunkedArrayOptions
     : fill_value(0.0)
     , cache_max(-1)
     , compression_method(DEFAULT_COMPRESSION)
+    , compression_threads(0)
     {}
 
     /** \brief Element value for read-only access of uninitialized chunks.
@@ -1320,9 +1482,31 @@ class ChunkedArrayOptions
         return ChunkedArrayOptions(*this).compression(v);
     }
 
+    /** \brief Compress evicted chunks in the background with the given number of threads.
+
+        When positive (or <tt>ParallelOptions::Auto</tt>), chunks evicted from the cache
+        of a \ref ChunkedArrayCompressed are compressed by a background thread pool
+        (write-behind), so that the thread which caused the eviction doesn't pay for the
+        compression. A chunk that is accessed again while its compression is still pending
+        is served directly from the uncompressed buffer.
+
+        Default: 0 (compress synchronously during eviction)
+    */
+    ChunkedArrayOptions & compressionThreads(int v)
+    {
+        compression_threads = v;
+        return *this;
+    }
+
+    ChunkedArrayOptions compressionThreads(int v) const
+    {
+        return ChunkedArrayOptions(*this).compressionThreads(v);
+    }
+
     double fill_value;
     int cache_max;
     CompressionMethod compression_method;
+    int compression_threads;
 };
 
 /** \weakgroup ParallelProcessing
@@ -1360,6 +1544,10 @@ Namespace: vigra
     Temporarily unused chunks are written to the hard-drive and deleted from
     memory.
 
+    <li>ChunkedArrayMmap: Like ChunkedArrayTmpFile, but the chunks are stored
+    in a named file which persists after the array is destroyed and can be
+    reopened instantly.
+
     <li>ChunkedArrayHDF5: Chunks are stored in a HDF5 dataset by means of
     HDF5's native chunked storage capabilities. Temporarily unused chunks are
     written to the hard-drive in compressed form and deleted from memory.
@@ -1613,7 +1801,7 @@ class ChunkedArray
     typedef ChunkBase<N, T> Chunk;
     typedef MultiArrayView<N, T, ChunkedArrayTag>                   view_type;
     typedef MultiArrayView<N, T const, ChunkedArrayTag>             const_view_type;
-    typedef std::queue<Handle*> CacheType;
+    typedef detail::ChunkCache<Handle> CacheType;
 
     static const long chunk_asleep = Handle::chunk_asleep;
     static const long chunk_uninitialized = Handle::chunk_uninitialized;
@@ -1663,7 +1851,44 @@ class ChunkedArray
     */
     int cacheSize() const
     {
-        return cache_.size();
+        return (int)cache_.size();
+    }
+
+    /** \brief Hit, miss, and eviction counts of the chunk cache.
+
+        A request for a chunk is a hit when the chunk is already active
+        and a miss when it must be loaded (or created) first. Evictions
+        count the chunks sent asleep in order to keep the cache within
+        cacheMaxSize(). The counts accumulate since construction or
+        the last call to resetCacheStatistics().
+    */
+    ChunkCacheStatistics cacheStatistics() const
+    {
+        ChunkedArray * self = const_cast<ChunkedArray *>(this);
+        ChunkCacheStatistics res;
+        for(std::size_t k=0; k<CacheType::shard_count; ++k)
+        {
+            typename CacheType::Shard & shard = self->cache_.shard(k);
+            res.hits += (std::size_t)shard.hits_.load();
+            res.misses += (std::size_t)shard.misses_.load();
+            threading::lock_guard<threading::mutex> guard(shard.lock_);
+            res.evictions += shard.evictions_;
+        }
+        return res;
+    }
+
+    /** \brief Reset the counts reported by cacheStatistics() to zero.
+    */
+    void resetCacheStatistics()
+    {
+        for(std::size_t k=0; k<CacheType::shard_count; ++k)
+        {
+            typename CacheType::Shard & shard = cache_.shard(k);
+            shard.hits_.store(0);
+            shard.misses_.store(0);
+            threading::lock_guard<threading::mutex> guard(shard.lock_);
+            shard.evictions_ = 0;
+        }
     }
 
     /** \brief Bytes of main memory occupied by the array's data.
@@ -1816,6 +2041,13 @@ class ChunkedArray
 
     virtual bool unloadChunk(Chunk * chunk, bool destroy = false) = 0;
 
+    // called by releaseChunk() after a chunk was sent asleep and its
+    // data bytes were accounted for. Backends that finish unloading
+    // in the background (e.g. ChunkedArrayCompressed with write-behind
+    // compression) hand the chunk to their workers here.
+    virtual void unloadChunkDeferred(Chunk *)
+    {}
+
     Handle * lookupHandle(shape_type const & index)
     {
         return &handle_array_[index];
@@ -1849,11 +2081,8 @@ class ChunkedArray
         for(unsigned int k=0; k<chunks.size(); ++k)
             unrefChunk(chunks[k]);
 
-        if(cacheMaxSize() > 0)
-        {
-            threading::lock_guard<threading::mutex> guard(*chunk_lock_);
+        if(cacheMaxSize() > 0 && cache_.size() > cacheMaxSize())
             cleanCache(cache_.size());
-        }
     }
 
     // Increase the reference counter of the given chunk.
@@ -1904,9 +2133,19 @@ class ChunkedArray
 
         long rc = acquireRef(handle);
         if(rc >= 0)
+        {
+            if(handle != &fill_value_handle_)
+            {
+                // avoid writing the shared cache line when the bit is already set
+                if(handle->chunk_referenced_.load(threading::memory_order_relaxed) == 0)
+                    handle->chunk_referenced_.store(1, threading::memory_order_relaxed);
+                self->cacheShard(handle).hits_.fetch_add(1, threading::memory_order_relaxed);
+            }
             return handle->pointer_->pointer_;
+        }
 
-        threading::lock_guard<threading::mutex> guard(*chunk_lock_);
+        // The handle is now in state chunk_locked, which gives us exclusive
+        // access to this chunk. Other chunks can be loaded concurrently.
         try
         {
             T * p = self->loadChunk(&handle->pointer_, chunk_index);
@@ -1916,14 +2155,29 @@ class ChunkedArray
 
             self->data_bytes_ += dataBytes(chunk);
 
+            typename CacheType::Shard & shard = self->cacheShard(handle);
+            shard.misses_.fetch_add(1, threading::memory_order_relaxed);
+
             if(cacheMaxSize() > 0 && insertInCache)
             {
-                // insert in queue of mapped chunks
-                self->cache_.push(handle);
+                {
+                    threading::lock_guard<threading::mutex> guard(shard.lock_);
+                    if(!handle->in_cache_)
+                    {
+                        shard.entries_.push_back(handle);
+                        handle->in_cache_ = true;
+                        self->cache_.size_.fetch_add(1);
+                    }
+                    handle->chunk_referenced_.store(1);
+                }
+                // publish the chunk before cache management, so that
+                // the sweep sees it as active and leaves it alone
+                handle->chunk_state_.store(1, threading::memory_order_release);
 
                 // do cache management if cache is full
-                // (note that we still hold the chunk_lock_)
-                self->cleanCache(2);
+                if(cache_.size() > cacheMaxSize())
+                    self->cleanCache(2, CacheType::shardIndex(handle - handle_array_.data()));
+                return p;
             }
             handle->chunk_state_.store(1, threading::memory_order_release);
             return p;
@@ -1989,8 +2243,10 @@ class ChunkedArray
         return chunkForIteratorImpl(point, strides, upper_bound, h, true);
     }
 
-    // NOTE: This function must only be called while we hold the chunk_lock_.
-    //       This implies refcount != chunk_locked, so that race conditions are avoided.
+    // Unload the chunk if it is unused. Exclusive access is obtained by
+    // switching the chunk's state to chunk_locked, so that the function
+    // may run concurrently with loading or releasing other chunks.
+    // Returns the state found in the handle (0 if the chunk was unloaded).
     long releaseChunk(Handle * handle, bool destroy = false)
     {
         long rc = 0;
@@ -2012,9 +2268,14 @@ class ChunkedArray
                 int didDestroy = unloadChunk(chunk, destroy);
                 this->data_bytes_ += dataBytes(chunk);
                 if(didDestroy)
+                {
                     handle->chunk_state_.store(chunk_uninitialized);
+                }
                 else
+                {
+                    unloadChunkDeferred(chunk);
                     handle->chunk_state_.store(chunk_asleep);
+                }
             }
             catch(...)
             {
@@ -2025,18 +2286,69 @@ class ChunkedArray
         return rc;
     }
 
-    // NOTE: this function must only be called while we hold the chunk_lock_
-    void cleanCache(int how_many = -1)
+    typename CacheType::Shard & cacheShard(Handle * handle)
+    {
+        return cache_.shard(CacheType::shardIndex(handle - handle_array_.data()));
+    }
+
+    // Send up to 'how_many' chunks asleep until the cache fits into
+    // cacheMaxSize(), starting with shard 'first_shard' and moving on to
+    // the next shard when the current one has no victims. Within a shard,
+    // the CLOCK policy is used: the hand passes over active chunks, and
+    // inactive chunks referenced since the hand's last visit get a second
+    // chance (their reference bit is cleared). Handles whose chunk was
+    // released by other means (e.g. releaseChunks()) are dropped.
+    void cleanCache(int how_many = -1, std::size_t first_shard = 0)
     {
         if(how_many == -1)
-            how_many = cache_.size();
-        for(; cache_.size() > cacheMaxSize() && how_many > 0; --how_many)
+            how_many = (int)cache_.size();
+        for(std::size_t s=0; s < CacheType::shard_count && how_many > 0; ++s)
         {
-            Handle * handle = cache_.front();
-            cache_.pop();
-            long rc = releaseChunk(handle);
-            if(rc > 0) // refcount was positive => chunk is still needed
-                cache_.push(handle);
+            if(cache_.size() <= cacheMaxSize())
+                return;
+            typename CacheType::Shard & shard =
+                  cache_.shard((first_shard + s) % CacheType::shard_count);
+            threading::lock_guard<threading::mutex> guard(shard.lock_);
+
+            // two revolutions of the hand suffice to clear all reference bits
+            std::size_t steps = 2*shard.entries_.size();
+            for(; steps > 0 && how_many > 0 && !shard.entries_.empty() &&
+                  cache_.size() > cacheMaxSize(); --steps)
+            {
+                if(shard.hand_ >= shard.entries_.size())
+                    shard.hand_ = 0;
+                Handle * handle = shard.entries_[shard.hand_];
+                long rc = handle->chunk_state_.load();
+                bool remove = false;
+                if(rc == 0)
+                {
+                    if(handle->chunk_referenced_.load() != 0)
+                    {
+                        handle->chunk_referenced_.store(0);
+                    }
+                    else if(releaseChunk(handle) == 0)
+                    {
+                        remove = true;
+                        ++shard.evictions_;
+                        --how_many;
+                    }
+                }
+                else if(rc < 0 && rc != chunk_locked)
+                {
+                    remove = true;  // already asleep, uninitialized, or failed
+                }
+                if(remove)
+                {
+                    handle->in_cache_ = false;
+                    shard.entries_[shard.hand_] = shard.entries_.back();
+                    shard.entries_.pop_back();
+                    cache_.size_.fetch_sub(1);
+                }
+                else
+                {
+                    ++shard.hand_;
+                }
+            }
         }
     }
 
@@ -2065,22 +2377,51 @@ class ChunkedArray
             }
 
             Handle * handle = this->lookupHandle(*i);
-            threading::lock_guard<threading::mutex> guard(*chunk_lock_);
             releaseChunk(handle, destroy);
         }
 
         // remove all chunks from the cache that are asleep or unitialized
-        threading::lock_guard<threading::mutex> guard(*chunk_lock_);
-        int cache_size = cache_.size();
-        for(int k=0; k < cache_size; ++k)
+        for(std::size_t k=0; k<CacheType::shard_count; ++k)
         {
-            Handle * handle = cache_.front();
-            cache_.pop();
-            if(handle->chunk_state_.load() >= 0)
-                cache_.push(handle);
+            typename CacheType::Shard & shard = cache_.shard(k);
+            threading::lock_guard<threading::mutex> guard(shard.lock_);
+            for(std::size_t j=0; j < shard.entries_.size();)
+            {
+                Handle * handle = shard.entries_[j];
+                long rc = handle->chunk_state_.load();
+                if(rc >= 0 || rc == chunk_locked)
+                {
+                    ++j;
+                    continue;
+                }
+                handle->in_cache_ = false;
+                shard.entries_[j] = shard.entries_.back();
+                shard.entries_.pop_back();
+                cache_.size_.fetch_sub(1);
+            }
         }
     }
 
+    /** \brief Activate the chunk with the given index and insert it into
+        the cache, without keeping a reference to it.
+
+        Only chunks that are asleep are loaded: chunks that are active,
+        currently being loaded, or have never been written (and thus
+        contain the fill value) are left alone. This is the work item
+        of \ref ChunkPrefetcher and may run concurrently with any other
+        access to the array.
+    */
+    void prefetchChunk(shape_type const & chunk_index) const
+    {
+        ChunkedArray * self = const_cast<ChunkedArray *>(this);
+        Handle * handle = self->lookupHandle(chunk_index);
+        if(cacheMaxSize() == 0 ||
+           handle->chunk_state_.load(threading::memory_order_acquire) != chunk_asleep)
+            return;
+        getChunk(handle, false, true, chunk_index);
+        unrefChunk(handle);
+    }
+
     /** \brief Copy an ROI of the chunked array into an ordinary MultiArrayView.
 
         The ROI's lower bound is given by 'start', its upper bound (in 'beyond' sense)
@@ -2103,6 +2444,32 @@ class ChunkedArray
         }
     }
 
+    /** \brief Copy an ROI of the chunked array into an ordinary MultiArrayView,
+        reading ahead.
+
+        Like the function above, but while a chunk is copied, the next
+        'lookahead' chunks are loaded by a background thread
+        (see \ref ChunkPrefetcher). The cache should hold at least
+        <tt>lookahead + 1</tt> chunks.
+    */
+    template <class U, class Stride>
+    void
+    checkoutSubarray(shape_type const & start,
+                     MultiArrayView<N, U, Stride> & subarray,
+                     int lookahead) const
+    {
+        shape_type stop   = start + subarray.shape();
+
+        checkSubarrayBounds(start, stop, "ChunkedArray::checkoutSubarray()");
+
+        ChunkPrefetcher<N, T> prefetcher(*this, start, stop, lookahead);
+        chunk_const_iterator i = chunk_cbegin(start, stop);
+        for(i.prefetch(prefetcher); i.isValid(); ++i)
+        {
+            subarray.subarray(i.chunkStart()-start, i.chunkStop()-start) = *i;
+        }
+    }
+
     /** \brief Copy an ordinary MultiArrayView into an ROI of the chunked array.
 
         The ROI's lower bound is given by 'start', its upper bound (in 'beyond' sense)
@@ -2159,8 +2526,8 @@ class ChunkedArray
             if(isConst && handle->chunk_state_.load() == chunk_uninitialized)
                 handle = &self->fill_value_handle_;
 
-            // This potentially acquires the chunk_lock_ in each iteration.
-            // Would it be better to acquire it once before the loop?
+            // This potentially loads the chunk and updates the cache
+            // in each iteration.
             pointer p = getChunk(handle, isConst, true, *i);
 
             ChunkBase<N, T> * mini_chunk = &view.chunks_[*i - chunk_start];
@@ -2370,10 +2737,7 @@ class ChunkedArray
     {
         cache_max_size_ = c;
         if(c < cache_.size())
-        {
-            threading::lock_guard<threading::mutex> guard(*chunk_lock_);
             cleanCache();
-        }
     }
 
     /** \brief Create a scan-order iterator for the entire chunked array.
@@ -2482,7 +2846,7 @@ class ChunkedArray
     value_type fill_value_;
     double fill_scalar_;
     MultiArray<N, Handle> handle_array_;
-    std::size_t data_bytes_, overhead_bytes_;
+    detail::ChunkByteCounter data_bytes_, overhead_bytes_;
 };
 
 /** Returns a CoupledScanOrderIterator to simultaneously iterate over image m1 and its coordinates.
@@ -2511,6 +2875,203 @@ createCoupledIterator(ChunkedArray<N, T> const & m)
                         P0(m.shape())));
 }
 
+/** \brief Read-ahead of the chunks of a \ref ChunkedArray on background threads.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\> <br/>
+    Namespace: vigra
+
+    A linear pass over a chunked array normally loads each chunk on first
+    touch, so that the computation alternates with reading (and
+    decompressing) data. A ChunkPrefetcher is told the order in which the
+    chunks will be visited, either as the scan order of a \ref ChunkIterator
+    over an ROI or as a list of blocks (e.g. from a \ref MultiBlocking),
+    where each step comprises all chunks intersected by the block.
+    When the application announces via \ref advance() that it is about
+    to process step k, the chunks of steps k+1, ..., k+lookahead are loaded
+    into the cache by background threads.
+
+    Prefetched chunks are ordinary cache entries, i.e. they are not locked.
+    The array's \ref ChunkedArray::cacheMaxSize() "cacheMaxSize()" must be big
+    enough to hold the chunks of the current step plus those of the lookahead,
+    otherwise prefetched chunks get evicted before they are used.
+
+    Usage:
+    \code
+    ChunkedArrayCompressed<3, float> array(...);
+
+    // read ahead four chunks of the scan over the ROI
+    ChunkPrefetcher<3, float> prefetcher(array, start, stop, 4);
+    ChunkedArray<3, float>::chunk_iterator i   = array.chunk_begin(start, stop),
+                                           end = array.chunk_end(start, stop);
+    for(i.prefetch(prefetcher); i != end; ++i)
+        ... // process *i
+
+    // read ahead the chunks of the next two blocks
+    MultiBlocking<3> blocking(array.shape(), Shape3(64));
+    ChunkPrefetcher<3, float> block_prefetcher(array, blocking.blockBegin(), blocking.blockEnd(), 2);
+    MultiArray<3, float> block;
+    int k = 0;
+    for(auto b = blocking.blockBegin(); b != blocking.blockEnd(); ++b, ++k)
+    {
+        block_prefetcher.advance(k);
+        block.reshape((*b).size());
+        array.checkoutSubarray((*b).begin(), block);
+        ... // process block
+    }
+    \endcode
+*/
+template <unsigned int N, class T>
+class ChunkPrefetcher
+{
+  public:
+    typedef ChunkedArray<N, T>                 array_type;
+    typedef typename MultiArrayShape<N>::type  shape_type;
+
+        /** \brief Read ahead in the order of a \ref ChunkIterator over
+            the ROI <tt>[start, stop)</tt>, one chunk per step.
+
+            The chunks are loaded by <tt>options.getThreadPool()</tt> if a pool
+            was set, and by a private pool of <tt>options.getNumThreads()</tt>
+            threads otherwise (default: one thread).
+        */
+    ChunkPrefetcher(array_type const & array,
+                    shape_type const & start, shape_type const & stop,
+                    int lookahead = 2,
+                    ParallelOptions const & options = ParallelOptions().numThreads(1))
+    : array_(&array)
+    , lookahead_(lookahead)
+    , scheduled_(0)
+    {
+        array.checkSubarrayBounds(start, stop, "ChunkPrefetcher()");
+        MultiCoordinateIterator<N> i(array.chunkStart(start), array.chunkStop(stop)),
+                                   end(i.getEndIterator());
+        step_begin_.push_back(0);
+        for(; i != end; ++i)
+        {
+            chunks_.push_back(*i);
+            step_begin_.push_back(chunks_.size());
+        }
+        init(options);
+    }
+
+        /** \brief Read ahead in the order of the given block list, where
+            step k comprises all chunks intersected by the k-th block.
+
+            The blocks must provide the ROI by means of <tt>begin()</tt> and
+            <tt>end()</tt> (as \ref Box does). Threads are chosen as in the
+            constructor above.
+        */
+    template <class BLOCK_ITERATOR>
+    ChunkPrefetcher(array_type const & array,
+                    BLOCK_ITERATOR blocks_begin, BLOCK_ITERATOR blocks_end,
+                    int lookahead = 2,
+                    ParallelOptions const & options = ParallelOptions().numThreads(1))
+    : array_(&array)
+    , lookahead_(lookahead)
+    , scheduled_(0)
+    {
+        step_begin_.push_back(0);
+        for(; blocks_begin != blocks_end; ++blocks_begin)
+        {
+            shape_type start((*blocks_begin).begin()),
+                       stop((*blocks_begin).end());
+            array.checkSubarrayBounds(start, stop, "ChunkPrefetcher()");
+            MultiCoordinateIterator<N> i(array.chunkStart(start), array.chunkStop(stop)),
+                                       end(i.getEndIterator());
+            for(; i != end; ++i)
+                chunks_.push_back(*i);
+            step_begin_.push_back(chunks_.size());
+        }
+        init(options);
+    }
+
+        /** \brief Wait until all scheduled chunks are loaded.
+        */
+    ~ChunkPrefetcher()
+    {
+        wait();
+    }
+
+        /** \brief Number of steps in the traversal order.
+        */
+    std::size_t size() const
+    {
+        return step_begin_.size() - 1;
+    }
+
+        /** \brief Announce that the application is about to process step
+            'step', so that the chunks of the next 'lookahead' steps get
+            loaded in the background.
+
+            Chunks of the current and earlier steps are never scheduled,
+            because the application loads them itself anyway. Calling the
+            function repeatedly with the same or a smaller step has no effect.
+        */
+    void advance(std::size_t step)
+    {
+        std::size_t stop = std::min<std::size_t>(step + 1 + lookahead_, size());
+        if(scheduled_ < step + 1)
+            scheduled_ = step + 1;
+        for(; scheduled_ < stop; ++scheduled_)
+        {
+            for(std::size_t k = step_begin_[scheduled_]; k < step_begin_[scheduled_+1]; ++k)
+            {
+                array_type const * array = array_;
+                shape_type chunk_index = chunks_[k];
+                pending_.push_back(pool_->enqueue(
+                    [array, chunk_index](int)
+                    {
+                        // errors will surface when the application
+                        // accesses the chunk itself
+                        try
+                        {
+                            array->prefetchChunk(chunk_index);
+                        }
+                        catch(...)
+                        {}
+                    }));
+            }
+        }
+
+        // forget about the loads that have already finished
+        std::size_t done = 0;
+        while(done < pending_.size() && detail::futureIsReady(pending_[done]))
+            ++done;
+        pending_.erase(pending_.begin(), pending_.begin() + done);
+    }
+
+        /** \brief Block until all scheduled chunks are loaded.
+        */
+    void wait()
+    {
+        for(std::size_t k=0; k<pending_.size(); ++k)
+            pool_->waitFor(pending_[k]);
+        pending_.clear();
+    }
+
+  private:
+    ChunkPrefetcher(ChunkPrefetcher const &);
+    ChunkPrefetcher & operator=(ChunkPrefetcher const &);
+
+    void init(ParallelOptions const & options)
+    {
+        pool_ = options.getThreadPool();
+        if(pool_ == 0)
+        {
+            own_pool_.reset(new ThreadPool(options));
+            pool_ = own_pool_.get();
+        }
+    }
+
+    array_type const * array_;
+    std::size_t lookahead_, scheduled_;
+    std::vector<shape_type> chunks_;          // the chunks of all steps in order
+    std::vector<std::size_t> step_begin_;     // the first chunk of each step
+    std::vector<threading::future<void> > pending_;
+    VIGRA_UNIQUE_PTR<ThreadPool> own_pool_;
+    ThreadPool * pool_;
+};
+
 /** \weakgroup ParallelProcessing
     \sa ChunkedArrayFull
 */
@@ -2834,6 +3395,9 @@ class ChunkedArrayCompressed
         : ChunkBase<N, T>(detail::defaultStride(shape))
         , compressed_()
         , size_(prod(shape))
+        , pending_(false)
+        , compressing_(false)
+        , generation_(0)
         {}
 
         ~Chunk()
@@ -2862,7 +3426,7 @@ class ChunkedArrayCompressed
                 vigra_invariant(compressed_.size() == 0,
                     "ChunkedArrayCompressed::Chunk::compress(): compressed and uncompressed pointer are both non-zero.");
 
-                ::vigra::compress((char const *)this->pointer_, size_*sizeof(T), compressed_, method);
+                ::vigra::compress((char const *)this->pointer_, size_*sizeof(T), compressed_, method, sizeof(T));
 
                 // std::cerr << "compression ratio: " << double(compressed_.size())/(this->size()*sizeof(T)) << "\n";
                 detail::destroy_dealloc_n(this->pointer_, size_, alloc_);
@@ -2879,7 +3443,7 @@ class ChunkedArrayCompressed
                     this->pointer_ = alloc_.allocate((typename Alloc::size_type)size_);
 
                     ::vigra::uncompress(compressed_.data(), compressed_.size(),
-                                        (char*)this->pointer_, size_*sizeof(T), method);
+                                        (char*)this->pointer_, size_*sizeof(T), method, sizeof(T));
                     compressed_.clear();
                 }
                 else
@@ -2895,9 +3459,77 @@ class ChunkedArrayCompressed
             return this->pointer_;
         }
 
+            // Mark the chunk for write-behind compression. Returns the generation
+            // to be passed to compressPending(), or 0 if there is nothing to compress.
+        std::size_t schedule()
+        {
+            threading::lock_guard<threading::mutex> guard(lock_);
+            if(this->pointer_ == 0)
+                return 0;
+            pending_ = true;
+            return ++generation_;
+        }
+
+            // Executed by a background thread: compress the chunk unless it was
+            // reclaimed or rescheduled meanwhile. The data are only read during
+            // compression, so the uncompressed buffer remains valid until the
+            // result is committed under the lock. Returns the compressed size,
+            // or 0 if the chunk was not compressed.
+        std::size_t compressPending(CompressionMethod method, std::size_t generation)
+        {
+            {
+                threading::lock_guard<threading::mutex> guard(lock_);
+                if(!pending_ || generation != generation_ || this->pointer_ == 0)
+                    return 0;
+                compressing_ = true;
+            }
+            ArrayVector<char> buffer;
+            bool ok = true;
+            try
+            {
+                ::vigra::compress((char const *)this->pointer_, size_*sizeof(T), buffer, method, sizeof(T));
+            }
+            catch(...)
+            {
+                // keep the chunk uncompressed
+                ok = false;
+            }
+            std::size_t res = 0;
+            {
+                threading::lock_guard<threading::mutex> guard(lock_);
+                compressing_ = false;
+                if(pending_ && ok)
+                {
+                    compressed_.swap(buffer);
+                    detail::destroy_dealloc_n(this->pointer_, size_, alloc_);
+                    this->pointer_ = 0;
+                    res = compressed_.size();
+                }
+                pending_ = false;
+            }
+            compressed_condition_.notify_all();
+            return res;
+        }
+
+            // Take the chunk back from the write-behind queue: a pending compression
+            // is cancelled, and a compression in progress is awaited (and its result
+            // discarded). Afterwards, the chunk is either compressed or uncompressed,
+            // and background threads no longer touch it.
+        void reclaim()
+        {
+            threading::unique_lock<threading::mutex> guard(lock_);
+            pending_ = false;
+            while(compressing_)
+                compressed_condition_.wait(guard);
+        }
+
         ArrayVector<char> compressed_;
         MultiArrayIndex size_;
         Alloc alloc_;
+        threading::mutex lock_;
+        threading::condition_variable compressed_condition_;
+        bool pending_, compressing_;
+        std::size_t generation_;
 
       private:
         Chunk & operator=(Chunk const &);
@@ -2920,6 +3552,11 @@ class ChunkedArrayCompressed
         <li>ZLIB_NONE: Use 'zlib' format without compression.
         <li>DEFAULT_COMPRESSION: Same as LZ4.
         </ul>
+        Each of these can be combined with the pre-filters <tt>SHUFFLE_FILTER</tt>,
+        <tt>BITSHUFFLE_FILTER</tt>, and <tt>DELTA_FILTER</tt> (see \ref compress()),
+        for example <tt>LZ4_SHUFFLE</tt> or <tt>ZLIB_FAST_DELTA_SHUFFLE</tt>. The filters
+        operate on the array elements (of size <tt>sizeof(T)</tt>) and usually improve
+        the compression ratio of label and smooth floating-point data considerably.
     */
     explicit ChunkedArrayCompressed(shape_type const & shape,
                                     shape_type const & chunk_shape=shape_type(),
@@ -2929,10 +3566,15 @@ class ChunkedArrayCompressed
     {
         if(compression_method_ == DEFAULT_COMPRESSION)
             compression_method_ = LZ4;
+        if(options.compression_threads != 0)
+            compression_pool_.reset(new ThreadPool(
+                 ParallelOptions().numThreads(options.compression_threads)));
     }
 
     ~ChunkedArrayCompressed()
     {
+        waitCompressionFinished();
+        compression_pool_.reset();
         typename ChunkStorage::iterator i   = this->handle_array_.begin(),
                                         end = this->handle_array_.end();
         for(; i != end; ++i)
@@ -2950,35 +3592,90 @@ class ChunkedArrayCompressed
             *p = new Chunk(this->chunkShape(index));
             this->overhead_bytes_ += sizeof(Chunk);
         }
-        return static_cast<Chunk *>(*p)->uncompress(compression_method_);
+        Chunk * chunk = static_cast<Chunk *>(*p);
+        if(compression_pool_)
+            chunk->reclaim();
+        // the caller accounts for the loaded chunk, so discount the compressed data
+        this->data_bytes_ -= dataBytes(chunk);
+        return chunk->uncompress(compression_method_);
     }
 
     virtual bool unloadChunk(ChunkBase<N, T> * chunk, bool destroy)
     {
         if(destroy)
+        {
+            if(compression_pool_)
+                static_cast<Chunk *>(chunk)->reclaim();
             static_cast<Chunk *>(chunk)->deallocate();
-        else
+        }
+        else if(!compression_pool_)
+        {
             static_cast<Chunk *>(chunk)->compress(compression_method_);
+        }
         return destroy;
     }
 
+    virtual void unloadChunkDeferred(ChunkBase<N, T> * c)
+    {
+        if(!compression_pool_)
+            return;
+        Chunk * chunk = static_cast<Chunk *>(c);
+        std::size_t generation = chunk->schedule();
+        if(generation == 0)
+            return;
+        compression_pool_->enqueue(
+            [this, chunk, generation](int)
+            {
+                std::size_t compressed = chunk->compressPending(this->compression_method_, generation);
+                if(compressed > 0)
+                {
+                    this->data_bytes_ -= chunk->size_*sizeof(T);
+                    this->data_bytes_ += compressed;
+                }
+            });
+    }
+
+    /** \brief Block until all chunks handed to the write-behind compression
+        (see \ref ChunkedArrayOptions::compressionThreads()) are compressed.
+
+        Does nothing when chunks are compressed synchronously.
+    */
+    void waitCompressionFinished()
+    {
+        if(compression_pool_)
+            compression_pool_->waitFinished();
+    }
+
     virtual std::string backend() const
     {
-        switch(compression_method_)
+        std::string method;
+        switch(compression_method_ & ~(SHUFFLE_FILTER | BITSHUFFLE_FILTER | DELTA_FILTER))
         {
           case ZLIB:
-            return "ChunkedArrayCompressed<ZLIB>";
+            method = "ZLIB";
+            break;
           case ZLIB_NONE:
-            return "ChunkedArrayCompressed<ZLIB_NONE>";
+            method = "ZLIB_NONE";
+            break;
           case ZLIB_FAST:
-            return "ChunkedArrayCompressed<ZLIB_FAST>";
+            method = "ZLIB_FAST";
+            break;
           case ZLIB_BEST:
-            return "ChunkedArrayCompressed<ZLIB_BEST>";
+            method = "ZLIB_BEST";
+            break;
           case LZ4:
-            return "ChunkedArrayCompressed<LZ4>";
+            method = "LZ4";
+            break;
           default:
             return "unknown";
         }
+        if(compression_method_ & DELTA_FILTER)
+            method += "_DELTA";
+        if(compression_method_ & SHUFFLE_FILTER)
+            method += "_SHUFFLE";
+        if(compression_method_ & BITSHUFFLE_FILTER)
+            method += "_BITSHUFFLE";
+        return "ChunkedArrayCompressed<" + method + ">";
     }
 
     virtual std::size_t dataBytes(ChunkBase<N,T> * c) const
@@ -2994,6 +3691,7 @@ class ChunkedArrayCompressed
     }
 
     CompressionMethod compression_method_;
+    VIGRA_UNIQUE_PTR<ThreadPool> compression_pool_;
 };
 
 /** \weakgroup ParallelProcessing
@@ -3210,6 +3908,8 @@ class ChunkedArrayTmpFile
             shape_type shape = this->chunkShape(index);
             std::size_t chunk_size = computeAllocSize(shape);
         #ifdef VIGRA_NO_SPARSE_FILE
+            // chunks may be loaded concurrently, but the file must grow serially
+            threading::lock_guard<threading::mutex> guard(*this->chunk_lock_);
             std::size_t offset = file_size_;
             if(offset + chunk_size > file_capacity_)
             {
@@ -3263,6 +3963,508 @@ class ChunkedArrayTmpFile
     std::size_t file_size_, file_capacity_;
 };
 
+/** \weakgroup ParallelProcessing
+    \sa ChunkedArrayMmap
+*/
+
+/** Implement ChunkedArray as a persistent file of memory-mapped chunks.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\> <br/>
+    Namespace: vigra
+
+    In contrast to \ref ChunkedArrayTmpFile, the chunks are stored in a named file
+    that survives the array, so that big intermediate results can be reopened later,
+    possibly by another process. The file starts with a small header (magic number,
+    format version, byte order, dimension, element size, array shape, chunk shape,
+    and a flag per chunk telling whether the chunk has ever been written), followed
+    by the chunks at fixed offsets aligned to the mapping granularity. The file is
+    created as a sparse file, so that chunks which were never written don't occupy
+    disk space.
+
+    Chunks are memory-mapped on demand and unmapped when they are evicted from the
+    cache. Reopening an existing file only reads the header, regardless of the array
+    size, and chunk data are never copied: the array refers directly to the operating
+    system's page cache, which also takes care of writing modified chunks back to disk.
+
+    Since chunks are stored as raw bytes, the element type should be trivially copyable.
+    The header records <tt>sizeof(T)</tt>, but not the type itself, so a file must be
+    opened with the element type it was created with. Files use the native byte order
+    and cannot be opened on machines with a different byte order.
+*/
+template <unsigned int N, class T>
+class ChunkedArrayMmap
+: public ChunkedArray<N, T>
+{
+  public:
+#ifdef _WIN32
+    typedef HANDLE FileHandle;
+#else
+    typedef int FileHandle;
+#endif
+
+        /** How to open the file.
+        */
+    enum OpenMode {
+        New,        ///< Create a new file, replacing any existing file of the same name.
+        ReadWrite,  ///< Open an existing file for reading and writing, create it if it doesn't exist.
+        ReadOnly,   ///< Open an existing file for reading.
+        Default     ///< Resolves to ReadOnly when the file exists, and to New otherwise.
+    };
+
+    class Chunk
+    : public ChunkBase<N, T>
+    {
+      public:
+        typedef typename MultiArrayShape<N>::type  shape_type;
+        typedef T value_type;
+        typedef value_type * pointer;
+        typedef value_type & reference;
+
+        Chunk(shape_type const & shape,
+              std::size_t offset, size_t alloc_size,
+              FileHandle file, bool read_only)
+        : ChunkBase<N, T>(detail::defaultStride(shape))
+        , offset_(offset)
+        , alloc_size_(alloc_size)
+        , file_(file)
+        , read_only_(read_only)
+        {}
+
+        ~Chunk()
+        {
+            unmap();
+        }
+
+        pointer map()
+        {
+            if(this->pointer_ == 0)
+            {
+            // Read-only chunks are mapped copy-on-write: changes through
+            // iterators remain private and never reach the file.
+            #ifdef _WIN32
+                static const std::size_t bits = sizeof(DWORD)*8,
+                                         mask = (std::size_t(1) << bits) - 1;
+                this->pointer_ = (pointer)MapViewOfFile(file_, read_only_ ? FILE_MAP_COPY : FILE_MAP_ALL_ACCESS,
+                                           std::size_t(offset_) >> bits, offset_ & mask, alloc_size_);
+                if(this->pointer_ == 0)
+                    winErrorToException("ChunkedArrayMmap::Chunk::map(): ");
+            #else
+                void * p = mmap(0, alloc_size_, PROT_READ | PROT_WRITE,
+                                read_only_ ? MAP_PRIVATE : MAP_SHARED, file_, offset_);
+                if(p == MAP_FAILED)
+                    throw std::runtime_error("ChunkedArrayMmap::Chunk::map(): mmap() failed.");
+                this->pointer_ = (pointer)p;
+            #endif
+            }
+            return this->pointer_;
+        }
+
+        void unmap()
+        {
+            if(this->pointer_ != 0)
+            {
+        #ifdef _WIN32
+                ::UnmapViewOfFile(this->pointer_);
+        #else
+                munmap(this->pointer_, alloc_size_);
+        #endif
+                this->pointer_ = 0;
+            }
+        }
+
+        std::size_t offset_, alloc_size_;
+        FileHandle file_;
+        bool read_only_;
+
+      private:
+        Chunk & operator=(Chunk const &);
+    };
+
+    typedef MultiArray<N, SharedChunkHandle<N, T>  > ChunkStorage;
+    typedef MultiArray<N, std::size_t>               OffsetStorage;
+    typedef typename ChunkStorage::difference_type   shape_type;
+    typedef T value_type;
+    typedef value_type * pointer;
+    typedef value_type & reference;
+
+        // layout of the fixed part of the file header,
+        // followed by one 'written' flag per chunk
+    struct Header
+    {
+        char magic[8];
+        UInt32 version, byte_order, dimension, element_size;
+        UInt64 shape[N], chunk_shape[N];
+    };
+
+    static std::size_t computeAllocSize(shape_type const & shape)
+    {
+        std::size_t size = prod(shape)*sizeof(T);
+        std::size_t mask = mmap_alignment - 1;
+        return (size + mask) & ~mask;
+    }
+
+    /** \brief Create or open the file 'filename' holding an array of the given 'shape'.
+
+        Argument 'mode' must be one of the following:
+        <ul>
+        <li>New: Create a new file, possibly replacing an existing one.
+        <li>ReadWrite: Open the file for reading and writing. Create the file if it doesn't exist.
+        <li>ReadOnly: Open the file for reading. It is an error to request this mode
+                      when the file doesn't exist.
+        <li>Default: Resolves to ReadOnly when the file exists, and to New otherwise.
+        </ul>
+        When an existing file is opened, its shape and chunk shape must match the
+        arguments (a default-constructed 'chunk_shape' matches any chunk shape).
+        Chunks that were written previously retain their data, all others
+        assume <tt>options.fill_value</tt>.
+    */
+    ChunkedArrayMmap(std::string const & filename,
+                     OpenMode mode,
+                     shape_type const & shape,
+                     shape_type const & chunk_shape=shape_type(),
+                     ChunkedArrayOptions const & options = ChunkedArrayOptions())
+    : ChunkedArray<N, T>(shape, resolveChunkShape(filename, mode, chunk_shape), options)
+    , filename_(filename)
+    {
+        init(mode);
+    }
+
+    /** \brief Open the existing file 'filename'.
+
+        Shape and chunk shape are read from the file. Argument 'mode' must be
+        <tt>ReadOnly</tt> (default) or <tt>ReadWrite</tt>.
+    */
+    explicit ChunkedArrayMmap(std::string const & filename,
+                              OpenMode mode = ReadOnly,
+                              ChunkedArrayOptions const & options = ChunkedArrayOptions())
+    : ChunkedArrayMmap(filename, checkExistingMode(mode), readHeader(filename), options)
+    {}
+
+    ~ChunkedArrayMmap()
+    {
+        typename ChunkStorage::iterator  i = this->handle_array_.begin(),
+                                         end = this->handle_array_.end();
+        for(; i != end; ++i)
+        {
+            if(i->pointer_)
+                delete static_cast<Chunk*>(i->pointer_);
+            i->pointer_ = 0;
+        }
+    #ifdef _WIN32
+        ::UnmapViewOfFile(header_);
+        ::CloseHandle(mappedFile_);
+        ::CloseHandle(file_);
+    #else
+        munmap(header_, header_size_);
+        ::close(file_);
+    #endif
+    }
+
+    /** \brief Name of the underlying file.
+    */
+    std::string const & fileName() const
+    {
+        return filename_;
+    }
+
+    /** \brief Check if the chunk at the given chunk index was ever written.
+
+        Chunks which were not written read as <tt>options.fill_value</tt>
+        and occupy no disk space.
+    */
+    bool isChunkWritten(shape_type const & chunk_index) const
+    {
+        return written_[chunkLinearIndex(chunk_index)] != 0;
+    }
+
+    virtual bool isReadOnly() const
+    {
+        return read_only_;
+    }
+
+    virtual pointer loadChunk(ChunkBase<N, T> ** p, shape_type const & index)
+    {
+        if(*p == 0)
+        {
+            *p = new Chunk(this->chunkShape(index), offset_array_[index],
+                           computeAllocSize(this->chunkShape(index)), mappedFile_, read_only_);
+            this->overhead_bytes_ += sizeof(Chunk);
+        }
+        pointer res = static_cast<Chunk*>(*p)->map();
+        // Chunks are only loaded when they exist in the file or are about to
+        // be initialized for writing. Chunks are loaded under exclusive access,
+        // and each chunk owns its flag, so the flags need no further locking.
+        std::size_t k = chunkLinearIndex(index);
+        if(!read_only_ && written_[k] == 0)
+            written_[k] = 1;
+        return res;
+    }
+
+    virtual bool unloadChunk(ChunkBase<N, T> * chunk, bool /* destroy*/)
+    {
+        static_cast<Chunk *>(chunk)->unmap();
+        return false; // never destroys the data
+    }
+
+    virtual std::string backend() const
+    {
+        return "ChunkedArrayMmap";
+    }
+
+    virtual std::size_t dataBytes(ChunkBase<N,T> * c) const
+    {
+        return c->pointer_ == 0
+                 ? 0
+                 : static_cast<Chunk*>(c)->alloc_size_;
+    }
+
+    virtual std::size_t overheadBytesPerChunk() const
+    {
+        return sizeof(Chunk) + sizeof(SharedChunkHandle<N, T>) + sizeof(std::size_t) + 1;
+    }
+
+  private:
+        // open an existing file whose header has already been read and validated
+    ChunkedArrayMmap(std::string const & filename,
+                     OpenMode mode,
+                     std::pair<shape_type, shape_type> const & shapes,
+                     ChunkedArrayOptions const & options)
+    : ChunkedArray<N, T>(shapes.first, shapes.second, options)
+    , filename_(filename)
+    {
+        init(mode, true);
+    }
+
+    static OpenMode checkExistingMode(OpenMode mode)
+    {
+        vigra_precondition(mode == ReadOnly || mode == ReadWrite,
+            "ChunkedArrayMmap(filename, mode): mode must be ReadOnly or ReadWrite.");
+        return mode;
+    }
+
+    static UInt32 byteOrderMark()
+    {
+        return 0x01020304u;
+    }
+
+    static bool fileExists(std::string const & filename)
+    {
+        std::FILE * f = std::fopen(filename.c_str(), "rb");
+        if(f == 0)
+            return false;
+        std::fclose(f);
+        return true;
+    }
+
+    static void checkHeader(Header const & header, std::string const & filename)
+    {
+        std::string message = "ChunkedArrayMmap(): file '" + filename + "' ";
+        vigra_precondition(std::equal(header.magic, header.magic + 8, "VIGRACHK"),
+            message + "is not a chunked array file.");
+        vigra_precondition(header.version == 1,
+            message + "has unsupported format version.");
+        vigra_precondition(header.byte_order == byteOrderMark(),
+            message + "has wrong byte order.");
+        vigra_precondition(header.dimension == N,
+            message + "has wrong dimension.");
+        vigra_precondition(header.element_size == sizeof(T),
+            message + "has wrong element size.");
+    }
+
+        // read array shape and chunk shape from an existing file
+    static std::pair<shape_type, shape_type> readHeader(std::string const & filename)
+    {
+        Header header;
+        std::FILE * f = std::fopen(filename.c_str(), "rb");
+        vigra_precondition(f != 0,
+            "ChunkedArrayMmap(): unable to open file '" + filename + "'.");
+        std::size_t count = std::fread(&header, sizeof(Header), 1, f);
+        std::fclose(f);
+        vigra_precondition(count == 1,
+            "ChunkedArrayMmap(): file '" + filename + "' is not a chunked array file.");
+        checkHeader(header, filename);
+        std::pair<shape_type, shape_type> res;
+        for(unsigned int k=0; k<N; ++k)
+        {
+            res.first[k]  = (MultiArrayIndex)header.shape[k];
+            res.second[k] = (MultiArrayIndex)header.chunk_shape[k];
+        }
+        return res;
+    }
+
+        // an existing file dictates the chunk shape unless one is requested explicitly
+    static shape_type resolveChunkShape(std::string const & filename, OpenMode mode,
+                                        shape_type const & chunk_shape)
+    {
+        if(chunk_shape != shape_type() || mode == New || !fileExists(filename))
+            return chunk_shape;
+        return readHeader(filename).second;
+    }
+
+    std::size_t chunkLinearIndex(shape_type const & chunk_index) const
+    {
+        return &this->handle_array_[chunk_index] - this->handle_array_.data();
+    }
+
+    void init(OpenMode mode, bool header_checked = false)
+    {
+        bool exists = fileExists(filename_);
+        if(mode == Default)
+            mode = exists ? ReadOnly : New;
+        vigra_precondition(exists || mode != ReadOnly,
+            "ChunkedArrayMmap(): file '" + filename_ + "' does not exist, but mode is ReadOnly.");
+        bool create = !exists || mode == New;
+        read_only_ = (mode == ReadOnly);
+
+        if(!create && !header_checked)
+        {
+            // validate the header before any resources are acquired, because
+            // the destructor won't release them when the constructor throws
+            std::pair<shape_type, shape_type> shapes = readHeader(filename_);
+            vigra_precondition(shapes.first == this->shape_,
+                "ChunkedArrayMmap(filename, mode, shape): shape mismatch between file and shape argument.");
+            vigra_precondition(shapes.second == this->chunk_shape_,
+                "ChunkedArrayMmap(filename, mode, shape, chunk_shape): chunk shape mismatch between file and chunk_shape argument.");
+        }
+
+        // compute chunk offsets in file
+        offset_array_.reshape(this->chunkArrayShape());
+        std::size_t chunk_count = offset_array_.size(),
+                    mask = mmap_alignment - 1;
+        header_size_ = (sizeof(Header) + chunk_count + mask) & ~mask;
+        typename OffsetStorage::iterator i = offset_array_.begin(),
+                                         end = offset_array_.end();
+        std::size_t size = header_size_;
+        for(; i != end; ++i)
+        {
+            *i = size;
+            size += computeAllocSize(this->chunkShape(i.point()));
+        }
+        this->overhead_bytes_ += offset_array_.size()*(sizeof(std::size_t) + 1);
+
+    #ifdef _WIN32
+        file_ = ::CreateFile(filename_.c_str(),
+                             read_only_ ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE,
+                             FILE_SHARE_READ, NULL,
+                             create ? CREATE_ALWAYS : OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file_ == INVALID_HANDLE_VALUE)
+            winErrorToException("ChunkedArrayMmap(): ");
+        if(!create)
+        {
+            // the chunks must not be mapped beyond the end of a truncated file
+            LARGE_INTEGER file_size;
+            if(!::GetFileSizeEx(file_, &file_size))
+            {
+                ::CloseHandle(file_);
+                winErrorToException("ChunkedArrayMmap(): ");
+            }
+            if((UInt64)file_size.QuadPart < (UInt64)size)
+            {
+                ::CloseHandle(file_);
+                throw std::runtime_error("ChunkedArrayMmap(): file '" + filename_ + "' is truncated.");
+            }
+        }
+        else
+        {
+            // make it a sparse file
+            DWORD dwTemp;
+            if(!::DeviceIoControl(file_, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &dwTemp, NULL))
+            {
+                ::CloseHandle(file_);
+                winErrorToException("ChunkedArrayMmap(): ");
+            }
+        }
+        static const std::size_t bits = sizeof(LONG)*8, lmask = (std::size_t(1) << bits) - 1;
+        mappedFile_ = CreateFileMapping(file_, NULL, read_only_ ? PAGE_WRITECOPY : PAGE_READWRITE,
+                                        create ? size >> bits : 0, create ? size & lmask : 0, NULL);
+        if(!mappedFile_)
+        {
+            ::CloseHandle(file_);
+            winErrorToException("ChunkedArrayMmap(): ");
+        }
+        header_ = (char *)MapViewOfFile(mappedFile_, read_only_ ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS,
+                                        0, 0, header_size_);
+        if(header_ == 0)
+        {
+            ::CloseHandle(mappedFile_);
+            ::CloseHandle(file_);
+            winErrorToException("ChunkedArrayMmap(): ");
+        }
+    #else
+        mappedFile_ = file_ = ::open(filename_.c_str(),
+                                     read_only_ ? O_RDONLY : (create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR),
+                                     0644);
+        if(file_ == -1)
+            throw std::runtime_error("ChunkedArrayMmap(): unable to open file '" + filename_ + "'.");
+        if(!create)
+        {
+            // the chunks must not be mapped beyond the end of a truncated file
+            struct stat file_stat;
+            if(::fstat(file_, &file_stat) == -1)
+            {
+                ::close(file_);
+                throw std::runtime_error("ChunkedArrayMmap(): unable to stat file '" + filename_ + "'.");
+            }
+            if((UInt64)file_stat.st_size < (UInt64)size)
+            {
+                ::close(file_);
+                throw std::runtime_error("ChunkedArrayMmap(): file '" + filename_ + "' is truncated.");
+            }
+        }
+        else if(ftruncate(file_, size) == -1)
+        {
+            ::close(file_);
+            throw std::runtime_error("ChunkedArrayMmap(): unable to resize file '" + filename_ + "'.");
+        }
+        void * h = mmap(0, header_size_, read_only_ ? PROT_READ : PROT_READ | PROT_WRITE,
+                        MAP_SHARED, file_, 0);
+        if(h == MAP_FAILED)
+        {
+            ::close(file_);
+            throw std::runtime_error("ChunkedArrayMmap(): unable to map header of file '" + filename_ + "'.");
+        }
+        header_ = (char *)h;
+    #endif
+        written_ = (UInt8 *)header_ + sizeof(Header);
+
+        Header & header = *(Header *)header_;
+        if(create)
+        {
+            std::copy("VIGRACHK", "VIGRACHK" + 8, header.magic);
+            header.version = 1;
+            header.byte_order = byteOrderMark();
+            header.dimension = N;
+            header.element_size = sizeof(T);
+            for(unsigned int k=0; k<N; ++k)
+            {
+                header.shape[k] = (UInt64)this->shape_[k];
+                header.chunk_shape[k] = (UInt64)this->chunk_shape_[k];
+            }
+            // the 'written' flags are zero in a freshly truncated file
+        }
+        else
+        {
+            // chunks already in the file are asleep, all others remain uninitialized
+            typename ChunkStorage::iterator h   = this->handle_array_.begin(),
+                                            hend = this->handle_array_.end();
+            for(std::size_t k=0; h != hend; ++h, ++k)
+            {
+                if(written_[k])
+                    h->chunk_state_.store(ChunkedArray<N, T>::chunk_asleep);
+            }
+        }
+    }
+
+    std::string filename_;
+    OffsetStorage offset_array_;  // the file offsets of the chunks
+    FileHandle file_, mappedFile_;  // the file back-end
+    char * header_;
+    UInt8 * written_;
+    std::size_t header_size_;
+    bool read_only_;
+};
+
 template<unsigned int N, class U>
 class ChunkIterator
 : public MultiCoordinateIterator<N>
@@ -3293,6 +4495,8 @@ class ChunkIterator
     ChunkIterator()
     : base_type()
     , base_type2()
+    , array_()
+    , prefetcher_()
     {}
 
     ChunkIterator(array_type * array,
@@ -3305,6 +4509,7 @@ class ChunkIterator
     , start_(start - chunk_.offset_)
     , stop_(end - chunk_.offset_)
     , chunk_shape_(chunk_shape)
+    , prefetcher_()
     {
         getChunk();
     }
@@ -3317,20 +4522,31 @@ class ChunkIterator
     , start_(rhs.start_)
     , stop_(rhs.stop_)
     , chunk_shape_(rhs.chunk_shape_)
+    , prefetcher_(rhs.prefetcher_)
     {
         getChunk();
     }
 
+    ~ChunkIterator()
+    {
+        // deref the present chunk
+        if(array_)
+            array_->unrefChunk(&chunk_);
+    }
+
     ChunkIterator & operator=(ChunkIterator const & rhs)
     {
         if(this != &rhs)
         {
+            if(array_)
+                array_->unrefChunk(&chunk_);
             base_type::operator=(rhs);
             array_ = rhs.array_;
             chunk_ = rhs.chunk_;
             start_ = rhs.start_;
             stop_ = rhs.stop_;
             chunk_shape_ = rhs.chunk_shape_;
+            prefetcher_ = rhs.prefetcher_;
             getChunk();
         }
         return *this;
@@ -3368,8 +4584,16 @@ class ChunkIterator
 
     void getChunk()
     {
-        if(array_)
+        if(array_ && !this->isValid())
         {
+            // don't activate chunks beyond the end of the iteration range
+            array_->unrefChunk(&chunk_);
+            this->m_ptr = 0;
+        }
+        else if(array_)
+        {
+            if(prefetcher_)
+                prefetcher_->advance(this->scanOrderIndex());
             shape_type array_point = max(start_, this->point()*chunk_shape_),
                        upper_bound(SkipInitialization);
             this->m_ptr = array_->chunkForIterator(array_point, this->m_stride, upper_bound, &chunk_);
@@ -3377,6 +4601,20 @@ class ChunkIterator
         }
     }
 
+        /** \brief Let the given prefetcher read ahead while the iterator
+            advances.
+
+            The prefetcher must have been constructed for the ROI of this
+            iterator, so that its steps match the iterator's scan order.
+        */
+    ChunkIterator & prefetch(ChunkPrefetcher<N, T> & prefetcher)
+    {
+        prefetcher_ = &prefetcher;
+        if(this->isValid())
+            prefetcher.advance(this->scanOrderIndex());
+        return *this;
+    }
+
     shape_type chunkStart() const
     {
         return max(start_, this->point()*chunk_shape_) + chunk_.offset_;
@@ -3481,6 +4719,7 @@ class ChunkIterator
     array_type * array_;
     Chunk chunk_;
     shape_type start_, stop_, chunk_shape_, array_point_;
+    ChunkPrefetcher<N, T> * prefetcher_;
 };
 
 //@}
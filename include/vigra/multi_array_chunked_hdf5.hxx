@@ -183,6 +183,10 @@ class ChunkedArrayHDF5
         <li>ZLIB_NONE: Use 'zlib' format without compression.
         <li>DEFAULT_COMPRESSION: Same as ZLIB_FAST.
         </ul>
+        Unless the raw data chunk cache is configured via \ref HDF5File::setChunkCache()
+        for 'file', it is chosen automatically: HDF5's cache is disabled when the
+        array's chunks coincide with the dataset's chunks (the array caches them itself),
+        and holds a layer of the dataset's chunks otherwise.
     */
     ChunkedArrayHDF5(HDF5File const & file, std::string const & dataset,
                      HDF5File::OpenMode mode,
@@ -221,6 +225,7 @@ class ChunkedArrayHDF5
         <li>ZLIB_NONE: Use 'zlib' format without compression.
         <li>DEFAULT_COMPRESSION: Same as ZLIB_FAST.
         </ul>
+        The raw data chunk cache is chosen as in the other constructor.
     */
     ChunkedArrayHDF5(HDF5File const & file, std::string const & dataset,
                      HDF5File::OpenMode mode = HDF5File::ReadOnly,
@@ -278,29 +283,36 @@ class ChunkedArrayHDF5
         vigra_precondition(exists || !file_.isReadOnly(),
             "ChunkedArrayHDF5(): dataset does not exist, but file is read-only.");
 
+        if(file_.chunkCache().isDefault())
+        {
+            // The array keeps recently used chunks in its own cache. When the
+            // array's chunks coincide with the file's chunks, HDF5's chunk cache
+            // would only duplicate them and is disabled. Otherwise, HDF5's cache
+            // must hold the file chunks shared by neighbouring array chunks.
+            bool aligned = !exists || mode == HDF5File::New;
+            if(!aligned)
+            {
+                ArrayVector<hsize_t> fileChunks(file_.getChunkShape(dataset_name_));
+                unsigned int offset = detail::HDF5TypeTraits<T>::numberOfBands() > 1
+                                           ? 1
+                                           : 0;
+                aligned = fileChunks.size() == N + offset;
+                for(unsigned int k=0; k<N && aligned; ++k)
+                    aligned = fileChunks[k+offset] == static_cast<hsize_t>(this->chunk_shape_[k]);
+            }
+            if(aligned)
+                file_.setChunkCache(HDF5ChunkCacheOptions().bytes(0));
+            else
+                file_.setChunkCache(HDF5ChunkCacheOptions().blockAccess()
+                                                           .maxBytes(std::size_t(64) << 20));
+        }
+
         if(!exists || mode == HDF5File::New)
         {
-            // FIXME: set rdcc_nbytes to 0 (disable cache, because we don't
-            //        need two caches
-            // H5Pset_chunk_cache (dapl, rdcc_nslots, rdcc_nbytes, rdcc_w0);
-            // Chunk cache size (rdcc_nbytes) should be large
-            // enough to hold all the chunks in a selection
-            // * If this is not possible, it may be best to disable chunk
-            // caching altogether (set rdcc_nbytes to 0)
-            // * rdcc_slots should be a prime number that is at
-            // least 10 to 100 times the number of chunks that can fit
-            // into rdcc_nbytes
-            // * rdcc_w0 should be set to 1 if chunks that have been
-            // fully read/written will never be read/written again
-            //
-            // the above may be WRONG in general - it may only apply if the
-            // chunk size in the file matches the chunk size in the CachedArray.
-            // Otherwise, make sure that the file cache can hold at least as many
-            // chunks as are needed for a single array chunk.
             if(compression_ == DEFAULT_COMPRESSION)
                 compression_ = ZLIB_FAST;
-            vigra_precondition(compression_ != LZ4,
-                "ChunkedArrayHDF5(): HDF5 does not support LZ4 compression.");
+            vigra_precondition(compression_ < LZ4,
+                "ChunkedArrayHDF5(): HDF5 does not support LZ4 compression and pre-filters.");
 
             vigra_precondition(this->size() > 0,
                 "ChunkedArrayHDF5(): invalid shape.");
@@ -423,6 +435,8 @@ class ChunkedArrayHDF5
 
     virtual pointer loadChunk(ChunkBase<N, T> ** p, shape_type const & index)
     {
+        // the HDF5 library must not be entered by several threads at once
+        threading::lock_guard<threading::mutex> guard(*this->chunk_lock_);
         vigra_precondition(file_.isOpen(),
             "ChunkedArrayHDF5::loadChunk(): file was already closed.");
         if(*p == 0)
@@ -435,6 +449,7 @@ class ChunkedArrayHDF5
 
     virtual bool unloadChunk(ChunkBase<N, T> * chunk, bool /* destroy */)
     {
+        threading::lock_guard<threading::mutex> guard(*this->chunk_lock_);
         if(!file_.isOpen())
             return true;
         static_cast<Chunk *>(chunk)->write();
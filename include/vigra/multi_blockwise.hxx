@@ -44,6 +44,7 @@
 #include "multi_tensorutilities.hxx"
 #include "threadpool.hxx"
 #include "array_vector.hxx"
+#include "multi_array_chunked.hxx"
 
 namespace vigra{
 
@@ -196,7 +197,7 @@ namespace blockwise{
         auto beginIter  =  blocking.blockWithBorderBegin(borderWidth);
         auto endIter   =  blocking.blockWithBorderEnd(borderWidth);
 
-        parallel_foreach(options.getNumThreads(),
+        parallel_foreach(options,
             beginIter, endIter,
             [&](const int /*threadId*/, const BlockWithBorder bwb)
             {
@@ -248,7 +249,7 @@ namespace blockwise{
         auto beginIter  =  blocking.blockWithBorderBegin(borderWidth);
         auto endIter   =  blocking.blockWithBorderEnd(borderWidth);
 
-        parallel_foreach(options.getNumThreads(),
+        parallel_foreach(options,
             beginIter, endIter,
             [&](const int /*threadId*/, const BlockWithBorder bwb)
             {
@@ -268,6 +269,55 @@ namespace blockwise{
 
     }
 
+    /**
+        helper function to create blockwise parallel filters
+        on chunked arrays. Each block is checked out together with its
+        halo into a temporary array, filtered, and the block's core is
+        committed into the destination. Thus, peak memory depends on
+        the block shape and the number of threads, not on the array size.
+        The functor must support the ROI/sub array options.
+    */
+    template<
+        unsigned int DIM,
+        class T_IN,
+        class T_OUT,
+        class FILTER_FUNCTOR,
+        class C
+    >
+    void blockwiseCaller(
+        const vigra::ChunkedArray<DIM, T_IN> & source,
+        vigra::ChunkedArray<DIM, T_OUT> & dest,
+        FILTER_FUNCTOR & functor,
+        const vigra::MultiBlocking<DIM, C> & blocking,
+        const typename vigra::MultiBlocking<DIM, C>::Shape & borderWidth,
+        const BlockwiseConvolutionOptions<DIM>  & options
+    ){
+
+        typedef typename MultiBlocking<DIM, C>::BlockWithBorder BlockWithBorder;
+        typedef typename MultiBlocking<DIM, C>::Block Block;
+
+        auto beginIter  =  blocking.blockWithBorderBegin(borderWidth);
+        auto endIter   =  blocking.blockWithBorderEnd(borderWidth);
+
+        parallel_foreach(options,
+            beginIter, endIter,
+            [&](const int /*threadId*/, const BlockWithBorder bwb)
+            {
+                // copy the input of the block (including its halo) into memory
+                vigra::MultiArray<DIM, T_IN> sourceSub(bwb.border().size());
+                source.checkoutSubarray(bwb.border().begin(), sourceSub);
+                // allocate the output for the block's core only
+                vigra::MultiArray<DIM, T_OUT> destCore(bwb.core().size());
+                const Block localCore =  bwb.localCore();
+                // call the functor
+                functor(sourceSub, destCore, localCore.begin(), localCore.end());
+                // write the core back into the chunked array
+                dest.commitSubarray(bwb.core().begin(), destCore);
+            },
+            blocking.numBlocks()
+        );
+    }
+
     #define CONVOLUTION_FUNCTOR(FUNCTOR_NAME, FUNCTION_NAME) \
     template<unsigned int DIM> \
     class FUNCTOR_NAME{ \
@@ -434,18 +484,50 @@ void FUNCTION( \
     blockwise::blockwiseCaller(source, dest, f, blocking, border, options); \
 }
 
-VIGRA_BLOCKWISE(GaussianSmoothFunctor,                   gaussianSmoothMultiArray,                   0, false );
-VIGRA_BLOCKWISE(GaussianGradientFunctor,                 gaussianGradientMultiArray,                 1, false );
-VIGRA_BLOCKWISE(SymmetricGradientFunctor,                symmetricGradientMultiArray,                1, false );
-VIGRA_BLOCKWISE(GaussianDivergenceFunctor,               gaussianDivergenceMultiArray,               1, false );
-VIGRA_BLOCKWISE(HessianOfGaussianFunctor,                hessianOfGaussianMultiArray,                2, false );
-VIGRA_BLOCKWISE(HessianOfGaussianEigenvaluesFunctor,     hessianOfGaussianEigenvaluesMultiArray,     2, false );
-VIGRA_BLOCKWISE(HessianOfGaussianFirstEigenvalueFunctor, hessianOfGaussianFirstEigenvalueMultiArray, 2, false );
-VIGRA_BLOCKWISE(HessianOfGaussianLastEigenvalueFunctor,  hessianOfGaussianLastEigenvalueMultiArray,  2, false );
-VIGRA_BLOCKWISE(LaplacianOfGaussianFunctor,              laplacianOfGaussianMultiArray,              2, false );
-VIGRA_BLOCKWISE(GaussianGradientMagnitudeFunctor,        gaussianGradientMagnitudeMultiArray,        1, false );
-VIGRA_BLOCKWISE(StructureTensorFunctor,                  structureTensorMultiArray,                  1, true  );
+    /* Overloads for ChunkedArray sources and destinations. If no block shape
+       is given in the options, the blocks coincide with the source's chunks.
+    */
+#define VIGRA_BLOCKWISE_CHUNKED(FUNCTOR, FUNCTION, ORDER, USES_OUTER_SCALE) \
+template <unsigned int N, class T1, class T2> \
+void FUNCTION( \
+    ChunkedArray<N, T1> const & source, \
+    ChunkedArray<N, T2> & dest, \
+    BlockwiseConvolutionOptions<N> const & options \
+) \
+{  \
+    typedef  MultiBlocking<N, vigra::MultiArrayIndex> Blocking; \
+    typedef typename Blocking::Shape Shape; \
+    vigra_precondition(source.shape() == dest.shape(), \
+        #FUNCTION "(): shape mismatch between input and output."); \
+    const Shape border = blockwise::getBorder(options, ORDER, USES_OUTER_SCALE); \
+    BlockwiseConvolutionOptions<N> subOptions(options); \
+    subOptions.subarray(Shape(0), Shape(0));  \
+    const Shape blockShape = options.getBlockShape().size() == 0 \
+                                 ? source.chunkShape() \
+                                 : options.template getBlockShapeN<N>(); \
+    const Blocking blocking(source.shape(), blockShape); \
+    blockwise::FUNCTOR<N> f(subOptions); \
+    blockwise::blockwiseCaller(source, dest, f, blocking, border, options); \
+}
 
+#define VIGRA_BLOCKWISE_ALL(FUNCTOR, FUNCTION, ORDER, USES_OUTER_SCALE) \
+VIGRA_BLOCKWISE(FUNCTOR, FUNCTION, ORDER, USES_OUTER_SCALE) \
+VIGRA_BLOCKWISE_CHUNKED(FUNCTOR, FUNCTION, ORDER, USES_OUTER_SCALE)
+
+VIGRA_BLOCKWISE_ALL(GaussianSmoothFunctor,                    gaussianSmoothMultiArray,                    0, false );
+VIGRA_BLOCKWISE_ALL(GaussianGradientFunctor,                  gaussianGradientMultiArray,                  1, false );
+VIGRA_BLOCKWISE_ALL(SymmetricGradientFunctor,                 symmetricGradientMultiArray,                 1, false );
+VIGRA_BLOCKWISE_ALL(GaussianDivergenceFunctor,                gaussianDivergenceMultiArray,                1, false );
+VIGRA_BLOCKWISE_ALL(HessianOfGaussianFunctor,                 hessianOfGaussianMultiArray,                 2, false );
+VIGRA_BLOCKWISE_ALL(HessianOfGaussianEigenvaluesFunctor,      hessianOfGaussianEigenvaluesMultiArray,      2, false );
+VIGRA_BLOCKWISE_ALL(HessianOfGaussianFirstEigenvalueFunctor,  hessianOfGaussianFirstEigenvalueMultiArray,  2, false );
+VIGRA_BLOCKWISE_ALL(HessianOfGaussianLastEigenvalueFunctor,   hessianOfGaussianLastEigenvalueMultiArray,   2, false );
+VIGRA_BLOCKWISE_ALL(LaplacianOfGaussianFunctor,               laplacianOfGaussianMultiArray,               2, false );
+VIGRA_BLOCKWISE_ALL(GaussianGradientMagnitudeFunctor,         gaussianGradientMagnitudeMultiArray,         1, false );
+VIGRA_BLOCKWISE_ALL(StructureTensorFunctor,                   structureTensorMultiArray,                   1, true  );
+
+#undef  VIGRA_BLOCKWISE_ALL
+#undef  VIGRA_BLOCKWISE_CHUNKED
 #undef  VIGRA_BLOCKWISE
 
     // alternative name for backward compatibility
@@ -459,6 +541,16 @@ gaussianGradientMagnitude(
     gaussianGradientMagnitudeMultiArray(source, dest, options);
 }
 
+template <unsigned int N, class T1, class T2>
+inline void
+gaussianGradientMagnitude(
+    ChunkedArray<N, T1> const & source,
+    ChunkedArray<N, T2> & dest,
+    BlockwiseConvolutionOptions<N> const & options)
+{
+    gaussianGradientMagnitudeMultiArray(source, dest, options);
+}
+
 
 } // end namespace vigra
 
@@ -50,6 +50,7 @@
 #include "functorexpression.hxx"
 #include "tinyvector.hxx"
 #include "algorithm.hxx"
+#include "threadpool.hxx"
 
 
 #include <iostream>
@@ -330,6 +331,13 @@ struct multiArrayScaleParam
                           );
   \endcode
 
+  <b>usage with multiple threads:</b>
+
+  \code
+  gaussianGradientMultiArray(test_image, gradient, scale,
+                             ConvolutionOptions<3>().parallelOptions(ParallelOptions().numThreads(4)));
+  \endcode
+
 */
 template <unsigned dim>
 class ConvolutionOptions
@@ -345,13 +353,15 @@ class ConvolutionOptions
     ParamVec outer_scale;
     double window_ratio;
     Shape from_point, to_point;
+    ParallelOptions parallel_options;
 
     ConvolutionOptions()
     : sigma_eff(0.0),
       sigma_d(0.0),
       step_size(1.0),
       outer_scale(0.0),
-      window_ratio(0.0)
+      window_ratio(0.0),
+      parallel_options(ParallelOptions().numThreads(ParallelOptions::NoThreads))
     {}
 
     typedef typename detail::WrapDoubleIteratorTriple<ParamIt, ParamIt, ParamIt>
@@ -508,6 +518,29 @@ class ConvolutionOptions
       res.second = to_point;
       return res;
     }
+
+        /** Filter the lines of each dimension in parallel.
+
+            Since the 1D convolutions along a given dimension are independent,
+            the array is split into slabs which are processed concurrently by
+            <tt>options.getNumThreads()</tt> threads (in <tt>options.getThreadPool()</tt>
+            or in the global thread pool, see \ref parallel_foreach()). Unlike the
+            blockwise filters, this requires no halo and gives exactly the same
+            result as sequential execution. Computations restricted to a
+            subarray (see <tt>subarray()</tt>) are always executed sequentially.
+
+            Default: <tt>ParallelOptions().numThreads(ParallelOptions::NoThreads)</tt>
+            (i.e. sequential execution)
+        */
+    ConvolutionOptions<dim> & parallelOptions(ParallelOptions const & options)
+    {
+        parallel_options = options;
+        return *this;
+    }
+
+    ParallelOptions const & getParallelOptions() const {
+      return parallel_options;
+    }
 };
 
 namespace detail
@@ -515,16 +548,99 @@ namespace detail
 
 /********************************************************/
 /*                                                      */
-/*        internalSeparableConvolveMultiArray           */
+/*           internalConvolveMultiArrayLines            */
 /*                                                      */
 /********************************************************/
 
+    // Number of adjacent lines that are convolved together by the batched
+    // line convolution below (a batch spans several cache lines and amortizes
+    // the cost of the transposition). Types without a specialization are
+    // convolved line by line.
+template <class T>
+struct ConvolutionBatchTraits
+{
+    typedef VigraFalseType isBatched;
+    enum { size = 1 };
+};
+
+template <>
+struct ConvolutionBatchTraits<float>
+{
+    typedef VigraTrueType isBatched;
+    enum { size = 32 };
+};
+
+template <>
+struct ConvolutionBatchTraits<double>
+{
+    typedef VigraTrueType isBatched;
+    enum { size = 32 };
+};
+
+    // Convolve BATCH interleaved lines at once. Element b of line position x is
+    // read from in[(x + kright)*BATCH + b] (i.e. 'in' must be padded by kright
+    // positions at the front and -kleft positions at the back) and the result is
+    // written to out[x*BATCH + b]. 'kernel' points to the kernel center. Since the
+    // innermost loops run over the batch, the compiler can vectorize them.
+    // The summation order is the same as in convolveLine(), so that both
+    // functions produce identical results.
+template <int BATCH, class T, class SumType>
+void
+convolveLineBatch(T const * in, SumType * out, int size,
+                  SumType const * kernel, int kleft, int kright)
+{
+    for(int x=0; x<size; ++x, out += BATCH)
+    {
+        T const * center = in + (x + kright)*BATCH;
+        SumType sum[BATCH];
+        for(int b=0; b<BATCH; ++b)
+            sum[b] = NumericTraits<SumType>::zero();
+        for(int i=kright; i>=kleft; --i)
+        {
+            SumType const k = kernel[i];
+            T const * s = center - i*BATCH;
+            for(int b=0; b<BATCH; ++b)
+                sum[b] += k*s[b];
+        }
+        for(int b=0; b<BATCH; ++b)
+            out[b] = sum[b];
+    }
+}
+
+    // Fill position x outside of [0, size) of a batch of interleaved lines
+    // (starting at 'line') according to the border treatment.
+template <int BATCH, class T>
+void
+padLineBatch(T * line, int x, int size, BorderTreatmentMode border)
+{
+    int j;
+    switch(border)
+    {
+      case BORDER_TREATMENT_REFLECT:
+        j = x < 0 ? -x : 2*(size-1) - x;
+        break;
+      case BORDER_TREATMENT_REPEAT:
+        j = x < 0 ? 0 : size - 1;
+        break;
+      case BORDER_TREATMENT_WRAP:
+        j = x < 0 ? x + size : x - size;
+        break;
+      default: // BORDER_TREATMENT_ZEROPAD
+        std::fill(line + x*BATCH, line + (x+1)*BATCH, T());
+        return;
+    }
+    std::copy(line + j*BATCH, line + (j+1)*BATCH, line + x*BATCH);
+}
+
+    // Convolve all lines along dimension d, one line at a time.
+    // Source and destination may refer to the same array.
 template <class SrcIterator, class SrcShape, class SrcAccessor,
-          class DestIterator, class DestAccessor, class KernelIterator>
+          class DestIterator, class DestAccessor, class Kernel>
 void
-internalSeparableConvolveMultiArrayTmp(
+internalConvolveMultiArrayLines(
                       SrcIterator si, SrcShape const & shape, SrcAccessor src,
-                      DestIterator di, DestAccessor dest, KernelIterator kit)
+                      DestIterator di, DestAccessor dest, Kernel const & kernel,
+                      int d, VigraFalseType /* batched */)
 {
     enum { N = 1 + SrcIterator::level };
 
@@ -532,47 +648,189 @@ internalSeparableConvolveMultiArrayTmp(
     typedef typename AccessorTraits<TmpType>::default_accessor TmpAcessor;
 
     // temporary array to hold the current line to enable in-place operation
-    ArrayVector<TmpType> tmp( shape[0] );
+    ArrayVector<TmpType> tmp( shape[d] );
 
     typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
     typedef MultiArrayNavigator<DestIterator, N> DNavigator;
 
     TmpAcessor acc;
 
-    {
-        // only operate on first dimension here
-        SNavigator snav( si, shape, 0 );
-        DNavigator dnav( di, shape, 0 );
+    SNavigator snav( si, shape, d );
+    DNavigator dnav( di, shape, d );
 
-        for( ; snav.hasMore(); snav++, dnav++ )
-        {
-             // first copy source to tmp for maximum cache efficiency
-             copyLine(snav.begin(), snav.end(), src, tmp.begin(), acc);
+    for( ; snav.hasMore(); snav++, dnav++ )
+    {
+         // first copy source to tmp for maximum cache efficiency
+         // (and since convolveLine() cannot work in-place)
+         copyLine(snav.begin(), snav.end(), src, tmp.begin(), acc);
 
-             convolveLine(srcIterRange(tmp.begin(), tmp.end(), acc),
-                          destIter( dnav.begin(), dest ),
-                          kernel1d( *kit ) );
-        }
-        ++kit;
+         convolveLine(srcIterRange(tmp.begin(), tmp.end(), acc),
+                      destIter( dnav.begin(), dest ),
+                      kernel1d( kernel ) );
     }
+}
 
-    // operate on further dimensions
-    for( int d = 1; d < N; ++d, ++kit )
+    // Convolve all lines along dimension d, ConvolutionBatchTraits<TmpType>::size
+    // adjacent lines at a time. The lines of a batch are transposed into an
+    // interleaved, border-padded buffer, so that the convolution accesses
+    // contiguous memory and vectorizes, regardless of the stride along d.
+    // Source and destination may refer to the same array.
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class Kernel>
+void
+internalConvolveMultiArrayLines(
+                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                      DestIterator di, DestAccessor dest, Kernel const & kernel,
+                      int d, VigraTrueType /* batched */)
+{
+    enum { N = 1 + SrcIterator::level };
+
+    typedef typename DestAccessor::value_type DestType;
+    typedef typename NumericTraits<DestType>::RealPromote TmpType;
+    enum { BATCH = ConvolutionBatchTraits<TmpType>::size };
+
+    const int size = shape[d],
+              kleft = kernel.left(),
+              kright = kernel.right();
+    const BorderTreatmentMode border = kernel.borderTreatment();
+
+    if(size < std::max(kright, -kleft) + 1 ||
+       (border != BORDER_TREATMENT_REFLECT && border != BORDER_TREATMENT_REPEAT &&
+        border != BORDER_TREATMENT_WRAP    && border != BORDER_TREATMENT_ZEROPAD))
     {
-        DNavigator dnav( di, shape, d );
+        // not supported by the batched version
+        internalConvolveMultiArrayLines(si, shape, src, di, dest, kernel, d, VigraFalseType());
+        return;
+    }
 
-        tmp.resize( shape[d] );
+    // same accumulator type as in convolveLine()
+    typedef typename PromoteTraits<TmpType, typename Kernel::value_type>::Promote SumType;
 
-        for( ; dnav.hasMore(); dnav++ )
-        {
-             // first copy source to tmp since convolveLine() cannot work in-place
-             copyLine(dnav.begin(), dnav.end(), dest, tmp.begin(), acc);
+    ArrayVector<SumType> k(kright - kleft + 1);
+    for(int i=kleft; i<=kright; ++i)
+        k[i-kleft] = kernel[i];
+
+    // the input is stored in SumType to avoid repeated conversions
+    // during the convolution (this doesn't change the results)
+    ArrayVector<SumType> in((size + kright - kleft)*BATCH), out(size*BATCH);
+
+    typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
+    typedef MultiArrayNavigator<DestIterator, N> DNavigator;
+    typedef typename SNavigator::iterator SLineIterator;
+    typedef typename DNavigator::iterator DLineIterator;
 
-             convolveLine(srcIterRange(tmp.begin(), tmp.end(), acc),
-                          destIter( dnav.begin(), dest ),
-                          kernel1d( *kit ) );
+    ArrayVector<SLineIterator> slines;
+    ArrayVector<DLineIterator> dlines;
+    slines.reserve(BATCH);
+    dlines.reserve(BATCH);
+
+    SNavigator snav( si, shape, d );
+    DNavigator dnav( di, shape, d );
+
+    while(snav.hasMore())
+    {
+        // collect a batch of adjacent lines
+        slines.clear();
+        dlines.clear();
+        for( ; snav.hasMore() && slines.size() < (unsigned int)BATCH; snav++, dnav++ )
+        {
+            slines.push_back(snav.begin());
+            dlines.push_back(dnav.begin());
         }
+        const int n = (int)slines.size();
+
+        // transpose the batch into the buffer (also enables in-place operation),
+        // visiting the lines' elements at the same position together
+        SumType * t = in.begin() + kright*BATCH;
+        for(int x=0; x<size; ++x, t += BATCH)
+            for(int b=0; b<n; ++b)
+            {
+                t[b] = TmpType(src(slines[b]));
+                ++slines[b];
+            }
+
+        // apply the border treatment to the padding
+        for(int x=-kright; x<0; ++x)
+            padLineBatch<BATCH>(in.begin() + kright*BATCH, x, size, border);
+        for(int x=size; x<size-kleft; ++x)
+            padLineBatch<BATCH>(in.begin() + kright*BATCH, x, size, border);
+
+        convolveLineBatch<BATCH>(in.begin(), out.begin(), size, k.begin() - kleft, kleft, kright);
+
+        // transpose the result into the destination
+        SumType const * r = out.begin();
+        for(int x=0; x<size; ++x, r += BATCH)
+            for(int b=0; b<n; ++b)
+            {
+                dest.set(detail::RequiresExplicitCast<DestType>::cast(r[b]), dlines[b]);
+                ++dlines[b];
+            }
+    }
+}
+
+    // Convolve all lines along dimension d in parallel. The array is split into
+    // slabs along the outermost dimension other than d, which are filtered
+    // concurrently (each slab contains complete lines along d).
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class Kernel>
+void
+internalConvolveMultiArrayLines(
+                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                      DestIterator di, DestAccessor dest, Kernel const & kernel,
+                      int d, ParallelOptions const & options)
+{
+    enum { N = 1 + SrcIterator::level };
+
+    typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
+    typedef typename ConvolutionBatchTraits<TmpType>::isBatched Batched;
+
+    const int p = (d == N-1)
+                     ? N-2
+                     : N-1;
+    const MultiArrayIndex nSlabs = p < 0
+                                     ? 1
+                                     : std::min<MultiArrayIndex>(shape[p], 4*options.getNumThreads());
+    if(options.getNumThreads() <= 1 || nSlabs <= 1)
+    {
+        internalConvolveMultiArrayLines(si, shape, src, di, dest, kernel, d, Batched());
+        return;
     }
+
+    parallel_foreach(options, nSlabs,
+        [&](size_t /*thread_id*/, MultiArrayIndex k)
+        {
+            SrcShape offset, slab(shape);
+            offset[p] = k*shape[p] / nSlabs;
+            slab[p] = (k+1)*shape[p] / nSlabs - offset[p];
+            internalConvolveMultiArrayLines(si + offset, slab, src, di + offset, dest,
+                                            kernel, d, Batched());
+        }
+    );
+}
+
+/********************************************************/
+/*                                                      */
+/*        internalSeparableConvolveMultiArray           */
+/*                                                      */
+/********************************************************/
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelIterator>
+void
+internalSeparableConvolveMultiArrayTmp(
+                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                      DestIterator di, DestAccessor dest, KernelIterator kit,
+                      ParallelOptions const & options)
+{
+    enum { N = 1 + SrcIterator::level };
+
+    // only operate on first dimension here
+    internalConvolveMultiArrayLines(si, shape, src, di, dest, *kit, 0, options);
+    ++kit;
+
+    // operate on further dimensions (in-place)
+    for( int d = 1; d < N; ++d, ++kit )
+        internalConvolveMultiArrayLines(di, shape, dest, di, dest, *kit, d, options);
 }
 
 /********************************************************/
@@ -719,6 +977,10 @@ scaleKernel(K & kernel, double a)
     interpreted relative to the end of the respective dimension
     (i.e. <tt>if(stop[k] < 0) stop[k] += source.shape(k);</tt>).
 
+    When \ref ParallelOptions are passed, the lines of each dimension are
+    convolved in parallel (see <tt>ConvolutionOptions::parallelOptions()</tt>).
+    This doesn't change the result. Subarray computations are always sequential.
+
     <b> Declarations:</b>
 
     pass arbitrary-dimensional array views:
@@ -735,6 +997,18 @@ scaleKernel(K & kernel, double a)
                                     typename MultiArrayShape<N>::type start = typename MultiArrayShape<N>::type(),
                                     typename MultiArrayShape<N>::type stop  = typename MultiArrayShape<N>::type());
 
+        // likewise, using multiple threads
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2,
+                  class KernelIterator>
+        void
+        separableConvolveMultiArray(MultiArrayView<N, T1, S1> const & source,
+                                    MultiArrayView<N, T2, S2> dest,
+                                    KernelIterator kernels,
+                                    typename MultiArrayShape<N>::type start,
+                                    typename MultiArrayShape<N>::type stop,
+                                    ParallelOptions const & options);
+
         // apply the same kernel to all dimensions
         template <unsigned int N, class T1, class S1,
                                   class T2, class S2,
@@ -865,8 +1139,8 @@ void
 separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src,
                              DestIterator d, DestAccessor dest,
                              KernelIterator kernels,
-                             SrcShape start = SrcShape(),
-                             SrcShape stop = SrcShape())
+                             SrcShape start, SrcShape stop,
+                             ParallelOptions const & options)
 {
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
 
@@ -889,16 +1163,30 @@ separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor
         // need a temporary array to avoid rounding errors
         MultiArray<SrcShape::static_size, TmpType> tmpArray(shape);
         detail::internalSeparableConvolveMultiArrayTmp( s, shape, src,
-             tmpArray.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor(), kernels );
+             tmpArray.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor(), kernels,
+             options );
         copyMultiArray(srcMultiArrayRange(tmpArray), destIter(d, dest));
     }
     else
     {
         // work directly on the destination array
-        detail::internalSeparableConvolveMultiArrayTmp( s, shape, src, d, dest, kernels );
+        detail::internalSeparableConvolveMultiArrayTmp( s, shape, src, d, dest, kernels, options );
     }
 }
 
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelIterator>
+inline void
+separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                             DestIterator d, DestAccessor dest,
+                             KernelIterator kernels,
+                             SrcShape const & start = SrcShape(),
+                             SrcShape const & stop = SrcShape())
+{
+    separableConvolveMultiArray( s, shape, src, d, dest, kernels, start, stop,
+                                 ParallelOptions().numThreads(ParallelOptions::NoThreads));
+}
+
 template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class T>
 inline void
@@ -948,7 +1236,8 @@ inline void
 separableConvolveMultiArray(MultiArrayView<N, T1, S1> const & source,
                             MultiArrayView<N, T2, S2> dest,
                             KernelIterator kit,
-                            SHAPE start, SHAPE stop)
+                            SHAPE start, SHAPE stop,
+                            ParallelOptions const & options)
 {
     if(stop != SHAPE())
     {
@@ -962,8 +1251,24 @@ separableConvolveMultiArray(MultiArrayView<N, T1, S1> const & source,
         vigra_precondition(source.shape() == dest.shape(),
             "separableConvolveMultiArray(): shape mismatch between input and output.");
     }
-    separableConvolveMultiArray( srcMultiArrayRange(source),
-                                 destMultiArray(dest), kit, start, stop );
+    separableConvolveMultiArray( source.traverser_begin(), source.shape(),
+                                 typename AccessorTraits<T1>::default_const_accessor(),
+                                 dest.traverser_begin(),
+                                 typename AccessorTraits<T2>::default_accessor(),
+                                 kit, start, stop, options );
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class KernelIterator, class SHAPE>
+inline void
+separableConvolveMultiArray(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, T2, S2> dest,
+                            KernelIterator kit,
+                            SHAPE start, SHAPE stop)
+{
+    separableConvolveMultiArray(source, dest, kit, start, stop,
+                                ParallelOptions().numThreads(ParallelOptions::NoThreads));
 }
 
 template <unsigned int N, class T1, class S1,
@@ -1347,7 +1652,8 @@ gaussianSmoothMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src
         kernels[dim].initGaussian(params.sigma_scaled(function_name, true),
                                   1.0, opt.window_ratio);
 
-    separableConvolveMultiArray(s, shape, src, d, dest, kernels.begin(), opt.from_point, opt.to_point);
+    separableConvolveMultiArray(s, shape, src, d, dest, kernels.begin(), opt.from_point, opt.to_point,
+                                opt.parallel_options);
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -1583,7 +1889,7 @@ gaussianGradientMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor s
         kernels[dim].initGaussianDerivative(params2.sigma_scaled(), 1, 1.0, opt.window_ratio);
         detail::scaleKernel(kernels[dim], 1.0 / params2.step_size());
         separableConvolveMultiArray(si, shape, src, di, ElementAccessor(dim, dest), kernels.begin(),
-                                    opt.from_point, opt.to_point);
+                                    opt.from_point, opt.to_point, opt.parallel_options);
     }
 }
 
@@ -2111,13 +2417,15 @@ laplacianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccesso
         if (dim == 0)
         {
             separableConvolveMultiArray( si, shape, src,
-                                         di, dest, kernels.begin(), opt.from_point, opt.to_point);
+                                         di, dest, kernels.begin(), opt.from_point, opt.to_point,
+                                         opt.parallel_options);
         }
         else
         {
             separableConvolveMultiArray( si, shape, src,
                                          derivative.traverser_begin(), DerivativeAccessor(),
-                                         kernels.begin(), opt.from_point, opt.to_point);
+                                         kernels.begin(), opt.from_point, opt.to_point,
+                                         opt.parallel_options);
             combineTwoMultiArrays(di, dshape, dest, derivative.traverser_begin(), DerivativeAccessor(),
                                   di, dest, Arg1() + Arg2() );
         }
@@ -2333,11 +2641,14 @@ gaussianDivergenceMultiArray(Iterator vectorField, Iterator vectorFieldEnd,
         kernels[k].initGaussianDerivative(sigmas[k], 1, 1.0, opt.window_ratio);
         if(k == 0)
         {
-            separableConvolveMultiArray(*vectorField, divergence, kernels.begin(), opt.from_point, opt.to_point);
+            separableConvolveMultiArray(*vectorField, divergence, kernels.begin(), opt.from_point, opt.to_point,
+                                        opt.parallel_options);
         }
         else
         {
-            separableConvolveMultiArray(*vectorField, tmpDeriv, kernels.begin(), opt.from_point, opt.to_point);
+            separableConvolveMultiArray(*vectorField, MultiArrayView<N, TmpType>(tmpDeriv),
+                                        kernels.begin(), opt.from_point, opt.to_point,
+                                        opt.parallel_options);
             divergence += tmpDeriv;
         }
         kernels[k].initGaussian(sigmas[k], 1.0, opt.window_ratio);
@@ -2556,7 +2867,8 @@ hessianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor
             detail::scaleKernel(kernels[i], 1 / params_i.step_size());
             detail::scaleKernel(kernels[j], 1 / params_j.step_size());
             separableConvolveMultiArray(si, shape, src, di, ElementAccessor(b, dest),
-                                        kernels.begin(), opt.from_point, opt.to_point);
+                                        kernels.begin(), opt.from_point, opt.to_point,
+                                        opt.parallel_options);
         }
     }
 }
@@ -40,6 +40,9 @@
 #include "multi_gridgraph.hxx"
 #include "union_find.hxx"
 #include "any.hxx"
+#include "threadpool.hxx"
+#include "multi_iterator.hxx"
+#include <vector>
 
 namespace vigra{
 
@@ -310,6 +313,7 @@ class LabelOptions
 {
     Any background_value_;
     NeighborhoodType neighborhood_;
+    ParallelOptions parallel_options_;
 
   public:
 
@@ -317,6 +321,7 @@ class LabelOptions
         */
     LabelOptions()
     : neighborhood_(DirectNeighborhood)
+    , parallel_options_(ParallelOptions().numThreads(ParallelOptions::NoThreads))
     {}
 
         /** \brief Choose direct or indirect neighborhood.
@@ -375,8 +380,161 @@ class LabelOptions
             "LabelOptions::getBackgroundValue<T>(): stored background value is not convertible to T.");
         return background_value_.template read<T>();
     }
+
+        /** \brief Label the array with multiple threads.
+
+            When more than one thread is requested, labelMultiArray() splits
+            the array into slabs along the last dimension, labels them
+            concurrently, and merges the regions crossing slab boundaries in a
+            \ref vigra::ConcurrentUnionFindArray. The result is identical to
+            sequential execution. In contrast to \ref labelMultiArrayBlockwise(),
+            this requires no block decomposition and works on any in-memory
+            <tt>MultiArrayView</tt>.
+
+            Default: <tt>ParallelOptions().numThreads(ParallelOptions::NoThreads)</tt>
+            (i.e. sequential execution)
+        */
+    LabelOptions & parallelOptions(ParallelOptions const & options)
+    {
+        parallel_options_ = options;
+        return *this;
+    }
+
+        /** \brief Get the parallel options.
+        */
+    ParallelOptions const & getParallelOptions() const
+    {
+        return parallel_options_;
+    }
 };
 
+namespace detail {
+
+    // Label an array with several threads: the array is split into slabs along
+    // the last dimension, which are labeled independently by the sequential
+    // algorithm. Regions crossing slab boundaries are then merged in a
+    // ConcurrentUnionFindArray over the slab labels (shifted by the number of
+    // labels in the preceding slabs). Since slab labels are ordered like the
+    // scan order and each set is represented by its smallest index, numbering
+    // the roots consecutively reproduces the sequential labeling exactly.
+template <unsigned int N, class T, class S1,
+                          class Label, class S2,
+          class Equal>
+Label
+parallelLabelMultiArray(MultiArrayView<N, T, S1> const & data,
+                        MultiArrayView<N, Label, S2> labels,
+                        NeighborhoodType neighborhood,
+                        bool hasBackground, T backgroundValue,
+                        Equal const & equal,
+                        ParallelOptions const & options)
+{
+    typedef GridGraph<N, undirected_tag>  Graph;
+    typedef typename Graph::OutBackArcIt  neighbor_iterator;
+    typedef typename Graph::shape_type    Shape;
+
+    const MultiArrayIndex nSlabs = std::min<MultiArrayIndex>(data.shape(N-1),
+                                                             options.getActualNumThreads());
+    std::vector<Shape> slabStart(nSlabs+1);
+    for(MultiArrayIndex k=0; k <= nSlabs; ++k)
+        slabStart[k][N-1] = k*data.shape(N-1) / nSlabs;
+
+    // pass 1: label the slabs independently, slab k gets labels
+    // offsets[k]+1 ... offsets[k+1] (label 0 is the background)
+    std::vector<MultiArrayIndex> offsets(nSlabs+1, 0);
+    parallel_foreach(options, nSlabs,
+        [&](size_t /*thread_id*/, MultiArrayIndex k)
+        {
+            Shape stop(data.shape());
+            stop[N-1] = slabStart[k+1][N-1];
+            MultiArrayView<N, T, StridedArrayTag>     dataSlab  = data.subarray(slabStart[k], stop);
+            MultiArrayView<N, Label, StridedArrayTag> labelSlab = labels.subarray(slabStart[k], stop);
+            Graph graph(dataSlab.shape(), neighborhood);
+            offsets[k+1] = hasBackground
+                              ? lemon_graph::labelGraphWithBackground(graph, dataSlab, labelSlab,
+                                                                      backgroundValue, equal)
+                              : lemon_graph::labelGraph(graph, dataSlab, labelSlab, equal);
+        }
+    );
+    for(MultiArrayIndex k=0; k < nSlabs; ++k)
+        offsets[k+1] += offsets[k];
+
+    // pass 2: merge regions across the slab boundaries, i.e. between the first
+    // plane of each slab and the last plane of its predecessor
+    ConcurrentUnionFindArray<MultiArrayIndex> regions(offsets[nSlabs]+1);
+    Graph graph(data.shape(), neighborhood);
+    Shape planeShape(data.shape());
+    planeShape[N-1] = 1;
+    parallel_foreach(options, nSlabs-1,
+        [&](size_t /*thread_id*/, MultiArrayIndex b)
+        {
+            const MultiArrayIndex k = b+1;
+            for(MultiCoordinateIterator<N> c(planeShape); c.isValid(); ++c)
+            {
+                const Shape node = *c + slabStart[k];
+                if(labels[node] == 0) // background
+                    continue;
+                T center = data[node];
+                for(neighbor_iterator arc(graph, node); arc != lemon::INVALID; ++arc)
+                {
+                    const Shape target = graph.target(*arc);
+                    if(target[N-1] == node[N-1] || labels[target] == 0)
+                        continue;
+                    Shape diff = graph.neighborOffset(arc.neighborIndex());
+                    if(labeling_equality::callEqual(equal, center, data[target], diff))
+                        regions.makeUnion(offsets[k] + labels[node], offsets[k-1] + labels[target]);
+                }
+            }
+        }
+    );
+
+    // pass 3: number the roots consecutively (in parallel over the slabs' label ranges)
+    // and map the other labels to the number of their root
+    std::vector<Label> newLabels(offsets[nSlabs]+1, 0);
+    std::vector<MultiArrayIndex> rootOffsets(nSlabs+1, 0);
+    parallel_foreach(options, nSlabs,
+        [&](size_t /*thread_id*/, MultiArrayIndex k)
+        {
+            for(MultiArrayIndex i = offsets[k]+1; i <= offsets[k+1]; ++i)
+                if(regions.isRoot(i))
+                    ++rootOffsets[k+1];
+        }
+    );
+    for(MultiArrayIndex k=0; k < nSlabs; ++k)
+        rootOffsets[k+1] += rootOffsets[k];
+    vigra_precondition((UInt64)rootOffsets[nSlabs] <= (UInt64)NumericTraits<Label>::max(),
+        "labelMultiArray(): Need more labels than can be represented in the destination type.");
+    parallel_foreach(options, nSlabs,
+        [&](size_t /*thread_id*/, MultiArrayIndex k)
+        {
+            Label count = (Label)rootOffsets[k];
+            for(MultiArrayIndex i = offsets[k]+1; i <= offsets[k+1]; ++i)
+                if(regions.isRoot(i))
+                    newLabels[i] = ++count;
+        }
+    );
+    parallel_foreach(options, nSlabs,
+        [&](size_t /*thread_id*/, MultiArrayIndex k)
+        {
+            for(MultiArrayIndex i = offsets[k]+1; i <= offsets[k+1]; ++i)
+                if(!regions.isRoot(i))
+                    newLabels[i] = newLabels[regions.findIndex(i)];
+
+            Shape stop(data.shape());
+            stop[N-1] = slabStart[k+1][N-1];
+            MultiArrayView<N, Label, StridedArrayTag> labelSlab = labels.subarray(slabStart[k], stop);
+            for(typename MultiArrayView<N, Label, StridedArrayTag>::iterator l = labelSlab.begin();
+                l != labelSlab.end(); ++l)
+            {
+                if(*l != 0)
+                    *l = newLabels[offsets[k] + *l];
+            }
+        }
+    );
+    return (Label)rootOffsets[nSlabs];
+}
+
+} // namespace detail
+
 /********************************************************/
 /*                                                      */
 /*                     labelMultiArray                  */
@@ -385,7 +543,9 @@ class LabelOptions
 
 /** \brief Find the connected components of a MultiArray with arbitrary many dimensions.
 
-    See also \ref labelMultiArrayBlockwise() for a parallel version of this algorithm.
+    The function can run in parallel by passing \ref vigra::LabelOptions with
+    <tt>parallelOptions()</tt> set (see example below). See also \ref labelMultiArrayBlockwise()
+    for a parallel version of this algorithm that works on blocks or chunked arrays.
 
     By specifying a background value in the \ref vigra::LabelOptions, this function
     can also realize the behavior of \ref labelMultiArrayWithBackground().
@@ -455,6 +615,12 @@ class LabelOptions
     max_region_label = labelMultiArray(src, dest,
                                        LabelOptions().neighborhood(DirectNeighborhood)
                                                      .ignoreBackgroundValue(0));
+
+    // same result, computed by 8 threads
+    max_region_label = labelMultiArray(src, dest,
+                                       LabelOptions().neighborhood(DirectNeighborhood)
+                                                     .ignoreBackgroundValue(0)
+                                                     .parallelOptions(ParallelOptions().numThreads(8)));
     \endcode
 
     <b> Required Interface:</b>
@@ -502,11 +668,7 @@ labelMultiArray(MultiArrayView<N, T, S1> const & data,
                 MultiArrayView<N, Label, S2> labels,
                 LabelOptions const & options)
 {
-    if(options.hasBackgroundValue())
-        return labelMultiArrayWithBackground(data, labels, options.getNeighborhood(),
-                                             options.template getBackgroundValue<T>());
-    else
-        return labelMultiArray(data, labels, options.getNeighborhood());
+    return labelMultiArray(data, labels, options, std::equal_to<T>());
 }
 
 template <unsigned int N, class T, class S1,
@@ -518,6 +680,15 @@ labelMultiArray(MultiArrayView<N, T, S1> const & data,
                 LabelOptions const & options,
                 Equal equal)
 {
+    if(options.getParallelOptions().getActualNumThreads() > 1 && data.shape(N-1) > 1)
+    {
+        vigra_precondition(data.shape() == labels.shape(),
+            "labelMultiArray(): shape mismatch between input and output.");
+        return detail::parallelLabelMultiArray(data, labels, options.getNeighborhood(),
+                                               options.hasBackgroundValue(),
+                                               options.template getBackgroundValue<T>(),
+                                               equal, options.getParallelOptions());
+    }
     if(options.hasBackgroundValue())
         return labelMultiArrayWithBackground(data, labels, options.getNeighborhood(),
                                              options.template getBackgroundValue<T>(),
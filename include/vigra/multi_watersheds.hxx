@@ -38,6 +38,7 @@
 
 #include <functional>
 #include <limits>
+#include <vector>
 #include "mathutil.hxx"
 #include "multi_array.hxx"
 #include "multi_math.hxx"
@@ -224,22 +225,85 @@ generateWatershedSeeds(Graph const & g,
 #pragma GCC diagnostic ignored "-Wsign-compare"
 #endif
 
-template <class Graph, class T1Map, class T2Map>
+    // cost of 'node' when it is flooded by region 'label' (see WatershedOptions::biasLabel())
+template <class T1Map, class Node, class LabelType>
+inline typename T1Map::value_type
+watershedCost(T1Map const & data, Node const & node, LabelType label,
+              WatershedOptions const & options)
+{
+    typedef typename T1Map::value_type CostType;
+
+    return (label == options.biased_label)
+               ? static_cast<CostType>(data[node] * options.bias)
+               : data[node];
+}
+
+    // heap-based queue for seededWatersheds()
+template <class Node, class CostType>
+class WatershedPriorityQueue
+: public PriorityQueue<Node, CostType, true>
+{
+  public:
+    typedef PriorityQueue<Node, CostType, true> BaseType;
+
+    using BaseType::push;
+
+        // a node is never flooded before the node that reached it
+    void push(Node const & node, CostType priority, CostType current)
+    {
+        BaseType::push(node, priority < current ? current : priority);
+    }
+
+    bool isPending(CostType priority, CostType current) const
+    {
+        return current < priority;
+    }
+};
+
+    // Monotone bucket queue for bucketSeededWatersheds(): a node is never
+    // pushed into a bucket below the one currently processed, so the buckets
+    // are processed in ascending order and are never revisited.
+template <class Node, class CostType, class BUCKETS>
+class WatershedBucketQueue
+{
+  public:
+    BUCKETS const & toBucket;
+    std::vector<std::vector<Node> > buckets;
+    std::size_t firstBucket;
+
+    WatershedBucketQueue(BUCKETS const & mapping)
+    : toBucket(mapping),
+      buckets(mapping.bucketCount()),
+      firstBucket(mapping.bucketCount())
+    {}
+
+    void push(Node const & node, CostType priority, std::size_t current = 0)
+    {
+        std::size_t b = std::max(toBucket(priority), current);
+        buckets[b].push_back(node);
+        firstBucket = std::min(firstBucket, b);
+    }
+
+    bool isPending(CostType priority, std::size_t current) const
+    {
+        return current < toBucket(priority);
+    }
+};
+
+    // register all seeds that have an unlabeled neighbor with 'queue',
+    // and return the highest seed label
+template <class Graph, class T1Map, class T2Map, class Queue>
 typename T2Map::value_type
-seededWatersheds(Graph const & g,
-                 T1Map const & data,
-                 T2Map & labels,
-                 WatershedOptions const & options)
+pushWatershedSeeds(Graph const & g,
+                   T1Map const & data,
+                   T2Map const & labels,
+                   WatershedOptions const & options,
+                   Queue & queue)
 {
-    typedef typename Graph::Node        Node;
     typedef typename Graph::NodeIt      graph_scanner;
     typedef typename Graph::OutArcIt    neighbor_iterator;
-    typedef typename T1Map::value_type  CostType;
     typedef typename T2Map::value_type  LabelType;
 
-    PriorityQueue<Node, CostType, true> pqueue;
-
-    bool keepContours = ((options.terminate & KeepContours) != 0);
     LabelType maxRegionLabel = 0;
 
     for (graph_scanner node(g); node != INVALID; ++node)
@@ -254,17 +318,79 @@ seededWatersheds(Graph const & g,
             {
                 if(labels[g.target(*arc)] == 0)
                 {
-                    // register all seeds that have an unlabeled neighbor
-                    if(label == options.biased_label)
-                        pqueue.push(*node, data[*node] * options.bias);
-                    else
-                        pqueue.push(*node, data[*node]);
+                    queue.push(*node, watershedCost(data, *node, label, options));
                     break;
                 }
             }
         }
     }
+    return maxRegionLabel;
+}
+
+    // flood the unlabeled neighbors of 'node' (which has priority 'current'),
+    // and mark neighbors reached by another region as contours if requested
+template <class Graph, class T1Map, class T2Map, class Queue, class Priority>
+void
+pushWatershedNeighbors(Graph const & g,
+                       T1Map const & data,
+                       T2Map & labels,
+                       WatershedOptions const & options,
+                       typename Graph::Node const & node,
+                       Priority current,
+                       typename T2Map::value_type contourLabel,
+                       Queue & queue)
+{
+    typedef typename Graph::OutArcIt    neighbor_iterator;
+    typedef typename T2Map::value_type  LabelType;
+
+    bool keepContours = ((options.terminate & KeepContours) != 0);
+    LabelType label = labels[node];
+
+    for (neighbor_iterator arc(g, node); arc != INVALID; ++arc)
+    {
+        LabelType neighborLabel = labels[g.target(*arc)];
+        if(neighborLabel == 0)
+        {
+            labels[g.target(*arc)] = label;
+            queue.push(g.target(*arc), watershedCost(data, g.target(*arc), label, options), current);
+        }
+        else if(keepContours && (label != neighborLabel) && (neighborLabel != contourLabel))
+        {
+            // The present neighbor is adjacent to more than one region
+            // => mark it as contour, unless it has already been processed.
+            if(queue.isPending(watershedCost(data, g.target(*arc), neighborLabel, options), current))
+                labels[g.target(*arc)] = contourLabel;
+        }
+    }
+}
+
+    // replace the temporary contour label with label 0
+template <class Graph, class T2Map>
+void
+removeWatershedContours(Graph const & g,
+                        T2Map & labels,
+                        typename T2Map::value_type contourLabel)
+{
+    for(typename Graph::NodeIt iter(g);iter!=lemon::INVALID;++iter){
+        if(labels[*iter]==contourLabel)
+            labels[*iter]=0;
+    }
+}
 
+template <class Graph, class T1Map, class T2Map>
+typename T2Map::value_type
+seededWatersheds(Graph const & g,
+                 T1Map const & data,
+                 T2Map & labels,
+                 WatershedOptions const & options)
+{
+    typedef typename Graph::Node        Node;
+    typedef typename T1Map::value_type  CostType;
+    typedef typename T2Map::value_type  LabelType;
+
+    WatershedPriorityQueue<Node, CostType> pqueue;
+
+    LabelType maxRegionLabel = pushWatershedSeeds(g, data, labels, options, pqueue);
     LabelType contourLabel = maxRegionLabel + 1;  // temporary contour label
 
     // perform region growing
@@ -277,53 +403,122 @@ seededWatersheds(Graph const & g,
         if((options.terminate & StopAtThreshold) && (cost > options.max_cost))
             break;
 
-        LabelType label = labels[node];
-
-        if(label == contourLabel)
+        if(labels[node] == contourLabel)
             continue;
 
-        // Put the unlabeled neighbors in the priority queue.
-        for (neighbor_iterator arc(g, node); arc != INVALID; ++arc)
-        {
-            LabelType neighborLabel = labels[g.target(*arc)];
-            if(neighborLabel == 0)
-            {
-                labels[g.target(*arc)] = label;
-                CostType priority = (label == options.biased_label)
-                                       ? data[g.target(*arc)] * options.bias
-                                       : data[g.target(*arc)];
-                if(priority < cost)
-                    priority = cost;
-                pqueue.push(g.target(*arc), priority);
-            }
-            else if(keepContours && (label != neighborLabel) && (neighborLabel != contourLabel))
-            {
-                // The present neighbor is adjacent to more than one region
-                // => mark it as contour.
-                CostType priority = (neighborLabel == options.biased_label)
-                                       ? data[g.target(*arc)] * options.bias
-                                       : data[g.target(*arc)];
-                if(cost < priority) // neighbor not yet processed
-                    labels[g.target(*arc)] = contourLabel;
-            }
-        }
+        pushWatershedNeighbors(g, data, labels, options, node, cost, contourLabel, pqueue);
     }
 
-    if(keepContours)
+    if((options.terminate & KeepContours) != 0)
+        removeWatershedContours(g, labels, contourLabel);
+
+    return maxRegionLabel;
+}
+
+    // bucket mapping for 8- and 16-bit integer costs: one bucket per value
+template <class CostType>
+struct WatershedIntegerBuckets
+{
+    std::size_t bucketCount() const
     {
-        // Replace the temporary contour label with label 0.
-        ///typename T2Map::iterator k   = labels.begin(),
-        ///                         end = labels.end();
-        ///for(; k != end; ++k)
-        ///    if(*k == contourLabel)
-        ///        *k = 0;
+        return (std::size_t)((std::ptrdiff_t)NumericTraits<CostType>::max() -
+                             (std::ptrdiff_t)NumericTraits<CostType>::min()) + 1;
+    }
 
-        for(typename Graph::NodeIt iter(g);iter!=lemon::INVALID;++iter){
-            if(labels[*iter]==contourLabel)
-                labels[*iter]=0;
+    std::size_t operator()(CostType cost) const
+    {
+        return (std::size_t)((std::ptrdiff_t)cost - (std::ptrdiff_t)NumericTraits<CostType>::min());
+    }
+
+        // highest bucket whose cost doesn't exceed the threshold (-1 if there is none)
+    std::ptrdiff_t lastBucket(double threshold) const
+    {
+        double t = std::floor(threshold) - (double)NumericTraits<CostType>::min();
+        return t < 0.0
+                 ? -1
+                 : (std::ptrdiff_t)std::min(t, (double)bucketCount() - 1.0);
+    }
+};
+
+    // bucket mapping for other costs: quantize [minCost, maxCost] into 'levels' buckets
+template <class CostType>
+struct WatershedQuantizedBuckets
+{
+    double minCost_, scale_;
+    std::size_t levels_;
+
+    WatershedQuantizedBuckets(double minCost, double maxCost, std::size_t levels)
+    : minCost_(minCost),
+      scale_(maxCost > minCost ? levels / (maxCost - minCost) : 0.0),
+      levels_(levels)
+    {}
+
+    std::size_t bucketCount() const
+    {
+        return levels_;
+    }
+
+    std::size_t operator()(CostType cost) const
+    {
+        // biased costs may be outside [minCost, maxCost]
+        double b = ((double)cost - minCost_) * scale_;
+        return b <= 0.0
+                 ? 0
+                 : (std::size_t)std::min(b, (double)levels_ - 1.0);
+    }
+
+    std::ptrdiff_t lastBucket(double threshold) const
+    {
+        return threshold < minCost_
+                 ? -1
+                 : (std::ptrdiff_t)(*this)(static_cast<CostType>(threshold));
+    }
+};
+
+    // Same as seededWatersheds(), but with a WatershedBucketQueue. Each bucket
+    // is processed in FIFO order like BucketQueue, so that the result is
+    // identical to seededWatersheds() whenever BUCKETS maps every cost to a
+    // separate bucket (i.e. for 8- and 16-bit integers).
+template <class Graph, class T1Map, class T2Map, class BUCKETS>
+typename T2Map::value_type
+bucketSeededWatersheds(Graph const & g,
+                       T1Map const & data,
+                       T2Map & labels,
+                       WatershedOptions const & options,
+                       BUCKETS const & toBucket)
+{
+    typedef typename Graph::Node        Node;
+    typedef typename T1Map::value_type  CostType;
+    typedef typename T2Map::value_type  LabelType;
+
+    WatershedBucketQueue<Node, CostType, BUCKETS> queue(toBucket);
+
+    LabelType maxRegionLabel = pushWatershedSeeds(g, data, labels, options, queue);
+    LabelType contourLabel = maxRegionLabel + 1;  // temporary contour label
+
+    const std::ptrdiff_t lastBucket = (options.terminate & StopAtThreshold)
+                                          ? toBucket.lastBucket(options.max_cost)
+                                          : (std::ptrdiff_t)queue.buckets.size() - 1;
+
+    // perform region growing
+    for(std::size_t cost = queue.firstBucket; (std::ptrdiff_t)cost <= lastBucket; ++cost)
+    {
+        // nodes may be appended to the current bucket while it is processed
+        for(std::size_t k = 0; k < queue.buckets[cost].size(); ++k)
+        {
+            Node node = queue.buckets[cost][k];
+
+            if(labels[node] == contourLabel)
+                continue;
+
+            pushWatershedNeighbors(g, data, labels, options, node, cost, contourLabel, queue);
         }
+        std::vector<Node>().swap(queue.buckets[cost]);
     }
 
+    if((options.terminate & KeepContours) != 0)
+        removeWatershedContours(g, labels, contourLabel);
+
     return maxRegionLabel;
 }
 
@@ -331,6 +526,59 @@ seededWatersheds(Graph const & g,
 #pragma GCC diagnostic pop
 #endif
 
+    // signed 8- and 16-bit integers: always use the bucket queue
+template <class Graph, class T1Map, class T2Map>
+typename T2Map::value_type
+seededWatershedsDispatch(Graph const & g,
+                         T1Map const & data,
+                         T2Map & labels,
+                         WatershedOptions const & options,
+                         VigraTrueType /* small signed integer costs */)
+{
+    return bucketSeededWatersheds(g, data, labels, options,
+                                  WatershedIntegerBuckets<typename T1Map::value_type>());
+}
+
+    // other types: use the bucket queue only when quantization is requested
+    // (PriorityQueue is already a BucketQueue for unsigned 8- and 16-bit integers,
+    // which are not quantized)
+template <class Graph, class T1Map, class T2Map>
+typename T2Map::value_type
+seededWatershedsDispatch(Graph const & g,
+                         T1Map const & data,
+                         T2Map & labels,
+                         WatershedOptions const & options,
+                         VigraFalseType /* small signed integer costs */)
+{
+    typedef typename T1Map::value_type CostType;
+
+    if(options.quantization_levels == 0 ||
+       (NumericTraits<CostType>::isIntegral::value && sizeof(CostType) <= 2))
+        return seededWatersheds(g, data, labels, options);
+
+    typename Graph::NodeIt node(g);
+    if(node == INVALID)
+        return 0;
+    CostType minCost = data[*node], maxCost = data[*node];
+    for(; node != INVALID; ++node)
+    {
+        if(data[*node] < minCost)
+            minCost = data[*node];
+        if(maxCost < data[*node])
+            maxCost = data[*node];
+    }
+    return bucketSeededWatersheds(g, data, labels, options,
+                   WatershedQuantizedBuckets<CostType>(minCost, maxCost, options.quantization_levels));
+}
+
+template <class T>
+struct WatershedUsesBuckets
+{
+    static const bool value = NumericTraits<T>::isIntegral::value &&
+                              NumericTraits<T>::isSigned::value && sizeof(T) <= 2;
+    typedef typename IfBool<value, VigraTrueType, VigraFalseType>::type type;
+};
+
 } // namespace graph_detail
 
 template <class Graph, class T1Map, class T2Map>
@@ -373,7 +621,8 @@ watershedsGraph(Graph const & g,
             graph_detail::generateWatershedSeeds(g, data, labels, seed_options);
         }
 
-        return graph_detail::seededWatersheds(g, data, labels, options);
+        typedef typename graph_detail::WatershedUsesBuckets<typename T1Map::value_type>::type UseBuckets;
+        return graph_detail::seededWatershedsDispatch(g, data, labels, options, UseBuckets());
     }
     else
     {
@@ -452,6 +701,12 @@ generateWatershedSeeds(MultiArrayView<N, T, S1> const & data,
 
     The option <tt>turboAlgorithm()</tt> is implied by method <tt>regionGrowing()</tt> (this is
     in contrast to watershedsRegionGrowing(), which supports an additional algorithm in 2D only).
+    For 8- and 16-bit integer data, region growing uses a bucket queue with one bucket per
+    value, so that each pixel is queued and dequeued in constant time (signed values are
+    shifted into the range of the buckets). Other value types
+    (e.g. float) use a heap-based priority queue, unless <tt>WatershedOptions::quantization()</tt>
+    is set, in which case the data are quantized into the given number of buckets (which is
+    faster, but only approximates the exact result).
 
     watershedsMultiArray() returns the number of regions found (= the highest region label, because
     labels start at 1).
@@ -40,7 +40,10 @@
 #include "config.hxx"
 #include "error.hxx"
 #include "array_vector.hxx"
+#include "sized_int.hxx"
 #include <queue>
+#include <vector>
+#include <algorithm>
 
 namespace vigra {
 
@@ -591,6 +594,186 @@ private:
 };
 
 
+/** \brief Heap-based priority queue with lazy priority updates.
+
+    This class has the same interface as \ref ChangeablePriorityQueue, but
+    never moves entries that are already in the heap. Instead, every index
+    carries a generation stamp which is incremented by <tt>push()</tt> and
+    <tt>deleteItem()</tt>. A priority change appends a new heap entry with
+    the current stamp, and deletion only increments the stamp. Entries whose
+    stamp is outdated are discarded when they reach the top of the heap.
+
+    Thus, <tt>deleteItem()</tt> is O(1) and <tt>push()</tt> is a plain heap
+    insertion without the index bookkeeping of ChangeablePriorityQueue, which
+    pays off when priorities change much more often than the top element is
+    removed (as in hierarchical clustering). When the stale entries outnumber
+    the valid ones, the heap is rebuilt from the valid entries.
+
+    <b>\#include</b> \<vigra/priority_queue.hxx\><br>
+
+    Namespace: vigra
+*/
+template<class T,class COMPARE = std::less<T> >
+class LazyPriorityQueue {
+
+public:
+
+    typedef T priority_type;
+    typedef int ValueType;
+    typedef ValueType value_type;
+    typedef ValueType const_reference;
+
+    /// Create an empty LazyPriorityQueue which can contain the indices 0...maxSize
+    LazyPriorityQueue(const size_t maxSize)
+    : maxSize_(maxSize),
+      currentSize_(0),
+      heap_(),
+      stamps_(maxSize_+1, 0),
+      contained_(maxSize_+1, false),
+      priorities_(maxSize_+1)
+    {}
+
+    void reset(){
+        clear();
+    }
+
+    /// check if the PQ is empty
+    bool empty() const {
+        return currentSize_ == 0;
+    }
+
+    /// remove all elements from the PQ
+    void clear() {
+        for(size_t k = 0; k < heap_.size(); ++k)
+            contained_[heap_[k].index_] = false;
+        heap_.clear();
+        currentSize_ = 0;
+    }
+
+    /// check if i is an index on the PQ
+    bool contains(const int i) const{
+        return contained_[i];
+    }
+
+    /// return the number of elements in the PQ
+    int size()const{
+        return currentSize_;
+    }
+
+    /** \brief Insert a index with a given priority.
+
+        If the queue contains i bevore this
+        call the priority of the given index will
+        be changed
+    */
+    void push(const value_type i, const priority_type p) {
+        if(!contained_[i]){
+            contained_[i] = true;
+            ++currentSize_;
+        }
+        priorities_[i] = p;
+        heap_.push_back(Entry(p, i, ++stamps_[i]));
+        std::push_heap(heap_.begin(), heap_.end(), EntryCompare(comp_));
+        if(heap_.size() > 2*currentSize_ + 64)
+            compact();
+    }
+
+    /** \brief get index with top priority
+    */
+    const_reference top() const {
+        discardStale();
+        return heap_.front().index_;
+    }
+
+    /**\brief get top priority
+    */
+    priority_type topPriority() const {
+        discardStale();
+        return heap_.front().priority_;
+    }
+
+    /** \brief Remove the current top element.
+    */
+    void pop() {
+        discardStale();
+        deleteItem(heap_.front().index_);
+        std::pop_heap(heap_.begin(), heap_.end(), EntryCompare(comp_));
+        heap_.pop_back();
+    }
+
+    /// returns the value associated with index i
+    priority_type priority(const value_type i) const{
+        return priorities_[i];
+    }
+
+    /// delete the priority associated with index i
+    void deleteItem(const value_type i)   {
+        if(contained_[i]){
+            contained_[i] = false;
+            ++stamps_[i];
+            --currentSize_;
+        }
+    }
+
+    /** \brief change priority of a given index.
+        The index must be in the queue!
+        Call push to auto insert / change .
+    */
+    void changePriority(const value_type i,const priority_type p)  {
+        push(i, p);
+    }
+
+private:
+
+    struct Entry{
+        Entry(const priority_type p, const value_type i, const UInt32 stamp)
+        : priority_(p), index_(i), stamp_(stamp)
+        {}
+        priority_type priority_;
+        value_type    index_;
+        UInt32        stamp_;
+    };
+
+    // std::push_heap() creates a max-heap, so the comparison is reversed
+    struct EntryCompare{
+        EntryCompare(const COMPARE & comp)
+        : comp_(comp)
+        {}
+        bool operator()(const Entry & a, const Entry & b) const{
+            return comp_(b.priority_, a.priority_);
+        }
+        COMPARE comp_;
+    };
+
+    bool isValid(const Entry & entry) const{
+        return contained_[entry.index_] && stamps_[entry.index_] == entry.stamp_;
+    }
+
+    void discardStale() const {
+        while(!isValid(heap_.front())){
+            std::pop_heap(heap_.begin(), heap_.end(), EntryCompare(comp_));
+            heap_.pop_back();
+        }
+    }
+
+    void compact(){
+        size_t valid = 0;
+        for(size_t k = 0; k < heap_.size(); ++k)
+            if(isValid(heap_[k]))
+                heap_[valid++] = heap_[k];
+        heap_.resize(valid, heap_.front());
+        std::make_heap(heap_.begin(), heap_.end(), EntryCompare(comp_));
+    }
+
+    size_t maxSize_;
+    size_t currentSize_;
+    mutable std::vector<Entry> heap_;
+    std::vector<UInt32> stamps_;
+    std::vector<bool>   contained_;
+    std::vector<T>      priorities_;
+    COMPARE             comp_;
+};
+
 } // namespace vigra
 
 #endif // VIGRA_PRIORITY_QUEUE_HXX
@@ -118,6 +118,8 @@ public:
    template <class InputIterator>
       void insert(InputIterator, InputIterator);
    const_iterator insert(const_iterator , const value_type&);
+   template <class InputIterator>
+      void insertSorted(InputIterator, InputIterator);
    void erase(iterator position);
    size_type erase(const key_type& );
    void erase( const_iterator, const_iterator);
@@ -150,6 +152,16 @@ public:
    }
 
 private:
+   struct Equivalent {
+      Equivalent(const Compare & compare)
+      : compare_(compare)
+      {}
+      bool operator()(const Key & a, const Key & b) const {
+         return !compare_(a, b) && !compare_(b, a);
+      }
+      Compare compare_;
+   };
+
    std::vector<Key> vector_;
    Compare compare_;
 };
@@ -388,6 +400,33 @@ RandomAccessSet<Key,Compare,Alloc>::insert
    }
 }
 
+/// insert a sorted sequence of elements
+///
+/// Same as insert(first, last), but the sequence must be sorted
+/// w.r.t. the comparator. The elements are appended and merged
+/// in a single pass instead of being inserted one by one.
+/// Elements which are already in the set are not replaced.
+///
+/// \param first iterator to the first element
+/// \param last iterator to the last element
+template<class Key, class Compare, class Alloc>
+template <class InputIterator>
+inline void
+RandomAccessSet<Key,Compare,Alloc>::insertSorted
+(
+   InputIterator first,
+   InputIterator last
+)
+{
+   const size_type oldSize = vector_.size();
+   vector_.insert(vector_.end(), first, last);
+   const iterator middle = vector_.begin() + oldSize;
+   // std::inplace_merge() is stable, so existing elements
+   // precede equal new ones and survive std::unique()
+   std::inplace_merge(vector_.begin(), middle, vector_.end(), compare_);
+   vector_.erase(std::unique(vector_.begin(), vector_.end(), Equivalent(compare_)), vector_.end());
+}
+
 /// insert a sequence of elements with a hint for the position
 ///
 /// \param position iterator to the position
@@ -107,6 +107,72 @@ struct RFMapUpdater<ArgMaxAcc>
 
 
 
+/// The features quantized into at most 256 bins per column (see RandomForestOptions::histogram_bins()).
+/// bins_(i, d) is the bin of instance i in feature d, bin_count_[d] the number of bins of feature d,
+/// and max_bin_count_ the requested maximum number of bins. If bins_ is empty, no binning is used.
+struct BinnedFeatures
+{
+    MultiArray<2, UInt8> bins_;
+    std::vector<size_t> bin_count_;
+    size_t max_bin_count_;
+
+    bool empty() const
+    {
+        return bins_.size() == 0;
+    }
+};
+
+/// Quantize each feature column into at most max_bins bins. The bin boundaries are
+/// placed at the quantiles of the feature values, and equal values always share a bin.
+/// If a column has no more than max_bins distinct values, each value gets its own bin.
+template <typename FEATURES>
+void bin_features(
+        FEATURES const & features,
+        size_t max_bins,
+        int n_threads,
+        BinnedFeatures & binned
+){
+    typedef typename FEATURES::value_type FeatureType;
+
+    vigra_precondition(max_bins >= 2 && max_bins <= 256,
+                       "bin_features(): Number of bins must be in [2, 256].");
+
+    size_t const num_instances = features.shape()[0];
+    size_t const num_features = features.shape()[1];
+    binned.bins_.reshape(Shape2(num_instances, num_features));
+    binned.bin_count_.resize(num_features);
+    binned.max_bin_count_ = max_bins;
+
+    parallel_foreach(
+        n_threads,
+        num_features,
+        [&features, &binned, max_bins, num_instances](size_t, size_t d)
+        {
+            std::vector<FeatureType> values(num_instances);
+            for (size_t i = 0; i < num_instances; ++i)
+                values[i] = features(i, d);
+            std::sort(values.begin(), values.end());
+
+            // Find the upper bound of each bin.
+            std::vector<FeatureType> upper(values.begin(), values.end());
+            upper.erase(std::unique(upper.begin(), upper.end()), upper.end());
+            if (upper.size() > max_bins)
+            {
+                upper.clear();
+                for (size_t b = 1; b <= max_bins; ++b)
+                    upper.push_back(values[(b*num_instances)/max_bins - 1]);
+                upper.erase(std::unique(upper.begin(), upper.end()), upper.end());
+            }
+
+            // The bin of a value is the first bin whose upper bound is not smaller.
+            for (size_t i = 0; i < num_instances; ++i)
+                binned.bins_(i, d) = static_cast<UInt8>(
+                    std::lower_bound(upper.begin(), upper.end(), features(i, d)) - upper.begin());
+            binned.bin_count_[d] = upper.size();
+        }
+    );
+}
+
 /// Loop over the split dimensions and compute the score of all considered splits.
 template <typename FEATURES, typename LABELS, typename SAMPLER, typename SCORER>
 void split_score(
@@ -141,6 +207,79 @@ void split_score(
     }
 }
 
+/// Loop over the split dimensions and compute the score of the splits between the bins of each feature.
+template <typename FEATURES, typename LABELS, typename SAMPLER, typename SCORER>
+void split_score_binned(
+        FEATURES const & features,
+        BinnedFeatures const & binned,
+        size_t num_classes,
+        LABELS const & labels,
+        std::vector<double> const & instance_weights,
+        std::vector<size_t> const & instances,
+        SAMPLER const & dim_sampler,
+        SCORER & score
+){
+    typedef typename FEATURES::value_type FeatureType;
+
+    std::vector<double> bin_counts; // the weighted class counts of each bin
+    std::vector<double> bin_weights; // the weighted number of instances in each bin
+    std::vector<FeatureType> bin_min; // the smallest feature value of each bin in this node
+    std::vector<FeatureType> bin_max; // the largest feature value of each bin in this node
+
+    for (int i = 0; i < dim_sampler.sampleSize(); ++i)
+    {
+        size_t const d = dim_sampler[i];
+        size_t const num_bins = binned.bin_count_[d];
+
+        bin_counts.assign(num_bins*num_classes, 0.0);
+        bin_weights.assign(num_bins, 0.0);
+        bin_min.resize(num_bins);
+        bin_max.resize(num_bins);
+
+        // Build the histogram of the instances.
+        for (auto k : instances)
+        {
+            size_t const b = binned.bins_(k, d);
+            FeatureType const f = features(k, d);
+            if (bin_weights[b] == 0.0)
+            {
+                bin_min[b] = f;
+                bin_max[b] = f;
+            }
+            else
+            {
+                bin_min[b] = std::min(bin_min[b], f);
+                bin_max[b] = std::max(bin_max[b], f);
+            }
+            bin_counts[b*num_classes + static_cast<size_t>(labels(k))] += instance_weights[k];
+            bin_weights[b] += instance_weights[k];
+        }
+
+        // Get the score of the splits.
+        score.score_histogram(bin_counts, bin_weights, bin_min, bin_max, num_bins, d);
+    }
+}
+
+/// Compute the split scores on the binned features if available, and on the sorted features otherwise.
+/// Nodes with less than one instance per 8 bins (of the feature with the most bins) are also
+/// handled by sorting, since sweeping over the mostly empty histograms would be more expensive.
+template <typename FEATURES, typename LABELS, typename SAMPLER, typename SCORER>
+void split_score(
+        FEATURES const & features,
+        BinnedFeatures const & binned,
+        size_t num_classes,
+        LABELS const & labels,
+        std::vector<double> const & instance_weights,
+        std::vector<size_t> const & instances,
+        SAMPLER const & dim_sampler,
+        SCORER & score
+){
+    if (binned.empty() || 8*instances.size() < binned.max_bin_count_)
+        split_score(features, labels, instance_weights, instances, dim_sampler, score);
+    else
+        split_score_binned(features, binned, num_classes, labels, instance_weights, instances, dim_sampler, score);
+}
+
 
 
 /**
@@ -154,7 +293,8 @@ void random_forest_single_tree(
         VISITOR & visitor,
         STOP stop,
         RF & tree,
-        RANDENGINE const & randengine
+        RANDENGINE const & randengine,
+        BinnedFeatures const & binned = BinnedFeatures()
 ){
     typedef typename RF::Features Features;
     typedef typename Features::value_type FeatureType;
@@ -257,6 +397,8 @@ void random_forest_single_tree(
             // Find the split using all instances.
             detail::split_score(
                 features,
+                binned,
+                spec.num_classes_,
                 labels,
                 instance_weights,
                 used_instances,
@@ -276,6 +418,8 @@ void random_forest_single_tree(
             // Find the split using the subset.
             detail::split_score(
                 features,
+                binned,
+                spec.num_classes_,
                 labels,
                 instance_weights,
                 indices,
@@ -414,27 +558,26 @@ random_forest_impl(
         t.problem_spec_ = pspec;
 
     // Find the correct number of threads.
-    size_t n_threads = 1;
+    int n_threads = 1;
     if (options.n_threads_ >= 1)
         n_threads = options.n_threads_;
     else if (options.n_threads_ == -1)
-        n_threads = std::thread::hardware_concurrency();
+        n_threads = ParallelOptions::Auto;
 
-    // Use the global random engine to create seeds for the random engines that run in the threads.
+    // Use the global random engine to create one seed per tree. Each tree gets
+    // its own random engine, so the result does not depend on the number of
+    // threads or on the order in which the trees are trained.
     UniformIntRandomFunctor<RANDENGINE> rand_functor(randengine);
-    std::set<UInt32> seeds;
-    while (seeds.size() < n_threads)
+    std::vector<UInt32> seeds(tree_count);
+    for (auto & seed : seeds)
     {
-        seeds.insert(rand_functor());
+        seed = rand_functor();
     }
-    vigra_assert(seeds.size() == n_threads, "random_forest_impl(): Could not create random seeds.");
 
-    // Create the random engines that run in the threads.
-    std::vector<RANDENGINE> rand_engines;
-    for (auto seed : seeds)
-    {
-        rand_engines.push_back(RANDENGINE(seed));
-    }
+    // Quantize the features for the histogram-based split search.
+    BinnedFeatures binned;
+    if (options.histogram_bins_ > 0)
+        bin_features(features, options.histogram_bins_, n_threads, binned);
 
     // Call the visitor.
     visitor.visit_before_training();
@@ -449,28 +592,24 @@ random_forest_impl(
     }
 
     // Train the trees.
-    ThreadPool pool((size_t)n_threads);
-    std::vector<threading::future<void> > futures;
-    for (size_t i = 0; i < tree_count; ++i)
-    {
-        futures.emplace_back(
-            pool.enqueue([&features, &transformed_labels, &options, &tree_visitors, &stop, &trees, i, &rand_engines](size_t thread_id)
-                {
-                    random_forest_single_tree<RF, SCORER, VisitorCopyType, STOP>(features, transformed_labels, options, tree_visitors[i], stop, trees[i], rand_engines[thread_id]);
-                }
-            )
-        );
-    }
-    for (auto & fut : futures)
-        fut.get();
+    parallel_foreach(
+        n_threads,
+        tree_count,
+        [&features, &transformed_labels, &options, &tree_visitors, &stop, &trees, &seeds, &binned](size_t, size_t i)
+        {
+            RANDENGINE const tree_randengine(seeds[i]);
+            random_forest_single_tree<RF, SCORER, VisitorCopyType, STOP>(features, transformed_labels, options, tree_visitors[i], stop, trees[i], tree_randengine, binned);
+        }
+    );
 
     // Merge the trees together.
-    RF rf(trees[0]);
+    RF rf(std::move(trees[0]));
     rf.options_ = options;
     for (size_t i = 1; i < trees.size(); ++i)
     {
         rf.merge(trees[i]);
     }
+    rf.compile();
 
     // Call the visitor.
     visitor.visit_after_training(tree_visitors, rf, features, labels);
@@ -51,6 +51,65 @@ namespace vigra
 namespace rf3
 {
 
+namespace detail
+{
+
+/// \brief Node of the flattened forest that is built by RandomForest::compile().
+///
+/// If child_ is non-negative, the node is an internal node and its children are
+/// stored at child_ and child_+1. Otherwise, the node is a leaf and its response
+/// is found at index -child_-1 in the response array.
+template <typename SPLITTESTS>
+struct FlatForestNode
+{
+    SPLITTESTS split_test_;
+    std::ptrdiff_t child_;
+};
+
+/// \brief Iterator over the responses of the leaves given by an index array.
+template <typename T>
+class FlatForestResponseIterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T const * pointer;
+    typedef T const & reference;
+
+    FlatForestResponseIterator(T const * responses, std::size_t const * index)
+    :   responses_(responses),
+        index_(index)
+    {}
+
+    reference operator*() const
+    {
+        return responses_[*index_];
+    }
+
+    FlatForestResponseIterator & operator++()
+    {
+        ++index_;
+        return *this;
+    }
+
+    bool operator==(FlatForestResponseIterator const & other) const
+    {
+        return index_ == other.index_;
+    }
+
+    bool operator!=(FlatForestResponseIterator const & other) const
+    {
+        return index_ != other.index_;
+    }
+
+private:
+    T const * responses_;
+    std::size_t const * index_;
+};
+
+} // namespace detail
+
 /********************************************************/
 /*                                                      */
 /*                    rf3::RandomForest                 */
@@ -105,10 +164,29 @@ public:
     );
 
     /// \brief Grow this forest by incorporating the other.
+    /// \note If this forest was compiled, the compiled layout is rebuilt.
     void merge(
         RandomForest const & other
     );
 
+    /// \brief Pack the trees into contiguous arrays for faster prediction.
+    ///
+    /// The two children of each node are stored next to each other, and the pairs are
+    /// allocated depth-first, so that every subtree occupies a contiguous range. The leaf
+    /// responses are stored in a separate array. Once compiled, predict() and
+    /// predict_probabilities() walk this layout and process blocks of instances tree by
+    /// tree, which keeps each tree in the cache.
+    /// Forests returned by random_forest() and by the HDF5 import are already compiled.
+    /// \note If graph_, split_tests_ or node_responses_ are modified directly,
+    /// compile() must be called again.
+    void compile();
+
+    /// \brief Return whether the forest has an up-to-date compiled layout.
+    bool is_compiled() const
+    {
+        return graph_.numRoots() > 0 && flat_roots_.size() == graph_.numRoots();
+    }
+
     /// \brief Predict the given data and return the average number of split comparisons.
     /// \note labels must be a 1-D array with size <tt>features.shape(0)</tt>.
     void predict(
@@ -179,6 +257,20 @@ public:
 
 private:
 
+    typedef detail::FlatForestNode<SplitTests> FlatNode;
+
+    /// \brief Number of instances that are processed per tree in the compiled prediction.
+    static const size_t flat_block_size = 256;
+
+    /// \brief The nodes of the compiled forest.
+    std::vector<FlatNode> flat_nodes_;
+
+    /// \brief The index of each tree root in flat_nodes_.
+    std::vector<size_t> flat_roots_;
+
+    /// \brief The leaf responses of the compiled forest.
+    std::vector<AccInputType> flat_responses_;
+
     /// \brief Compute the leaf ids of the instances in [from, to).
     template <typename IDS, typename INDICES>
     double leaf_ids_impl(
@@ -196,6 +288,15 @@ private:
         const size_t i,
         const std::vector<size_t> & tree_indices) const;
 
+    /// \brief Predict the probabilities of the instances in [from, to) using the compiled layout.
+    template<typename PROBS>
+    void predict_probabilities_compiled(
+        FEATURES const & features,
+        PROBS & probs,
+        const size_t from,
+        const size_t to,
+        const std::vector<size_t> & tree_indices) const;
+
 };
 
 template <typename FEATURES, typename LABELS, typename SPLITTESTS, typename ACC>
@@ -218,7 +319,9 @@ RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::RandomForest(
     split_tests_(split_tests),
     node_responses_(node_responses),
     problem_spec_(problem_spec)
-{}
+{
+    compile();
+}
 
 template <typename FEATURES, typename LABELS, typename SPLITTESTS, typename ACC>
 void RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::merge(
@@ -239,6 +342,52 @@ void RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::merge(
     {
         node_responses_.insert(Node(p.first.id()+offset), p.second);
     }
+    if (!flat_roots_.empty())
+        compile();
+}
+
+template <typename FEATURES, typename LABELS, typename SPLITTESTS, typename ACC>
+void RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::compile()
+{
+    flat_nodes_.clear();
+    flat_roots_.clear();
+    flat_responses_.clear();
+    flat_nodes_.reserve(graph_.numNodes());
+    flat_roots_.reserve(graph_.numRoots());
+
+    // The two children of a node are always stored next to each other. The pairs
+    // are allocated in depth-first order, so that each subtree occupies a
+    // contiguous range and the nodes on a root-to-leaf path are close in memory.
+    std::vector<std::pair<Node, size_t> > stack;
+    for (size_t k = 0; k < graph_.numRoots(); ++k)
+    {
+        flat_roots_.push_back(flat_nodes_.size());
+        flat_nodes_.push_back(FlatNode());
+        stack.push_back(std::make_pair(graph_.getRoot(k), flat_roots_.back()));
+        while (!stack.empty())
+        {
+            Node const node = stack.back().first;
+            size_t const index = stack.back().second;
+            stack.pop_back();
+            if (graph_.outDegree(node) > 0)
+            {
+                vigra_precondition(graph_.outDegree(node) == 2,
+                                   "RandomForest::compile(): Internal nodes must have exactly two children.");
+                size_t const child = flat_nodes_.size();
+                flat_nodes_[index].split_test_ = split_tests_.at(node);
+                flat_nodes_[index].child_ = child;
+                flat_nodes_.push_back(FlatNode());
+                flat_nodes_.push_back(FlatNode());
+                stack.push_back(std::make_pair(graph_.getChild(node, 1), child+1));
+                stack.push_back(std::make_pair(graph_.getChild(node, 0), child));
+            }
+            else
+            {
+                flat_nodes_[index].child_ = -static_cast<std::ptrdiff_t>(flat_responses_.size()) - 1;
+                flat_responses_.push_back(node_responses_.at(node));
+            }
+        }
+    }
 }
 
 // FIXME TODO we don't support the selection of tree indices any more in predict_probabilities, might be a good idea
@@ -307,13 +456,29 @@ void RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::predict_probabilities(
     if (n_threads < 1)
         n_threads = 1;
     
-    parallel_foreach(
-        n_threads,
-        num_instances,
-        [&features,&probs,&tree_indices_cpy,this](size_t, size_t i) {
-            this->predict_probabilities_impl(features, probs, i, tree_indices_cpy);
-        }
-    );
+    if (is_compiled())
+    {
+        size_t const num_blocks = (num_instances + flat_block_size - 1) / flat_block_size;
+        parallel_foreach(
+            n_threads,
+            num_blocks,
+            [&features,&probs,&tree_indices_cpy,num_instances,this](size_t, size_t b) {
+                size_t const from = b*flat_block_size;
+                size_t const to = std::min(from + flat_block_size, num_instances);
+                this->predict_probabilities_compiled(features, probs, from, to, tree_indices_cpy);
+            }
+        );
+    }
+    else
+    {
+        parallel_foreach(
+            n_threads,
+            num_instances,
+            [&features,&probs,&tree_indices_cpy,this](size_t, size_t i) {
+                this->predict_probabilities_impl(features, probs, i, tree_indices_cpy);
+            }
+        );
+    }
 }
 
 template <typename FEATURES, typename LABELS, typename SPLITTESTS, typename ACC>
@@ -348,6 +513,51 @@ void RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::predict_probabilities_impl
     acc(tree_results.begin(), tree_results.end(), sub_probs.begin());    
 }
 
+template <typename FEATURES, typename LABELS, typename SPLITTESTS, typename ACC>
+template <typename PROBS>
+void RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::predict_probabilities_compiled(
+    FEATURES const & features,
+    PROBS & probs,
+    const size_t from,
+    const size_t to,
+    const std::vector<size_t> & tree_indices
+) const {
+    typedef decltype(features.template bind<0>(0)) SubFeatures;
+    typedef detail::FlatForestResponseIterator<AccInputType> ResponseIterator;
+
+    size_t const num_trees = tree_indices.size();
+    std::vector<SubFeatures> sub_features;
+    sub_features.reserve(to - from);
+    for (size_t i = from; i < to; ++i)
+        sub_features.push_back(features.template bind<0>(i));
+
+    // Walk each tree with the whole block of instances before moving on to the next tree.
+    // leaves[j*num_trees + t] receives the response index of instance from+j in tree t.
+    std::vector<size_t> leaves((to - from) * num_trees);
+    FlatNode const * const nodes = flat_nodes_.data();
+    for (size_t t = 0; t < num_trees; ++t)
+    {
+        FlatNode const * const root = nodes + flat_roots_[tree_indices[t]];
+        for (size_t j = 0; j < sub_features.size(); ++j)
+        {
+            FlatNode const * node = root;
+            while (node->child_ >= 0)
+                node = nodes + node->child_ + node->split_test_(sub_features[j]);
+            leaves[j*num_trees + t] = static_cast<size_t>(-node->child_ - 1);
+        }
+    }
+
+    // write the tree results into the probabilities
+    ACC acc;
+    AccInputType const * const responses = flat_responses_.data();
+    for (size_t j = 0; j < sub_features.size(); ++j)
+    {
+        size_t const * const leaf = leaves.data() + j*num_trees;
+        auto sub_probs = probs.template bind<0>(from + j);
+        acc(ResponseIterator(responses, leaf), ResponseIterator(responses, leaf + num_trees), sub_probs.begin());
+    }
+}
+
 template <typename FEATURES, typename LABELS, typename SPLITTESTS, typename ACC>
 template <typename IDS>
 double RandomForest<FEATURES, LABELS, SPLITTESTS, ACC>::leaf_ids(
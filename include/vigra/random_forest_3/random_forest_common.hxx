@@ -276,6 +276,54 @@ namespace detail
             }
         }
 
+        /// Compute the score of the splits between the bins of a histogram.
+        /// bin_counts[b*num_classes+c] holds the weighted number of instances of class c in bin b,
+        /// bin_weights[b] the weighted number of instances in bin b, and bin_min[b] and bin_max[b]
+        /// the smallest and largest feature value in bin b. Only the boundaries between non-empty
+        /// bins are considered, and the threshold lies halfway between the adjacent feature values,
+        /// as in operator().
+        template <typename T>
+        void score_histogram(
+            std::vector<double> const & bin_counts,
+            std::vector<double> const & bin_weights,
+            std::vector<T> const & bin_min,
+            std::vector<T> const & bin_max,
+            size_t num_bins,
+            size_t dim
+        ){
+            Functor score;
+
+            size_t const num_classes = priors_.size();
+            std::vector<double> counts(num_classes, 0.0);
+            double n_left = 0;
+            size_t left_bin = num_bins; // the last non-empty bin on the left side
+            for (size_t b = 0; b < num_bins; ++b)
+            {
+                if (bin_weights[b] == 0.0)
+                    continue;
+
+                if (left_bin != num_bins)
+                {
+                    // Update the score.
+                    split_found_ = true;
+                    double const s = score(priors_, counts, n_total_, n_left);
+                    bool const better_score = s < best_score_;
+                    if (better_score)
+                    {
+                        best_score_ = s;
+                        best_split_ = 0.5*(bin_max[left_bin]+bin_min[b]);
+                        best_dim_ = dim;
+                    }
+                }
+
+                // Move the bin from the right side to the left side.
+                for (size_t c = 0; c < num_classes; ++c)
+                    counts[c] += bin_counts[b*num_classes+c];
+                n_left += bin_weights[b];
+                left_bin = b;
+            }
+        }
+
         bool split_found_; // whether a split was found at all
         double best_split_; // the threshold of the best split
         size_t best_dim_; // the dimension of the best split
@@ -596,6 +644,7 @@ public:
         min_num_instances_(1),
         use_stratification_(false),
         n_threads_(-1),
+        histogram_bins_(0),
         class_weights_()
     {}
 
@@ -747,6 +796,27 @@ public:
         return *this;
     }
 
+    /**
+     * @brief Search the splits on histograms of the features instead of sorted feature values.
+     *
+     * Before training, each feature column is quantized once into at most \a n bins
+     * (2 <= \a n <= 256) whose boundaries lie at the quantiles of the feature values.
+     * The split search in a node then only accumulates the class counts per bin, which
+     * takes linear instead of <tt>O(n log n)</tt> time. The thresholds are placed halfway
+     * between the largest and smallest feature values of adjacent bins in the node. If a
+     * feature has no more than \a n distinct values, the splits are the same as without
+     * binning.
+     *
+     * Default: \a n = 0 (find the exact splits by sorting)
+     */
+    RandomForestOptions & histogram_bins(size_t n)
+    {
+        vigra_precondition(n == 0 || (n >= 2 && n <= 256),
+                           "RandomForestOptions::histogram_bins(): Number of bins must be 0 or in [2, 256].");
+        histogram_bins_ = n;
+        return *this;
+    }
+
     /**
      * @brief Each datapoint is weighted by its class weight. By default, each class has weight 1.
      * @details
@@ -794,6 +864,7 @@ public:
     size_t min_num_instances_;
     bool use_stratification_;
     int n_threads_;
+    size_t histogram_bins_;
     std::vector<double> class_weights_;
 
 };
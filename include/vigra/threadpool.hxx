@@ -38,7 +38,10 @@
 
 #include <vector>
 #include <queue>
+#include <memory>
+#include <functional>
 #include <stdexcept>
+#include <exception>
 #include <cmath>
 #include "mathutil.hxx"
 #include "counting_iterator.hxx"
@@ -53,6 +56,8 @@ namespace vigra
 
 //@{
 
+class ThreadPool;
+
     /**\brief Option base class for parallel algorithms.
 
         <b>\#include</b> \<vigra/threadpool.hxx\><br>
@@ -72,6 +77,7 @@ class ParallelOptions
 
     ParallelOptions()
     :   numThreads_(actualNumThreads(Auto))
+    ,   threadPool_(0)
     {}
 
         /** \brief Get desired number of threads.
@@ -114,6 +120,28 @@ class ParallelOptions
         return *this;
     }
 
+        /** \brief Execute parallel algorithms on an existing thread pool.
+
+            Instead of creating their own worker threads, algorithms receiving these
+            options will enqueue their tasks into the given pool (for example
+            <tt>ThreadPool::global()</tt>), using at most <tt>getNumThreads()</tt>
+            of its workers. The pool must outlive all algorithm calls using these options.
+
+            Default: no pool (<tt>parallel_foreach()</tt> uses <tt>ThreadPool::global()</tt>
+            when it has enough threads, and a temporary pool otherwise)
+        */
+    ParallelOptions & threadPool(ThreadPool & pool)
+    {
+        threadPool_ = &pool;
+        return *this;
+    }
+
+        /** \brief Get the thread pool set by <tt>threadPool()</tt>, or 0 if there is none.
+        */
+    ThreadPool * getThreadPool() const
+    {
+        return threadPool_;
+    }
 
   private:
         // helper function to compute the actual number of threads
@@ -131,8 +159,163 @@ class ParallelOptions
     }
 
     int numThreads_;
+    ThreadPool * threadPool_;
 };
 
+/********************************************************/
+/*                                                      */
+/*                  WorkStealingDeque                   */
+/*                                                      */
+/********************************************************/
+
+namespace detail {
+
+    // Lock-free work-stealing deque after Chase and Lev (2005), using
+    // the memory orderings proposed by Le et al. (2013). Only the owning
+    // worker may call push() and pop() (at the bottom end), all other
+    // threads call steal() (at the top end). Buffers that were replaced
+    // during growth are retained until destruction, because concurrent
+    // thieves may still read from them.
+template <class T>
+class WorkStealingDeque
+{
+    struct Buffer
+    {
+        explicit Buffer(std::ptrdiff_t capacity)
+        : mask(capacity - 1)
+        , items(new threading::atomic<T *>[capacity])
+        {}
+
+        std::ptrdiff_t capacity() const
+        {
+            return mask + 1;
+        }
+
+        T * get(std::ptrdiff_t i) const
+        {
+            return items[i & mask].load(threading::memory_order_relaxed);
+        }
+
+        void put(std::ptrdiff_t i, T * item)
+        {
+            items[i & mask].store(item, threading::memory_order_relaxed);
+        }
+
+        std::ptrdiff_t mask;
+        std::unique_ptr<threading::atomic<T *>[]> items;
+    };
+
+  public:
+
+    explicit WorkStealingDeque(std::ptrdiff_t capacity = 256)
+    : top_(0)
+    , bottom_(0)
+    , buffer_(0)
+    {
+        buffers_.emplace_back(new Buffer(capacity));
+        buffer_.store(buffers_.back().get());
+    }
+
+        // called by the owner only
+    void push(T * item)
+    {
+        std::ptrdiff_t b = bottom_.load(threading::memory_order_relaxed);
+        std::ptrdiff_t t = top_.load(threading::memory_order_acquire);
+        Buffer * a = buffer_.load(threading::memory_order_relaxed);
+        if(b - t > a->capacity() - 1)
+        {
+            Buffer * grown = new Buffer(2*a->capacity());
+            for(std::ptrdiff_t i = t; i != b; ++i)
+                grown->put(i, a->get(i));
+            buffers_.emplace_back(grown);
+            buffer_.store(grown, threading::memory_order_release);
+            a = grown;
+        }
+        a->put(b, item);
+        threading::atomic_thread_fence(threading::memory_order_release);
+        bottom_.store(b + 1, threading::memory_order_relaxed);
+    }
+
+        // called by the owner only, returns 0 if the deque is empty
+    T * pop()
+    {
+        std::ptrdiff_t b = bottom_.load(threading::memory_order_relaxed) - 1;
+        Buffer * a = buffer_.load(threading::memory_order_relaxed);
+        bottom_.store(b, threading::memory_order_relaxed);
+        threading::atomic_thread_fence(threading::memory_order_seq_cst);
+        std::ptrdiff_t t = top_.load(threading::memory_order_relaxed);
+        T * res = 0;
+        if(t <= b)
+        {
+            res = a->get(b);
+            if(t == b)
+            {
+                // last item => compete with the thieves
+                if(!top_.compare_exchange_strong(t, t + 1, threading::memory_order_seq_cst,
+                                                           threading::memory_order_relaxed))
+                    res = 0;
+                bottom_.store(b + 1, threading::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            bottom_.store(b + 1, threading::memory_order_relaxed);
+        }
+        return res;
+    }
+
+        // called by any thread, returns 0 if the deque is empty or
+        // another thread won the race for the top item
+    T * steal()
+    {
+        std::ptrdiff_t t = top_.load(threading::memory_order_acquire);
+        threading::atomic_thread_fence(threading::memory_order_seq_cst);
+        std::ptrdiff_t b = bottom_.load(threading::memory_order_acquire);
+        if(t < b)
+        {
+            Buffer * a = buffer_.load(threading::memory_order_acquire);
+            T * res = a->get(t);
+            if(top_.compare_exchange_strong(t, t + 1, threading::memory_order_seq_cst,
+                                                      threading::memory_order_relaxed))
+                return res;
+        }
+        return 0;
+    }
+
+  private:
+    WorkStealingDeque(WorkStealingDeque const &);
+    WorkStealingDeque & operator=(WorkStealingDeque const &);
+
+    threading::atomic<std::ptrdiff_t> top_, bottom_;
+    threading::atomic<Buffer *> buffer_;
+    std::vector<std::unique_ptr<Buffer> > buffers_;
+};
+
+    // identifies the pool and index of the worker running on the current thread
+struct ThreadPoolWorker
+{
+    ThreadPool * pool;
+    int id;
+};
+
+inline ThreadPoolWorker & currentThreadPoolWorker()
+{
+    static thread_local ThreadPoolWorker worker = { 0, -1 };
+    return worker;
+}
+
+template <class T>
+inline bool futureIsReady(threading::future<T> const & f)
+{
+#ifdef USE_BOOST_THREAD
+    return f.wait_for(boost::chrono::seconds(0)) == boost::future_status::ready;
+#else
+    return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+#endif
+}
+
+} // namespace detail
+
 /********************************************************/
 /*                                                      */
 /*                      ThreadPool                      */
@@ -141,6 +324,20 @@ class ParallelOptions
 
     /**\brief Thread pool class to manage a set of parallel workers.
 
+        Two scheduling policies are available: <tt>ThreadPool::SharedQueue</tt>
+        (the default) places all tasks in a single queue guarded by a mutex.
+        <tt>ThreadPool::WorkStealing</tt> gives each worker a lock-free deque.
+        Tasks enqueued by a worker (nested tasks) are pushed onto its own deque,
+        and idle workers steal tasks from the deques of busy workers. Tasks enqueued
+        from outside the pool are placed in a shared injection queue. The latter
+        policy scales much better when many fine-grained tasks are created, and
+        especially when tasks spawn subtasks.
+
+        In both modes, a task may wait for subtasks it has enqueued, either by
+        means of \ref waitFor() or \ref waitFinished(). Instead of blocking, the
+        waiting worker then executes pending tasks itself, so that nested waiting
+        cannot deadlock the pool.
+
         <b>\#include</b> \<vigra/threadpool.hxx\><br>
         Namespace: vigra
     */
@@ -148,13 +345,21 @@ class ThreadPool
 {
   public:
 
+        /** Scheduling policies.
+        */
+    enum SchedulingPolicy {
+        SharedQueue,  ///< All tasks are placed in a single mutex-guarded queue.
+        WorkStealing  ///< Each worker owns a lock-free deque, idle workers steal tasks.
+    };
+
     /** Create a thread pool from ParallelOptions. The constructor just launches
         the desired number of workers. If the number of threads is zero,
         no workers are started, and all tasks will be executed in synchronously
         in the present thread.
      */
-    ThreadPool(const ParallelOptions & options)
+    ThreadPool(const ParallelOptions & options, SchedulingPolicy p = SharedQueue)
     :   stop(false)
+    ,   policy(p)
     {
         init(options);
     }
@@ -169,8 +374,9 @@ class ThreadPool
         to zero (i.e. synchronous execution), regardless of the value of \arg n. This
         is useful for debugging.
      */
-    ThreadPool(const int n)
+    ThreadPool(const int n, SchedulingPolicy p = SharedQueue)
     :   stop(false)
+    ,   policy(p)
     {
         init(ParallelOptions().numThreads(n));
     }
@@ -197,12 +403,34 @@ class ThreadPool
     threading::future<void> enqueue(F&& f) ;
 
     /**
-     * Block until all tasks are finished.
+     * Block until all tasks are finished. When called from within a task
+     * of this pool, the function returns as soon as all tasks except the waiting
+     * ones are finished, and the calling worker executes pending tasks meanwhile.
+     */
+    void waitFinished();
+
+    /**
+     * Wait for the given future and return its result. When called from within
+     * a task of this pool, the calling worker executes pending tasks until the
+     * future becomes ready.
      */
-    void waitFinished()
+    template<class T>
+    T waitFor(threading::future<T> & f)
     {
-        threading::unique_lock<threading::mutex> lock(queue_mutex);
-        finish_condition.wait(lock, [this](){ return tasks.empty() && (busy == 0); });
+        const int id = workerIndex();
+        if(id >= 0)
+        {
+            // the present task counts as waiting, so that nested calls
+            // to waitFinished() from tasks executed meanwhile can return
+            ++waiting;
+            while(!detail::futureIsReady(f))
+            {
+                if(!runPendingTask(id))
+                    threading::this_thread::yield();
+            }
+            --waiting;
+        }
+        return f.get();
     }
 
     /**
@@ -213,36 +441,102 @@ class ThreadPool
         return workers.size();
     }
 
+    /**
+     * Return the scheduling policy.
+     */
+    SchedulingPolicy schedulingPolicy() const
+    {
+        return policy;
+    }
+
+    /**
+     * Return the index of the worker running on the current thread,
+     * or -1 if the current thread doesn't belong to this pool.
+     */
+    int workerIndex() const
+    {
+        detail::ThreadPoolWorker const & w = detail::currentThreadPoolWorker();
+        return w.pool == this ? w.id : -1;
+    }
+
+    /**
+     * Return the process-wide shared thread pool. It uses the work-stealing
+     * policy and <tt>ParallelOptions::Auto</tt> threads, which are launched
+     * upon the first call of this function and joined at program exit.
+     * Using this pool avoids the thread creation overhead of temporary pools,
+     * and prevents oversubscription when several parallel algorithms
+     * run concurrently or are nested.
+     */
+    static ThreadPool & global();
+
 private:
 
+    typedef std::function<void(int)> Task;
+
     // helper function to init the thread pool
     void init(const ParallelOptions & options);
 
+    // helper functions for the work-stealing mode
+    void workStealingLoop(int ti);
+    Task * nextTask(int ti);
+    void pushTask(Task * task);
+    void runTask(Task * task, int ti);
+
+    // execute one pending task on worker 'ti', return false if there was none
+    bool runPendingTask(int ti);
+
     // need to keep track of threads so we can join them
     std::vector<threading::thread> workers;
 
-    // the task queue
+    // the task queue (in work-stealing mode, this is the injection queue
+    // for tasks enqueued from outside the pool)
     std::queue<std::function<void(int)> > tasks;
 
+    // the workers' deques (work-stealing mode only)
+    std::vector<std::unique_ptr<detail::WorkStealingDeque<Task> > > deques;
+
     // synchronization
     threading::mutex queue_mutex;
     threading::condition_variable worker_condition;
     threading::condition_variable finish_condition;
     bool stop;
-    threading::atomic_long busy, processed;
+    SchedulingPolicy policy;
+    threading::atomic_long busy, processed, pending, queued, sleeping, waiting;
 };
 
+inline ThreadPool & ThreadPool::global()
+{
+    static ThreadPool pool(ParallelOptions::Auto, WorkStealing);
+    return pool;
+}
+
 inline void ThreadPool::init(const ParallelOptions & options)
 {
     busy.store(0);
     processed.store(0);
+    pending.store(0);
+    queued.store(0);
+    sleeping.store(0);
+    waiting.store(0);
 
     const size_t actualNThreads = options.getNumThreads();
+    if(policy == WorkStealing)
+    {
+        for(size_t ti = 0; ti<actualNThreads; ++ti)
+            deques.emplace_back(new detail::WorkStealingDeque<Task>());
+        for(size_t ti = 0; ti<actualNThreads; ++ti)
+            workers.emplace_back([ti,this]{ this->workStealingLoop((int)ti); });
+        return;
+    }
+
     for(size_t ti = 0; ti<actualNThreads; ++ti)
     {
         workers.emplace_back(
             [ti,this]
             {
+                detail::currentThreadPoolWorker().pool = this;
+                detail::currentThreadPoolWorker().id = (int)ti;
+
                 for(;;)
                 {
                     std::function<void(int)> task;
@@ -260,11 +554,16 @@ inline void ThreadPool::init(const ParallelOptions & options)
                             ++busy;
                             task = std::move(this->tasks.front());
                             this->tasks.pop();
+                            --pending;
                             lock.unlock();
                             task(ti);
                             ++processed;
+                            // decrement under the lock, so that waitFinished()
+                            // cannot miss the notification
+                            lock.lock();
                             --busy;
-                            finish_condition.notify_one();
+                            lock.unlock();
+                            finish_condition.notify_all();
                         }
                         else if(stop)
                         {
@@ -277,6 +576,166 @@ inline void ThreadPool::init(const ParallelOptions & options)
     }
 }
 
+inline void ThreadPool::workStealingLoop(int ti)
+{
+    detail::currentThreadPoolWorker().pool = this;
+    detail::currentThreadPoolWorker().id = ti;
+
+    for(;;)
+    {
+        Task * task = nextTask(ti);
+        if(task)
+        {
+            runTask(task, ti);
+            continue;
+        }
+
+        threading::unique_lock<threading::mutex> lock(queue_mutex);
+        if(stop && pending.load() == 0)
+            return;
+        // 'sleeping' must be incremented before 'pending' is checked
+        // (and 'pending' is incremented before 'sleeping' is checked in pushTask()),
+        // so that no wake-up can be lost
+        ++sleeping;
+        worker_condition.wait(lock, [this]{ return this->stop || this->pending.load() > 0; });
+        --sleeping;
+    }
+}
+
+inline ThreadPool::Task * ThreadPool::nextTask(int ti)
+{
+    // own deque first (LIFO order keeps the caches warm)
+    Task * task = ti >= 0
+                     ? deques[ti]->pop()
+                     : 0;
+    // then the injection queue
+    if(!task && queued.load() > 0)
+    {
+        threading::unique_lock<threading::mutex> lock(queue_mutex);
+        if(!tasks.empty())
+        {
+            task = new Task(std::move(tasks.front()));
+            tasks.pop();
+            --queued;
+        }
+    }
+    // finally, try to steal from the other workers
+    const int n = (int)deques.size();
+    for(int k = 1; !task && k <= n; ++k)
+    {
+        int victim = (ti + k) % n;
+        if(victim != ti)
+            task = deques[victim]->steal();
+    }
+    if(task)
+    {
+        // increment 'busy' first, so that 'busy' and 'pending'
+        // are never zero simultaneously while work is outstanding
+        ++busy;
+        --pending;
+    }
+    return task;
+}
+
+inline void ThreadPool::pushTask(Task * task)
+{
+    ++pending;
+    const int id = workerIndex();
+    if(id >= 0)
+    {
+        // nested task => push onto the worker's own deque
+        deques[id]->push(task);
+    }
+    else
+    {
+        threading::unique_lock<threading::mutex> lock(queue_mutex);
+
+        // don't allow enqueueing after stopping the pool
+        if(stop)
+        {
+            --pending;
+            delete task;
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        tasks.emplace(std::move(*task));
+        ++queued;
+        delete task;
+    }
+    if(sleeping.load() > 0)
+    {
+        {
+            threading::lock_guard<threading::mutex> lock(queue_mutex);
+        }
+        worker_condition.notify_one();
+    }
+}
+
+inline void ThreadPool::runTask(Task * task, int ti)
+{
+    (*task)(ti);
+    delete task;
+    ++processed;
+    if(--busy == 0 && pending.load() == 0)
+    {
+        // the pool became idle => wake up threads blocked in waitFinished()
+        {
+            threading::lock_guard<threading::mutex> lock(queue_mutex);
+        }
+        finish_condition.notify_all();
+    }
+}
+
+inline bool ThreadPool::runPendingTask(int ti)
+{
+    if(policy == WorkStealing)
+    {
+        Task * task = nextTask(ti);
+        if(!task)
+            return false;
+        runTask(task, ti);
+        return true;
+    }
+
+    std::function<void(int)> task;
+    {
+        threading::unique_lock<threading::mutex> lock(queue_mutex);
+        if(tasks.empty())
+            return false;
+        ++busy;
+        task = std::move(tasks.front());
+        tasks.pop();
+        --pending;
+    }
+    task(ti);
+    ++processed;
+    {
+        threading::unique_lock<threading::mutex> lock(queue_mutex);
+        --busy;
+    }
+    finish_condition.notify_all();
+    return true;
+}
+
+inline void ThreadPool::waitFinished()
+{
+    const int id = workerIndex();
+    if(id >= 0)
+    {
+        // nested call from a task => help until all non-waiting tasks are done
+        ++waiting;
+        while(pending.load() > 0 || busy.load() > waiting.load())
+        {
+            if(!runPendingTask(id))
+                threading::this_thread::yield();
+        }
+        --waiting;
+        return;
+    }
+
+    threading::unique_lock<threading::mutex> lock(queue_mutex);
+    finish_condition.wait(lock, [this](){ return this->pending.load() == 0 && (this->busy == 0); });
+}
+
 inline ThreadPool::~ThreadPool()
 {
     {
@@ -299,6 +758,16 @@ ThreadPool::enqueueReturning(F&& f) -> threading::future<decltype(f(0))>
     auto res = task->get_future();
 
     if(workers.size()>0){
+        if(policy == WorkStealing)
+        {
+            pushTask(new Task(
+                [task](int tid)
+                {
+                    (*task)(std::move(tid));
+                }
+            ));
+            return res;
+        }
         {
             threading::unique_lock<threading::mutex> lock(queue_mutex);
 
@@ -312,6 +781,7 @@ ThreadPool::enqueueReturning(F&& f) -> threading::future<decltype(f(0))>
                     (*task)(std::move(tid));
                 }
             );
+            ++pending;
         }
         worker_condition.notify_one();
     }
@@ -343,6 +813,22 @@ ThreadPool::enqueue(F&& f)
 
     auto res = task->get_future();
     if(workers.size()>0){
+        Task wrapper(
+           [task](int tid)
+           {
+#if defined(USE_BOOST_THREAD) && \
+    !defined(BOOST_THREAD_PROVIDES_VARIADIC_THREAD)
+                (*task)();
+#else
+                (*task)(std::move(tid));
+#endif
+           }
+        );
+        if(policy == WorkStealing)
+        {
+            pushTask(new Task(std::move(wrapper)));
+            return res;
+        }
         {
             threading::unique_lock<threading::mutex> lock(queue_mutex);
 
@@ -350,17 +836,8 @@ ThreadPool::enqueue(F&& f)
             if(stop)
                 throw std::runtime_error("enqueue on stopped ThreadPool");
 
-            tasks.emplace(
-               [task](int tid)
-               {
-#if defined(USE_BOOST_THREAD) && \
-    !defined(BOOST_THREAD_PROVIDES_VARIADIC_THREAD)
-                    (*task)();
-#else
-                    (*task)(std::move(tid));
-#endif
-               }
-            );
+            tasks.emplace(std::move(wrapper));
+            ++pending;
         }
         worker_condition.notify_one();
     }
@@ -381,6 +858,66 @@ ThreadPool::enqueue(F&& f)
 /*                                                      */
 /********************************************************/
 
+namespace detail {
+
+    // Calls processChunk(laneIndex, chunkIndex) for all chunk indices in [0, nChunks),
+    // using at most nLanes concurrent tasks in the given pool. The lanes fetch chunk
+    // indices from a shared counter, so the lane index passed to the functor is
+    // always smaller than nLanes, regardless of which worker executes the lane and
+    // whether the pool is shared with other (possibly enclosing) parallel loops.
+    // Exceptions are propagated to the caller after all lanes have terminated.
+template<class F>
+inline void parallel_foreach_lanes(
+    ThreadPool & pool,
+    std::ptrdiff_t nLanes,
+    const std::ptrdiff_t nChunks,
+    F && processChunk
+){
+    nLanes = std::min(nLanes, nChunks);
+    threading::atomic<std::ptrdiff_t> next(0);
+
+    std::vector<threading::future<void> > futures;
+    for(std::ptrdiff_t lane = 0; lane < nLanes; ++lane)
+    {
+        futures.emplace_back(
+            pool.enqueue(
+                [&processChunk, &next, nChunks, lane]
+                (int)
+                {
+                    try
+                    {
+                        for(std::ptrdiff_t k = next++; k < nChunks; k = next++)
+                            processChunk((size_t)lane, k);
+                    }
+                    catch(...)
+                    {
+                        next = nChunks; // let the other lanes stop early
+                        throw;
+                    }
+                }
+            )
+        );
+    }
+
+    std::exception_ptr error;
+    for (auto & fut : futures)
+    {
+        try
+        {
+            pool.waitFor(fut);
+        }
+        catch(...)
+        {
+            if(!error)
+                error = std::current_exception();
+        }
+    }
+    if(error)
+        std::rethrow_exception(error);
+}
+
+} // namespace detail
+
 // nItems must be either zero or std::distance(iter, end).
 // NOTE: the redundancy of nItems and iter,end here is due to the fact that, for forward iterators,
 // computing the distance from iterators is costly, and, for input iterators, we might not know in advance
@@ -388,6 +925,7 @@ ThreadPool::enqueue(F&& f)
 template<class ITER, class F>
 inline void parallel_foreach_impl(
     ThreadPool & pool,
+    const std::ptrdiff_t nLanes,
     const std::ptrdiff_t nItems,
     ITER iter,
     ITER end,
@@ -396,29 +934,22 @@ inline void parallel_foreach_impl(
 ){
     std::ptrdiff_t workload = std::distance(iter, end);
     vigra_precondition(workload == nItems || nItems == 0, "parallel_foreach(): Mismatch between num items and begin/end.");
-    const float workPerThread = float(workload)/pool.nThreads();
+    if(workload == 0)
+        return;
+    const float workPerThread = float(workload)/nLanes;
     const std::ptrdiff_t chunkedWorkPerThread = std::max<std::ptrdiff_t>(roundi(workPerThread/3.0), 1);
+    const std::ptrdiff_t nChunks = (workload + chunkedWorkPerThread - 1) / chunkedWorkPerThread;
 
-    std::vector<threading::future<void> > futures;
-    for( ;iter<end; iter+=chunkedWorkPerThread)
-    {
-        const size_t lc = std::min(workload, chunkedWorkPerThread);
-        workload-=lc;
-        futures.emplace_back(
-            pool.enqueue(
-                [&f, iter, lc]
-                (int id)
-                {
-                    for(size_t i=0; i<lc; ++i)
-                        f(id, iter[i]);
-                }
-            )
-        );
-    }
-    for (auto & fut : futures)
-    {
-        fut.get();
-    }
+    detail::parallel_foreach_lanes(pool, nLanes, nChunks,
+        [&f, iter, workload, chunkedWorkPerThread]
+        (size_t id, std::ptrdiff_t k)
+        {
+            const std::ptrdiff_t b = k*chunkedWorkPerThread,
+                                 e = std::min(b+chunkedWorkPerThread, workload);
+            for(std::ptrdiff_t i=b; i<e; ++i)
+                f(id, iter[i]);
+        }
+    );
 }
 
 
@@ -427,51 +958,47 @@ inline void parallel_foreach_impl(
 template<class ITER, class F>
 inline void parallel_foreach_impl(
     ThreadPool & pool,
+    const std::ptrdiff_t nLanes,
     const std::ptrdiff_t nItems,
     ITER iter,
     ITER end,
     F && f,
     std::forward_iterator_tag
 ){
-    if (nItems == 0)
-        nItems = std::distance(iter, end);
-
-    std::ptrdiff_t workload = nItems;
-    const float workPerThread = float(workload)/pool.nThreads();
+    std::ptrdiff_t workload = nItems == 0
+                                  ? std::distance(iter, end)
+                                  : nItems;
+    if(workload == 0)
+        return;
+    const float workPerThread = float(workload)/nLanes;
     const std::ptrdiff_t chunkedWorkPerThread = std::max<std::ptrdiff_t>(roundi(workPerThread/3.0), 1);
 
-    std::vector<threading::future<void> > futures;
-    for(;;)
+    // determine the start iterator and length of all chunks in advance
+    std::vector<std::pair<ITER, std::ptrdiff_t> > chunks;
+    while(workload > 0)
     {
-        const size_t lc = std::min(chunkedWorkPerThread, workload);
+        const std::ptrdiff_t lc = std::min(chunkedWorkPerThread, workload);
         workload -= lc;
-        futures.emplace_back(
-            pool.enqueue(
-                [&f, iter, lc]
-                (int id)
-                {
-                    auto iterCopy = iter;
-                    for(size_t i=0; i<lc; ++i){
-                        f(id, *iterCopy);
-                        ++iterCopy;
-                    }
-                }
-            )
-        );
-        for (size_t i = 0; i < lc; ++i)
+        chunks.emplace_back(iter, lc);
+        for (std::ptrdiff_t i = 0; i < lc; ++i)
         {
+            vigra_postcondition(iter != end, "parallel_foreach(): Mismatch between num items and begin/end.");
             ++iter;
-            if (iter == end)
-            {
-                vigra_postcondition(workload == 0, "parallel_foreach(): Mismatch between num items and begin/end.");
-                break;
-            }
         }
-        if(workload==0)
-            break;
     }
-    for (auto & fut : futures)
-        fut.get();
+    vigra_postcondition(iter == end, "parallel_foreach(): Mismatch between num items and begin/end.");
+
+    detail::parallel_foreach_lanes(pool, nLanes, (std::ptrdiff_t)chunks.size(),
+        [&f, &chunks]
+        (size_t id, std::ptrdiff_t k)
+        {
+            auto iterCopy = chunks[k].first;
+            for(std::ptrdiff_t i=0; i<chunks[k].second; ++i){
+                f(id, *iterCopy);
+                ++iterCopy;
+            }
+        }
+    );
 }
 
 
@@ -480,29 +1007,21 @@ inline void parallel_foreach_impl(
 template<class ITER, class F>
 inline void parallel_foreach_impl(
     ThreadPool & pool,
+    const std::ptrdiff_t nLanes,
     const std::ptrdiff_t nItems,
     ITER iter,
     ITER end,
     F && f,
     std::input_iterator_tag
 ){
-    std::ptrdiff_t num_items = 0;
-    std::vector<threading::future<void> > futures;
+    // input iterators can only be traversed once => buffer the items
+    typedef typename std::iterator_traits<ITER>::value_type ValueType;
+    std::vector<ValueType> items;
     for (; iter != end; ++iter)
-    {
-        auto item = *iter;
-        futures.emplace_back(
-            pool.enqueue(
-                [&f, &item](int id){
-                    f(id, item);
-                }
-            )
-        );
-        ++num_items;
-    }
-    vigra_postcondition(num_items == nItems || nItems == 0, "parallel_foreach(): Mismatch between num items and begin/end.");
-    for (auto & fut : futures)
-        fut.get();
+        items.push_back(*iter);
+    vigra_postcondition((std::ptrdiff_t)items.size() == nItems || nItems == 0, "parallel_foreach(): Mismatch between num items and begin/end.");
+    parallel_foreach_impl(pool, nLanes, 0, items.begin(), items.end(), f,
+                          std::random_access_iterator_tag());
 }
 
 // Runs foreach on a single thread.
@@ -523,6 +1042,54 @@ inline void parallel_foreach_single_thread(
     vigra_postcondition(n == nItems || nItems == 0, "parallel_foreach(): Mismatch between num items and begin/end.");
 }
 
+namespace detail {
+
+    // Selects the pool for parallel_foreach() with a given number of threads:
+    // - When called from a task of some pool (nested call), the enclosing pool is
+    //   reused, so that inner loops neither deadlock nor oversubscribe the machine.
+    // - Otherwise, the preferred pool is used (if given) or, when it has enough
+    //   threads, the global pool.
+    // - Otherwise, a temporary pool with the desired number of threads is created.
+    // The loop runs sequentially when less than two threads are available.
+template<class ITER, class F>
+inline void parallel_foreach_dispatch(
+    ThreadPool * pool,
+    const int64_t nThreads,
+    ITER begin,
+    ITER end,
+    F && f,
+    const std::ptrdiff_t nItems
+){
+    const std::ptrdiff_t actualNThreads = ParallelOptions().numThreads((int)nThreads).getNumThreads();
+    if(actualNThreads > 1)
+    {
+        ThreadPool * current = currentThreadPoolWorker().pool;
+        if(current != 0)
+            pool = current;
+        else if(pool == 0 && actualNThreads <= (std::ptrdiff_t)ThreadPool::global().nThreads())
+            pool = &ThreadPool::global();
+
+        if(pool == 0)
+        {
+            ThreadPool tmp((int)actualNThreads);
+            parallel_foreach_impl(tmp, actualNThreads, nItems, begin, end, f,
+                typename std::iterator_traits<ITER>::iterator_category());
+            return;
+        }
+
+        const std::ptrdiff_t nLanes = std::min<std::ptrdiff_t>(actualNThreads, pool->nThreads());
+        if(nLanes > 1)
+        {
+            parallel_foreach_impl(*pool, nLanes, nItems, begin, end, f,
+                typename std::iterator_traits<ITER>::iterator_category());
+            return;
+        }
+    }
+    parallel_foreach_single_thread(begin, end, f, nItems);
+}
+
+} // namespace detail
+
 /** \brief Apply a functor to all items in a range in parallel.
 
     <b> Declarations:</b>
@@ -530,7 +1097,7 @@ inline void parallel_foreach_single_thread(
     \code
     namespace vigra {
         // pass the desired number of threads or ParallelOptions::Auto
-        // (creates an internal thread pool accordingly)
+        // (uses the global thread pool or creates an internal pool accordingly)
         template<class ITER, class F>
         void parallel_foreach(int64_t nThreads,
                               ITER begin, ITER end,
@@ -544,6 +1111,13 @@ inline void parallel_foreach_single_thread(
                               F && f,
                               const uint64_t nItems = 0);
 
+        // take the number of threads and (optionally) the pool from ParallelOptions
+        template<class ITER, class F>
+        void parallel_foreach(ParallelOptions const & options,
+                              ITER begin, ITER end,
+                              F && f,
+                              const uint64_t nItems = 0);
+
         // pass the integers from 0 ... (nItems-1) to the functor f,
         // using the given number of threads or ParallelOptions::Auto
         template<class F>
@@ -556,6 +1130,12 @@ inline void parallel_foreach_single_thread(
         void parallel_foreach(ThreadPool & threadpool,
                               uint64_t nItems,
                               F && f);
+
+        // likewise with ParallelOptions
+        template<class F>
+        void parallel_foreach(ParallelOptions const & options,
+                              uint64_t nItems,
+                              F && f);
     }
     \endcode
 
@@ -579,6 +1159,16 @@ inline void parallel_foreach_single_thread(
     preprocessor flag <tt>VIGRA_SINGLE_THREADED</tt>, ignoring the value of
     <tt>nThreads</tt> (useful for debugging).
 
+    The work is executed by at most <tt>nThreads</tt> concurrent tasks, and the thread
+    index passed to \arg f is always smaller than <tt>nThreads</tt>. Unless a pool
+    is passed explicitly (directly or via <tt>ParallelOptions::threadPool()</tt>),
+    the tasks run in <tt>ThreadPool::global()</tt> if it has at least <tt>nThreads</tt>
+    threads, so that no threads need to be created. When <tt>parallel_foreach()</tt>
+    is called from within a task of some thread pool (e.g. in the functor of an outer
+    <tt>parallel_foreach()</tt>), the inner loop is executed in the same pool, using
+    at most as many threads as the pool owns. The waiting task helps executing
+    the inner tasks, so that nesting neither deadlocks nor oversubscribes the machine.
+
     <b>Usage:</b>
 
     \code
@@ -634,7 +1224,7 @@ inline void parallel_foreach(
 {
     if(pool.nThreads()>1)
     {
-        parallel_foreach_impl(pool,nItems, begin, end, f,
+        parallel_foreach_impl(pool, pool.nThreads(), nItems, begin, end, f,
             typename std::iterator_traits<ITER>::iterator_category());
     }
     else
@@ -651,9 +1241,19 @@ inline void parallel_foreach(
     F && f,
     const std::ptrdiff_t nItems = 0)
 {
+    detail::parallel_foreach_dispatch(0, nThreads, begin, end, f, nItems);
+}
 
-    ThreadPool pool(nThreads);
-    parallel_foreach(pool, begin, end, f, nItems);
+template<class ITER, class F>
+inline void parallel_foreach(
+    ParallelOptions const & options,
+    ITER begin,
+    ITER end,
+    F && f,
+    const std::ptrdiff_t nItems = 0)
+{
+    detail::parallel_foreach_dispatch(options.getThreadPool(), options.getNumThreads(),
+                                      begin, end, f, nItems);
 }
 
 template<class F>
@@ -677,6 +1277,16 @@ inline void parallel_foreach(
     parallel_foreach(threadpool, iter, iter.end(), f, nItems);
 }
 
+template<class F>
+inline void parallel_foreach(
+    ParallelOptions const & options,
+    std::ptrdiff_t nItems,
+    F && f)
+{
+    auto iter = range(nItems);
+    parallel_foreach(options, iter, iter.end(), f, nItems);
+}
+
 //@}
 
 } // namespace vigra
@@ -39,6 +39,9 @@
 
 /*std*/
 #include <map>
+#include <vector>
+#include <atomic>
+#include <algorithm>
 
 /*vigra*/
 #include "config.hxx"
@@ -321,6 +324,87 @@ class UnionFindArray
     }
 };
 
+/** \brief Union-find array that can be modified by several threads concurrently.
+
+    In contrast to \ref UnionFindArray, the number of indices is fixed at
+    construction, and all indices start as separate sets. <tt>makeUnion()</tt>
+    and <tt>findIndex()</tt> may be called from different threads at the same
+    time without locking: roots are linked by an atomic compare-and-swap on
+    their parent entry, and the paths visited by <tt>findIndex()</tt> are
+    shortened by path halving. Since the larger root is always linked to the
+    smaller one, the representative of a set is its smallest index.
+
+    <b>\#include</b> \<vigra/union_find.hxx\><br>
+    Namespace: vigra
+*/
+template <class T>
+class ConcurrentUnionFindArray
+{
+    std::vector<std::atomic<T> > parents_;
+
+  public:
+        /** Create <tt>size</tt> singleton sets with indices <tt>0...size-1</tt>.
+        */
+    explicit ConcurrentUnionFindArray(std::size_t size)
+    : parents_(size)
+    {
+        for(std::size_t k=0; k < size; ++k)
+            parents_[k].store((T)k, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const
+    {
+        return parents_.size();
+    }
+
+        /** Check if <tt>index</tt> is currently the representative of its set.
+        */
+    bool isRoot(T index) const
+    {
+        return parents_[index].load() == index;
+    }
+
+        /** Find the representative of <tt>index</tt>'s set.
+        */
+    T findIndex(T index)
+    {
+        while(true)
+        {
+            T parent = parents_[index].load();
+            if(parent == index)
+                return index;
+            T grandparent = parents_[parent].load();
+            // path halving: let index skip its parent (if another thread
+            // changed the entry in the meantime, it already points higher up)
+            if(grandparent != parent)
+                parents_[index].compare_exchange_weak(parent, grandparent);
+            index = grandparent;
+        }
+    }
+
+        /** Merge the sets of <tt>l1</tt> and <tt>l2</tt> and return the new
+            representative (which may already be outdated when other threads
+            merge the set concurrently).
+        */
+    T makeUnion(T l1, T l2)
+    {
+        while(true)
+        {
+            l1 = findIndex(l1);
+            l2 = findIndex(l2);
+            if(l1 == l2)
+                return l1;
+            if(l1 < l2)
+                std::swap(l1, l2);
+            // link the larger root to the smaller one, retry
+            // if another thread has linked l1 in the meantime
+            T expected = l1;
+            if(parents_[l1].compare_exchange_strong(expected, l2))
+                return l2;
+        }
+    }
+};
+
 } // namespace vigra
 
 #endif // VIGRA_UNION_FIND_HXX
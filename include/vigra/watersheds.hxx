@@ -779,7 +779,7 @@ class WatershedOptions
     double max_cost, bias;
     SRGType terminate;
     Method method;
-    unsigned int biased_label, bucket_count;
+    unsigned int biased_label, bucket_count, quantization_levels;
     SeedOptions seed_options;
 
 
@@ -797,6 +797,7 @@ class WatershedOptions
       method(RegionGrowing),
       biased_label(0),
       bucket_count(0),
+      quantization_levels(0),
       seed_options(SeedOptions().unspecified())
     {}
 
@@ -866,6 +867,25 @@ class WatershedOptions
         return *this;
     }
 
+        /** \brief Quantize the boundary indicator for region growing.
+
+            watershedsMultiArray() floods 8- and 16-bit integer data with a
+            bucket queue. When this option is set, other value types (e.g. float)
+            are linearly mapped from their range <tt>[min, max]</tt> onto
+            <tt>levels</tt> buckets, and the bucket queue is used as well.
+            This is considerably faster than the heap-based priority queue,
+            but values falling into the same bucket are treated as equal,
+            so that the result approximates the exact watersheds.
+
+            Default: 0 (don't quantize, use a heap for non-integer data)
+        */
+    WatershedOptions & quantization(unsigned int levels = 256)
+    {
+        quantization_levels = levels;
+        method = RegionGrowing;
+        return *this;
+    }
+
         /** \brief Specify seed options.
 
             In this case, watershedsRegionGrowing() assumes that the destination
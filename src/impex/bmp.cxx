@@ -844,6 +844,32 @@ void BmpDecoder::nextScanline()
     ++(pimpl->scanline);
 }
 
+void BmpDecoder::decodeImage( void * dest, std::ptrdiff_t pixelStride,
+                              std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                              unsigned int numBands )
+{
+    // the entire image is decoded at once, copy it without going
+    // through the scanline interface
+    if (!pimpl->data_read)
+        pimpl->read_data ();
+
+    const unsigned int width = pimpl->info_header.width,
+                       height = pimpl->info_header.height,
+                       components = pimpl->grayscale ? 1 : 3;
+    const UInt8 * src = pimpl->pixels.data();
+    UInt8 * line = static_cast< UInt8 * >(dest);
+    if ( numBands == components && bandStride == 1 &&
+         pixelStride == static_cast<std::ptrdiff_t>(components) &&
+         lineStride == static_cast<std::ptrdiff_t>(width * components) ) {
+        VIGRA_CSTD::memcpy( line, src, width * height * components );
+    } else {
+        for ( unsigned int y = 0; y < height; ++y, src += width * components, line += lineStride )
+            for ( unsigned int b = 0; b < numBands; ++b )
+                copyScanline( src + b, components, width, 1, line + b * bandStride, pixelStride );
+    }
+    pimpl->scanline = height - 1;
+}
+
 void BmpDecoder::close() {}
 
 void BmpDecoder::abort() {}
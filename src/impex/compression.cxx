@@ -34,7 +34,9 @@
 /************************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include "vigra/compression.hxx"
+#include "vigra/sized_int.hxx"
 #include "lz4.h"
 
 #ifdef HasZLIB
@@ -43,6 +45,208 @@
 
 namespace vigra {
 
+namespace {
+
+static const int preFilterMask = SHUFFLE_FILTER | BITSHUFFLE_FILTER | DELTA_FILTER;
+
+inline int preFilters(CompressionMethod method)
+{
+    return method < 0 ? 0 : (method & preFilterMask);
+}
+
+inline CompressionMethod codecMethod(CompressionMethod method)
+{
+    return method < 0 ? method : CompressionMethod(method & ~preFilterMask);
+}
+
+template <class T>
+void deltaEncode(char * data, std::size_t count)
+{
+    // work backwards, so that each element still sees its original predecessor
+    T current, previous;
+    for(std::size_t k = count - 1; k > 0; --k)
+    {
+        std::memcpy(&current, data + k*sizeof(T), sizeof(T));
+        std::memcpy(&previous, data + (k-1)*sizeof(T), sizeof(T));
+        current = static_cast<T>(current - previous);
+        std::memcpy(data + k*sizeof(T), &current, sizeof(T));
+    }
+}
+
+template <class T>
+void deltaDecode(char * data, std::size_t count)
+{
+    T current, previous;
+    std::memcpy(&previous, data, sizeof(T));
+    for(std::size_t k = 1; k < count; ++k)
+    {
+        std::memcpy(&current, data + k*sizeof(T), sizeof(T));
+        previous = static_cast<T>(current + previous);
+        std::memcpy(data + k*sizeof(T), &previous, sizeof(T));
+    }
+}
+
+    // elements of sizes 1, 2, 4, 8 are treated as unsigned integers,
+    // other sizes bytewise with stride 'elementSize'
+void deltaFilter(char * data, std::size_t size, std::size_t elementSize, bool encode)
+{
+    std::size_t count = size / elementSize;
+    if(count < 2)
+        return;
+    switch(elementSize)
+    {
+      case 1:
+        encode ? deltaEncode<UInt8>(data, count)  : deltaDecode<UInt8>(data, count);
+        break;
+      case 2:
+        encode ? deltaEncode<UInt16>(data, count) : deltaDecode<UInt16>(data, count);
+        break;
+      case 4:
+        encode ? deltaEncode<UInt32>(data, count) : deltaDecode<UInt32>(data, count);
+        break;
+      case 8:
+        encode ? deltaEncode<UInt64>(data, count) : deltaDecode<UInt64>(data, count);
+        break;
+      default:
+      {
+        std::size_t end = count*elementSize;
+        if(encode)
+            for(std::size_t k = end - 1; k >= elementSize; --k)
+                data[k] = static_cast<char>(data[k] - data[k-elementSize]);
+        else
+            for(std::size_t k = elementSize; k < end; ++k)
+                data[k] = static_cast<char>(data[k] + data[k-elementSize]);
+      }
+    }
+}
+
+    // Byte shuffle: byte b of element i goes to position b*count + i.
+    // Trailing bytes that don't form a complete element are copied unchanged.
+void shuffle(char const * source, char * dest, std::size_t size, std::size_t elementSize)
+{
+    std::size_t count = size / elementSize;
+    for(std::size_t i = 0; i < count; ++i)
+        for(std::size_t b = 0; b < elementSize; ++b)
+            dest[b*count + i] = source[i*elementSize + b];
+    std::copy(source + count*elementSize, source + size, dest + count*elementSize);
+}
+
+void unshuffle(char const * source, char * dest, std::size_t size, std::size_t elementSize)
+{
+    std::size_t count = size / elementSize;
+    for(std::size_t i = 0; i < count; ++i)
+        for(std::size_t b = 0; b < elementSize; ++b)
+            dest[i*elementSize + b] = source[b*count + i];
+    std::copy(source + count*elementSize, source + size, dest + count*elementSize);
+}
+
+    // transpose the 8x8 bit matrix whose rows are the bytes of x
+inline UInt64 transposeBits8x8(UInt64 x)
+{
+    UInt64 t;
+    t = (x ^ (x >> 7))  & 0x00AA00AA00AA00AAull;  x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;  x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;  x = x ^ t ^ (t << 28);
+    return x;
+}
+
+    // Bit shuffle: after a byte shuffle, each byte plane (holding byte b of all elements)
+    // is split into 8 bit planes. Groups of 8 elements are transposed at a time,
+    // a remainder of less than 8 elements stays byte-shuffled.
+void bitshuffle(char const * source, char * dest, std::size_t size, std::size_t elementSize)
+{
+    std::size_t count = size / elementSize,
+                groups = count / 8;
+    ArrayVector<char> planes(size);
+    shuffle(source, planes.data(), size, elementSize);
+    std::copy(planes.data(), planes.data() + size, dest);
+    for(std::size_t b = 0; b < elementSize; ++b)
+    {
+        UInt8 const * in = reinterpret_cast<UInt8 const *>(planes.data()) + b*count;
+        UInt8 * out = reinterpret_cast<UInt8 *>(dest) + b*count;
+        for(std::size_t g = 0; g < groups; ++g)
+        {
+            UInt64 x = 0;
+            for(int k = 0; k < 8; ++k)
+                x |= static_cast<UInt64>(in[8*g + k]) << (8*k);
+            x = transposeBits8x8(x);
+            for(int k = 0; k < 8; ++k)
+                out[k*groups + g] = static_cast<UInt8>(x >> (8*k));
+        }
+    }
+}
+
+void unbitshuffle(char const * source, char * dest, std::size_t size, std::size_t elementSize)
+{
+    std::size_t count = size / elementSize,
+                groups = count / 8;
+    ArrayVector<char> planes(source, source + size);
+    for(std::size_t b = 0; b < elementSize; ++b)
+    {
+        UInt8 const * in = reinterpret_cast<UInt8 const *>(source) + b*count;
+        UInt8 * out = reinterpret_cast<UInt8 *>(planes.data()) + b*count;
+        for(std::size_t g = 0; g < groups; ++g)
+        {
+            UInt64 x = 0;
+            for(int k = 0; k < 8; ++k)
+                x |= static_cast<UInt64>(in[k*groups + g]) << (8*k);
+            x = transposeBits8x8(x);
+            for(int k = 0; k < 8; ++k)
+                out[8*g + k] = static_cast<UInt8>(x >> (8*k));
+        }
+    }
+    unshuffle(planes.data(), dest, size, elementSize);
+}
+
+    // apply the pre-filters of 'method' to 'source', the result is in 'buffer'
+void applyPreFilters(char const * source, std::size_t size, ArrayVector<char> & buffer,
+                     int filters, std::size_t elementSize)
+{
+    vigra_precondition(elementSize > 0,
+        "compress(): elementSize must be positive.");
+    vigra_precondition((filters & SHUFFLE_FILTER) == 0 || (filters & BITSHUFFLE_FILTER) == 0,
+        "compress(): shuffle and bit-shuffle filters cannot be combined.");
+    buffer.resize(size);
+    if(filters & DELTA_FILTER)
+    {
+        std::copy(source, source + size, buffer.data());
+        deltaFilter(buffer.data(), size, elementSize, true);
+        if((filters & (SHUFFLE_FILTER | BITSHUFFLE_FILTER)) == 0)
+            return;
+        ArrayVector<char> delta(buffer.data(), buffer.data() + size);
+        if(filters & SHUFFLE_FILTER)
+            shuffle(delta.data(), buffer.data(), size, elementSize);
+        else
+            bitshuffle(delta.data(), buffer.data(), size, elementSize);
+    }
+    else if(filters & SHUFFLE_FILTER)
+    {
+        shuffle(source, buffer.data(), size, elementSize);
+    }
+    else
+    {
+        bitshuffle(source, buffer.data(), size, elementSize);
+    }
+}
+
+    // invert the pre-filters, 'source' holds the output of the decompression
+void revertPreFilters(char const * source, std::size_t size, char * dest,
+                      int filters, std::size_t elementSize)
+{
+    vigra_precondition(elementSize > 0,
+        "uncompress(): elementSize must be positive.");
+    if(filters & SHUFFLE_FILTER)
+        unshuffle(source, dest, size, elementSize);
+    else if(filters & BITSHUFFLE_FILTER)
+        unbitshuffle(source, dest, size, elementSize);
+    else
+        std::copy(source, source + size, dest);
+    if(filters & DELTA_FILTER)
+        deltaFilter(dest, size, elementSize, false);
+}
+
+} // anonymous namespace
+
 std::size_t compressImpl(char const * source, std::size_t srcSize, 
                          ArrayVector<char> & buffer,
                          CompressionMethod method)
@@ -118,23 +322,37 @@ std::size_t compressImpl(char const * source, std::size_t srcSize,
     return 0;
 }
 
-void compress(char const * source, std::size_t size, ArrayVector<char> & dest, CompressionMethod method)
+std::size_t compressFiltered(char const * source, std::size_t srcSize,
+                             ArrayVector<char> & buffer,
+                             CompressionMethod method, std::size_t elementSize)
+{
+    int filters = preFilters(method);
+    if(filters == 0)
+        return compressImpl(source, srcSize, buffer, method);
+    ArrayVector<char> filtered;
+    applyPreFilters(source, srcSize, filtered, filters, elementSize);
+    return compressImpl(filtered.data(), srcSize, buffer, codecMethod(method));
+}
+
+void compress(char const * source, std::size_t size, ArrayVector<char> & dest,
+              CompressionMethod method, std::size_t elementSize)
 {
     ArrayVector<char> buffer;
-    std::size_t destSize = compressImpl(source, size, buffer, method);
+    std::size_t destSize = compressFiltered(source, size, buffer, method, elementSize);
     dest.resize(destSize);
     std::copy(buffer.data(), buffer.data() + destSize, dest.begin());
 }
 
-void compress(char const * source, std::size_t size, std::vector<char> & dest, CompressionMethod method)
+void compress(char const * source, std::size_t size, std::vector<char> & dest,
+              CompressionMethod method, std::size_t elementSize)
 {
     ArrayVector<char> buffer;
-    std::size_t destSize = compressImpl(source, size, buffer, method);
+    std::size_t destSize = compressFiltered(source, size, buffer, method, elementSize);
     dest.insert(dest.begin(), buffer.data(), buffer.data() + destSize);
 }
 
-void uncompress(char const * source, std::size_t srcSize, 
-                char * dest, std::size_t destSize, CompressionMethod method)
+void uncompressImpl(char const * source, std::size_t srcSize,
+                    char * dest, std::size_t destSize, CompressionMethod method)
 {
     switch(method)
     {
@@ -193,6 +411,21 @@ void uncompress(char const * source, std::size_t srcSize,
     }
 }
 
+void uncompress(char const * source, std::size_t srcSize,
+                char * dest, std::size_t destSize, CompressionMethod method,
+                std::size_t elementSize)
+{
+    int filters = preFilters(method);
+    if(filters == 0)
+    {
+        uncompressImpl(source, srcSize, dest, destSize, method);
+        return;
+    }
+    ArrayVector<char> filtered(destSize);
+    uncompressImpl(source, srcSize, filtered.data(), destSize, codecMethod(method));
+    revertPreFilters(filtered.data(), destSize, dest, filters, elementSize);
+}
+
 /** Uncompress a data buffer when the uncompressed size is unknown.
 
     The destination array will be resized as required.
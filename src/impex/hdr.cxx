@@ -235,6 +235,30 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    void HDRDecoder::decodeImage( void * dest, std::ptrdiff_t pixelStride,
+                                  std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                  unsigned int numBands )
+    {
+        // the RGBE decoder produces interleaved float scanlines, which can be
+        // written into the destination directly if it has the same layout
+        const int bands = pimpl->samples_per_pixel;
+        if ( numBands != static_cast<unsigned int>(bands) ||
+             bandStride != static_cast<std::ptrdiff_t>(sizeof(float)) ||
+             pixelStride != static_cast<std::ptrdiff_t>(bands * sizeof(float)) ) {
+            Decoder::decodeImage( dest, pixelStride, lineStride, bandStride, numBands );
+            return;
+        }
+
+        FILE * file = pimpl->infile.get();
+        if ( lineStride == pimpl->width * pixelStride ) {
+            VIGRA_RGBE_ReadPixels_RLE(file, static_cast<float *>(dest), pimpl->width, pimpl->height);
+        } else {
+            char * line = static_cast<char *>(dest);
+            for ( int y = 0; y < pimpl->height; ++y, line += lineStride )
+                VIGRA_RGBE_ReadPixels_RLE(file, reinterpret_cast<float *>(line), pimpl->width, 1);
+        }
+    }
+
     void HDRDecoder::close() {}
     void HDRDecoder::abort() {}
 
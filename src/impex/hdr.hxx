@@ -70,6 +70,7 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
+        void decodeImage( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t, unsigned int );
 
         std::string getPixelType() const;
         unsigned int getOffset() const;
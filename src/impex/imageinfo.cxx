@@ -334,7 +334,7 @@ bool isImage(char const * filename)
 
 ImageExportInfo::ImageExportInfo( const char * filename, const char * mode )
     : m_filename(filename), m_mode(mode),
-      m_x_res(0), m_y_res(0),
+      m_x_res(0), m_y_res(0), m_num_threads(-1),
       fromMin_(0.0), fromMax_(0.0), toMin_(0.0), toMax_(0.0)
 {}
 
@@ -482,6 +482,28 @@ ImageExportInfo & ImageExportInfo::setICCProfile(
     return *this;
 }
 
+ImageExportInfo & ImageExportInfo::setTileSize(const Size2D & size)
+{
+    m_tile_size = size;
+    return *this;
+}
+
+Size2D ImageExportInfo::getTileSize() const
+{
+    return m_tile_size;
+}
+
+ImageExportInfo & ImageExportInfo::setNumThreads(int n)
+{
+    m_num_threads = n;
+    return *this;
+}
+
+int ImageExportInfo::getNumThreads() const
+{
+    return m_num_threads;
+}
+
 // return an encoder for a given ImageExportInfo object
 VIGRA_UNIQUE_PTR<Encoder> encoder( const ImageExportInfo & info )
 {
@@ -551,13 +573,18 @@ VIGRA_UNIQUE_PTR<Encoder> encoder( const ImageExportInfo & info )
         enc->setICCProfile(info.getICCProfile());
     }
 
+    if ( info.getTileSize().area() > 0 ) {
+        enc->setTileSize(info.getTileSize());
+    }
+    enc->setNumThreads(info.getNumThreads());
+
     return enc;
 }
 
 // class ImageImportInfo
 
 ImageImportInfo::ImageImportInfo( const char * filename, unsigned int imageIndex )
-    : m_filename(filename), m_image_index(imageIndex)
+    : m_filename(filename), m_image_index(imageIndex), m_num_threads(-1)
 {
     readHeader_();
 }
@@ -637,6 +664,16 @@ int ImageImportInfo::getImageIndex() const
     return m_image_index;
 }
 
+void ImageImportInfo::setNumThreads(int n)
+{
+    m_num_threads = n;
+}
+
+int ImageImportInfo::getNumThreads() const
+{
+    return m_num_threads;
+}
+
 Size2D ImageImportInfo::size() const
 {
     return Size2D( m_width, m_height );
@@ -713,7 +750,9 @@ VIGRA_UNIQUE_PTR<Decoder> decoder( const ImageImportInfo & info )
 {
     std::string filetype = info.getFileType();
     validate_filetype(filetype);
-    return getDecoder( std::string( info.getFileName() ), filetype, info.getImageIndex() );
+    VIGRA_UNIQUE_PTR<Decoder> dec = getDecoder( std::string( info.getFileName() ), filetype, info.getImageIndex() );
+    dec->setNumThreads(info.getNumThreads());
+    return dec;
 }
 
 // class VolumeExportInfo
@@ -194,6 +194,7 @@ namespace vigra
         // methods
 
         void init();
+        unsigned int readScanlines( JSAMPROW * rows, unsigned int count );
     };
 
     JPEGDecoderImpl::JPEGDecoderImpl( const std::string & filename )
@@ -319,6 +320,45 @@ namespace vigra
         }
     }
 
+    // kept separate from decodeImage(), so that no local variables
+    // are modified between setjmp() and a possible longjmp()
+    unsigned int JPEGDecoderImpl::readScanlines( JSAMPROW * rows, unsigned int count )
+    {
+        if (setjmp(err.buf))
+            vigra_fail( "error in jpeg_read_scanlines()" );
+        return jpeg_read_scanlines( &info, rows, count );
+    }
+
+    void JPEGDecoder::decodeImage( void * dest, std::ptrdiff_t pixelStride,
+                                   std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                   unsigned int numBands )
+    {
+        // libjpeg produces interleaved 8-bit scanlines, which can be
+        // written into the destination directly if it has the same layout
+        const unsigned int components = pimpl->components;
+        if ( numBands != components || bandStride != 1 ||
+             pixelStride != static_cast<std::ptrdiff_t>(components) ) {
+            Decoder::decodeImage( dest, pixelStride, lineStride, bandStride, numBands );
+            return;
+        }
+
+        // pass several scanlines at once, so that libjpeg can decode
+        // an entire MCU row per call
+        const unsigned int max_rows = 16;
+        JSAMPROW rows[max_rows];
+        JSAMPLE * line = static_cast< JSAMPLE * >(dest);
+        while ( pimpl->info.output_scanline < pimpl->info.output_height ) {
+            unsigned int count = pimpl->info.output_height - pimpl->info.output_scanline;
+            if ( count > max_rows )
+                count = max_rows;
+            for ( unsigned int k = 0; k < count; ++k )
+                rows[k] = line + k * lineStride;
+            const unsigned int done = pimpl->readScanlines( rows, count );
+            vigra_postcondition( done > 0, "JPEGDecoder::decodeImage(): no scanlines decoded." );
+            line += done * lineStride;
+        }
+    }
+
     void JPEGDecoder::close()
     {
         // finish any pending decompression
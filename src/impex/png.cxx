@@ -180,6 +180,7 @@ namespace vigra {
         // methods
         void init();
         void nextScanline();
+        void readImage( png_bytep * rows );
     };
 
     PngDecoderImpl::PngDecoderImpl( const std::string & filename )
@@ -385,6 +386,15 @@ namespace vigra {
         }
     }
 
+    // kept separate from PngDecoder::decodeImage(), so that no local
+    // variables are modified between setjmp() and a possible longjmp()
+    void PngDecoderImpl::readImage( png_bytep * rows )
+    {
+        if (setjmp(png_jmpbuf(png)))
+            vigra_postcondition( false, png_error_message.insert(0, "error in png_read_image(): ").c_str() );
+        png_read_image( png, rows );
+    }
+
     void PngDecoder::init( const std::string & filename )
     {
         pimpl = new PngDecoderImpl(filename);
@@ -483,6 +493,46 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    void PngDecoder::decodeImage( void * dest, std::ptrdiff_t pixelStride,
+                                  std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                  unsigned int numBands )
+    {
+        // libpng produces interleaved scanlines, which are written into
+        // the destination directly if it has the same layout
+        const png_uint_32 width = pimpl->width, height = pimpl->height,
+                          components = pimpl->components;
+        const std::ptrdiff_t element_size = pimpl->bit_depth / 8,
+                             src_stride = components * element_size;
+        const bool direct = numBands == components && bandStride == element_size &&
+                            pixelStride == src_stride && pimpl->rowsize == width * src_stride;
+
+        png_byte * line = static_cast< png_byte * >(dest);
+        if ( direct || pimpl->n_interlace_passes > 1 ) {
+            // let libpng decode the entire image (handling interlacing as needed),
+            // using a temporary buffer if the destination doesn't fit
+            ArrayVector< png_byte > buffer( direct ? 0 : height * pimpl->rowsize );
+            ArrayVector< png_bytep > rows( height );
+            for ( png_uint_32 y = 0; y < height; ++y )
+                rows[y] = direct
+                             ? line + y * lineStride
+                             : buffer.data() + y * pimpl->rowsize;
+            pimpl->readImage( rows.data() );
+            if ( direct )
+                return;
+            for ( png_uint_32 y = 0; y < height; ++y, line += lineStride )
+                for ( unsigned int b = 0; b < numBands; ++b )
+                    copyScanline( rows[y] + b * element_size, src_stride, width, element_size,
+                                  line + b * bandStride, pixelStride );
+        } else {
+            for ( png_uint_32 y = 0; y < height; ++y, line += lineStride ) {
+                pimpl->nextScanline();
+                for ( unsigned int b = 0; b < numBands; ++b )
+                    copyScanline( pimpl->row_data.begin() + b * element_size, src_stride, width,
+                                  element_size, line + b * bandStride, pixelStride );
+            }
+        }
+    }
+
     void PngDecoder::close() {}
 
     void PngDecoder::abort() {}
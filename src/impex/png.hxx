@@ -91,6 +91,7 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
+        void decodeImage( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t, unsigned int );
     };
 
     class PngEncoder : public Encoder
@@ -473,6 +473,37 @@ namespace vigra {
         }
     }
 
+    void PnmDecoder::decodeImage( void * dest, std::ptrdiff_t pixelStride,
+                                  std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                  unsigned int numBands )
+    {
+        // raw files store interleaved scanlines, which can be read into
+        // the destination directly if it has the same layout
+        const std::ptrdiff_t element_size = pixelTypeSize( pimpl->pixeltype );
+        if ( !pimpl->raw || pimpl->bilevel || numBands != pimpl->components ||
+             bandStride != element_size || pixelStride != pimpl->components * element_size ) {
+            Decoder::decodeImage( dest, pixelStride, lineStride, bandStride, numBands );
+            return;
+        }
+
+        // read the entire image at once if the destination is contiguous
+        const std::size_t line_size = pimpl->width * pimpl->components;
+        const unsigned int lines = lineStride == static_cast<std::ptrdiff_t>(line_size * element_size)
+                                      ? 1
+                                      : pimpl->height;
+        const std::size_t count = line_size * (pimpl->height / lines);
+        char * line = static_cast<char *>(dest);
+        byteorder bo( "big endian" );
+        for ( unsigned int y = 0; y < lines; ++y, line += lineStride ) {
+            if ( element_size == 1 )
+                pimpl->stream.read( line, count );
+            else if ( element_size == 2 )
+                read_array( pimpl->stream, bo, reinterpret_cast< UInt16 * >(line), count );
+            else
+                read_array( pimpl->stream, bo, reinterpret_cast< UInt32 * >(line), count );
+        }
+    }
+
     void PnmDecoder::close()
     {}
 
@@ -76,6 +76,7 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
+        void decodeImage( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t, unsigned int );
     };
 
     class PnmEncoder : public Encoder
@@ -59,9 +59,13 @@
 #endif
 
 #include "vigra/sized_int.hxx"
+#include "vigra/threadpool.hxx"
+#include "vigra/compression.hxx"
 #include "error.hxx"
 #include "tiff.hxx"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -189,6 +193,7 @@ namespace vigra {
 
         uint32 stripindex, stripheight;
         uint32 width, height;
+        uint32 tile_width, tile_height; // zero if the image is stored in strips
         uint16 samples_per_pixel, bits_per_sample,
             photometric, planarconfig, fillorder, extra_samples_per_pixel;
         float x_resolution, y_resolution;
@@ -197,6 +202,12 @@ namespace vigra {
 
         Decoder::ICCProfile iccProfile;
 
+        // buffer for a single tile
+        ArrayVector< char > tilebuffer;
+
+        // maximum number of threads for decoding resp. encoding
+        int num_threads;
+
     public:
 
         TIFFCodecImpl();
@@ -210,6 +221,9 @@ namespace vigra {
         stripbuffer = 0;
         strip = 0;
         stripindex = 0;
+        tile_width = 0;
+        tile_height = 0;
+        num_threads = ParallelOptions::Auto;
         planarconfig = PLANARCONFIG_CONTIG;
         x_resolution = 0;
         y_resolution = 0;
@@ -241,11 +255,14 @@ namespace vigra {
     {
         friend class TIFFDecoder;
 
+        std::string filename;
         unsigned int scanline;
 
         std::string get_pixeltype_by_sampleformat() const;
         std::string get_pixeltype_by_datatype() const;
 
+        void readTileRow( uint32 row );
+
     public:
 
         TIFFDecoderImpl( const std::string & filename );
@@ -258,9 +275,15 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int band ) const;
         void nextScanline();
+
+        void decodeRegion( char * dest, std::ptrdiff_t pixelStride,
+                           std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                           unsigned int numBands, uint32 x, uint32 y,
+                           uint32 region_width, uint32 region_height );
     };
 
     TIFFDecoderImpl::TIFFDecoderImpl( const std::string & filename )
+        : filename( filename )
     {
         tiff = TIFFOpen( filename.c_str(), "r" );
 
@@ -361,15 +384,15 @@ namespace vigra {
         TIFFGetField( tiff, TIFFTAG_IMAGELENGTH, &height );
 
         // check for tiled TIFFs
-        uint32 tileWidth, tileHeight;
-        if( TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tileWidth ) &&
-            TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tileHeight ) )
-            vigra_precondition( (tileWidth == width) && (tileHeight == height),
-                                "TIFFDecoder: "
-                                "Cannot read tiled TIFFs (not implemented)." );
+        tile_width = tile_height = 0;
+        if ( TIFFIsTiled(tiff) ) {
+            TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tile_width );
+            TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tile_height );
+        }
 
-        // find out strip heights
-        stripheight = 1; // now using scanline interface instead of strip interface
+        // find out strip heights: the scanline interface reads one scanline
+        // at a time from striped images, and one row of tiles from tiled images
+        stripheight = tile_width > 0 ? tile_height : 1;
 
         // get samples_per_pixel
         samples_per_pixel = 0;
@@ -525,6 +548,10 @@ namespace vigra {
                 fillorder = FILLORDER_MSB2LSB;
         }
 
+        vigra_precondition( tile_width == 0 || bits_per_sample % 8 == 0,
+                            "TIFFDecoder: "
+                            "Cannot read tiled bilevel TIFFs (not implemented)." );
+
         // make sure the LogLuv has correct pixeltype because only float is supported
         if (photometric == PHOTOMETRIC_LOGLUV) {
             pixeltype = "FLOAT";
@@ -597,7 +624,7 @@ namespace vigra {
         }
 
         // allocate data buffers
-        const unsigned int stripsize = TIFFScanlineSize(tiff);
+        const unsigned int stripsize = TIFFScanlineSize(tiff) * stripheight;
         if ( planarconfig == PLANARCONFIG_SEPARATE ) {
             stripbuffer = new tdata_t[samples_per_pixel];
             for( unsigned int i = 0; i < samples_per_pixel; ++i ) {
@@ -615,6 +642,8 @@ namespace vigra {
             if(stripbuffer[0] == 0)
                 throw std::bad_alloc();
         }
+        if ( tile_width > 0 )
+            tilebuffer.resize( TIFFTileSize(tiff) );
 
         // let the codec read a new strip
         stripindex = stripheight;
@@ -670,7 +699,10 @@ namespace vigra {
         if ( ++stripindex >= stripheight ) {
             stripindex = 0;
 
-            if ( planarconfig == PLANARCONFIG_SEPARATE ) {
+            if ( tile_width > 0 ) {
+                readTileRow( scanline );
+                scanline += tile_height;
+            } else if ( planarconfig == PLANARCONFIG_SEPARATE ) {
                 const tsize_t size = TIFFScanlineSize(tiff);
                 for( unsigned int i = 0; i < samples_per_pixel; ++i )
                     TIFFReadScanline(tiff, stripbuffer[i], scanline++, size);
@@ -685,7 +717,7 @@ namespace vigra {
                  samples_per_pixel == 1 && pixeltype == "UINT8" ) {
 
                 UInt8 * buf = static_cast< UInt8 * >(stripbuffer[0]);
-                const unsigned int n = TIFFScanlineSize(tiff);
+                const unsigned int n = TIFFScanlineSize(tiff) * stripheight;
 
                 // invert every pixel
                 for ( unsigned int i = 0; i < n; ++i, ++buf )
@@ -694,6 +726,186 @@ namespace vigra {
         }
     }
 
+    void TIFFDecoderImpl::readTileRow( uint32 row )
+    {
+        // decode the tiles one by one and copy them into the rows of the strip buffer
+        const bool separate = planarconfig == PLANARCONFIG_SEPARATE;
+        const tsize_t line_size = TIFFScanlineSize(tiff),
+                      pixel_size = separate
+                                       ? bits_per_sample / 8
+                                       : samples_per_pixel * ( bits_per_sample / 8 ),
+                      tile_line = tile_width * pixel_size;
+        const uint32 rows = std::min( tile_height, height - row );
+        const unsigned int planes = separate ? samples_per_pixel : 1;
+        for ( unsigned int plane = 0; plane < planes; ++plane ) {
+            char * const buf = static_cast< char * >(stripbuffer[plane]);
+            for ( uint32 x = 0; x < width; x += tile_width ) {
+                vigra_postcondition(
+                    TIFFReadEncodedTile( tiff, TIFFComputeTile( tiff, x, row, 0, plane ),
+                                         tilebuffer.data(), -1 ) >= 0,
+                    "TIFFDecoder: unable to read tile." );
+                const uint32 cols = std::min( tile_width, width - x );
+                for ( uint32 r = 0; r < rows; ++r )
+                    std::memcpy( buf + r * line_size + x * pixel_size,
+                                 tilebuffer.data() + r * tile_line, cols * pixel_size );
+            }
+        }
+    }
+
+    // Lazily opened libtiff handles for concurrent decoding: a handle must
+    // not be shared between threads, so that each thread reads the file through
+    // its own handle (the first thread uses the decoder's handle).
+    class TIFFHandlePool
+    {
+        std::vector< TIFF * > handles;
+        std::string filename;
+        tdir_t directory;
+
+      public:
+
+        TIFFHandlePool( TIFF * tiff, const std::string & filename, int count )
+            : handles( count, (TIFF *)0 ), filename( filename ),
+              directory( TIFFCurrentDirectory( tiff ) )
+        {
+            handles[0] = tiff;
+        }
+
+        ~TIFFHandlePool()
+        {
+            for ( std::size_t k = 1; k < handles.size(); ++k )
+                if ( handles[k] != 0 )
+                    TIFFClose( handles[k] );
+        }
+
+        TIFF * get( int thread )
+        {
+            TIFF * & handle = handles[thread];
+            if ( handle == 0 ) {
+                handle = TIFFOpen( filename.c_str(), "r" );
+                vigra_postcondition( handle != 0 && TIFFSetDirectory( handle, directory ),
+                                     "TIFFDecoder: unable to reopen file for concurrent decoding." );
+            }
+            return handle;
+        }
+    };
+
+    void TIFFDecoderImpl::decodeRegion( char * dest, std::ptrdiff_t pixelStride,
+                                        std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                        unsigned int numBands, uint32 x, uint32 y,
+                                        uint32 region_width, uint32 region_height )
+    {
+        if ( region_width == 0 || region_height == 0 )
+            return;
+
+        // strips are treated like tiles spanning the entire image width
+        const bool tiled = tile_width > 0,
+                   separate = planarconfig == PLANARCONFIG_SEPARATE;
+        uint32 block_width = tile_width, block_height = tile_height;
+        if ( !tiled ) {
+            block_width = width;
+            block_height = height;
+            TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &block_height );
+            block_height = std::min( block_height, height );
+        }
+        const std::ptrdiff_t element_size = bits_per_sample / 8,
+                             src_stride = separate
+                                              ? element_size
+                                              : samples_per_pixel * element_size,
+                             block_line = block_width * src_stride;
+        const uint32 first_col = x / block_width,
+                     cols = ( x + region_width - 1 ) / block_width - first_col + 1,
+                     first_row = y / block_height,
+                     rows = ( y + region_height - 1 ) / block_height - first_row + 1,
+                     planes = separate ? numBands : 1;
+        const std::size_t blocks = std::size_t(planes) * rows * cols,
+                          buffer_size = std::max< std::size_t >(
+                                            tiled ? TIFFTileSize(tiff) : TIFFStripSize(tiff),
+                                            block_height * block_line );
+
+        // decode the tiles resp. strips intersecting the region independently
+        const int threads = (int)std::min< std::size_t >(
+                                ParallelOptions().numThreads( num_threads ).getActualNumThreads(), blocks );
+        TIFFHandlePool handles( tiff, filename, threads );
+        std::vector< ArrayVector< char > > buffers( threads );
+
+        parallel_foreach( threads, blocks,
+            [&]( int thread, std::size_t k )
+            {
+                const uint32 plane = k / ( rows * cols ),
+                             block_x = ( first_col + k % cols ) * block_width,
+                             block_y = ( first_row + ( k / cols ) % rows ) * block_height,
+                             block_rows = std::min( block_height, height - block_y ),
+                             x0 = std::max( x, block_x ),
+                             x1 = std::min( x + region_width, std::min( block_x + block_width, width ) ),
+                             y0 = std::max( y, block_y ),
+                             y1 = std::min( y + region_height, block_y + block_rows );
+                char * target = dest + ( y0 - y ) * lineStride + ( x0 - x ) * pixelStride
+                                     + plane * bandStride;
+
+                // strips inside the region are decoded in place if the
+                // destination has the file's layout
+                const bool direct = !tiled && x0 == 0 && x1 == width &&
+                                    y0 == block_y && y1 == block_y + block_rows &&
+                                    lineStride == block_line && pixelStride == src_stride &&
+                                    ( separate || ( numBands == samples_per_pixel &&
+                                                    bandStride == element_size ) );
+                TIFF * handle = handles.get( thread );
+                ArrayVector< char > & buffer = buffers[thread];
+                if ( !direct && buffer.size() == 0 )
+                    buffer.resize( buffer_size );
+                char * data = direct
+                                  ? target
+                                  : buffer.data();
+                const tsize_t res = tiled
+                    ? TIFFReadEncodedTile( handle, TIFFComputeTile( handle, block_x, block_y, 0, plane ),
+                                           data, -1 )
+                    : TIFFReadEncodedStrip( handle, TIFFComputeStrip( handle, block_y, plane ),
+                                            data, block_rows * block_line );
+                vigra_postcondition( res >= 0, "TIFFDecoder: unable to read tile or strip." );
+                if ( direct )
+                    return;
+
+                const char * src = data + ( y0 - block_y ) * block_line + ( x0 - block_x ) * src_stride;
+                for ( uint32 row = y0; row < y1; ++row, src += block_line, target += lineStride ) {
+                    if ( separate ) {
+                        Decoder::copyScanline( src, src_stride, x1 - x0, element_size,
+                                               target, pixelStride );
+                    } else {
+                        for ( unsigned int b = 0; b < numBands; ++b )
+                            Decoder::copyScanline( src + b * element_size, src_stride, x1 - x0, element_size,
+                                                   target + b * bandStride, pixelStride );
+                    }
+                }
+            });
+    }
+
+    void TIFFDecoder::decodeRegion( void * dest, std::ptrdiff_t pixelStride,
+                                    std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                    unsigned int numBands, unsigned int x, unsigned int y,
+                                    unsigned int width, unsigned int height )
+    {
+        // striped images go through the scanline interface unless concurrent
+        // decoding is requested explicitly, and so do bilevel, inverted and
+        // LogLuv images
+        if ( ( pimpl->tile_width == 0 && pimpl->num_threads <= 1 ) ||
+             pimpl->bits_per_sample % 8 != 0 ||
+             pimpl->photometric == PHOTOMETRIC_LOGL || pimpl->photometric == PHOTOMETRIC_LOGLUV ||
+             ( pimpl->photometric == PHOTOMETRIC_MINISWHITE &&
+               pimpl->samples_per_pixel == 1 && pimpl->pixeltype == "UINT8" ) ) {
+            Decoder::decodeRegion( dest, pixelStride, lineStride, bandStride, numBands,
+                                   x, y, width, height );
+            return;
+        }
+        pimpl->decodeRegion( static_cast< char * >(dest), pixelStride, lineStride, bandStride,
+                             numBands, x, y, width, height );
+        pimpl->scanline = pimpl->height;
+    }
+
+    void TIFFDecoder::setNumThreads( int n )
+    {
+        pimpl->num_threads = n;
+    }
+
     void TIFFDecoder::init( const std::string & filename, unsigned int imageIndex=0 )
     {
         pimpl = new TIFFDecoderImpl(filename);
@@ -847,6 +1059,12 @@ namespace vigra {
         void setCompressionType( const std::string &, int );
         void finalizeSettings();
 
+        void writeBlock( uint32 index, tdata_t data, tsize_t size );
+        void writeTileRow( uint32 row, uint32 rows );
+        void encodeImage( const char * src, std::ptrdiff_t pixelStride,
+                          std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                          unsigned int numBands, std::size_t element_size );
+
         void * currentScanlineOfBand( unsigned int band ) const
         {
             const unsigned int atomicbytes = bits_per_sample >> 3;
@@ -857,15 +1075,20 @@ namespace vigra {
 
         void nextScanline()
         {
-            // compute the number of rows in the current strip
+            // compute the number of rows in the current strip resp. row of tiles
             unsigned int rows = ( strip + 1 ) * stripheight > height ?
                 height - strip * stripheight : stripheight;
 
             if ( ++stripindex >= rows ) {
 
-                // write next strip
+                // write next strip resp. row of tiles
                 stripindex = 0;
 
+                if ( tile_width > 0 ) {
+                    writeTileRow( strip++ * stripheight, rows );
+                    return;
+                }
+
                 int success = TIFFWriteEncodedStrip( tiff, strip++, stripbuffer[0],
                                        TIFFVStripSize( tiff, rows ) );
                 if(success == -1 && tiffcomp != COMPRESSION_NONE)
@@ -879,6 +1102,107 @@ namespace vigra {
         }
     };
 
+    void TIFFEncoderImpl::writeBlock( uint32 index, tdata_t data, tsize_t size )
+    {
+        tsize_t success = tile_width > 0
+                              ? TIFFWriteEncodedTile( tiff, index, data, size )
+                              : TIFFWriteEncodedStrip( tiff, index, data, size );
+        if(success == -1 && tiffcomp != COMPRESSION_NONE)
+        {
+            throw Encoder::TIFFCompressionException(); // retry without compression
+        }
+
+        vigra_postcondition(success != -1,
+                "exportImage(): Unable to write TIFF data.");
+    }
+
+    void TIFFEncoderImpl::writeTileRow( uint32 row, uint32 rows )
+    {
+        // split the rows of the strip buffer into tiles
+        const std::ptrdiff_t pixel_size = samples_per_pixel * ( bits_per_sample >> 3 ),
+                             line_size = width * pixel_size,
+                             tile_line = tile_width * pixel_size;
+        const char * buf = static_cast< const char * >(stripbuffer[0]);
+        for ( uint32 x = 0; x < width; x += tile_width ) {
+            const uint32 cols = std::min( tile_width, width - x );
+            // tiles at the right and lower border are padded with zeros
+            if ( cols < tile_width || rows < tile_height )
+                std::fill( tilebuffer.begin(), tilebuffer.end(), 0 );
+            for ( uint32 r = 0; r < rows; ++r )
+                std::memcpy( tilebuffer.data() + r * tile_line,
+                             buf + r * line_size + x * pixel_size, cols * pixel_size );
+            writeBlock( TIFFComputeTile( tiff, x, row, 0, 0 ), tilebuffer.data(), tilebuffer.size() );
+        }
+    }
+
+    void TIFFEncoderImpl::encodeImage( const char * src, std::ptrdiff_t pixelStride,
+                                       std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                       unsigned int numBands, std::size_t element_size )
+    {
+        // strips are treated like tiles spanning the entire image width,
+        // so that block 'k' is tile resp. strip number 'k' in the file
+        const bool tiled = tile_width > 0;
+        const uint32 block_width = tiled ? tile_width : width,
+                     block_height = stripheight,
+                     blocks_per_row = ( width + block_width - 1 ) / block_width,
+                     blocks = blocks_per_row * ( ( height + block_height - 1 ) / block_height );
+        const std::ptrdiff_t pixel_size = samples_per_pixel * element_size,
+                             block_line = block_width * pixel_size;
+
+        // copy block 'k' into 'buffer' and return the number of bytes to be written
+        auto gather = [&]( uint32 k, char * buffer ) -> tsize_t
+        {
+            const uint32 block_x = ( k % blocks_per_row ) * block_width,
+                         block_y = ( k / blocks_per_row ) * block_height,
+                         cols = std::min( block_width, width - block_x ),
+                         rows = std::min( block_height, height - block_y );
+            // tiles are always complete, pad them with zeros at the image border
+            if ( tiled && ( cols < block_width || rows < block_height ) )
+                std::fill( buffer, buffer + block_height * block_line, 0 );
+            const char * line = src + block_y * lineStride + block_x * pixelStride;
+            for ( uint32 r = 0; r < rows; ++r, line += lineStride, buffer += block_line )
+                for ( unsigned int b = 0; b < numBands; ++b )
+                    Decoder::copyScanline( line + b * bandStride, pixelStride, cols, element_size,
+                                           buffer + b * element_size, pixel_size );
+            return ( tiled ? block_height : rows ) * block_line;
+        };
+
+        const int threads = (int)std::min< std::size_t >(
+                                ParallelOptions().numThreads( num_threads ).getActualNumThreads(), blocks );
+#ifdef HasZLIB
+        // libtiff cannot compress concurrently, but deflate compression is
+        // simple enough to be done here: batches of blocks are compressed
+        // in parallel and then appended to the file in order
+        if ( threads > 1 &&
+             ( tiffcomp == COMPRESSION_DEFLATE || tiffcomp == COMPRESSION_ADOBE_DEFLATE ) ) {
+            const uint32 batch_size = 4 * threads;
+            std::vector< ArrayVector< char > > buffers( threads ), compressed( batch_size );
+            for ( uint32 first = 0; first < blocks; first += batch_size ) {
+                const uint32 count = std::min( batch_size, blocks - first );
+                parallel_foreach( threads, count,
+                    [&]( int thread, std::size_t i )
+                    {
+                        ArrayVector< char > & buffer = buffers[thread];
+                        if ( buffer.size() == 0 )
+                            buffer.resize( block_height * block_line );
+                        const tsize_t size = gather( first + i, buffer.data() );
+                        compress( buffer.data(), size, compressed[i], ZLIB );
+                    });
+                for ( uint32 i = 0; i < count; ++i ) {
+                    const tsize_t success = tiled
+                        ? TIFFWriteRawTile( tiff, first + i, compressed[i].data(), compressed[i].size() )
+                        : TIFFWriteRawStrip( tiff, first + i, compressed[i].data(), compressed[i].size() );
+                    vigra_postcondition( success != -1, "exportImage(): Unable to write TIFF data." );
+                }
+            }
+            return;
+        }
+#endif
+        ArrayVector< char > buffer( block_height * block_line );
+        for ( uint32 k = 0; k < blocks; ++k )
+            writeBlock( k, buffer.data(), gather( k, buffer.data() ) );
+    }
+
     void TIFFEncoderImpl::setCompressionType( const std::string & comp,
                                               int quality = -1 )
     {
@@ -912,14 +1236,23 @@ namespace vigra {
         TIFFSetField( tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG );
         TIFFSetField( tiff, TIFFTAG_IMAGEWIDTH, width );
         TIFFSetField( tiff, TIFFTAG_IMAGELENGTH, height );
-        // TIFFDefaultStripSize tries for 8kb strips! Laughable!
-        // This will do a 1MB strip for 8-bit images,
-        // 2MB strip for 16-bit, and so forth.
-        unsigned int estimate =
-            (unsigned int)std::max(static_cast<UIntBiggest>(1),
-                                  (static_cast<UIntBiggest>(1)<<20) / (width * samples_per_pixel));
-        TIFFSetField( tiff, TIFFTAG_ROWSPERSTRIP,
-                      stripheight = TIFFDefaultStripSize( tiff, estimate ) );
+        if ( tile_width > 0 ) {
+            // the TIFF specification requires multiples of 16
+            tile_width = ( tile_width + 15 ) / 16 * 16;
+            tile_height = ( tile_height + 15 ) / 16 * 16;
+            TIFFSetField( tiff, TIFFTAG_TILEWIDTH, tile_width );
+            TIFFSetField( tiff, TIFFTAG_TILELENGTH, tile_height );
+            stripheight = tile_height;
+        } else {
+            // TIFFDefaultStripSize tries for 8kb strips! Laughable!
+            // This will do a 1MB strip for 8-bit images,
+            // 2MB strip for 16-bit, and so forth.
+            unsigned int estimate =
+                (unsigned int)std::max(static_cast<UIntBiggest>(1),
+                                      (static_cast<UIntBiggest>(1)<<20) / (width * samples_per_pixel));
+            TIFFSetField( tiff, TIFFTAG_ROWSPERSTRIP,
+                          stripheight = TIFFDefaultStripSize( tiff, estimate ) );
+        }
         TIFFSetField( tiff, TIFFTAG_SAMPLESPERPIXEL, samples_per_pixel );
         TIFFSetField( tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT );
         TIFFSetField( tiff, TIFFTAG_COMPRESSION, tiffcomp );
@@ -955,6 +1288,10 @@ namespace vigra {
         }
         TIFFSetField( tiff, TIFFTAG_BITSPERSAMPLE, bits_per_sample );
 
+        vigra_precondition( tile_width == 0 || bits_per_sample % 8 == 0,
+                            "TIFFEncoder: "
+                            "Cannot write tiled bilevel TIFFs (not implemented)." );
+
        if (extra_samples_per_pixel > 0) {
               uint16 * types = new  uint16[extra_samples_per_pixel];
            for ( int i=0; i < extra_samples_per_pixel; i++ ) {
@@ -1003,12 +1340,17 @@ namespace vigra {
                          iccProfile.size(), iccProfile.begin());
         }
 
-        // alloc memory
+        // alloc memory (the scanline interface collects an entire
+        // row of tiles before writing them)
         stripbuffer = new tdata_t[1];
         stripbuffer[0] = 0;
-        stripbuffer[0] = _TIFFmalloc( TIFFStripSize(tiff) );
+        stripbuffer[0] = _TIFFmalloc( tile_width > 0
+                                          ? width * samples_per_pixel * ( bits_per_sample >> 3 ) * tile_height
+                                          : TIFFStripSize(tiff) );
         if(stripbuffer[0] == 0)
             throw std::bad_alloc();
+        if ( tile_width > 0 )
+            tilebuffer.resize( TIFFTileSize(tiff) );
 
         finalized = true;
     }
@@ -1083,6 +1425,18 @@ namespace vigra {
         pimpl->y_resolution = yres;
     }
 
+    void TIFFEncoder::setTileSize( const vigra::Size2D & size )
+    {
+        VIGRA_IMPEX_FINALIZED(pimpl->finalized);
+        pimpl->tile_width = size.x;
+        pimpl->tile_height = size.y;
+    }
+
+    void TIFFEncoder::setNumThreads( int n )
+    {
+        pimpl->num_threads = n;
+    }
+
     unsigned int TIFFEncoder::getOffset() const
     {
         return pimpl->samples_per_pixel;
@@ -1104,6 +1458,26 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    void TIFFEncoder::encodeImage( const void * src, std::ptrdiff_t pixelStride,
+                                   std::ptrdiff_t lineStride, std::ptrdiff_t bandStride,
+                                   unsigned int width, unsigned int height,
+                                   unsigned int numBands, std::size_t elementSize )
+    {
+        vigra_precondition( pimpl->finalized && width == pimpl->width && height == pimpl->height &&
+                            numBands == pimpl->samples_per_pixel,
+                            "TIFFEncoder::encodeImage(): image shape doesn't match the settings." );
+        // striped images go through the scanline interface unless concurrent
+        // encoding is requested explicitly, and so do bilevel images
+        if ( ( pimpl->tile_width == 0 && pimpl->num_threads <= 1 ) ||
+             pimpl->bits_per_sample % 8 != 0 ) {
+            Encoder::encodeImage( src, pixelStride, lineStride, bandStride,
+                                  width, height, numBands, elementSize );
+            return;
+        }
+        pimpl->encodeImage( static_cast< const char * >(src), pixelStride, lineStride, bandStride,
+                            numBands, elementSize );
+    }
+
     void TIFFEncoder::setICCProfile(const ICCProfile & data)
     {
         pimpl->iccProfile = data;
@@ -91,6 +91,9 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
+        void decodeRegion( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t, unsigned int,
+                           unsigned int, unsigned int, unsigned int, unsigned int );
+        void setNumThreads( int );
 
         std::string getPixelType() const;
         unsigned int getOffset() const;
@@ -127,6 +130,8 @@ namespace vigra {
         void setCanvasSize( const Size2D & pos );
         void setXResolution( float xres );
         void setYResolution( float yres );
+        void setTileSize( const vigra::Size2D & size );
+        void setNumThreads( int );
 
         unsigned int getOffset() const;
 
@@ -134,6 +139,8 @@ namespace vigra {
 
         void * currentScanlineOfBand( unsigned int );
         void nextScanline();
+        void encodeImage( const void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t,
+                          unsigned int, unsigned int, unsigned int, std::size_t );
 
         void setICCProfile(const ICCProfile & data);
 
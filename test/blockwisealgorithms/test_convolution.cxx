@@ -104,6 +104,50 @@ struct BlockwiseConvolutionTest
         );
 
     }
+
+    void testChunkedFilters()
+    {
+        typedef MultiArray<3, float> Array;
+        typedef Array::difference_type Shape;
+
+        Shape shape(50, 40, 30);
+        Array data(shape);
+        fillRandom(data.begin(), data.end(), 2000);
+
+        ChunkedArrayCompressed<3, float> chunkedData(shape, Shape(16));
+        chunkedData.commitSubarray(Shape(0), data);
+
+        BlockwiseConvolutionOptions<3> opt;
+        opt.stdDev(1.5);
+        opt.numThreads(4);
+
+        // chunk-aligned blocks with a small cache
+        {
+            ChunkedArrayCompressed<3, float> chunkedRes(shape, Shape(16),
+                                                        ChunkedArrayOptions().cacheMax(4));
+            gaussianSmoothMultiArray(chunkedData, chunkedRes, opt);
+
+            Array res(shape), resC(shape);
+            gaussianSmoothMultiArray(data, res, opt);
+            chunkedRes.checkoutSubarray(Shape(0), resC);
+
+            shouldEqualSequenceTolerance(res.begin(), res.end(), resC.begin(), 1e-5);
+        }
+
+        // user-defined blocks straddling chunk borders
+        {
+            typedef TinyVector<float, 3> EV;
+            opt.blockShape(Shape(20, 12, 9));
+            ChunkedArrayLazy<3, EV> chunkedRes(shape, Shape(8));
+            hessianOfGaussianEigenvaluesMultiArray(chunkedData, chunkedRes, opt);
+
+            MultiArray<3, EV> res(shape), resC(shape);
+            hessianOfGaussianEigenvaluesMultiArray(data, res, opt);
+            chunkedRes.checkoutSubarray(Shape(0), resC);
+
+            shouldEqualSequenceTolerance(res.begin(), res.end(), resC.begin(), EV(1e-5f));
+        }
+    }
 };
 
 struct BlockwiseConvolutionTestSuite
@@ -115,6 +159,7 @@ struct BlockwiseConvolutionTestSuite
         add(testCase(&BlockwiseConvolutionTest::simpleTest));
         add(testCase(&BlockwiseConvolutionTest::chunkedTest));
         add(testCase(&BlockwiseConvolutionTest::testParallel));
+        add(testCase(&BlockwiseConvolutionTest::testChunkedFilters));
     }
 };
 
@@ -0,0 +1,170 @@
+/************************************************************************/
+/*                                                                      */
+/*          Copyright 2016 by the VIGRA developers                      */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#include <vigra/blockwise_features.hxx>
+
+#include <vigra/multi_array.hxx>
+#include <vigra/multi_array_chunked.hxx>
+#include <vigra/random.hxx>
+#include <vigra/unittest.hxx>
+
+#include <iostream>
+
+using namespace std;
+using namespace vigra;
+using namespace vigra::acc;
+
+struct BlockwiseFeaturesTest
+{
+    typedef Select<DataArg<1>, LabelArg<2>,
+                   Count, Mean, Variance, Skewness, Minimum, Maximum,
+                   RegionCenter, Coord<Maximum>, AutoRangeHistogram<8>,
+                   Global<Mean>, Global<Maximum> > Selected;
+
+    MultiArray<3, double> data;
+    MultiArray<3, UInt32> labels;
+
+    BlockwiseFeaturesTest()
+    : data(Shape3(45, 37, 23)),
+      labels(data.shape())
+    {
+        MersenneTwister random(42);
+        for(int k=0; k<data.size(); ++k)
+        {
+            data[k] = random.uniform(-10.0, 10.0);
+            // a few large regions and some small ones, with gaps between the labels
+            labels[k] = random.uniformInt(10) < 7
+                            ? 10*(data.scanOrderIndexToCoordinate(k)[0] / 10)
+                            : 200 + random.uniformInt(5);
+        }
+    }
+
+    template <class A, class B>
+    void compare(A const & a, B const & b, MultiArrayIndex label, double tolerance)
+    {
+        shouldEqual(get<Count>(a, label), get<Count>(b, label));
+        shouldEqual(get<Minimum>(a, label), get<Minimum>(b, label));
+        shouldEqual(get<Maximum>(a, label), get<Maximum>(b, label));
+        shouldEqual(get<Coord<Maximum> >(a, label), get<Coord<Maximum> >(b, label));
+        shouldEqual(get<AutoRangeHistogram<8> >(a, label), get<AutoRangeHistogram<8> >(b, label));
+        shouldEqualTolerance(get<Mean>(a, label), get<Mean>(b, label), tolerance);
+        shouldEqualTolerance(get<Variance>(a, label), get<Variance>(b, label), tolerance);
+        shouldEqualTolerance(get<Skewness>(a, label), get<Skewness>(b, label), tolerance);
+        shouldEqualSequenceTolerance(get<RegionCenter>(a, label).begin(), get<RegionCenter>(a, label).end(),
+                                     get<RegionCenter>(b, label).begin(), tolerance);
+    }
+
+    void testMultiArrayView()
+    {
+        typedef AccumulatorChainArray<CoupledArrays<3, double, UInt32>, Selected> A;
+
+        A serial, blockwise, blockwise1;
+        serial.ignoreLabel(202);
+        blockwise.ignoreLabel(202);
+        blockwise1.ignoreLabel(202);
+        extractFeatures(data, labels, serial);
+        extractFeaturesBlockwise(data, labels, blockwise, BlockwiseOptions().blockShape(Shape3(16, 8, 10)).numThreads(3));
+        extractFeaturesBlockwise(data, labels, blockwise1, BlockwiseOptions().blockShape(Shape3(16, 8, 10)).numThreads(1));
+
+        shouldEqual(blockwise.maxRegionLabel(), serial.maxRegionLabel());
+        shouldEqual(get<Global<Maximum> >(blockwise), get<Global<Maximum> >(serial));
+        shouldEqualTolerance(get<Global<Mean> >(blockwise), get<Global<Mean> >(serial), 1e-12);
+        for(MultiArrayIndex k=0; k<=serial.maxRegionLabel(); ++k)
+        {
+            if(get<Count>(serial, k) == 0.0)
+            {
+                shouldEqual(get<Count>(blockwise, k), 0.0);
+                continue;
+            }
+            compare(blockwise, serial, k, 1e-12);
+            // the result doesn't depend on the number of threads
+            compare(blockwise, blockwise1, k, 0.0);
+        }
+        shouldEqual(get<Count>(blockwise, 202), 0.0);
+    }
+
+    void testChunkedArray()
+    {
+        typedef AccumulatorChainArray<CoupledArrays<3, double, UInt32>, Selected> A;
+        typedef SparseAccumulatorChainArray<CoupledArrays<3, double, UInt32>, Selected> S;
+
+        ChunkedArrayLazy<3, double> chunkedData(data.shape(), Shape3(16));
+        ChunkedArrayLazy<3, UInt32> chunkedLabels(data.shape(), Shape3(16));
+        chunkedData.commitSubarray(Shape3(0), data);
+        chunkedLabels.commitSubarray(Shape3(0), labels);
+
+        A serial;
+        S blockwise;
+        serial.setCoordinateOffset(Shape3(100, 200, 300));
+        blockwise.setCoordinateOffset(Shape3(100, 200, 300));
+        extractFeatures(data, labels, serial);
+        extractFeaturesBlockwise(chunkedData, chunkedLabels, blockwise, BlockwiseOptions().numThreads(4));
+
+        shouldEqual(blockwise.maxRegionLabel(), serial.maxRegionLabel());
+        unsigned int regionCount = 0;
+        for(MultiArrayIndex k=0; k<=serial.maxRegionLabel(); ++k)
+        {
+            if(get<Count>(serial, k) == 0.0)
+            {
+                should(!blockwise.hasRegion(k));
+                continue;
+            }
+            ++regionCount;
+            compare(blockwise, serial, k, 1e-12);
+        }
+        shouldEqual(blockwise.regionCount(), regionCount);
+    }
+};
+
+struct BlockwiseFeaturesTestSuite
+  : public test_suite
+{
+    BlockwiseFeaturesTestSuite()
+      : test_suite("blockwise features test")
+    {
+        add(testCase(&BlockwiseFeaturesTest::testMultiArrayView));
+        add(testCase(&BlockwiseFeaturesTest::testChunkedArray));
+    }
+};
+
+int main(int argc, char** argv)
+{
+    BlockwiseFeaturesTestSuite test;
+    int failed = test.run(testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+    return failed != 0;
+}
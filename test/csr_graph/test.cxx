@@ -0,0 +1,263 @@
+/************************************************************************/
+/*                                                                      */
+/*          Copyright 2016 by the VIGRA developers                      */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <iostream>
+#include <set>
+#include "vigra/unittest.hxx"
+#include "vigra/multi_array.hxx"
+#include "vigra/adjacency_list_graph.hxx"
+#include "vigra/csr_graph.hxx"
+#include "vigra/graph_algorithms.hxx"
+
+using namespace vigra;
+
+struct CsrGraphTest{
+
+    typedef vigra::CsrGraph                      GraphType;
+    typedef GraphType::Node                      Node;
+    typedef GraphType::Edge                      Edge;
+    typedef GraphType::Arc                       Arc;
+    typedef GraphType::EdgeIt                    EdgeIt;
+    typedef GraphType::NodeIt                    NodeIt;
+    typedef GraphType::ArcIt                     ArcIt;
+    typedef GraphType::IncEdgeIt                 IncEdgeIt;
+    typedef GraphType::OutArcIt                  OutArcIt;
+    typedef GraphType::InArcIt                   InArcIt;
+    typedef GraphType::NeighborNodeIt            NeighborNodeIt;
+
+    typedef AdjacencyListGraph                   ListGraph;
+
+    // check that g and the list graph have identical structure
+    void checkSameGraph(const GraphType & g, const ListGraph & lg){
+        shouldEqual(g.nodeNum(), lg.nodeNum());
+        shouldEqual(g.edgeNum(), lg.edgeNum());
+        shouldEqual(g.arcNum(),  lg.arcNum());
+        shouldEqual(g.maxNodeId(), lg.maxNodeId());
+        shouldEqual(g.maxEdgeId(), lg.maxEdgeId());
+        shouldEqual(g.maxArcId(),  lg.maxArcId());
+
+        for(Int64 id=-1; id<=g.maxNodeId()+1; ++id)
+            shouldEqual(g.nodeFromId(id)==lemon::INVALID, lg.nodeFromId(id)==lemon::INVALID);
+
+        std::size_t count=0;
+        for(EdgeIt e(g); e!=lemon::INVALID; ++e, ++count){
+            shouldEqual(g.id(g.u(*e)), lg.id(lg.u(*e)));
+            shouldEqual(g.id(g.v(*e)), lg.id(lg.v(*e)));
+        }
+        shouldEqual(count, (std::size_t)g.edgeNum());
+
+        count=0;
+        for(ArcIt a(g); a!=lemon::INVALID; ++a, ++count){
+            shouldEqual(g.id(g.source(*a)), lg.id(lg.source(*a)));
+            shouldEqual(g.id(g.target(*a)), lg.id(lg.target(*a)));
+        }
+        shouldEqual(count, (std::size_t)g.arcNum());
+
+        for(NodeIt n(g); n!=lemon::INVALID; ++n){
+            shouldEqual(g.degree(*n), lg.degree(*n));
+
+            // neighbors are visited in the same (sorted) order as in the list graph
+            ListGraph::IncEdgeIt le(lg, *n);
+            for(IncEdgeIt e(g, *n); e!=lemon::INVALID; ++e, ++le)
+                should(*e == *le);
+            should(le == lemon::INVALID);
+
+            ListGraph::NeighborNodeIt ln(lg, *n);
+            for(NeighborNodeIt o(g, *n); o!=lemon::INVALID; ++o, ++ln)
+                should(*o == *ln);
+
+            for(OutArcIt a(g, *n); a!=lemon::INVALID; ++a)
+                should(g.source(*a) == *n);
+            for(InArcIt a(g, *n); a!=lemon::INVALID; ++a)
+                should(g.target(*a) == *n);
+
+            for(NodeIt m(g); m!=lemon::INVALID; ++m){
+                should(g.findEdge(*n, *m) == lg.findEdge(*n, *m));
+                should(g.findArc(*n, *m) == lg.findArc(*n, *m));
+            }
+        }
+    }
+
+    void testFromAdjacencyListGraph(){
+        // node ids with gaps
+        ListGraph lg;
+        lg.addNode(1);
+        lg.addNode(2);
+        lg.addNode(3);
+        lg.addNode(5);
+        lg.addNode(8);
+        lg.addEdge(2,1);
+        lg.addEdge(1,3);
+        lg.addEdge(5,2);
+        lg.addEdge(3,5);
+        lg.addEdge(5,8);
+        lg.addEdge(1,8);
+
+        GraphType g(lg);
+        checkSameGraph(g, lg);
+
+        should(g.nodeFromId(0)==lemon::INVALID);
+        should(g.nodeFromId(4)==lemon::INVALID);
+        shouldEqual(g.degree(g.nodeFromId(5)), 3u);
+        should(g.findEdge(g.nodeFromId(2), g.nodeFromId(3))==lemon::INVALID);
+        shouldEqual(g.id(g.findEdge(g.nodeFromId(8), g.nodeFromId(5))), 4);
+
+        // empty graphs
+        GraphType e1, e2((ListGraph()));
+        shouldEqual(e1.nodeNum(), 0);
+        shouldEqual(e2.edgeNum(), 0);
+        should(NodeIt(e1)==lemon::INVALID);
+        should(EdgeIt(e2)==lemon::INVALID);
+    }
+
+    void testFromEdgeList(){
+        MultiArray<2, UInt32> uvIds(Shape2(5, 2));
+        const UInt32 uv[5][2] = {{0,1}, {3,1}, {2,0}, {1,2}, {3,4}};
+        for(int e=0; e<5; ++e){
+            uvIds(e,0) = uv[e][0];
+            uvIds(e,1) = uv[e][1];
+        }
+
+        GraphType g(6, uvIds);
+        shouldEqual(g.nodeNum(), 6);
+        shouldEqual(g.edgeNum(), 5);
+        for(int e=0; e<5; ++e){
+            shouldEqual(g.id(g.u(Edge(e))), (Int64)uv[e][0]);
+            shouldEqual(g.id(g.v(Edge(e))), (Int64)uv[e][1]);
+            shouldEqual(g.id(g.findEdge(Node(uv[e][1]), Node(uv[e][0]))), e);
+        }
+        shouldEqual(g.degree(Node(5)), 0u);
+        should(IncEdgeIt(g, Node(5))==lemon::INVALID);
+
+        ListGraph lg;
+        for(int n=0; n<6; ++n)
+            lg.addNode(n);
+        for(int e=0; e<5; ++e)
+            lg.addEdge(uv[e][0], uv[e][1]);
+        checkSameGraph(g, lg);
+
+        uvIds(4,1) = 3;
+        try{
+            GraphType bad(6, uvIds);
+            failTest("no exception thrown for a self-loop");
+        }
+        catch(PreconditionViolation &){}
+
+        uvIds(4,0) = 1;   // same as edge 1, but reversed
+        uvIds(4,1) = 3;
+        try{
+            GraphType bad(6, uvIds);
+            failTest("no exception thrown for parallel edges");
+        }
+        catch(PreconditionViolation &){}
+    }
+
+    void testAlgorithms(){
+        // 4-connected grid graph as list graph and as csr graph
+        const int w=7, h=5;
+        ListGraph lg;
+        for(int i=0; i<w*h; ++i)
+            lg.addNode(i);
+        for(int y=0; y<h; ++y)
+        for(int x=0; x<w; ++x){
+            if(x+1<w) lg.addEdge(x+w*y, x+1+w*y);
+            if(y+1<h) lg.addEdge(x+w*y, x+w*(y+1));
+        }
+        GraphType g(lg);
+        checkSameGraph(g, lg);
+
+        ListGraph::EdgeMap<float> lweights(lg);
+        GraphType::EdgeMap<float> weights(g);
+        for(EdgeIt e(g); e!=lemon::INVALID; ++e){
+            const float value = float((g.id(*e)*37) % 11) + 1.0f;
+            lweights[*e] = value;
+            weights[*e]  = value;
+        }
+
+        // shortest path
+        ShortestPathDijkstra<ListGraph, float> lsp(lg);
+        ShortestPathDijkstra<GraphType, float> sp(g);
+        lsp.run(lweights, lg.nodeFromId(3));
+        sp.run(weights, g.nodeFromId(3));
+        for(NodeIt n(g); n!=lemon::INVALID; ++n){
+            shouldEqual(sp.distance(*n), lsp.distance(*n));
+            should(sp.predecessors()[*n] == lsp.predecessors()[*n]);
+        }
+
+        // watersheds
+        ListGraph::NodeMap<UInt32> lseeds(lg, 0), llabels(lg, 0);
+        GraphType::NodeMap<UInt32> seeds(g, 0), labels(g, 0);
+        lseeds[Node(0)] = seeds[Node(0)] = 1;
+        lseeds[Node(w*h-1)] = seeds[Node(w*h-1)] = 2;
+        lseeds[Node(w*2+3)] = seeds[Node(w*2+3)] = 3;
+        edgeWeightedWatershedsSegmentation(lg, lweights, lseeds, llabels);
+        edgeWeightedWatershedsSegmentation(g, weights, seeds, labels);
+        for(NodeIt n(g); n!=lemon::INVALID; ++n){
+            should(labels[*n] != 0);
+            shouldEqual(labels[*n], llabels[*n]);
+        }
+
+        // felzenszwalb
+        ListGraph::NodeMap<float> lsizes(lg, 1.0f);
+        GraphType::NodeMap<float> sizes(g, 1.0f);
+        felzenszwalbSegmentation(lg, lweights, lsizes, 2.0f, llabels);
+        felzenszwalbSegmentation(g, weights, sizes, 2.0f, labels);
+        for(NodeIt n(g); n!=lemon::INVALID; ++n)
+            shouldEqual(labels[*n], llabels[*n]);
+    }
+};
+
+struct CsrGraphTestSuite
+: public vigra::test_suite
+{
+    CsrGraphTestSuite()
+    : vigra::test_suite("CsrGraphTestSuite")
+    {
+        add( testCase( &CsrGraphTest::testFromAdjacencyListGraph));
+        add( testCase( &CsrGraphTest::testFromEdgeList));
+        add( testCase( &CsrGraphTest::testAlgorithms));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    CsrGraphTestSuite test;
+
+    int failed = test.run(vigra::testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+
+    return (failed != 0);
+}
@@ -453,6 +453,59 @@ struct GraphAlgorithmTest{
     }
 
 
+    void testRegionAdjacencyGraphParallel(){
+        typedef GridGraph<3, boost_graph::undirected_tag> GridGraph3d;
+        typedef GridGraph3d::Edge GridEdge;
+        typedef GraphType::EdgeMap< std::vector<GridEdge> > AffEdges;
+        typedef MultiArrayShape<3>::type Shape3;
+
+        MultiArray<3, UInt32> labels(Shape3(13, 10, 9));
+        for(MultiArrayIndex z=0; z<labels.shape(2); ++z)
+        for(MultiArrayIndex y=0; y<labels.shape(1); ++y)
+        for(MultiArrayIndex x=0; x<labels.shape(0); ++x)
+            labels(x,y,z) = x/3 + 5*(y/4) + 15*(z/3) + ((x*7+y*3+z) % 11 == 0 ? 60 : 0);
+
+        for(int direct=0; direct<2; ++direct){
+            GridGraph3d g(labels.shape(), direct ? DirectNeighborhood : IndirectNeighborhood);
+            for(int ignore=-1; ignore<=16; ignore+=17){
+                GraphType ragSerial;
+                AffEdges affSerial;
+                makeRegionAdjacencyGraph(g, labels, ragSerial, affSerial, ignore);
+
+                for(int threads=1; threads<=4; threads+=3){
+                    GraphType rag;
+                    AffEdges aff;
+                    makeRegionAdjacencyGraph(g, labels, rag, aff, ParallelOptions().numThreads(threads), ignore);
+
+                    shouldEqual(rag.nodeNum(), ragSerial.nodeNum());
+                    shouldEqual(rag.edgeNum(), ragSerial.edgeNum());
+                    shouldEqual(rag.maxNodeId(), ragSerial.maxNodeId());
+                    for(NodeIt n(ragSerial); n!=lemon::INVALID; ++n){
+                        should(rag.nodeFromId(ragSerial.id(*n)) != lemon::INVALID);
+                        shouldEqual(rag.degree(rag.nodeFromId(ragSerial.id(*n))), ragSerial.degree(*n));
+                    }
+
+                    for(EdgeIt e(ragSerial); e!=lemon::INVALID; ++e){
+                        const Edge pe = rag.findEdge(rag.nodeFromId(ragSerial.id(ragSerial.u(*e))),
+                                                     rag.nodeFromId(ragSerial.id(ragSerial.v(*e))));
+                        should(pe != lemon::INVALID);
+                        should(rag.id(rag.u(pe)) < rag.id(rag.v(pe)));
+
+                        // the parallel version lists the affiliated edges by increasing id
+                        std::vector<MultiArrayIndex> idsSerial, ids;
+                        for(std::size_t k=0; k<affSerial[*e].size(); ++k)
+                            idsSerial.push_back(g.id(affSerial[*e][k]));
+                        for(std::size_t k=0; k<aff[pe].size(); ++k)
+                            ids.push_back(g.id(aff[pe][k]));
+                        std::sort(idsSerial.begin(), idsSerial.end());
+                        shouldEqual(ids.size(), idsSerial.size());
+                        shouldEqualSequence(ids.begin(), ids.end(), idsSerial.begin());
+                    }
+                }
+            }
+        }
+    }
+
     void testEdgeSort(){
         {
             GraphType g(0,0);
@@ -556,6 +609,7 @@ struct GraphAlgorithmTestSuite
         add( testCase( &GraphAlgorithmTest::testShortestPathAdjacencyListGraph));
         add( testCase( &GraphAlgorithmTest::testShortestPathGridGraph));
         add( testCase( &GraphAlgorithmTest::testRegionAdjacencyGraph));
+        add( testCase( &GraphAlgorithmTest::testRegionAdjacencyGraphParallel));
         add( testCase( &GraphAlgorithmTest::testEdgeSort));
         add( testCase( &GraphAlgorithmTest::testEdgeWeightComputation));
         add( testCase( &GraphAlgorithmTest::testShortestPathGridGraph2));
@@ -0,0 +1,131 @@
+/************************************************************************/
+/*                                                                      */
+/*        Copyright 2009 by Michael Hanselmann and Ullrich Koethe       */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <iostream>
+#include <string>
+#include "vigra/unittest.hxx"
+#include "vigra/hdf5impex.hxx"
+#include "vigra/multi_array.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+/*
+    Compare slice- and block-wise reads of a compressed, chunked dataset
+    with HDF5's default chunk cache and with HDF5ChunkCacheOptions.
+*/
+struct HDF5SpeedTest
+{
+    static void readChunkCacheSlices(HDF5File & file, int axis, std::string const & name)
+    {
+        typedef MultiArrayShape<3>::type Shape3;
+        HDF5HandleShared dataset = file.getDatasetHandleShared("/volume");
+        Shape3 shape(file.getDatasetShape("/volume").begin()), sliceShape(shape);
+        sliceShape[axis] = 1;
+        MultiArray<3, unsigned short> slice(sliceShape);
+
+        USETICTOC;
+        TIC;
+        for(int k=0; k<shape[axis]; ++k)
+        {
+            Shape3 start;
+            start[axis] = k;
+            file.readBlock(dataset, start, sliceShape, slice);
+        }
+        std::cerr << "    " << name << ": " << TOCS << "\n";
+    }
+
+    static void readChunkCacheBlocks(HDF5File & file, std::string const & name)
+    {
+        typedef MultiArrayShape<3>::type Shape3;
+        HDF5HandleShared dataset = file.getDatasetHandleShared("/volume");
+        Shape3 shape(file.getDatasetShape("/volume").begin()), blockShape(40);
+        MultiArray<3, unsigned short> block(blockShape);
+
+        USETICTOC;
+        TIC;
+        MultiCoordinateIterator<3> iter(shape / blockShape), end(iter.getEndIterator());
+        for(; iter != end; ++iter)
+            file.readBlock(dataset, *iter * blockShape, blockShape, block);
+        std::cerr << "    " << name << ": " << TOCS << "\n";
+    }
+
+    void testChunkCache()
+    {
+        std::string file_name( "testfile_HDF5File_chunk_cache_speed.hdf5");
+        typedef MultiArrayShape<3>::type Shape3;
+
+        MultiArray<3, unsigned short> data(Shape3(240, 240, 240));
+        for(int k=0; k<data.size(); ++k)
+            data[k] = (unsigned short)((k*17) % 1013);
+
+        HDF5File file (file_name, HDF5File::New);
+        file.write("/volume", data, Shape3(64, 64, 64), 4);
+
+        std::cerr << "############ HDF5 chunk cache (240^3 uint16, 64^3 chunks, deflate) #############\n";
+        for(int axis=2; axis >= 0; --axis)
+        {
+            std::string axisName(axis == 2 ? "z" : axis == 1 ? "y" : "x");
+            file.setChunkCache(HDF5ChunkCacheOptions());
+            readChunkCacheSlices(file, axis, axisName + "-slices, default cache");
+            file.setChunkCache(HDF5ChunkCacheOptions().accessAxis(axis));
+            readChunkCacheSlices(file, axis, axisName + "-slices, accessAxis(" + asString(axis) + ")");
+        }
+        file.setChunkCache(HDF5ChunkCacheOptions());
+        readChunkCacheBlocks(file, "40^3 blocks, default cache");
+        file.setChunkCache(HDF5ChunkCacheOptions().blockAccess());
+        readChunkCacheBlocks(file, "40^3 blocks, blockAccess()");
+    }
+};
+
+struct HDF5SpeedTestSuite
+: public vigra::test_suite
+{
+    HDF5SpeedTestSuite()
+    : vigra::test_suite("HDF5SpeedTestSuite")
+    {
+        add(testCase(&HDF5SpeedTest::testChunkCache));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    HDF5SpeedTestSuite test;
+
+    int failed = test.run(testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+    return (failed != 0);
+}
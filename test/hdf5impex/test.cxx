@@ -41,6 +41,7 @@
 #include "vigra/stdimage.hxx"
 #include "vigra/unittest.hxx"
 #include "vigra/hdf5impex.hxx"
+#include "vigra/multi_array_chunked_hdf5.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/multi_impex.hxx"
 
@@ -1112,6 +1113,131 @@ public:
 
 
 
+    void testHDF5FileParallelChunkAccess()
+    {
+        std::string file_name( "testfile_HDF5File_parallel.hdf5");
+
+        typedef MultiArrayShape<3>::type Shape3;
+        MultiArray<3, float> out_data(Shape3(37, 45, 23));
+        for (int i = 0; i < out_data.size(); ++i)
+            out_data.data () [i] = (float)(i % 1000) - 500.0f;
+
+        MultiArray<2, TinyVector<int, 3> > out_data_tv(Shape2(33, 21));
+        for (int i = 0; i < out_data_tv.size(); ++i)
+            out_data_tv.data () [i] = TinyVector<int, 3>(i, 2*i, -i);
+
+        ParallelOptions options = ParallelOptions().numThreads(4);
+
+        HDF5File file (file_name, HDF5File::New);
+
+        // compressed chunks are written in parallel, chunks at the border are partial
+        file.write("/parallel", out_data, Shape3(8, 10, 8), 6, options);
+        file.write("/parallel_tv", out_data_tv, Shape2(10, 8), 3, options);
+        // uncompressed dataset written serially and read in parallel
+        file.write("/serial", out_data, Shape3(8, 10, 8), 0);
+
+        MultiArray<3, float> in_data(out_data.shape()), in_serial(out_data.shape());
+        file.read("/parallel", in_serial);
+        should (in_serial == out_data);
+        file.read("/parallel", in_data, options);
+        should (in_data == out_data);
+        in_data.init(0.0f);
+        file.read("/serial", in_data, options);
+        should (in_data == out_data);
+
+        MultiArray<2, TinyVector<int, 3> > in_data_tv(out_data_tv.shape());
+        file.read("/parallel_tv", in_data_tv, options);
+        should (in_data_tv == out_data_tv);
+
+        // read an unaligned block, compare with the serial readBlock()
+        Shape3 block_offset(3, 7, 5), block_shape(20, 31, 12);
+        MultiArray<3, float> in_block(block_shape), in_block_serial(block_shape);
+        file.readBlock("/parallel", block_offset, block_shape, in_block, options);
+        file.readBlock("/parallel", block_offset, block_shape, in_block_serial);
+        should (in_block == in_block_serial);
+        should (in_block == out_data.subarray(block_offset, block_offset + block_shape));
+
+        // unaligned parallel writeBlock() mixes direct chunk writes and H5Dwrite()
+        MultiArray<3, float> block(block_shape, 1.5f);
+        file.writeBlock("/parallel", block_offset, block, options);
+        out_data.subarray(block_offset, block_offset + block_shape) = block;
+        file.read("/parallel", in_data);
+        should (in_data == out_data);
+
+        // unwritten chunks deliver the fill value
+        file.createDataset<3, float>("/empty", out_data.shape(), 7.0f, Shape3(8, 10, 8), 5);
+        file.read("/empty", in_data, options);
+        MultiArray<3, float> fill_data(out_data.shape(), 7.0f);
+        should (in_data == fill_data);
+    }
+
+    void testHDF5FileChunkCache()
+    {
+        std::string file_name( "testfile_HDF5File_chunk_cache.hdf5");
+        typedef MultiArrayShape<3>::type Shape3;
+
+        HDF5File file (file_name, HDF5File::New);
+        file.createDataset<3, float>("/volume", Shape3(100, 80, 60), 0.0f, Shape3(16, 16, 16), 1);
+        file.createDataset<2, TinyVector<float, 3> >("/vector", Shape2(100, 80),
+                                                       0.0f, Shape2(16, 16), 1);
+
+        size_t nslots = 0, nbytes = 0;
+        double w0 = 0.0;
+
+        // z-slices intersect 7 x 5 chunks of 16^3 floats
+        file.setChunkCache(HDF5ChunkCacheOptions().accessAxis(2));
+        {
+            HDF5HandleShared dataset = file.getDatasetHandleShared("/volume");
+            HDF5Handle dapl(H5Dget_access_plist(dataset), &H5Pclose, "");
+            H5Pget_chunk_cache(dapl, &nslots, &nbytes, &w0);
+            shouldEqual(nbytes, 35u*16*16*16*sizeof(float));
+            shouldEqual(nslots, 3511u); // smallest prime >= 3500
+            shouldEqual(w0, 1.0);
+        }
+
+        // x-slices intersect 5 x 4 chunks, and 'maxBytes' is respected
+        file.setChunkCache(HDF5ChunkCacheOptions().accessAxis(0).maxBytes(10*16*16*16*sizeof(float)));
+        {
+            HDF5HandleShared dataset = file.getDatasetHandleShared("/volume");
+            HDF5Handle dapl(H5Dget_access_plist(dataset), &H5Pclose, "");
+            H5Pget_chunk_cache(dapl, &nslots, &nbytes, &w0);
+            shouldEqual(nbytes, 10u*16*16*16*sizeof(float));
+        }
+
+        // axis 0 of a multi-band dataset is the band axis
+        file.setChunkCache(HDF5ChunkCacheOptions().accessAxis(1));
+        {
+            HDF5HandleShared dataset = file.getDatasetHandleShared("/vector");
+            HDF5Handle dapl(H5Dget_access_plist(dataset), &H5Pclose, "");
+            H5Pget_chunk_cache(dapl, &nslots, &nbytes, &w0);
+            shouldEqual(nbytes, 5u*16*3*sizeof(float)*16);
+        }
+
+        // explicit parameters
+        file.setChunkCache(HDF5ChunkCacheOptions().bytes(1 << 22).slots(10007).preemption(0.5));
+        {
+            HDF5HandleShared dataset = file.getDatasetHandleShared("/volume");
+            HDF5Handle dapl(H5Dget_access_plist(dataset), &H5Pclose, "");
+            H5Pget_chunk_cache(dapl, &nslots, &nbytes, &w0);
+            shouldEqual(nbytes, size_t(1 << 22));
+            shouldEqual(nslots, 10007u);
+            shouldEqual(w0, 0.5);
+        }
+
+        // the settings also apply to new datasets, and data are unaffected
+        MultiArray<3, float> data(Shape3(40, 30, 20)), res(data.shape());
+        linearSequence(data.begin(), data.end());
+        file.setChunkCache(HDF5ChunkCacheOptions().blockAccess());
+        file.write("/data", data, Shape3(8, 8, 8), 3);
+        file.read("/data", res);
+        should(res == data);
+
+        ChunkedArrayHDF5<3, float> chunked(file, "/data");
+        MultiArray<3, float> chunked_res(data.shape());
+        chunked.checkoutSubarray(Shape3(), chunked_res);
+        should(chunked_res == data);
+    }
+
     void testHDF5FileBrowsing()
     {
         //create groups, change current group, ...
@@ -1406,6 +1532,8 @@ struct HDF5ImportExportTestSuite : public vigra::test_suite
         add(testCase(&HDF5ExportImportTest::testHDF5FileBlockAccess));
         add(testCase(&HDF5ExportImportTest::testHDF5FileChunks));
         add(testCase(&HDF5ExportImportTest::testHDF5FileCompression));
+        add(testCase(&HDF5ExportImportTest::testHDF5FileParallelChunkAccess));
+        add(testCase(&HDF5ExportImportTest::testHDF5FileChunkCache));
         add(testCase(&HDF5ExportImportTest::testHDF5FileBrowsing));
         add(testCase(&HDF5ExportImportTest::testHDF5FileAttributes));
         add(testCase(&HDF5ExportImportTest::testHDF5FileTutorial));
@@ -766,6 +766,265 @@ class PNGInt16Test
     }
 };
 
+class DirectDecodeTest
+{
+    vigra::BImage gray;
+    vigra::BRGBImage rgb;
+
+  public:
+
+    DirectDecodeTest()
+    {
+        vigra::ImageImportInfo info("lenna.xv");
+        gray.resize(info.size());
+        importImage(info, destImage(gray));
+
+        vigra::ImageImportInfo rgbinfo("lennargb.xv");
+        rgb.resize(rgbinfo.size());
+        importImage(rgbinfo, destImage(rgb));
+    }
+
+        // compare importImage() into MultiArrayViews of different layouts
+        // (decoded by Decoder::decodeImage()) with the accessor-based import
+        // (decoded scanline by scanline)
+    template <class T>
+    void checkFile(const char * filename)
+    {
+        typedef MultiArrayShape<2>::type Shape;
+
+        vigra::ImageImportInfo info(filename);
+        const int w = info.width(), h = info.height();
+
+        BasicImage<T> reference(info.size());
+        importImage(info, destImage(reference));
+        MultiArrayView<2, T> expected(Shape(w, h), reference.data());
+
+        MultiArray<2, T> contiguous;
+        importImage(filename, contiguous);
+        should(contiguous == expected);
+
+        MultiArray<2, T> padded(Shape(w + 3, h));
+        MultiArrayView<2, T> inner(padded.subarray(Shape(1, 0), Shape(w + 1, h)));
+        importImage(info, inner);
+        should(inner == expected);
+
+        MultiArray<2, T> spread(Shape(2*w, h));
+        MultiArrayView<2, T> everyOther(spread.stridearray(Shape(2, 1)));
+        importImage(info, everyOther);
+        should(everyOther == expected);
+    }
+
+        // compare importImageBlock() with the corresponding part of the entire image
+    template <class T, class U>
+    void checkBlocks(const char * filename)
+    {
+        typedef MultiArrayShape<2>::type Shape;
+
+        vigra::ImageImportInfo info(filename);
+        MultiArray<2, T> image(info.shape());
+        importImage(info, image);
+
+        Shape offsets[] = { Shape(0, 0), Shape(13, 7), Shape(info.width() - 40, info.height() - 30) },
+              shapes[]  = { Shape(40, 30), info.shape() - Shape(13, 7), Shape(40, 30) };
+        for (int k = 0; k < 3; ++k)
+        {
+            MultiArray<2, T> block(shapes[k]);
+            importImageBlock(info, offsets[k], block);
+            should(block == image.subarray(offsets[k], offsets[k] + shapes[k]));
+
+            // converted to a different type, and with padded scanlines
+            MultiArray<2, U> converted(shapes[k] + Shape(5, 0)),
+                             expected(shapes[k]);
+            MultiArrayView<2, U> inner(converted.subarray(Shape(2, 0), shapes[k] + Shape(2, 0)));
+            importImageBlock(info, offsets[k], inner);
+            expected = image.subarray(offsets[k], offsets[k] + shapes[k]);
+            should(inner == expected);
+        }
+
+        MultiArray<2, T> tooLarge(info.shape());
+        try
+        {
+            importImageBlock(info, Shape(1, 0), tooLarge);
+            failTest("importImageBlock() failed to throw exception.");
+        }
+        catch(vigra::PreconditionViolation & e)
+        {
+            std::string expected("\nPrecondition violation!\nimportImageBlock(): block exceeds the image.");
+            std::string message(e.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
+
+    void testImportBlock()
+    {
+        exportImage(srcImageRange(gray), vigra::ImageExportInfo("direct.pgm"));
+        checkBlocks<UInt8, float>("direct.pgm");
+
+        exportImage(srcImageRange(rgb), vigra::ImageExportInfo("direct_rgb.bmp"));
+        checkBlocks<RGBValue<UInt8>, TinyVector<float, 3> >("direct_rgb.bmp");
+        checkBlocks<UInt8, int>("direct_rgb.bmp");
+
+#if defined(HasPNG)
+        exportImage(srcImageRange(rgb), vigra::ImageExportInfo("direct_rgb.png"));
+        checkBlocks<RGBValue<UInt8>, RGBValue<double> >("direct_rgb.png");
+#endif
+    }
+
+    void testTiledTIFF()
+    {
+#if defined(HasTIFF)
+        typedef MultiArrayShape<2>::type Shape;
+
+        MultiArray<2, RGBValue<UInt8> > image(Shape(rgb.width(), rgb.height()));
+        copyImage(srcImageRange(rgb), destImage(image));
+        MultiArray<2, float> fimage(image.shape());
+        for (int k = 0; k < fimage.size(); ++k)
+            fimage[k] = image[k].luminance() / 7.0f;
+
+        const char * compressions[] = { "NONE", "LZW", "DEFLATE" };
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int threads = 0; threads < 5; threads += 4)
+            {
+                // tile sizes are rounded up to 32 x 48, which doesn't divide the image size
+                exportImage(image, vigra::ImageExportInfo("tiled.tif").setTileSize(Size2D(30, 40))
+                                       .setCompression(compressions[c]).setNumThreads(threads));
+                exportImage(fimage, vigra::ImageExportInfo("tiled_float.tif").setTileSize(Size2D(64, 64))
+                                       .setCompression(compressions[c]).setNumThreads(threads));
+                // the scanline interface writes tiles as well
+                exportImage(srcImageRange(rgb), vigra::ImageExportInfo("tiled_scanlines.tif").setTileSize(Size2D(32, 32))
+                                       .setCompression(compressions[c]));
+                // strips are compressed in parallel as well
+                exportImage(image, vigra::ImageExportInfo("strips.tif")
+                                       .setCompression(compressions[c]).setNumThreads(threads));
+
+                vigra::ImageImportInfo info("tiled.tif");
+                info.setNumThreads(threads);
+                MultiArray<2, RGBValue<UInt8> > result(info.shape());
+                importImage(info, result);
+                should(result == image);
+
+                // decode through the scanline interface
+                BRGBImage scanlines(info.size());
+                importImage(info, destImage(scanlines));
+                MultiArrayView<2, RGBValue<UInt8> > scanlineView(image.shape(), scanlines.data());
+                should(scanlineView == image);
+
+                MultiArray<2, float> fresult;
+                importImage("tiled_float.tif", fresult);
+                should(fresult == fimage);
+
+                importImage("tiled_scanlines.tif", result);
+                should(result == image);
+
+                importImage("strips.tif", result);
+                should(result == image);
+
+                // strips are decoded concurrently only on explicit request
+                vigra::ImageImportInfo stripInfo("strips.tif");
+                stripInfo.setNumThreads(threads);
+                importImage(stripInfo, result);
+                should(result == image);
+
+                checkFile<RGBValue<UInt8> >("tiled.tif");
+                checkFile<UInt8>("tiled.tif");
+                checkBlocks<RGBValue<UInt8>, TinyVector<int, 3> >("tiled.tif");
+                checkBlocks<RGBValue<UInt8>, TinyVector<int, 3> >("strips.tif");
+                checkBlocks<float, double>("tiled_float.tif");
+            }
+        }
+#endif
+    }
+
+    void testPNM()
+    {
+        exportImage(srcImageRange(gray), vigra::ImageExportInfo("direct.pgm"));
+        checkFile<UInt8>("direct.pgm");
+
+        exportImage(srcImageRange(rgb), vigra::ImageExportInfo("direct.ppm"));
+        checkFile<RGBValue<UInt8> >("direct.ppm");
+        checkFile<UInt8>("direct.ppm");
+
+        vigra::UInt16Image gray16(gray.size());
+        for (int k = 0; k < gray.width()*gray.height(); ++k)
+            gray16.begin()[k] = gray.begin()[k] * 257;
+        exportImage(srcImageRange(gray16), vigra::ImageExportInfo("direct16.pgm"));
+        shouldEqual(std::string(vigra::ImageImportInfo("direct16.pgm").getPixelType()), std::string("UINT16"));
+        checkFile<UInt16>("direct16.pgm");
+
+        vigra::ImageExportInfo ascii("direct_ascii.pgm");
+        ascii.setCompression("ASCII");
+        exportImage(srcImageRange(gray), ascii);
+        checkFile<UInt8>("direct_ascii.pgm");
+    }
+
+    void testBMP()
+    {
+        exportImage(srcImageRange(gray), vigra::ImageExportInfo("direct.bmp"));
+        checkFile<UInt8>("direct.bmp");
+
+        exportImage(srcImageRange(rgb), vigra::ImageExportInfo("direct_rgb.bmp"));
+        checkFile<RGBValue<UInt8> >("direct_rgb.bmp");
+        checkFile<UInt8>("direct_rgb.bmp");
+    }
+
+    void testPNG()
+    {
+#if defined(HasPNG)
+        exportImage(srcImageRange(gray), vigra::ImageExportInfo("direct.png"));
+        checkFile<UInt8>("direct.png");
+
+        exportImage(srcImageRange(rgb), vigra::ImageExportInfo("direct_rgb.png"));
+        checkFile<RGBValue<UInt8> >("direct_rgb.png");
+        checkFile<UInt8>("direct_rgb.png");
+
+        vigra::UInt16Image gray16(gray.size());
+        for (int k = 0; k < gray.width()*gray.height(); ++k)
+            gray16.begin()[k] = gray.begin()[k] * 257;
+        exportImage(srcImageRange(gray16), vigra::ImageExportInfo("direct16.png"));
+        checkFile<UInt16>("direct16.png");
+#endif
+    }
+
+    void testJPEG()
+    {
+#if defined(HasJPEG)
+        exportImage(srcImageRange(gray), vigra::ImageExportInfo("direct.jpg"));
+        checkFile<UInt8>("direct.jpg");
+
+        exportImage(srcImageRange(rgb), vigra::ImageExportInfo("direct_rgb.jpg"));
+        checkFile<RGBValue<UInt8> >("direct_rgb.jpg");
+        checkFile<UInt8>("direct_rgb.jpg");
+#endif
+    }
+
+    void testTIFF()
+    {
+#if defined(HasTIFF)
+        exportImage(srcImageRange(gray), vigra::ImageExportInfo("direct.tif"));
+        checkFile<UInt8>("direct.tif");
+
+        exportImage(srcImageRange(rgb), vigra::ImageExportInfo("direct_rgb.tif"));
+        checkFile<RGBValue<UInt8> >("direct_rgb.tif");
+        checkFile<UInt8>("direct_rgb.tif");
+
+        vigra::FImage fgray(gray.size());
+        copyImage(srcImageRange(gray), destImage(fgray));
+        exportImage(srcImageRange(fgray), vigra::ImageExportInfo("direct_float.tif"));
+        checkFile<float>("direct_float.tif");
+#endif
+    }
+
+    void testHDR()
+    {
+        vigra::FRGBImage frgb(rgb.size());
+        copyImage(srcImageRange(rgb), destImage(frgb));
+        exportImage(srcImageRange(frgb), vigra::ImageExportInfo("direct.hdr"));
+        checkFile<RGBValue<float> >("direct.hdr");
+        checkFile<float>("direct.hdr");
+    }
+};
+
 class FloatImageExportImportTest
 {
     typedef vigra::DImage Image;
@@ -1852,6 +2111,24 @@ struct ImageImportExportTestSuite : public vigra::test_suite
         add(testCase(&PNGInt16Test::testByteOrder));
 #endif
 
+        // decoding into MultiArrayViews
+        add(testCase(&DirectDecodeTest::testPNM));
+        add(testCase(&DirectDecodeTest::testBMP));
+#if defined(HasPNG)
+        add(testCase(&DirectDecodeTest::testPNG));
+#endif
+#if defined(HasJPEG)
+        add(testCase(&DirectDecodeTest::testJPEG));
+#endif
+#if defined(HasTIFF)
+        add(testCase(&DirectDecodeTest::testTIFF));
+#endif
+        add(testCase(&DirectDecodeTest::testHDR));
+        add(testCase(&DirectDecodeTest::testImportBlock));
+#if defined(HasTIFF)
+        add(testCase(&DirectDecodeTest::testTiledTIFF));
+#endif
+
         add(testCase(&CanvasSizeTest::testTIFFCanvasSize));
 
         add(testCase(&PositionTest::testEXRPosition));
@@ -40,6 +40,7 @@
 #include "vigra/multi_array.hxx"
 #include "vigra/adjacency_list_graph.hxx"
 #include "vigra/merge_graph_adaptor.hxx"
+#include "vigra/hierarchical_clustering.hxx"
 using namespace vigra;
 
 template<class ID_TYPE>
@@ -1691,6 +1692,139 @@ struct AdjacencyListGraph2MergeGraphTest{
 };
 
 
+struct SmallToLargeMergingTest{
+
+    typedef vigra::AdjacencyListGraph           Graph;
+    typedef vigra::MergeGraphAdaptor<Graph>     MergeGraphType;
+    typedef Graph::index_type                   index_type;
+    typedef Graph::Node                         GraphNode;
+    typedef Graph::Edge                         GraphEdge;
+    typedef Graph::NodeIt                       GraphNodeIt;
+    typedef Graph::EdgeIt                       GraphEdgeIt;
+    typedef MergeGraphType::Node                Node;
+    typedef MergeGraphType::NodeIt              NodeIt;
+    typedef MergeGraphType::IncEdgeIt           IncEdgeIt;
+
+    // 12x12 grid with an additional hub node connected to every third node
+    Graph graph_;
+
+    SmallToLargeMergingTest(){
+        const int w = 12;
+        std::vector<GraphNode> nodes;
+        for(int i=0; i<w*w; ++i)
+            nodes.push_back(graph_.addNode(i));
+        for(int y=0; y<w; ++y){
+            for(int x=0; x<w; ++x){
+                if(x+1<w)
+                    graph_.addEdge(nodes[y*w+x], nodes[y*w+x+1]);
+                if(y+1<w)
+                    graph_.addEdge(nodes[y*w+x], nodes[(y+1)*w+x]);
+            }
+        }
+        const GraphNode hub = graph_.addNode(w*w);
+        for(int i=0; i<w*w; i+=3)
+            graph_.addEdge(hub, nodes[i]);
+    }
+
+    // check that both merge graphs represent the same partition of the base graph
+    void checkSamePartition(const MergeGraphType & a, const MergeGraphType & b){
+        shouldEqual(a.nodeNum(), b.nodeNum());
+        shouldEqual(a.edgeNum(), b.edgeNum());
+        std::map<index_type, index_type> aToB;
+        for(GraphNodeIt n(graph_); n!=lemon::INVALID; ++n){
+            const index_type ra = a.reprNodeId(graph_.id(*n));
+            const index_type rb = b.reprNodeId(graph_.id(*n));
+            if(aToB.find(ra)==aToB.end())
+                aToB[ra] = rb;
+            shouldEqual(aToB[ra], rb);
+            shouldEqual(a.degree(a.nodeFromId(ra)), b.degree(b.nodeFromId(rb)));
+        }
+        shouldEqual(aToB.size(), a.nodeNum());
+    }
+
+    void testContraction(){
+        MergeGraphType ref(graph_);
+        MergeGraphType g(graph_);
+        g.setSmallToLargeMerging(true);
+        should(g.smallToLargeMerging());
+        should(!ref.smallToLargeMerging());
+
+        UInt32 seed = 7;
+        while(g.nodeNum() > 3){
+            seed = 1664525u * seed + 1013904223u;
+            const index_type e = (seed >> 8) % (graph_.maxEdgeId()+1);
+            if(ref.stateOfInitalEdge(e)){
+                ref.contractEdge(ref.reprEdge(graph_.edgeFromId(e)));
+                g.contractEdge(g.reprEdge(graph_.edgeFromId(e)));
+                checkSamePartition(ref, g);
+
+                // the adjacency of the small-to-large graph must be consistent
+                size_t degreeSum = 0;
+                for(NodeIt n(g); n!=lemon::INVALID; ++n){
+                    for(IncEdgeIt i(g,*n); i!=lemon::INVALID; ++i){
+                        should(g.hasEdgeId(g.id(*i)));
+                        should(g.u(*i)==*n || g.v(*i)==*n);
+                        ++degreeSum;
+                    }
+                }
+                shouldEqual(degreeSum, 2*g.edgeNum());
+            }
+        }
+        // the hub has the largest degree and must have survived all its merges
+        should(g.hasNodeId(graph_.maxNodeId()));
+    }
+
+    template <class NODE_LABEL_MAP>
+    void cluster(const ClusteringOptions & options, NODE_LABEL_MAP & labels){
+        Graph::EdgeMap<float> edgeWeights(graph_), edgeLengths(graph_);
+        Graph::NodeMap<TinyVector<float, 2> > nodeFeatures(graph_);
+        Graph::NodeMap<float> nodeSizes(graph_);
+        UInt32 seed = 3;
+        for(GraphEdgeIt e(graph_); e!=lemon::INVALID; ++e){
+            seed = 1664525u * seed + 1013904223u;
+            edgeWeights[*e] = float((seed >> 8) % 100000) / 100000.0f + float(graph_.id(*e)) * 1.0e-7f;
+            edgeLengths[*e] = 1.0f + float((seed >> 20) % 4);
+        }
+        for(GraphNodeIt n(graph_); n!=lemon::INVALID; ++n){
+            seed = 1664525u * seed + 1013904223u;
+            nodeFeatures[*n] = TinyVector<float, 2>(float((seed >> 8) % 100) / 100.0f,
+                                                    float((seed >> 16) % 100) / 100.0f);
+            nodeSizes[*n] = 1.0f + float((seed >> 24) % 8);
+        }
+        hierarchicalClustering(graph_, edgeWeights, edgeLengths, nodeFeatures, nodeSizes,
+                               labels, options);
+    }
+
+    void testHierarchicalClustering(){
+        typedef Graph::NodeMap<UInt32> LabelMap;
+        LabelMap ref(graph_), lazy(graph_), smallToLarge(graph_), both(graph_);
+        const ClusteringOptions options = ClusteringOptions().minRegionCount(10);
+
+        cluster(options, ref);
+        cluster(ClusteringOptions(options).lazyPriorityUpdates(), lazy);
+        cluster(ClusteringOptions(options).smallToLargeMerging(), smallToLarge);
+        cluster(ClusteringOptions(options).lazyPriorityUpdates().smallToLargeMerging(), both);
+
+        // lazy updates don't change the representatives
+        for(GraphNodeIt n(graph_); n!=lemon::INVALID; ++n)
+            shouldEqual(lazy[*n], ref[*n]);
+
+        // small-to-large merging may choose other representatives
+        std::map<UInt32, UInt32> toSmallToLarge, toBoth;
+        for(GraphNodeIt n(graph_); n!=lemon::INVALID; ++n){
+            if(toSmallToLarge.find(ref[*n])==toSmallToLarge.end()){
+                toSmallToLarge[ref[*n]] = smallToLarge[*n];
+                toBoth[ref[*n]] = both[*n];
+            }
+            shouldEqual(toSmallToLarge[ref[*n]], smallToLarge[*n]);
+            shouldEqual(toBoth[ref[*n]], both[*n]);
+        }
+        shouldEqual(toSmallToLarge.size(), 10u);
+        shouldEqual(toBoth.size(), 10u);
+    }
+};
+
+
  
 struct AdjacencyListGraphMergeGraphAdaptorTestSuite
 : public vigra::test_suite
@@ -1719,6 +1853,9 @@ struct AdjacencyListGraphMergeGraphAdaptorTestSuite
         // test which do some merging
         add( testCase( &AdjacencyListGraph2MergeGraphTest<vigra::UInt32>::GraphMergeGridDegreeTest));
         add( testCase( &AdjacencyListGraph2MergeGraphTest<vigra::UInt32>::GraphMergeGridEdgeTest));
+
+        add( testCase( &SmallToLargeMergingTest::testContraction));
+        add( testCase( &SmallToLargeMergingTest::testHierarchicalClustering));
     }
 };
 
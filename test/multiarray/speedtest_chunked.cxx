@@ -0,0 +1,168 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2013-2014 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "vigra/unittest.hxx"
+#include "vigra/multi_array.hxx"
+#include "vigra/compression.hxx"
+#include "vigra/algorithm.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+/*
+    Compression ratio and throughput of the compress() pre-filters
+    on chunk-sized pieces of typical volumes.
+*/
+struct CompressionSpeedTest
+{
+    typedef MultiArray<3, UInt32> LabelArray;
+    typedef MultiArray<3, float>  FloatArray;
+
+    Shape3 shape;
+    LabelArray labels;
+    FloatArray smooth, linear;
+
+    CompressionSpeedTest()
+    : shape(128, 128, 128),
+      labels(shape),
+      smooth(shape),
+      linear(shape)
+    {
+        // blocky label volume with large label values, a smooth float volume,
+        // and a linear sequence
+        for(auto i = labels.begin(); i != labels.end(); ++i)
+        {
+            Shape3 p = i.point();
+            *i = 1000000u + (p[0] / 10) + 13*(p[1] / 10) + 169*(p[2] / 10);
+        }
+        for(auto i = smooth.begin(); i != smooth.end(); ++i)
+        {
+            Shape3 p = i.point();
+            *i = 100.0f + 10.0f*std::sin(p[0] / 20.0f) * std::cos(p[1] / 30.0f) + p[2] / 10.0f;
+        }
+        linearSequence(linear.begin(), linear.end());
+    }
+
+    template <class T>
+    void measure(std::string const & name, MultiArray<3, T> const & data,
+                 CompressionMethod method, std::string const & methodName)
+    {
+        // compress in chunk-sized pieces, as ChunkedArrayCompressed would do
+        std::size_t chunkBytes = 64*64*64*sizeof(T),
+                    totalBytes = data.size()*sizeof(T),
+                    compressedBytes = 0;
+        char const * source = (char const *)data.data();
+        std::vector<ArrayVector<char> > compressed((totalBytes + chunkBytes - 1) / chunkBytes);
+        ArrayVector<char> decompressed(totalBytes);
+
+        USETICTOC;
+        TIC;
+        for(std::size_t k = 0; k < compressed.size(); ++k)
+        {
+            std::size_t size = std::min(chunkBytes, totalBytes - k*chunkBytes);
+            compress(source + k*chunkBytes, size, compressed[k], method, sizeof(T));
+            compressedBytes += compressed[k].size();
+        }
+        double compressTime = TOCN;
+        TIC;
+        for(std::size_t k = 0; k < compressed.size(); ++k)
+        {
+            std::size_t size = std::min(chunkBytes, totalBytes - k*chunkBytes);
+            uncompress(compressed[k].data(), compressed[k].size(),
+                       decompressed.data() + k*chunkBytes, size, method, sizeof(T));
+        }
+        double uncompressTime = TOCN;
+
+        shouldEqualSequence(source, source + totalBytes, decompressed.data());
+
+        double mb = totalBytes / 1048576.0;
+        std::cerr << "    " << std::left << std::setw(8) << name << std::setw(26) << methodName
+                  << std::right << " ratio: " << std::setw(7) << std::setprecision(4)
+                  << double(totalBytes) / compressedBytes
+                  << "  compress: " << std::setw(7) << std::setprecision(4)
+                  << mb / std::max(compressTime, 1e-3) * 1000.0 << " MB/s"
+                  << "  uncompress: " << std::setw(7) << std::setprecision(4)
+                  << mb / std::max(uncompressTime, 1e-3) * 1000.0 << " MB/s\n";
+    }
+
+    template <class T>
+    void measureAll(std::string const & name, MultiArray<3, T> const & data)
+    {
+        measure(name, data, LZ4, "LZ4");
+        measure(name, data, LZ4_SHUFFLE, "LZ4_SHUFFLE");
+        measure(name, data, LZ4_BITSHUFFLE, "LZ4_BITSHUFFLE");
+        measure(name, data, LZ4_DELTA_SHUFFLE, "LZ4_DELTA_SHUFFLE");
+#ifdef HasZLIB
+        measure(name, data, ZLIB_FAST, "ZLIB_FAST");
+        measure(name, data, ZLIB_FAST_SHUFFLE, "ZLIB_FAST_SHUFFLE");
+        measure(name, data, ZLIB_FAST_BITSHUFFLE, "ZLIB_FAST_BITSHUFFLE");
+        measure(name, data, ZLIB_FAST_DELTA_SHUFFLE, "ZLIB_FAST_DELTA_SHUFFLE");
+#endif
+    }
+
+    void testCompressionSpeed()
+    {
+        std::cerr << "############ compression pre-filters #############\n";
+        measureAll("labels", labels);
+        measureAll("smooth", smooth);
+        measureAll("linear", linear);
+    }
+};
+
+struct CompressionSpeedTestSuite
+: public vigra::test_suite
+{
+    CompressionSpeedTestSuite()
+    : vigra::test_suite("CompressionSpeedTestSuite")
+    {
+        add(testCase(&CompressionSpeedTest::testCompressionSpeed));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    CompressionSpeedTestSuite test;
+
+    int failed = test.run(testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+    return (failed != 0);
+}
@@ -34,6 +34,7 @@
 /************************************************************************/
 
 #include <functional>
+#include <cmath>
 #include <stdio.h>
 
 #include "vigra/unittest.hxx"
@@ -47,6 +48,8 @@
 #include "vigra/algorithm.hxx"
 #include "vigra/random.hxx"
 #include "vigra/timing.hxx"
+#include "vigra/threadpool.hxx"
+#include "vigra/multi_blocking.hxx"
 //#include "marray.hxx"
 
 using namespace vigra;
@@ -94,6 +97,23 @@ public:
         linearSequence(array->begin(), array->end());
     }
 
+    ~ChunkedMultiArrayTest ()
+    {
+        empty_array.reset();
+        array.reset();
+        removeFiles((Array *)0);
+    }
+
+    template <class A>
+    static void removeFiles(A *)
+    {}
+
+    static void removeFiles(ChunkedArrayMmap<3, T> *)
+    {
+        std::remove("empty.h5.mmap");
+        std::remove("chunked_test.h5.mmap");
+    }
+
     static ArrayPtr createArray(Shape3 const & shape,
                                 Shape3 const & /*chunk_shape*/,
                                 ChunkedArrayFull<3, T> *,
@@ -143,6 +163,16 @@ public:
                                                       ChunkedArrayOptions().fillValue(fill_value), ""));
     }
 
+    static ArrayPtr createArray(Shape3 const & shape,
+                                Shape3 const & chunk_shape,
+                                ChunkedArrayMmap<3, T> *,
+                                std::string const & name = "chunked_test.h5")
+    {
+        return ArrayPtr(new ChunkedArrayMmap<3, T>(name + ".mmap", ChunkedArrayMmap<3, T>::New,
+                                                   shape, chunk_shape,
+                                                   ChunkedArrayOptions().fillValue(fill_value)));
+    }
+
     void test_construction ()
     {
         bool isFullArray = IsSameType<Array, ChunkedArrayFull<3, T> >::value;
@@ -189,7 +219,8 @@ public:
 
         // non-const iterator should allocate the array and initialize with fill_value_
         shouldEqualSequence(empty_array->begin(), empty_array->end(), empty.begin());
-        if(IsSameType<Array, ChunkedArrayTmpFile<3, T> >::value)
+        if(IsSameType<Array, ChunkedArrayTmpFile<3, T> >::value ||
+           IsSameType<Array, ChunkedArrayMmap<3, T> >::value)
             should(empty_array->dataBytes() >= ref.size()*sizeof(T)); // must pad to a full memory page
         else
             shouldEqual(empty_array->dataBytes(), ref.size()*sizeof(T));
@@ -408,7 +439,8 @@ public:
             shouldEqualSequence(c.begin(), c.end(), empty.begin());
 
             MultiArrayView <3, T, ChunkedArrayTag> v(empty_array->subarray(start, stop));
-            if(IsSameType<Array, ChunkedArrayTmpFile<3, T> >::value)
+            if(IsSameType<Array, ChunkedArrayTmpFile<3, T> >::value ||
+               IsSameType<Array, ChunkedArrayMmap<3, T> >::value)
                 should(empty_array->dataBytes() >= ref.size()*sizeof(T)); // must pad to a full memory page
             else
                 shouldEqual(empty_array->dataBytes(), ref.size()*sizeof(T));
@@ -784,6 +816,114 @@ public:
         shouldEqualSequence(a->begin(), a->end(), ref.begin());
     }
 
+    void testCacheStatistics()
+    {
+        array.reset(0); // close the file if backend is HDF5
+        ArrayPtr a = createArray(Shape3(64), Shape3(8), (Array *)0);
+        int chunk_count = prod(a->chunkArrayShape());
+        a->setCacheMaxSize(10);
+        a->resetCacheStatistics();
+
+        // every chunk is written exactly once, concurrently from several threads
+        parallel_foreach(4, chunk_count,
+            [&a](size_t, size_t k)
+            {
+                Shape3 chunk(k % 8, (k / 8) % 8, k / 64);
+                PlainArray block(Shape3(8), T(k));
+                a->commitSubarray(chunk*8, block);
+            });
+
+        ChunkCacheStatistics stats = a->cacheStatistics();
+        shouldEqual(stats.misses, (std::size_t)chunk_count);
+        should(a->cacheSize() <= 10);
+        shouldEqual(stats.evictions, (std::size_t)(chunk_count - a->cacheSize()));
+
+        // repeated access to an active chunk is a hit
+        a->resetCacheStatistics();
+        PlainArray block(Shape3(8));
+        a->checkoutSubarray(Shape3(8, 16, 24), block);
+        a->checkoutSubarray(Shape3(8, 16, 24), block);
+        stats = a->cacheStatistics();
+        should(stats.misses <= 1);
+        shouldEqual(stats.hits + stats.misses, 2u);
+        should(block == PlainArray(Shape3(8), T(1 + 2*8 + 3*64)));
+
+        for(int k=0; k<chunk_count; ++k)
+        {
+            Shape3 chunk(k % 8, (k / 8) % 8, k / 64);
+            a->checkoutSubarray(chunk*8, block);
+            should(block == PlainArray(Shape3(8), T(k)));
+        }
+        should(a->cacheSize() <= 10);
+    }
+
+    void testPrefetch()
+    {
+        array.reset(0); // close the file if backend is HDF5
+        ArrayPtr a = createArray(Shape3(64), Shape3(8), (Array *)0);
+        a->setCacheMaxSize(16);
+        PlainArray ref(a->shape());
+        linearSequence(ref.begin(), ref.end());
+        a->commitSubarray(Shape3(), ref);
+        a->releaseChunks(Shape3(), a->shape());
+        shouldEqual(a->cacheSize(), 0);
+
+        // the chunks of the steps following the announced one are loaded
+        {
+            ChunkPrefetcher<3, T> prefetcher(*a, Shape3(), a->shape(), 4);
+            shouldEqual(prefetcher.size(), (std::size_t)prod(a->chunkArrayShape()));
+            a->resetCacheStatistics();
+            prefetcher.advance(0);
+            prefetcher.wait();
+            shouldEqual(a->cacheStatistics().misses, 4u);
+            shouldEqual(a->cacheSize(), 4);
+
+            PlainArray block(Shape3(8));
+            for(int k=1; k<=4; ++k)
+            {
+                a->checkoutSubarray(Shape3(8*k, 0, 0), block);
+                shouldEqualSequence(block.begin(), block.end(),
+                                    ref.subarray(Shape3(8*k, 0, 0), Shape3(8*k+8, 8, 8)).begin());
+            }
+            shouldEqual(a->cacheStatistics().hits, 4u);
+            shouldEqual(a->cacheStatistics().misses, 4u);
+        }
+
+        // scan with a prefetching chunk iterator
+        {
+            Shape3 start(3, 10, 0), stop(64, 50, 61);
+            ChunkPrefetcher<3, T> prefetcher(*a, start, stop, 4);
+            typename BaseArray::chunk_const_iterator i   = a->chunk_cbegin(start, stop),
+                                                     end = a->chunk_cend(start, stop);
+            for(i.prefetch(prefetcher); i != end; ++i)
+                should(*i == ref.subarray(i.chunkStart(), i.chunkStop()));
+            should(a->cacheSize() <= 16);
+        }
+
+        // read ahead in checkoutSubarray()
+        PlainArray res(a->shape());
+        a->checkoutSubarray(Shape3(), res, 8);
+        should(res == ref);
+
+        // read ahead along a block list
+        a->releaseChunks(Shape3(), a->shape());
+        MultiBlocking<3> blocking(a->shape(), Shape3(16));
+        ChunkPrefetcher<3, T> prefetcher(*a, blocking.blockBegin(), blocking.blockEnd(), 1);
+        shouldEqual(prefetcher.size(), (std::size_t)blocking.numBlocks());
+        a->resetCacheStatistics();
+        prefetcher.advance(0);
+        prefetcher.wait();
+        shouldEqual(a->cacheStatistics().misses, 8u); // the 2x2x2 chunks of the second block
+        PlainArray block(Shape3(16));
+        int k = 0;
+        for(MultiBlocking<3>::BlockIter b = blocking.blockBegin(); b != blocking.blockEnd(); ++b, ++k)
+        {
+            prefetcher.advance(k);
+            a->checkoutSubarray((*b).begin(), block);
+            should(block == ref.subarray((*b).begin(), (*b).end()));
+        }
+    }
+
     // void testIsUnstrided()
     // {
         // typedef difference3_type Shape;
@@ -1512,6 +1652,226 @@ public:
     }
 };
 
+struct ChunkedMmapTest
+{
+    typedef ChunkedArrayMmap<3, UInt16> Array;
+
+    Shape3 shape;
+    MultiArray<3, UInt16> data;
+
+    ChunkedMmapTest()
+    : shape(40, 50, 30),
+      data(shape)
+    {
+        linearSequence(data.begin(), data.end());
+    }
+
+    void testPersistence()
+    {
+        std::string name("chunked_mmap_test.mmap");
+        Shape3 start(5, 6, 7), stop(20, 30, 25);
+        {
+            Array array(name, Array::New, shape, Shape3(16),
+                        ChunkedArrayOptions().fillValue(3).cacheMax(2));
+            shouldEqual(array.backend(), "ChunkedArrayMmap");
+            shouldEqual(array.fileName(), name);
+            should(!array.isReadOnly());
+            array.commitSubarray(start, data.subarray(start, stop));
+        }
+
+        MultiArray<3, UInt16> expected(shape, UInt16(3));
+        expected.subarray(start, stop) = data.subarray(start, stop);
+        {
+            // reopen read-only, shape and chunk shape are taken from the file
+            Array array(name, Array::ReadOnly, ChunkedArrayOptions().fillValue(3));
+            shouldEqual(array.shape(), shape);
+            shouldEqual(array.chunkShape(), Shape3(16));
+            should(array.isReadOnly());
+            should(array.isChunkWritten(Shape3(0, 0, 0)));
+            should(array.isChunkWritten(Shape3(1, 1, 1)));
+            should(!array.isChunkWritten(Shape3(2, 3, 1)));
+
+            MultiArray<3, UInt16> result(shape);
+            array.checkoutSubarray(Shape3(), result);
+            should(result == expected);
+
+            try
+            {
+                array.commitSubarray(Shape3(), data);
+                failTest("ChunkedArrayMmap: writing to read-only array did not throw.");
+            }
+            catch(PreconditionViolation &) {}
+        }
+        {
+            // reopen for writing and overwrite everything
+            Array array(name, Array::ReadWrite, shape);
+            shouldEqual(array.chunkShape(), Shape3(16));
+            array.commitSubarray(Shape3(), data);
+        }
+        {
+            Array array(name);
+            for(MultiCoordinateIterator<3> c(array.chunkArrayShape()), end = c.getEndIterator(); c != end; ++c)
+                should(array.isChunkWritten(*c));
+            MultiArray<3, UInt16> result(shape);
+            array.checkoutSubarray(Shape3(), result);
+            should(result == data);
+        }
+
+        try
+        {
+            Array array(name, Array::ReadWrite, Shape3(40, 50, 31));
+            failTest("ChunkedArrayMmap: shape mismatch did not throw.");
+        }
+        catch(PreconditionViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nChunkedArrayMmap(filename, mode, shape): shape mismatch");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+        try
+        {
+            ChunkedArrayMmap<3, float> array(name);
+            failTest("ChunkedArrayMmap: element size mismatch did not throw.");
+        }
+        catch(PreconditionViolation &) {}
+
+        // a truncated file must be rejected instead of mapping chunks beyond its end
+        std::string truncated("chunked_mmap_truncated.mmap");
+        {
+            std::FILE * in = std::fopen(name.c_str(), "rb");
+            std::vector<char> buffer(1 << 20);
+            std::size_t size = std::fread(buffer.data(), 1, buffer.size(), in);
+            std::fclose(in);
+            std::FILE * out = std::fopen(truncated.c_str(), "wb");
+            std::fwrite(buffer.data(), 1, size / 2, out);
+            std::fclose(out);
+        }
+        try
+        {
+            Array array(truncated);
+            failTest("ChunkedArrayMmap: truncated file did not throw.");
+        }
+        catch(std::runtime_error & c)
+        {
+            std::string expected("ChunkedArrayMmap(): file '" + truncated + "' is truncated.");
+            shouldEqual(std::string(c.what()), expected);
+        }
+
+        std::remove(truncated.c_str());
+        std::remove(name.c_str());
+    }
+};
+
+struct ChunkedCompressionTest
+{
+    typedef MultiArray<3, UInt32> LabelArray;
+    typedef MultiArray<3, float>  FloatArray;
+
+    Shape3 shape;
+    LabelArray labels;
+    FloatArray smooth;
+
+    ChunkedCompressionTest()
+    : shape(128, 128, 128),
+      labels(shape),
+      smooth(shape)
+    {
+        // blocky label volume with large label values and a smooth float volume
+        for(auto i = labels.begin(); i != labels.end(); ++i)
+        {
+            Shape3 p = i.point();
+            *i = 1000000u + (p[0] / 10) + 13*(p[1] / 10) + 169*(p[2] / 10);
+        }
+        for(auto i = smooth.begin(); i != smooth.end(); ++i)
+        {
+            Shape3 p = i.point();
+            *i = 100.0f + 10.0f*std::sin(p[0] / 20.0f) * std::cos(p[1] / 30.0f) + p[2] / 10.0f;
+        }
+    }
+
+    template <class T>
+    void testRoundtrip(MultiArray<3, T> const & data, CompressionMethod method)
+    {
+        ChunkedArrayCompressed<3, T> array(shape, Shape3(32),
+                                           ChunkedArrayOptions().compression(method));
+        array.commitSubarray(Shape3(), data);
+        array.releaseChunks(Shape3(), shape);
+
+        // all chunks are compressed now, so this reads back through uncompress()
+        MultiArray<3, T> result(shape);
+        array.checkoutSubarray(Shape3(), result);
+        shouldEqualSequence(data.begin(), data.end(), result.begin());
+        typedef ChunkedArray<3, T> BaseArray;
+        should(static_cast<BaseArray &>(array).dataBytes() < data.size()*sizeof(T));
+    }
+
+    void testChunkedRoundtrip()
+    {
+        ChunkedArrayCompressed<3, float> array(shape, Shape3(),
+                                               ChunkedArrayOptions().compression(LZ4_DELTA_SHUFFLE));
+        shouldEqual(array.backend(), "ChunkedArrayCompressed<LZ4_DELTA_SHUFFLE>");
+        testRoundtrip(labels, LZ4_DELTA_SHUFFLE);
+        testRoundtrip(labels, LZ4_BITSHUFFLE);
+        testRoundtrip(smooth, LZ4_SHUFFLE);
+#ifdef HasZLIB
+        testRoundtrip(labels, ZLIB_FAST_DELTA_SHUFFLE);
+        testRoundtrip(smooth, ZLIB_FAST_BITSHUFFLE);
+#endif
+    }
+
+    void testWriteBehind()
+    {
+        typedef ChunkedArrayCompressed<3, UInt32> Array;
+        typedef ChunkedArray<3, UInt32> BaseArray;
+
+        Array array(shape, Shape3(32),
+                    ChunkedArrayOptions().compression(LZ4_DELTA_SHUFFLE)
+                                         .compressionThreads(2).cacheMax(4));
+        BaseArray & base = array;
+
+        // write and read back in parallel, so that chunks are evicted
+        // (and handed to the background threads) all the time
+        MultiBlocking<3> blocking(shape, Shape3(32));
+        parallel_foreach(4, blocking.numBlocks(),
+            [&](int, MultiArrayIndex k)
+            {
+                auto block = *(blocking.blockBegin() + k);
+                array.commitSubarray(block.begin(), labels.subarray(block.begin(), block.end()));
+            });
+        parallel_foreach(4, blocking.numBlocks(),
+            [&](int, MultiArrayIndex k)
+            {
+                auto block = *(blocking.blockBegin() + k);
+                MultiArray<3, UInt32> result(block.end() - block.begin());
+                array.checkoutSubarray(block.begin(), result);
+                should(result == labels.subarray(block.begin(), block.end()));
+            });
+
+        // chunks which are accessed while their compression is pending
+        // are served from the uncompressed buffer
+        for(int round = 0; round < 3; ++round)
+        {
+            array.releaseChunks(Shape3(), shape);
+            MultiArray<3, UInt32> result(shape);
+            array.checkoutSubarray(Shape3(), result);
+            should(result == labels);
+        }
+
+        array.releaseChunks(Shape3(), shape);
+        array.waitCompressionFinished();
+        should(base.dataBytes() < labels.size()*sizeof(UInt32) / 10);
+
+        MultiArray<3, UInt32> result(shape);
+        array.checkoutSubarray(Shape3(), result);
+        should(result == labels);
+
+        // data bytes must be accounted correctly
+        array.releaseChunks(Shape3(), shape, true);
+        array.waitCompressionFinished();
+        shouldEqual(base.dataBytes(), 0u);
+    }
+};
+
 struct ChunkedMultiArrayTestSuite
 : public vigra::test_suite
 {
@@ -1565,14 +1925,28 @@ struct ChunkedMultiArrayTestSuite
         testImpl<ChunkedArrayLazy<3, float> >();
         testImpl<ChunkedArrayCompressed<3, float> >();
         testImpl<ChunkedArrayTmpFile<3, float> >();
+        testImpl<ChunkedArrayMmap<3, float> >();
 #ifdef HasHDF5
         testImpl<ChunkedArrayHDF5<3, float> >();
 #endif
 
+        add( testCase( (&ChunkedMultiArrayTest<ChunkedArrayCompressed<3, float> >::testCacheStatistics )));
+        add( testCase( (&ChunkedMultiArrayTest<ChunkedArrayTmpFile<3, float> >::testCacheStatistics )));
+        add( testCase( (&ChunkedMultiArrayTest<ChunkedArrayMmap<3, float> >::testCacheStatistics )));
+#ifdef HasHDF5
+        add( testCase( (&ChunkedMultiArrayTest<ChunkedArrayHDF5<3, float> >::testCacheStatistics )));
+#endif
+        add( testCase( (&ChunkedMultiArrayTest<ChunkedArrayCompressed<3, float> >::testPrefetch )));
+        add( testCase( (&ChunkedMultiArrayTest<ChunkedArrayTmpFile<3, float> >::testPrefetch )));
+#ifdef HasHDF5
+        add( testCase( (&ChunkedMultiArrayTest<ChunkedArrayHDF5<3, float> >::testPrefetch )));
+#endif
+
         testImpl<ChunkedArrayFull<3, TinyVector<float, 3> > >();
         testImpl<ChunkedArrayLazy<3, TinyVector<float, 3> > >();
         testImpl<ChunkedArrayCompressed<3, TinyVector<float, 3> > >();
         testImpl<ChunkedArrayTmpFile<3, TinyVector<float, 3> > >();
+        testImpl<ChunkedArrayMmap<3, TinyVector<float, 3> > >();
 #ifdef HasHDF5
         testImpl<ChunkedArrayHDF5<3, TinyVector<float, 3> > >();
 #endif
@@ -1585,6 +1959,10 @@ struct ChunkedMultiArrayTestSuite
         testIndexingSpeedImpl<float>();
         testIndexingSpeedImpl<double>();
 
+        add( testCase( &ChunkedMmapTest::testPersistence ) );
+        add( testCase( &ChunkedCompressionTest::testChunkedRoundtrip ) );
+        add( testCase( &ChunkedCompressionTest::testWriteBehind ) );
+
         //add( testCase( &MultiArrayPointoperatorsTest::testInit ) );
         //add( testCase( &MultiArrayPointoperatorsTest::testCopy ) );
         //add( testCase( &MultiArrayPointoperatorsTest::testCopyOuterExpansion ) );
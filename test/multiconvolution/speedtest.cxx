@@ -4,7 +4,7 @@
 #include "vigra/unittest.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/multi_pointoperators.hxx"
-//#include "vigra/multi_convolution.hxx"
+#include "vigra/multi_convolution.hxx"
 #include "vigra/basicimageview.hxx"
 #include "vigra/convolution.hxx" 
 #include "vigra/navigator.hxx"
@@ -331,6 +331,35 @@ struct MultiArraySepConvSpeedTest
   }
 
 
+  // line-by-line reference (the former implementation of separableConvolveMultiArray())
+  // against the batched line convolution on a 3D float volume
+  void testBatched()
+  {
+    const Size3 shape(128, 128, 128);
+    Image3D src(shape), ref(shape), res(shape), smoothed(shape);
+    makeBox( src );
+
+    int t_ref = clock();
+    Impls::convolveCopySrc( srcMultiArrayRange(src), destMultiArray(ref), kernels.begin() );
+    t_ref = clock() - t_ref;
+
+    int t_batched = clock();
+    separableConvolveMultiArray( srcMultiArrayRange(src), destMultiArray(res), kernels.begin() );
+    t_batched = clock() - t_batched;
+
+    int t_smooth = clock();
+    gaussianSmoothMultiArray( src, smoothed, 2.3 );
+    t_smooth = clock() - t_smooth;
+
+    std::cout << "Timed function: line-by-line 128^3" << std::endl << "   = " << t_ref << std::endl;
+    std::cout << "Timed function: batched 128^3" << std::endl << "   = " << t_batched
+              << " (speedup " << double(t_ref) / std::max(t_batched, 1) << ")" << std::endl;
+    std::cout << "Timed function: gaussianSmoothMultiArray 128^3" << std::endl << "   = " << t_smooth << std::endl;
+
+    shouldEqualSequence( res.begin(), res.end(), ref.begin() );
+  }
+
+
   void makeBox( Image3D &image )
   {
     const int b = 8;
@@ -371,6 +400,7 @@ struct MultiArraySepConvSpeedTestSuite
         add( testCase( &MultiArraySepConvSpeedTest::test1 ) );
         add( testCase( &MultiArraySepConvSpeedTest::test2 ) );
         add( testCase( &MultiArraySepConvSpeedTest::testCorrectness ) );
+        add( testCase( &MultiArraySepConvSpeedTest::testBatched ) );
     }
 };
 
@@ -530,6 +530,101 @@ struct MultiArraySeparableConvolutionTest
         shouldEqualSequenceTolerance(st1.data(), st1.data()+size, rst.data(), epsilon);
     }
 
+    void test_parallel()
+    {
+        Image3D src(Size3(41, 33, 27)), res(src.shape()), ref(src.shape());
+        makeRandom(src);
+
+        ConvolutionOptions<3> opt;
+        opt.parallelOptions(ParallelOptions().numThreads(4));
+
+        gaussianSmoothMultiArray(src, ref, 1.5);
+        gaussianSmoothMultiArray(src, res, 1.5, opt);
+        shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+        laplacianOfGaussianMultiArray(src, ref, 1.5);
+        laplacianOfGaussianMultiArray(src, res, 1.5, opt);
+        shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+        MultiArray<3, TinyVector<PixelType, 3> > grad(src.shape()), rgrad(src.shape());
+        gaussianGradientMultiArray(src, rgrad, 1.5);
+        gaussianGradientMultiArray(src, grad, 1.5, opt);
+        shouldEqualSequence(grad.begin(), grad.end(), rgrad.begin());
+
+        MultiArray<3, TinyVector<PixelType, 6> > tensor(src.shape()), rtensor(src.shape());
+        hessianOfGaussianMultiArray(src, rtensor, 1.5);
+        hessianOfGaussianMultiArray(src, tensor, 1.5, opt);
+        shouldEqualSequence(tensor.begin(), tensor.end(), rtensor.begin());
+
+        structureTensorMultiArray(src, rtensor, 1.0, 2.0);
+        structureTensorMultiArray(src, tensor, 1.0, 2.0, opt);
+        shouldEqualSequence(tensor.begin(), tensor.end(), rtensor.begin());
+
+        // 2D and in a user-provided thread pool
+        ThreadPool pool(3);
+        MultiArray<2, double> src2(Shape2(57, 45)), res2(src2.shape()), ref2(src2.shape());
+        makeRandom(src2);
+        gaussianSmoothMultiArray(src2, ref2, 2.0);
+        gaussianSmoothMultiArray(src2, res2, 2.0,
+              ConvolutionOptions<2>().parallelOptions(ParallelOptions().threadPool(pool)));
+        shouldEqualSequence(res2.begin(), res2.end(), ref2.begin());
+    }
+
+    template <class T>
+    void testBatchedBorders(BorderTreatmentMode border)
+    {
+        // float and double lines are convolved in batches of adjacent lines;
+        // the result must be identical to convolveLine() on every line
+        // (convolveMultiArrayOneDimension() works line by line). The shape
+        // produces partial batches along every dimension.
+        MultiArray<3, T> src(Shape3(37, 9, 6)), res(src.shape()), ref(src.shape());
+        makeRandom(src);
+
+        Kernel1D<double> kernels[3];
+        kernels[0].initGaussian(1.0);
+        kernels[1].initExplicitly(-1, 3) = 0.1, 0.2, 0.3, 0.25, 0.15;
+        kernels[2].initAveraging(4);  // wider than the lines along dimension 2
+        for(int k=0; k<3; ++k)
+        {
+            kernels[k].setBorderTreatment(border);
+
+            separableConvolveMultiArray(src, res, kernels[k]);
+
+            ref = src;
+            for(int d=0; d<3; ++d)
+                convolveMultiArrayOneDimension(ref, ref, d, kernels[k]);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+        }
+
+        // kernel radius not smaller than the line length (6) is rejected
+        Kernel1D<double> tooLong;
+        tooLong.initAveraging(6);
+        tooLong.setBorderTreatment(border);
+        try
+        {
+            separableConvolveMultiArray(src, res, tooLong);
+            failTest("separableConvolveMultiArray() failed to throw exception.");
+        }
+        catch(PreconditionViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nconvolveLine(): kernel longer than line.");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
+
+    void test_batchedBorders()
+    {
+        testBatchedBorders<float>(BORDER_TREATMENT_REFLECT);
+        testBatchedBorders<float>(BORDER_TREATMENT_REPEAT);
+        testBatchedBorders<float>(BORDER_TREATMENT_WRAP);
+        testBatchedBorders<float>(BORDER_TREATMENT_ZEROPAD);
+        testBatchedBorders<double>(BORDER_TREATMENT_REFLECT);
+        testBatchedBorders<double>(BORDER_TREATMENT_REPEAT);
+        testBatchedBorders<double>(BORDER_TREATMENT_WRAP);
+        testBatchedBorders<double>(BORDER_TREATMENT_ZEROPAD);
+    }
+
     //--------------------------------------------
 
     const Size3 shape;
@@ -598,6 +693,8 @@ struct MultiArraySeparableConvolutionTestSuite
                 add( testCase( &MultiArraySeparableConvolutionTest::test_hessian ) );
                 add( testCase( &MultiArraySeparableConvolutionTest::test_structureTensor ) );
                 add( testCase( &MultiArraySeparableConvolutionTest::test_gradient_magnitude ) );
+                add( testCase( &MultiArraySeparableConvolutionTest::test_parallel ) );
+                add( testCase( &MultiArraySeparableConvolutionTest::test_batchedBorders ) );
     }
 }; // struct MultiArraySeparableConvolutionTestSuite
 
@@ -41,6 +41,7 @@
 #include <vigra/unittest.hxx>
 #include <vigra/multi_array.hxx>
 #include <vigra/accumulator.hxx>
+#include <vigra/random.hxx>
 
 namespace std {
 
@@ -1490,6 +1491,164 @@ struct AccumulatorTest
             shouldEqual(W(3, 0, 1), get<AutoRangeHistogram<3> >(c,3));
         }
     }
+
+    void testParallelExtractFeatures()
+    {
+        using namespace vigra::acc;
+
+        MersenneTwister random(42);
+        MultiArray<3, double> data(Shape3(40, 30, 20));
+        MultiArray<3, int> labels(data.shape());
+        for(int k=0; k<data.size(); ++k)
+        {
+            data[k] = random.uniform(-10.0, 10.0);
+            labels[k] = random.uniformInt(12);
+        }
+
+        typedef Select<DataArg<1>, LabelArg<2>,
+                       Count, Mean, Variance, Skewness, Kurtosis, Minimum, Maximum,
+                       RegionCenter, Coord<Maximum>, AutoRangeHistogram<16>,
+                       Global<Mean>, Global<Kurtosis> > Selected;
+        typedef AccumulatorChainArray<CoupledArrays<3, double, int>, Selected> A;
+
+        A serial, parallel;
+        serial.ignoreLabel(3);
+        parallel.ignoreLabel(3);
+        extractFeatures(data, labels, serial);
+        extractFeatures(data, labels, parallel, ParallelOptions().numThreads(4));
+
+        shouldEqual(parallel.maxRegionLabel(), serial.maxRegionLabel());
+        shouldEqualTolerance(get<Global<Mean> >(parallel), get<Global<Mean> >(serial), 1e-12);
+        shouldEqualTolerance(get<Global<Kurtosis> >(parallel), get<Global<Kurtosis> >(serial), 1e-12);
+        for(int k=0; k<=serial.maxRegionLabel(); ++k)
+        {
+            shouldEqual(get<Count>(parallel, k), get<Count>(serial, k));
+            shouldEqual(get<Minimum>(parallel, k), get<Minimum>(serial, k));
+            shouldEqual(get<Maximum>(parallel, k), get<Maximum>(serial, k));
+            shouldEqual(get<Coord<Maximum> >(parallel, k), get<Coord<Maximum> >(serial, k));
+            shouldEqual(get<AutoRangeHistogram<16> >(parallel, k), get<AutoRangeHistogram<16> >(serial, k));
+            if(k == 3)
+                continue;
+            shouldEqualTolerance(get<Mean>(parallel, k), get<Mean>(serial, k), 1e-12);
+            shouldEqualTolerance(get<Variance>(parallel, k), get<Variance>(serial, k), 1e-12);
+            shouldEqualTolerance(get<Skewness>(parallel, k), get<Skewness>(serial, k), 1e-12);
+            shouldEqualTolerance(get<Kurtosis>(parallel, k), get<Kurtosis>(serial, k), 1e-12);
+            shouldEqualSequenceTolerance(get<RegionCenter>(parallel, k).begin(), get<RegionCenter>(parallel, k).end(),
+                                         get<RegionCenter>(serial, k).begin(), 1e-12);
+        }
+
+        // global chain driven by an iterator range
+        typedef AccumulatorChain<double, Select<Mean, Variance, Skewness, Kurtosis> > B;
+        B bs, bp;
+        extractFeatures(data.begin(), data.end(), bs);
+        extractFeatures(data.begin(), data.end(), bp, ParallelOptions().numThreads(3));
+        shouldEqual(get<Count>(bp), get<Count>(bs));
+        shouldEqualTolerance(get<Mean>(bp), get<Mean>(bs), 1e-12);
+        shouldEqualTolerance(get<Variance>(bp), get<Variance>(bs), 1e-12);
+        shouldEqualTolerance(get<Skewness>(bp), get<Skewness>(bs), 1e-12);
+        shouldEqualTolerance(get<Kurtosis>(bp), get<Kurtosis>(bs), 1e-12);
+    }
+
+    void testSparseAccumulatorChainArray()
+    {
+        using namespace vigra::acc;
+
+        MersenneTwister random(42);
+        MultiArray<3, double> data(Shape3(30, 20, 10));
+        MultiArray<3, int> labels(data.shape());
+        MultiArray<3, Int64> sparseLabels(data.shape());
+        for(int k=0; k<data.size(); ++k)
+        {
+            data[k] = random.uniform(-10.0, 10.0);
+            labels[k] = random.uniformInt(8);
+            sparseLabels[k] = sparseLabel(labels[k]);
+        }
+
+        typedef Select<DataArg<1>, LabelArg<2>,
+                       Count, Mean, Variance, Skewness, Minimum, Maximum,
+                       RegionCenter, AutoRangeHistogram<16>, Global<Mean> > Selected;
+        typedef AccumulatorChainArray<CoupledArrays<3, double, int>, Selected> Dense;
+        typedef SparseAccumulatorChainArray<CoupledArrays<3, double, Int64>, Selected> Sparse;
+
+        Dense dense;
+        dense.ignoreLabel(5);
+        extractFeatures(data, labels, dense);
+
+        Sparse sparse;
+        sparse.ignoreLabel(sparseLabel(5));
+        extractFeatures(data, sparseLabels, sparse);
+
+        shouldEqual(sparse.regionCount(), 7u);
+        shouldEqual(sparse.maxRegionLabel(), sparseLabel(7));
+        should(!sparse.hasRegion(sparseLabel(5)));
+        should(!sparse.hasRegion(1));
+        shouldEqual(sparse.regionLabels()[0], sparseLabels[0]);
+        shouldEqual(get<Global<Mean> >(sparse), get<Global<Mean> >(dense));
+
+        try
+        {
+            get<Count>(sparse, 1);
+            failTest("no exception thrown");
+        }
+        catch(ContractViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nSparseAccumulatorChainArray: region label does not exist.");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+
+        // merge the chains of the two halves of the volume (auto-range
+        // histograms cannot be merged, because their ranges differ)
+        typedef SparseAccumulatorChainArray<CoupledArrays<3, double, Int64>,
+                    Select<DataArg<1>, LabelArg<2>, Count, Mean, Variance, Maximum, RegionCenter> > SparseNoHistogram;
+        SparseNoHistogram left, right;
+        extractFeatures(data.subarray(Shape3(0), Shape3(15, 20, 10)),
+                        sparseLabels.subarray(Shape3(0), Shape3(15, 20, 10)), left);
+        right.setCoordinateOffset(Shape3(15, 0, 0));
+        extractFeatures(data.subarray(Shape3(15, 0, 0), data.shape()),
+                        sparseLabels.subarray(Shape3(15, 0, 0), data.shape()), right);
+        left.merge(right);
+
+        // pass-wise merging in the parallel extractFeatures()
+        Sparse parallel;
+        extractFeatures(data, sparseLabels, parallel, ParallelOptions().numThreads(4));
+
+        for(int k=0; k<8; ++k)
+        {
+            if(k == 5)
+                continue;
+            MultiArrayIndex l = sparseLabel(k);
+            shouldEqual(get<Count>(sparse, l), get<Count>(dense, k));
+            shouldEqual(get<Minimum>(sparse, l), get<Minimum>(dense, k));
+            shouldEqual(get<Maximum>(sparse, l), get<Maximum>(dense, k));
+            shouldEqual(get<Mean>(sparse, l), get<Mean>(dense, k));
+            shouldEqual(get<Variance>(sparse, l), get<Variance>(dense, k));
+            shouldEqual(get<Skewness>(sparse, l), get<Skewness>(dense, k));
+            shouldEqual(get<RegionCenter>(sparse, l), get<RegionCenter>(dense, k));
+            shouldEqual(get<AutoRangeHistogram<16> >(sparse, l), get<AutoRangeHistogram<16> >(dense, k));
+
+            shouldEqual(get<Count>(left, l), get<Count>(dense, k));
+            shouldEqual(get<Maximum>(left, l), get<Maximum>(dense, k));
+            shouldEqualTolerance(get<Mean>(left, l), get<Mean>(dense, k), 1e-12);
+            shouldEqualTolerance(get<Variance>(left, l), get<Variance>(dense, k), 1e-12);
+            shouldEqualSequenceTolerance(get<RegionCenter>(left, l).begin(), get<RegionCenter>(left, l).end(),
+                                         get<RegionCenter>(dense, k).begin(), 1e-12);
+
+            shouldEqual(get<Count>(parallel, l), get<Count>(dense, k));
+            shouldEqual(get<AutoRangeHistogram<16> >(parallel, l), get<AutoRangeHistogram<16> >(dense, k));
+            shouldEqualTolerance(get<Skewness>(parallel, l), get<Skewness>(dense, k), 1e-12);
+        }
+
+        // merging two regions
+        left.merge(sparseLabel(0), sparseLabel(1));
+        shouldEqual(get<Count>(left, sparseLabel(0)), get<Count>(dense, 0) + get<Count>(dense, 1));
+        shouldEqual(get<Count>(left, sparseLabel(1)), 0.0);
+    }
+
+    static Int64 sparseLabel(int k)
+    {
+        return (Int64)1000000000000ll + (Int64)k * 7919000000ll;
+    }
 };
 
 struct FeaturesTestSuite : public vigra::test_suite
@@ -1506,6 +1665,8 @@ struct FeaturesTestSuite : public vigra::test_suite
         add(testCase(&AccumulatorTest::testHistogram));
         add(testCase(&AccumulatorTest::testRegionAccumulators));
         add(testCase(&AccumulatorTest::testIndexSpecifiers));
+        add(testCase(&AccumulatorTest::testParallelExtractFeatures));
+        add(testCase(&AccumulatorTest::testSparseAccumulatorChainArray));
     }
 };
 
@@ -169,6 +169,164 @@ struct RandomForestTests
         should(oob.oob_err_ > 0.02 && oob.oob_err_ < 0.04); // FIXME: Use a statistical approach here.
     }
     
+    void test_compiled_prediction()
+    {
+        // Create a noisy chessboard as in test_oob_visitor().
+        size_t const nx = 60;
+        size_t const ny = 50;
+
+        RandomNumberGenerator<MersenneTwister> rand;
+        MultiArray<2, double> train_x(Shape2(nx*ny, 2));
+        MultiArray<1, int> train_y(Shape1(nx*ny));
+        for (size_t y = 0; y < ny; ++y)
+        {
+            for (size_t x = 0; x < nx; ++x)
+            {
+                train_x(y*nx+x, 0) = x + 2*rand.uniform()-1;
+                train_x(y*nx+x, 1) = y + 2*rand.uniform()-1;
+                train_y(y*nx+x) = ((x/15+y/15) % 2 == 0) ? 0 : 3;
+            }
+        }
+
+        RandomForestOptions const options = RandomForestOptions()
+                                                   .tree_count(8)
+                                                   .n_threads(1);
+        auto rf = random_forest(train_x, train_y, options);
+        should(rf.is_compiled());
+
+        // A forest that is assembled member by member is not compiled and walks the graph.
+        decltype(rf) rf_graph;
+        rf_graph.graph_ = rf.graph_;
+        rf_graph.split_tests_ = rf.split_tests_;
+        rf_graph.node_responses_ = rf.node_responses_;
+        rf_graph.problem_spec_ = rf.problem_spec_;
+        should(!rf_graph.is_compiled());
+
+        MultiArray<2, double> probs(Shape2(nx*ny, 2));
+        MultiArray<2, double> probs_graph(Shape2(nx*ny, 2));
+        rf.predict_probabilities(train_x, probs, 3);
+        rf_graph.predict_probabilities(train_x, probs_graph, 1);
+        shouldEqualSequence(probs.begin(), probs.end(), probs_graph.begin());
+
+        std::vector<size_t> tree_indices;
+        tree_indices.push_back(5);
+        tree_indices.push_back(1);
+        rf.predict_probabilities(train_x, probs, 2, tree_indices);
+        rf_graph.predict_probabilities(train_x, probs_graph, 1, tree_indices);
+        shouldEqualSequence(probs.begin(), probs.end(), probs_graph.begin());
+
+        // Merging keeps the compiled layout up to date.
+        rf_graph.compile();
+        should(rf_graph.is_compiled());
+        rf_graph.merge(rf);
+        should(rf_graph.is_compiled());
+        shouldEqual(rf_graph.num_trees(), 16);
+        MultiArray<1, int> pred_y(train_y.shape());
+        MultiArray<1, int> pred_y_graph(train_y.shape());
+        rf.predict(train_x, pred_y, 1);
+        rf_graph.predict(train_x, pred_y_graph, 1);
+        shouldEqualSequence(pred_y.begin(), pred_y.end(), pred_y_graph.begin());
+    }
+
+    void test_deterministic_training()
+    {
+        int const n = 500;
+
+        RandomNumberGenerator<MersenneTwister> rand(3);
+        MultiArray<2, double> train_x(Shape2(n, 5));
+        MultiArray<1, int> train_y(Shape1(train_x.shape(0)));
+        for (int i = 0; i < n; ++i)
+        {
+            for (int k = 0; k < 5; ++k)
+                train_x(i, k) = rand.uniform();
+            train_y(i) = (train_x(i, 0) + train_x(i, 2) + 0.2*rand.uniform() > 1.1) ? 1 : 2;
+        }
+
+        // The trees must not depend on the number of threads, since each tree
+        // gets its own random engine.
+        MultiArray<2, double> probs_ref(Shape2(n, 2));
+        size_t num_nodes_ref = 0;
+        int thread_counts[] = { 1, 2, 5 };
+        for (auto n_threads : thread_counts)
+        {
+            RandomForestOptions const options = RandomForestOptions()
+                                                       .tree_count(12)
+                                                       .n_threads(n_threads);
+            MersenneTwister randengine(42);
+            RFStopVisiting stop;
+            auto rf = random_forest(train_x, train_y, options, stop, randengine);
+            shouldEqual(rf.num_trees(), 12);
+
+            MultiArray<2, double> probs(Shape2(n, 2));
+            rf.predict_probabilities(train_x, probs, 1);
+            if (n_threads == 1)
+            {
+                probs_ref = probs;
+                num_nodes_ref = rf.num_nodes();
+            }
+            else
+            {
+                shouldEqual(rf.num_nodes(), num_nodes_ref);
+                shouldEqualSequence(probs.begin(), probs.end(), probs_ref.begin());
+            }
+        }
+    }
+
+    void test_histogram_split()
+    {
+        int const n = 600;
+
+        RandomNumberGenerator<MersenneTwister> rand(5);
+        MultiArray<2, double> train_x(Shape2(n, 4));
+        MultiArray<1, int> train_y(Shape1(train_x.shape(0)));
+        for (int i = 0; i < n; ++i)
+        {
+            for (int k = 0; k < 4; ++k)
+                train_x(i, k) = (k < 2) ? rand.uniformInt(20) : rand.uniform();
+            train_y(i) = (train_x(i, 0) + train_x(i, 1) + 10.0*train_x(i, 2) > 22.0) ? 1 : 0;
+        }
+
+        // Columns with at most histogram_bins distinct values give the same splits
+        // as the exact search.
+        MultiArray<2, double> int_x = train_x.subarray(Shape2(0, 0), Shape2(n, 2));
+        MultiArray<2, double> probs_exact(Shape2(n, 2));
+        MultiArray<2, double> probs_binned(Shape2(n, 2));
+        {
+            MersenneTwister randengine(17);
+            RFStopVisiting stop;
+            auto rf = random_forest(int_x, train_y, RandomForestOptions().tree_count(6).n_threads(2), stop, randengine);
+            rf.predict_probabilities(int_x, probs_exact, 1);
+
+            MersenneTwister randengine_binned(17);
+            auto rf_binned = random_forest(int_x, train_y, RandomForestOptions().tree_count(6).n_threads(2).histogram_bins(32),
+                                           stop, randengine_binned);
+            rf_binned.predict_probabilities(int_x, probs_binned, 1);
+
+            shouldEqual(rf.num_nodes(), rf_binned.num_nodes());
+            shouldEqualSequence(probs_exact.begin(), probs_exact.end(), probs_binned.begin());
+        }
+
+        // With coarse bins, the forest must still fit the training data well.
+        {
+            auto rf = random_forest(train_x, train_y, RandomForestOptions().tree_count(10).n_threads(1).histogram_bins(16));
+            MultiArray<1, int> pred_y(train_y.shape());
+            rf.predict(train_x, pred_y, 1);
+            int correct = 0;
+            for (int i = 0; i < n; ++i)
+                if (pred_y(i) == train_y(i))
+                    ++correct;
+            should(correct > 0.95*n);
+        }
+
+        try
+        {
+            RandomForestOptions().histogram_bins(300);
+            failTest("RandomForestOptions::histogram_bins() failed to throw an exception.");
+        }
+        catch(PreconditionViolation &)
+        {}
+    }
+
     void test_var_importance_visitor()
     {
         // Create a (noisy) grid with datapoints and split the classes according to an oblique line.
@@ -267,6 +425,9 @@ struct RandomForestTestSuite : public test_suite
         add(testCase(&RandomForestTests::test_base_class));
         add(testCase(&RandomForestTests::test_default_rf));
         add(testCase(&RandomForestTests::test_oob_visitor));
+        add(testCase(&RandomForestTests::test_compiled_prediction));
+        add(testCase(&RandomForestTests::test_deterministic_training));
+        add(testCase(&RandomForestTests::test_histogram_split));
         add(testCase(&RandomForestTests::test_var_importance_visitor));
 #ifdef HasHDF5
         add(testCase(&RandomForestTests::test_import));
@@ -0,0 +1,146 @@
+/************************************************************************/
+/*                                                                      */
+/*        Copyright 2014-2015 by Ullrich Koethe and Philip Schill       */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <vigra/unittest.hxx>
+#include <vigra/threading.hxx>
+#include <vigra/threadpool.hxx>
+#include <vigra/timing.hxx>
+#include <iostream>
+#include <iomanip>
+#include <numeric>
+
+using namespace vigra;
+
+/*
+    Compare the scaling of the two ThreadPool scheduling policies
+    from 1 to 128 threads for fine-grained workloads.
+*/
+struct ThreadPoolSpeedTests
+{
+    static double work(size_t i)
+    {
+        double res = 0.0;
+        for(size_t k=0; k<200; ++k)
+            res += std::sqrt(double(i + k));
+        return res;
+    }
+
+    static const char * policyName(ThreadPool::SchedulingPolicy policy)
+    {
+        return policy == ThreadPool::WorkStealing
+                   ? "work stealing"
+                   : "shared queue ";
+    }
+
+        // many small tasks enqueued from outside the pool
+    double manyTasks(int n_threads, ThreadPool::SchedulingPolicy policy)
+    {
+        size_t const n = 20000;
+        std::vector<double> res(n);
+        USETICTOC;
+        TIC;
+        {
+            ThreadPool pool(n_threads, policy);
+            for(size_t i=0; i<n; ++i)
+                pool.enqueue([&res, i](int) { res[i] = work(i); });
+            pool.waitFinished();
+        }
+        double t = TOCN;
+        shouldEqualTolerance(res[n-1], work(n-1), 1e-12);
+        return t;
+    }
+
+        // nested parallel_foreach: each outer item spawns an inner loop
+    double nestedForeach(int n_threads, ThreadPool::SchedulingPolicy policy)
+    {
+        size_t const n = 200;
+        std::vector<double> res(n*n);
+        USETICTOC;
+        TIC;
+        {
+            ThreadPool pool(n_threads, policy);
+            parallel_foreach(pool, n,
+                [&pool, &res, n](int, size_t i)
+                {
+                    parallel_foreach(pool, n,
+                        [&res, i, n](int, size_t k)
+                        {
+                            res[i*n+k] = work(i*n+k);
+                        });
+                });
+        }
+        double t = TOCN;
+        shouldEqualTolerance(res[n*n-1], work(n*n-1), 1e-12);
+        return t;
+    }
+
+    void testScaling()
+    {
+        ThreadPool::SchedulingPolicy policies[] = { ThreadPool::SharedQueue, ThreadPool::WorkStealing };
+
+        std::cout << "ThreadPool scaling (times in msec, hardware concurrency: "
+                  << threading::thread::hardware_concurrency() << ")\n"
+                  << "  threads  policy          many tasks  nested parallel_foreach\n";
+        for(int n_threads=1; n_threads<=128; n_threads*=2)
+        {
+            for(int p=0; p<2; ++p)
+            {
+                double t1 = manyTasks(n_threads, policies[p]);
+                double t2 = nestedForeach(n_threads, policies[p]);
+                std::cout << "  " << std::setw(7) << n_threads << "  " << policyName(policies[p])
+                          << "  " << std::setw(10) << std::setprecision(4) << t1
+                          << "  " << std::setw(10) << std::setprecision(4) << t2 << "\n";
+            }
+        }
+    }
+};
+
+struct ThreadPoolSpeedTestSuite : public test_suite
+{
+    ThreadPoolSpeedTestSuite()
+        :
+        test_suite("ThreadPool speed test")
+    {
+        add(testCase(&ThreadPoolSpeedTests::testScaling));
+    }
+};
+
+int main(int argc, char** argv)
+{
+    ThreadPoolSpeedTestSuite threadpool_test;
+    int failed = threadpool_test.run(testsToBeExecuted(argc, argv));
+    std::cout << threadpool_test.report() << std::endl;
+    return (failed != 0);
+}
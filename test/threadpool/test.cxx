@@ -70,6 +70,197 @@ struct ThreadPoolTests
         shouldEqualSequence(v.begin(), v.end(), v_expected.begin());
     }
 
+    void test_threadpool_work_stealing()
+    {
+        size_t const n = 10000;
+        std::vector<int> v(n);
+        ThreadPool pool(4, ThreadPool::WorkStealing);
+        shouldEqual(pool.schedulingPolicy(), ThreadPool::WorkStealing);
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            pool.enqueue(
+                [&v, i](size_t /*thread_id*/)
+                {
+                    v[i] = 0;
+                    for (size_t k = 0; k < i+1; ++k)
+                    {
+                        v[i] += k;
+                    }
+                }
+            );
+        }
+        pool.waitFinished();
+
+        std::vector<int> v_expected(n);
+        for (size_t i = 0; i < v_expected.size(); ++i)
+            v_expected[i] = i*(i+1)/2;
+
+        shouldEqualSequence(v.begin(), v.end(), v_expected.begin());
+
+        auto fut = pool.enqueueReturning([](int) { return 42; });
+        shouldEqual(pool.waitFor(fut), 42);
+        shouldEqual(pool.workerIndex(), -1);
+    }
+
+    void test_threadpool_nested(ThreadPool::SchedulingPolicy policy)
+    {
+        // more outer tasks than threads, so that all workers wait for
+        // subtasks simultaneously (would deadlock without helping)
+        size_t const n_outer = 16, n_inner = 200;
+        std::vector<int> v(n_outer*n_inner, 0);
+        std::vector<int> ids(n_outer, -2);
+        ThreadPool pool(2, policy);
+        std::vector<threading::future<void> > futures;
+        for (size_t i = 0; i < n_outer; ++i)
+        {
+            futures.emplace_back(
+                pool.enqueue(
+                    [&pool, &v, &ids, i, n_inner](size_t /*thread_id*/)
+                    {
+                        ids[i] = pool.workerIndex();
+                        std::vector<threading::future<void> > inner;
+                        for (size_t k = 0; k < n_inner/2; ++k)
+                        {
+                            inner.emplace_back(
+                                pool.enqueue(
+                                    [&v, i, k, n_inner](size_t)
+                                    {
+                                        v[i*n_inner + k] = 1;
+                                    }
+                                )
+                            );
+                        }
+                        for (auto & fut : inner)
+                            pool.waitFor(fut);
+
+                        for (size_t k = n_inner/2; k < n_inner; ++k)
+                        {
+                            pool.enqueue(
+                                [&v, i, k, n_inner](size_t)
+                                {
+                                    v[i*n_inner + k] = 1;
+                                }
+                            );
+                        }
+                        // returns when all non-waiting tasks are done
+                        pool.waitFinished();
+                    }
+                )
+            );
+        }
+        for (auto & fut : futures)
+            fut.get();
+        pool.waitFinished();
+
+        shouldEqual(std::accumulate(v.begin(), v.end(), 0), (int)(n_outer*n_inner));
+        for (size_t i = 0; i < n_outer; ++i)
+            should(ids[i] == 0 || ids[i] == 1);
+    }
+
+    void test_threadpool_nested_shared_queue()
+    {
+        test_threadpool_nested(ThreadPool::SharedQueue);
+    }
+
+    void test_threadpool_nested_work_stealing()
+    {
+        test_threadpool_nested(ThreadPool::WorkStealing);
+    }
+
+    void test_parallel_foreach_nested()
+    {
+        size_t const n = 100;
+        std::vector<int> v(n*n, 0);
+        ThreadPool pool(3, ThreadPool::WorkStealing);
+        parallel_foreach(pool, n,
+            [&pool, &v, n](size_t /*thread_id*/, int i)
+            {
+                parallel_foreach(pool, n,
+                    [&v, i, n](size_t /*thread_id*/, int k)
+                    {
+                        v[i*n + k] = i + k;
+                    }
+                );
+            }
+        );
+        for (size_t i = 0; i < n; ++i)
+            for (size_t k = 0; k < n; ++k)
+                shouldEqual(v[i*n + k], (int)(i + k));
+    }
+
+    void test_parallel_foreach_options()
+    {
+        ThreadPool & global = ThreadPool::global();
+        should(&global == &ThreadPool::global());
+        shouldEqual(global.schedulingPolicy(), ThreadPool::WorkStealing);
+        shouldEqual(global.nThreads(), (size_t)ParallelOptions().getNumThreads());
+
+        // run on an existing pool, but use at most 2 of its threads
+        size_t const n = 2000;
+        ThreadPool pool(4, ThreadPool::WorkStealing);
+        std::vector<size_t> results(2, 0);
+        threading::atomic_long outside(0);
+        parallel_foreach(ParallelOptions().numThreads(2).threadPool(pool), n,
+            [&results, &pool, &outside](size_t thread_id, size_t x)
+            {
+                if(pool.workerIndex() < 0)
+                    ++outside;
+                results.at(thread_id) += x;
+            }
+        );
+        shouldEqual(outside.load(), 0);
+        shouldEqual(results[0] + results[1], (n*(n-1))/2);
+
+        // sequential execution
+        std::vector<size_t> serial(1, 0);
+        parallel_foreach(ParallelOptions().numThreads(ParallelOptions::NoThreads).threadPool(pool), n,
+            [&serial](size_t thread_id, size_t x)
+            {
+                serial.at(thread_id) += x;
+            }
+        );
+        shouldEqual(serial[0], (n*(n-1))/2);
+    }
+
+    void test_parallel_foreach_nested_threads()
+    {
+        // inner loops requesting more threads than the enclosing pool owns
+        // must reuse the pool's workers instead of creating new threads
+        size_t const n_outer = 12, n_inner = 500;
+        ThreadPool pool(3, ThreadPool::WorkStealing);
+        std::vector<size_t> sums(n_outer, 0);
+        threading::atomic_long outside(0), bad_ids(0);
+        parallel_foreach(pool, n_outer,
+            [&](size_t /*thread_id*/, size_t i)
+            {
+                std::vector<size_t> results(8, 0);
+                parallel_foreach(8, n_inner,
+                    [&](size_t thread_id, size_t x)
+                    {
+                        if(pool.workerIndex() < 0)
+                            ++outside;
+                        if(thread_id >= pool.nThreads())
+                            ++bad_ids;
+                        results.at(thread_id) += x + i;
+                    }
+                );
+                std::vector<size_t> options_results(2, 0);
+                parallel_foreach(ParallelOptions().numThreads(2), n_inner,
+                    [&](size_t thread_id, size_t x)
+                    {
+                        options_results.at(thread_id) += x;
+                    }
+                );
+                sums[i] = std::accumulate(results.begin(), results.end(), (size_t)0) +
+                          options_results[0] + options_results[1];
+            }
+        );
+        shouldEqual(outside.load(), 0);
+        shouldEqual(bad_ids.load(), 0);
+        for(size_t i = 0; i < n_outer; ++i)
+            shouldEqual(sums[i], n_inner*(n_inner-1) + n_inner*i);
+    }
+
     void test_threadpool_exception()
     {
         bool caught = false;
@@ -241,6 +432,9 @@ struct ThreadPoolTestSuite : public test_suite
     {
         add(testCase(&ThreadPoolTests::test_threadpool));
         add(testCase(&ThreadPoolTests::test_threadpool_exception));
+        add(testCase(&ThreadPoolTests::test_threadpool_work_stealing));
+        add(testCase(&ThreadPoolTests::test_threadpool_nested_shared_queue));
+        add(testCase(&ThreadPoolTests::test_threadpool_nested_work_stealing));
         add(testCase(&ThreadPoolTests::test_parallel_foreach));
         add(testCase(&ThreadPoolTests::test_parallel_foreach_exception));
         add(testCase(&ThreadPoolTests::test_parallel_foreach_sum_serial));
@@ -248,6 +442,9 @@ struct ThreadPoolTestSuite : public test_suite
     defined(BOOST_THREAD_PROVIDES_VARIADIC_THREAD)
         add(testCase(&ThreadPoolTests::test_parallel_foreach_sum));
         add(testCase(&ThreadPoolTests::test_parallel_foreach_sum_auto));
+        add(testCase(&ThreadPoolTests::test_parallel_foreach_nested));
+        add(testCase(&ThreadPoolTests::test_parallel_foreach_options));
+        add(testCase(&ThreadPoolTests::test_parallel_foreach_nested_threads));
         add(testCase(&ThreadPoolTests::test_parallel_foreach_timing));
 #endif
     }
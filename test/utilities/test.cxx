@@ -34,6 +34,7 @@
 /************************************************************************/
 
 #include <cstddef>
+#include <cmath>
 #include <iostream>
 #include <iterator>
 #include <algorithm>
@@ -406,6 +407,83 @@ struct BucketQueueTest
 };
 
 
+struct LazyPriorityQueueTest
+{
+    template <class COMPARE>
+    void compareWithChangeableQueue()
+    {
+        const int size = 50;
+        ChangeablePriorityQueue<double, COMPARE> ref(size);
+        LazyPriorityQueue<double, COMPARE> q(size);
+
+        UInt32 seed = 42;
+        for(int k = 0; k < 20000; ++k)
+        {
+            seed = 1664525u * seed + 1013904223u;
+            const int item = (seed >> 8) % size;
+            // priorities are unique per item, so that both queues agree on the order
+            const double p = double((seed >> 16) % 1000) * size + item;
+            switch((seed >> 4) % 8)
+            {
+              case 0:
+                // ChangeablePriorityQueue requires the item to be contained
+                if(ref.contains(item))
+                    ref.deleteItem(item);
+                q.deleteItem(item);
+                break;
+              case 1:
+                if(!ref.empty())
+                {
+                    ref.pop();
+                    q.pop();
+                }
+                break;
+              default:
+                ref.push(item, p);
+                q.push(item, p);
+            }
+
+            shouldEqual(q.size(), ref.size());
+            shouldEqual(q.empty(), ref.empty());
+            if(!ref.empty())
+            {
+                shouldEqual(q.top(), ref.top());
+                shouldEqual(q.topPriority(), ref.topPriority());
+            }
+            should(q.contains(item) == ref.contains(item));
+            if(ref.contains(item))
+                shouldEqual(q.priority(item), ref.priority(item));
+        }
+
+        while(!ref.empty())
+        {
+            shouldEqual(q.top(), ref.top());
+            ref.pop();
+            q.pop();
+        }
+        should(q.empty());
+
+        q.push(3, 1.0);
+        q.push(4, 2.0);
+        q.clear();
+        should(q.empty());
+        should(!q.contains(3));
+        q.push(4, 2.0);
+        shouldEqual(q.top(), 4);
+    }
+
+    void testMinQueue()
+    {
+        compareWithChangeableQueue<std::less<double> >();
+    }
+
+    void testMaxQueue()
+    {
+        compareWithChangeableQueue<std::greater<double> >();
+    }
+};
+
+
 struct ChangeablePriorityQueueTest
 {
     typedef ChangeablePriorityQueue<float, std::less<float>    > MinQueueType;
@@ -1279,6 +1357,73 @@ struct CompressionTest
 
         shouldEqualSequence(data.begin(), data.end(), decompressed.begin());
     }
+
+    std::size_t roundtrip(char const * source, std::size_t size,
+                          CompressionMethod method, std::size_t elementSize)
+    {
+        ArrayVector<char> compressed;
+        compress(source, size, compressed, method, elementSize);
+
+        ArrayVector<char> decompressed(size);
+        uncompress(compressed.begin(), compressed.size(),
+                   decompressed.begin(), decompressed.size(), method, elementSize);
+
+        shouldEqualSequence(source, source + size, decompressed.begin());
+        return compressed.size();
+    }
+
+    void testPreFilters()
+    {
+        std::vector<CompressionMethod> methods;
+        methods.push_back(LZ4_SHUFFLE);
+        methods.push_back(LZ4_BITSHUFFLE);
+        methods.push_back(LZ4_DELTA_SHUFFLE);
+        methods.push_back(CompressionMethod(LZ4 | DELTA_FILTER));
+        methods.push_back(CompressionMethod(LZ4 | DELTA_FILTER | BITSHUFFLE_FILTER));
+    #ifdef HasZLIB
+        methods.push_back(ZLIB_FAST_SHUFFLE);
+        methods.push_back(ZLIB_FAST_BITSHUFFLE);
+        methods.push_back(ZLIB_FAST_DELTA_SHUFFLE);
+    #endif
+
+        // piecewise constant labels, a smooth float signal, and 3-byte elements
+        // (the element counts are deliberately not multiples of 8)
+        ArrayVector<UInt32> labels(100003);
+        for(std::size_t k = 0; k < labels.size(); ++k)
+            labels[k] = UInt32(100000 + k / 37);
+        ArrayVector<float> smooth(50001);
+        for(std::size_t k = 0; k < smooth.size(); ++k)
+            smooth[k] = float(1000.0 + 100.0*std::sin(k / 1000.0));
+
+        for(std::size_t m = 0; m < methods.size(); ++m)
+        {
+            roundtrip((char const *)labels.data(), labels.size()*sizeof(UInt32), methods[m], sizeof(UInt32));
+            roundtrip((char const *)smooth.data(), smooth.size()*sizeof(float), methods[m], sizeof(float));
+            roundtrip(data.data(), data.size() - 1, methods[m], 3);
+            roundtrip(data.data(), 5, methods[m], 3);
+        }
+
+        // the filters must actually help on label data
+        std::size_t plain   = roundtrip((char const *)labels.data(), labels.size()*sizeof(UInt32), LZ4, sizeof(UInt32)),
+                    shuffled = roundtrip((char const *)labels.data(), labels.size()*sizeof(UInt32), LZ4_SHUFFLE, sizeof(UInt32)),
+                    delta   = roundtrip((char const *)labels.data(), labels.size()*sizeof(UInt32), LZ4_DELTA_SHUFFLE, sizeof(UInt32));
+        should(shuffled < plain);
+        should(delta < shuffled);
+
+        try
+        {
+            ArrayVector<char> compressed;
+            compress(data.data(), data.size(), compressed,
+                     CompressionMethod(LZ4 | SHUFFLE_FILTER | BITSHUFFLE_FILTER), 4);
+            failTest("combined shuffle filters did not throw exception.");
+        }
+        catch(ContractViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\ncompress(): shuffle and bit-shuffle filters cannot be combined.");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
 };
 
 
@@ -1536,6 +1681,8 @@ struct UtilitiesTestSuite
         add( testCase( &BucketQueueTest::testAscendingMapped));
         add( testCase( &ChangeablePriorityQueueTest::testMinQueue));
         add( testCase( &ChangeablePriorityQueueTest::testMaxQueue));
+        add( testCase( &LazyPriorityQueueTest::testMinQueue));
+        add( testCase( &LazyPriorityQueueTest::testMaxQueue));
         add( testCase( &SizedIntTest::testSizedInt));
         add( testCase( &MetaprogrammingTest::testInt));
         add( testCase( &MetaprogrammingTest::testLogic));
@@ -1545,6 +1692,7 @@ struct UtilitiesTestSuite
         add( testCase( &CompressionTest::testZLIB));
         add( testCase( &CompressionTest::testLZ4));
         add( testCase( &CompressionTest::testNoCompression));
+        add( testCase( &CompressionTest::testPreFilters));
 
         add( testCase( &AnyTest::test));
     }
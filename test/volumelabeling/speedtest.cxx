@@ -0,0 +1,109 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2006-2007 by F. Heinrich, B. Seppke, Ullrich Koethe    */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */                
+/*                                                                      */
+/************************************************************************/
+
+#include <iostream>
+#include "vigra/unittest.hxx"
+#include "vigra/multi_labeling.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+/*
+    Compare sequential labelMultiArray() with the slab-parallel
+    labeling on the default number of threads.
+*/
+struct ParallelLabelingSpeedTest
+{
+    template <unsigned int N>
+    static void fillRandom(MultiArray<N, int> & data, int values = 2)
+    {
+        UInt32 seed = 17;
+        for(typename MultiArray<N, int>::iterator i = data.begin(); i != data.end(); ++i)
+        {
+            seed = 1664525u * seed + 1013904223u;
+            *i = (seed >> 16) % values;
+        }
+    }
+
+    template <unsigned int N>
+    void benchmarkImpl(typename MultiArrayShape<N>::type const & shape)
+    {
+        MultiArray<N, int> data(shape);
+        fillRandom(data);
+        MultiArray<N, UInt32> ref(shape), res(shape);
+        const int threads = ParallelOptions().getActualNumThreads();
+
+        USETICTOC;
+        TIC;
+        UInt32 count = labelMultiArray(data, ref, IndirectNeighborhood);
+        double tSequential = TOCN;
+        TIC;
+        UInt32 countParallel = labelMultiArray(data, res,
+                                   LabelOptions().neighborhood(IndirectNeighborhood)
+                                                 .parallelOptions(ParallelOptions()));
+        double tParallel = TOCN;
+
+        shouldEqual(countParallel, count);
+        should(res == ref);
+        std::cerr << "    labelMultiArray " << shape << ", " << count << " regions: sequential "
+                  << tSequential << " msec, " << threads << " threads " << tParallel << " msec\n";
+    }
+
+    void testLabeling()
+    {
+        benchmarkImpl<2>(Shape2(2000, 2000));
+        benchmarkImpl<3>(Shape3(160, 160, 160));
+    }
+};
+
+struct ParallelLabelingSpeedTestSuite
+: public vigra::test_suite
+{
+    ParallelLabelingSpeedTestSuite()
+    : vigra::test_suite("ParallelLabelingSpeedTestSuite")
+    {
+        add(testCase(&ParallelLabelingSpeedTest::testLabeling));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    ParallelLabelingSpeedTestSuite test;
+
+    int failed = test.run(testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+    return (failed != 0);
+}
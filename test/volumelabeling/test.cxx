@@ -462,6 +462,86 @@ struct VolumeLabelingTest
 };
 
 
+struct ParallelLabelingTest
+{
+    // random binary data, so that many regions cross the slab boundaries
+    template <unsigned int N>
+    static void fillRandom(MultiArray<N, int> & data, int values = 2)
+    {
+        UInt32 seed = 17;
+        for(typename MultiArray<N, int>::iterator i = data.begin(); i != data.end(); ++i)
+        {
+            seed = 1664525u * seed + 1013904223u;
+            *i = (seed >> 16) % values;
+        }
+    }
+
+    template <unsigned int N>
+    void compareToSequential(MultiArrayView<N, int, StridedArrayTag> const & data)
+    {
+        MultiArray<N, UInt32> ref(data.shape()), res(data.shape());
+        NeighborhoodType neighborhoods[] = { DirectNeighborhood, IndirectNeighborhood };
+        int threads[] = { 1, 2, 3, 4, 7, 64 };
+
+        for(int n = 0; n < 2; ++n)
+        {
+            UInt32 count = labelMultiArray(data, ref, neighborhoods[n]);
+            UInt32 countBg = 0;
+            MultiArray<N, UInt32> refBg(data.shape());
+            countBg = labelMultiArrayWithBackground(data, refBg, neighborhoods[n], 0);
+
+            for(int t = 0; t < 6; ++t)
+            {
+                LabelOptions options;
+                options.neighborhood(neighborhoods[n])
+                       .parallelOptions(ParallelOptions().numThreads(threads[t]));
+
+                res = 0;
+                shouldEqual(labelMultiArray(data, res, options), count);
+                should(res == ref);
+
+                res = 0;
+                options.ignoreBackgroundValue(0);
+                shouldEqual(labelMultiArray(data, res, options), countBg);
+                should(res == refBg);
+            }
+        }
+    }
+
+    void test2D()
+    {
+        MultiArray<2, int> data(Shape2(123, 97));
+        fillRandom(data);
+        compareToSequential<2>(data);
+        // strided view
+        compareToSequential<2>(data.transpose());
+    }
+
+    void test3D()
+    {
+        MultiArray<3, int> data(Shape3(21, 17, 30));
+        fillRandom(data, 3);
+        compareToSequential<3>(data);
+        compareToSequential<3>(data.transpose());
+    }
+
+    void testEqualityFunctor()
+    {
+        MultiArray<2, int> data(Shape2(60, 80));
+        fillRandom(data, 6);
+        MultiArray<2, UInt32> ref(data.shape()), res(data.shape());
+
+        // values 2k and 2k+1 belong to the same region
+        auto equal = [](int a, int b) { return a / 2 == b / 2; };
+        UInt32 count = labelMultiArray(data, ref, LabelOptions(), equal);
+        shouldEqual(labelMultiArray(data, res,
+                                    LabelOptions().parallelOptions(ParallelOptions().numThreads(4)),
+                                    equal),
+                    count);
+        should(res == ref);
+    }
+};
+
 
 struct VolumeLabelingTestSuite
 : public vigra::test_suite
@@ -479,6 +559,10 @@ struct VolumeLabelingTestSuite
         add( testCase( &VolumeLabelingTest::labelingTwentySixTest3));
         add( testCase( &VolumeLabelingTest::labelingTwentySixWithBackgroundTest1));
         add( testCase( &VolumeLabelingTest::labelingAllTest));
+
+        add( testCase( &ParallelLabelingTest::test2D));
+        add( testCase( &ParallelLabelingTest::test3D));
+        add( testCase( &ParallelLabelingTest::testEqualityFunctor));
     }
 };
 
@@ -0,0 +1,119 @@
+/************************************************************************/
+/*                                                                      */
+/*       Copyright 2004 by F. Heinrich, B. Seppke, Ullrich Koethe       */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <iostream>
+#include <cmath>
+#include "vigra/unittest.hxx"
+#include "vigra/multi_array.hxx"
+#include "vigra/multi_watersheds.hxx"
+#include "vigra/random.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+/*
+    Compare watershedsMultiArray() on 128^3 volumes with the
+    heap-based priority queue of lemon_graph::graph_detail::seededWatersheds().
+*/
+struct BucketWatershedsSpeedTest
+{
+    typedef MultiArray<3, UInt32> LabelVolume;
+
+    template <class T>
+    static void makeBoundaryMap(MultiArray<3, T> & data, double maxValue)
+    {
+        RandomMT19937 random(42);
+        for(MultiArrayIndex z=0; z<data.shape(2); ++z)
+        for(MultiArrayIndex y=0; y<data.shape(1); ++y)
+        for(MultiArrayIndex x=0; x<data.shape(0); ++x)
+        {
+            double v = std::abs(std::sin(0.21*x) * std::sin(0.17*y + 0.5) * std::sin(0.13*z + 1.0));
+            v = std::floor(4.0 * (1.0 - v)) / 4.0 * 0.9 + 0.1*random.uniform();
+            data(x, y, z) = static_cast<T>(std::floor(v * maxValue));
+        }
+    }
+
+    template <class T>
+    void benchmarkType(const char * name, double maxValue, WatershedOptions const & options)
+    {
+        MultiArray<3, T> data(Shape3(128, 128, 128));
+        makeBoundaryMap(data, maxValue);
+
+        LabelVolume seeds(data.shape());
+        generateWatershedSeeds(data, seeds, IndirectNeighborhood);
+
+        LabelVolume labels(seeds), reference(seeds);
+        GridGraph<3, undirected_tag> graph(data.shape(), IndirectNeighborhood);
+        USETICTOC;
+        TIC;
+        lemon_graph::graph_detail::seededWatersheds(graph, data, reference,
+                                                    WatershedOptions().regionGrowing());
+        double heapTime = TOCN;
+        TIC;
+        watershedsMultiArray(data, labels, IndirectNeighborhood, options);
+        double bucketTime = TOCN;
+
+        std::cerr << "    watersheds 128^3 " << name << ": priority queue " << heapTime
+                  << " ms, bucket queue " << bucketTime << " ms\n";
+    }
+
+    void testWatersheds()
+    {
+        benchmarkType<Int8>("Int8", 127.0, WatershedOptions().regionGrowing());
+        benchmarkType<Int16>("Int16", 30000.0, WatershedOptions().regionGrowing());
+        benchmarkType<float>("float, 256 levels", 1000.0, WatershedOptions().quantization(256));
+        benchmarkType<float>("float, 4096 levels", 1000.0, WatershedOptions().quantization(4096));
+    }
+};
+
+struct BucketWatershedsSpeedTestSuite
+: public vigra::test_suite
+{
+    BucketWatershedsSpeedTestSuite()
+    : vigra::test_suite("BucketWatershedsSpeedTestSuite")
+    {
+        add(testCase(&BucketWatershedsSpeedTest::testWatersheds));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    BucketWatershedsSpeedTestSuite test;
+
+    int failed = test.run(testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+    return (failed != 0);
+}
@@ -41,6 +41,7 @@
 #include "vigra/watersheds3d.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/multi_watersheds.hxx"
+#include "vigra/random.hxx"
 #include "list"
 
 #include <stdlib.h>
@@ -560,6 +561,147 @@ struct Watersheds3dTest
 };
 
 
+struct BucketWatershedsTest
+{
+    typedef MultiArray<3, UInt32> LabelVolume;
+
+        // synthetic boundary map: thin walls between cells plus noise,
+        // with large plateaus to exercise the tie order
+    template <class T>
+    static void makeBoundaryMap(MultiArray<3, T> & data, double maxValue)
+    {
+        RandomMT19937 random(42);
+        for(MultiArrayIndex z=0; z<data.shape(2); ++z)
+        for(MultiArrayIndex y=0; y<data.shape(1); ++y)
+        for(MultiArrayIndex x=0; x<data.shape(0); ++x)
+        {
+            double v = std::abs(std::sin(0.21*x) * std::sin(0.17*y + 0.5) * std::sin(0.13*z + 1.0));
+            v = std::floor(4.0 * (1.0 - v)) / 4.0 * 0.9 + 0.1*random.uniform();
+            data(x, y, z) = static_cast<T>(std::floor(v * maxValue));
+        }
+        data(0, 0, 0) = static_cast<T>(0);
+        data(1, 0, 0) = static_cast<T>(maxValue);
+    }
+
+        // reference result using the heap-based priority queue
+    template <class T>
+    static UInt32 heapWatersheds(MultiArray<3, T> const & data, LabelVolume & labels,
+                                 NeighborhoodType neighborhood, WatershedOptions const & options)
+    {
+        GridGraph<3, undirected_tag> graph(data.shape(), neighborhood);
+        return lemon_graph::graph_detail::seededWatersheds(graph, data, labels, options);
+    }
+
+    template <class T>
+    void checkIdentical(double maxValue, NeighborhoodType neighborhood)
+    {
+        MultiArray<3, T> data(Shape3(40, 35, 30));
+        makeBoundaryMap(data, maxValue);
+
+        LabelVolume seeds(data.shape());
+        generateWatershedSeeds(data, seeds, neighborhood);
+
+        WatershedOptions options[4] = {
+            WatershedOptions().regionGrowing(),
+            WatershedOptions().regionGrowing().keepContours(),
+            WatershedOptions().regionGrowing().biasLabel(3, 0.5),
+            WatershedOptions().regionGrowing().stopAtThreshold(maxValue / 3.0).keepContours()
+        };
+        // unsigned data go through the heap (i.e. PriorityQueue's BucketQueue),
+        // so check the one-bucket-per-value queue used for signed data explicitly
+        GridGraph<3, undirected_tag> graph(data.shape(), neighborhood);
+        lemon_graph::graph_detail::WatershedIntegerBuckets<T> toBucket;
+        for(int k=0; k<4; ++k)
+        {
+            LabelVolume labels(seeds), buckets(seeds), reference(seeds);
+            UInt32 maxLabel = watershedsMultiArray(data, labels, neighborhood, options[k]);
+            shouldEqual(maxLabel, heapWatersheds(data, reference, neighborhood, options[k]));
+            should(labels == reference);
+
+            UInt32 maxBucketLabel = lemon_graph::graph_detail::bucketSeededWatersheds(
+                                        graph, data, buckets, options[k], toBucket);
+            shouldEqual(maxBucketLabel, maxLabel);
+            should(buckets == reference);
+        }
+    }
+
+    void testUInt8()
+    {
+        checkIdentical<UInt8>(255.0, DirectNeighborhood);
+        checkIdentical<UInt8>(255.0, IndirectNeighborhood);
+    }
+
+    void testUInt16()
+    {
+        checkIdentical<UInt16>(4000.0, DirectNeighborhood);
+        checkIdentical<UInt16>(65535.0, IndirectNeighborhood);
+    }
+
+    void testInt16()
+    {
+        // signed data are shifted into the same buckets as unsigned data
+        MultiArray<3, UInt16> data16(Shape3(40, 35, 30));
+        makeBoundaryMap(data16, 65535.0);
+        MultiArray<3, Int16> datas(data16.shape());
+        for(MultiArrayIndex k=0; k<data16.size(); ++k)
+            datas[k] = static_cast<Int16>((int)data16[k] - 32768);
+
+        LabelVolume seeds(data16.shape());
+        generateWatershedSeeds(data16, seeds, IndirectNeighborhood);
+
+        LabelVolume labels16(seeds), labelss(seeds);
+        watershedsMultiArray(data16, labels16, IndirectNeighborhood,
+                             WatershedOptions().regionGrowing().keepContours());
+        watershedsMultiArray(datas, labelss, IndirectNeighborhood,
+                             WatershedOptions().regionGrowing().keepContours());
+        should(labels16 == labelss);
+
+        labels16 = seeds;
+        labelss = seeds;
+        watershedsMultiArray(data16, labels16, IndirectNeighborhood,
+                             WatershedOptions().regionGrowing().stopAtThreshold(30000.0));
+        watershedsMultiArray(datas, labelss, IndirectNeighborhood,
+                             WatershedOptions().regionGrowing().stopAtThreshold(30000.0 - 32768.0));
+        should(labels16 == labelss);
+    }
+
+    void testQuantized()
+    {
+        // float data with integer values in [0, 255] fall into the same
+        // buckets as the corresponding UInt8 data
+        MultiArray<3, UInt8> data8(Shape3(40, 35, 30));
+        makeBoundaryMap(data8, 255.0);
+        MultiArray<3, float> dataf(data8);
+
+        LabelVolume seeds(data8.shape());
+        generateWatershedSeeds(data8, seeds, DirectNeighborhood);
+
+        LabelVolume labels8(seeds), labelsf(seeds), labelsHeap(seeds);
+        watershedsMultiArray(data8, labels8, DirectNeighborhood,
+                             WatershedOptions().regionGrowing().keepContours());
+        watershedsMultiArray(dataf, labelsf, DirectNeighborhood,
+                             WatershedOptions().keepContours().quantization(256));
+        should(labels8 == labelsf);
+
+        // without quantization, float data still use the exact algorithm
+        labelsf = seeds;
+        watershedsMultiArray(dataf, labelsf, DirectNeighborhood,
+                             WatershedOptions().regionGrowing().keepContours());
+        heapWatersheds(dataf, labelsHeap, DirectNeighborhood,
+                       WatershedOptions().regionGrowing().keepContours());
+        should(labelsf == labelsHeap);
+
+        // constant data: everything goes into a single bucket
+        dataf.init(1.0f);
+        labelsf = seeds;
+        watershedsMultiArray(dataf, labelsf, DirectNeighborhood,
+                             WatershedOptions().quantization(16));
+        UInt32 minLabel, maxLabel;
+        labelsf.minmax(&minLabel, &maxLabel);
+        should(minLabel > 0);
+    }
+};
+
 struct Watershed3DTestSuite
 : public test_suite
 {
@@ -572,6 +714,11 @@ struct Watershed3DTestSuite
         add( testCase( &Watersheds3dTest::testWatersheds3dSix2));
         add( testCase( &Watersheds3dTest::testWatersheds3dGradient1));
         add( testCase( &Watersheds3dTest::testWatersheds3dGradient2));
+
+        add( testCase( &BucketWatershedsTest::testUInt8));
+        add( testCase( &BucketWatershedsTest::testUInt16));
+        add( testCase( &BucketWatershedsTest::testInt16));
+        add( testCase( &BucketWatershedsTest::testQuantized));
     }
 };
 
@@ -0,0 +1,91 @@
+/************************************************************************/
+/*                                                                      */
+/*          Copyright 2016 by the VIGRA developers                      */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#define PY_ARRAY_UNIQUE_SYMBOL vigranumpygraphs_PyArray_API
+#define NO_IMPORT_ARRAY
+
+
+
+#include "export_graph_visitor.hxx"
+#include "export_graph_algorithm_visitor.hxx"
+#include "export_graph_shortest_path_visitor.hxx"
+
+#include <vigra/numpy_array.hxx>
+#include <vigra/numpy_array_converters.hxx>
+#include <vigra/adjacency_list_graph.hxx>
+#include <vigra/csr_graph.hxx>
+#include <vigra/python_graph.hxx>
+namespace python = boost::python;
+
+namespace vigra{
+
+
+
+    CsrGraph * pyCsrGraphFromUvIds(
+        const Int64 nodeNum,
+        const NumpyArray<2, UInt32> & uvIds
+    ){
+        return new CsrGraph(nodeNum, uvIds);
+    }
+
+
+    void defineCsrGraph(){
+
+        typedef CsrGraph  Graph;
+        // define graph itself
+        // (immutable, hence without the add-items and merge graph visitors)
+        const std::string clsName = "CsrGraph";
+        python::class_<Graph>(clsName.c_str(),"immutable undirected graph in compressed sparse row layout",
+            python::init< >( )
+        )
+        .def(python::init< const AdjacencyListGraph & >(
+            python::arg("graph"),
+            "freeze an AdjacencyListGraph, node and edge ids are preserved"
+        ))
+        .def("__init__",python::make_constructor(registerConverters(&pyCsrGraphFromUvIds),
+            python::default_call_policies(),
+            (
+                python::arg("nodeNum"),
+                python::arg("uvIds")
+            )
+        ))
+        .def(LemonUndirectedGraphCoreVisitor<Graph>(clsName))
+        .def(LemonGraphAlgorithmVisitor<Graph>(clsName))
+        .def(LemonGraphShortestPathVisitor<Graph>(clsName))
+        ;
+    }
+} 
+
+
@@ -54,6 +54,7 @@ namespace vigra{
     }
 
 	void defineAdjacencyListGraph();
+	void defineCsrGraph();
 	void defineGridGraph2d();
     void defineGridGraph3d();
     void defineGridGraphImplicitEdgeMap();
@@ -92,6 +93,7 @@ BOOST_PYTHON_MODULE_INIT(graphs)
 
     // all graph classes itself (GridGraph , AdjacencyListGraph)
     defineAdjacencyListGraph();
+    defineCsrGraph();
     defineGridGraph2d();
     defineGridGraph3d();
 
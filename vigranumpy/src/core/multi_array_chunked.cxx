@@ -939,12 +939,24 @@ void defineChunkedArray()
          "   ``Compression.ZLIB_NONE:``\n      ZLIB no compression (level = 0)\n"
          "   ``Compression.ZLIB_FAST:``\n      ZLIB fast compression (level = 1)\n"
          "   ``Compression.ZLIB_BEST:``\n      ZLIB best compression (level = 9)\n"
-         "   ``Compression.LZ4:``\n      LZ4 compression (very fast)\n\n")
+         "   ``Compression.LZ4:``\n      LZ4 compression (very fast)\n"
+         "   ``Compression.LZ4_SHUFFLE:``\n      LZ4 after byte shuffling of the elements\n"
+         "   ``Compression.LZ4_BITSHUFFLE:``\n      LZ4 after bit shuffling of the elements\n"
+         "   ``Compression.LZ4_DELTA_SHUFFLE:``\n      LZ4 after delta filter and byte shuffling\n"
+         "   ``Compression.ZLIB_FAST_SHUFFLE:``\n      ZLIB fast compression after byte shuffling\n"
+         "   ``Compression.ZLIB_FAST_BITSHUFFLE:``\n      ZLIB fast compression after bit shuffling\n"
+         "   ``Compression.ZLIB_FAST_DELTA_SHUFFLE:``\n      ZLIB fast compression after delta filter and byte shuffling\n\n")
         .value("ZLIB", vigra::ZLIB)
         .value("ZLIB_NONE", vigra::ZLIB_NONE)
         .value("ZLIB_FAST", vigra::ZLIB_FAST)
         .value("ZLIB_BEST", vigra::ZLIB_BEST)
         .value("LZ4", vigra::LZ4)
+        .value("LZ4_SHUFFLE", vigra::LZ4_SHUFFLE)
+        .value("LZ4_BITSHUFFLE", vigra::LZ4_BITSHUFFLE)
+        .value("LZ4_DELTA_SHUFFLE", vigra::LZ4_DELTA_SHUFFLE)
+        .value("ZLIB_FAST_SHUFFLE", vigra::ZLIB_FAST_SHUFFLE)
+        .value("ZLIB_FAST_BITSHUFFLE", vigra::ZLIB_FAST_BITSHUFFLE)
+        .value("ZLIB_FAST_DELTA_SHUFFLE", vigra::ZLIB_FAST_DELTA_SHUFFLE)
     ;
 
 #ifdef HasHDF5